@@ -0,0 +1,283 @@
+// CommandGrammar matching cost and a fuzz pass over it, then (given a
+// plugin directory) the same fuzzing against a room's processInput, seeded
+// from the vocabulary the room publishes for tab completion.
+//
+// Checks that matching never allocates and that every match is consistent
+// with its input; exits non-zero on any violation or room exception.
+//
+// Usage: bench_command_grammar [plugin directory] [room name] [iterations]
+
+#include "framework/CommandGrammar.h"
+#include "framework/CommandTrie.h"
+#include "framework/PluginManager.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace devescape;
+using Clock = std::chrono::steady_clock;
+
+// Counts every allocation in the process
+static std::atomic<size_t> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+const char* const VERBS[] = {"examine", "filter", "identify", "navigate", "calculate",
+                             "submit", "deploy", "scale", "restart", "rollback"};
+const char* const NOUNS[] = {"logs", "metrics", "pool", "config", "service", "cache",
+                             "database", "queue", "replica", "shard"};
+
+// 10 verbs x 10 nouns x a few shapes, plus some synthetic filler verbs
+void buildGrammar(CommandGrammar& grammar, std::vector<std::string>& corpus) {
+    int id = 0;
+    for (const char* verb : VERBS) {
+        for (const char* noun : NOUNS) {
+            std::string base = std::string(verb) + " " + noun;
+            grammar.add(base, id++);
+            grammar.add(base + " <int>", id++);
+            grammar.add(base + " <word> <int>", id++);
+            grammar.add(base + " level <word>", id++);
+            corpus.push_back(base);
+            corpus.push_back(base + " 60");
+            corpus.push_back(base + " payment-api 3");
+            corpus.push_back(base + " level ERROR");
+        }
+        grammar.add(std::string(verb) + " <rest>", id++);
+        corpus.push_back(std::string(verb) + " something else entirely");
+    }
+    for (int i = 0; i < 500; ++i) {
+        grammar.add("verb" + std::to_string(i) + " <word>", id++);
+    }
+    corpus.push_back("verb250 argument");
+    corpus.push_back("   navigate   metrics   ");
+}
+
+std::string mutate(const std::string& seed, std::mt19937_64& rng) {
+    static const char* const JUNK[] = {"", " ", "\t", "<int>", "<rest>", "-", "0", "-0",
+                                       "99999999999999999999", "-9223372036854775808",
+                                       "9223372036854775807", "12abc", "\xff\xfe", "\x1b[A",
+                                       "database", "pool", "  "};
+    std::string out = seed;
+    int edits = static_cast<int>(rng() % 4);
+    for (int e = 0; e < edits; ++e) {
+        size_t at = out.empty() ? 0 : rng() % (out.size() + 1);
+        switch (rng() % 5) {
+            case 0:
+                out.insert(at, JUNK[rng() % (sizeof(JUNK) / sizeof(JUNK[0]))]);
+                break;
+            case 1:
+                out.insert(at, 1, static_cast<char>(rng() % 256));
+                break;
+            case 2:
+                if (!out.empty()) out.erase(at == out.size() ? at - 1 : at, 1 + rng() % 8);
+                break;
+            case 3:
+                out.resize(at);
+                break;
+            default:
+                out += " " + std::to_string(static_cast<int64_t>(rng()));
+                break;
+        }
+    }
+    return out;
+}
+
+bool within(std::string_view part, std::string_view whole) {
+    return part.empty() ||
+           (part.data() >= whole.data() && part.data() + part.size() <= whole.data() + whole.size());
+}
+
+// Problems with a match of `input`, or 0
+int checkMatch(const CommandGrammar& grammar, std::string_view input, const CommandMatch& match) {
+    int problems = 0;
+    if (match.command < CommandGrammar::NO_MATCH || match.argumentCount > CommandMatch::MAX_ARGUMENTS) {
+        problems++;
+    }
+    for (size_t i = 0; i < match.argumentCount; ++i) {
+        std::string_view text = match.text(i);
+        if (text.empty() || !within(text, input)) {
+            problems++;
+        }
+        int64_t value = 0;
+        auto [ptr, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        bool isNumber = error == std::errc() && ptr == text.data() + text.size();
+        // <word> slots leave number at 0
+        if (match.number(i) != 0 && (!isNumber || match.number(i) != value)) {
+            problems++;
+        }
+    }
+    if (!within(match.rest, input) || (!match.rest.empty() && match.rest.back() == ' ')) {
+        problems++;
+    }
+    CommandMatch again;
+    if (grammar.match(input, again) != match.command || again.argumentCount != match.argumentCount) {
+        problems++;
+    }
+    return problems;
+}
+
+// Every full command in the trie, found by completing word by word
+void enumerate(const CommandTrie& trie, const std::string& prefix, std::set<std::string>& out) {
+    Completion completion = trie.complete(prefix, 4096);
+    std::string extended = prefix + completion.extension;
+    if (trie.contains(extended)) {
+        out.insert(extended);
+    }
+    for (const std::string& candidate : completion.candidates) {
+        if (trie.contains(candidate)) {
+            out.insert(candidate);
+        }
+        if (candidate != extended) {
+            enumerate(trie, candidate, out);
+        }
+    }
+}
+
+int fuzzRoom(const std::string& directory, const std::string& roomName, size_t iterations) {
+    PluginManager manager(directory);
+    manager.scanForPlugins();
+    FrameworkContext context;
+
+    IEscapeRoomV2* room = manager.acquireRoom(roomName, context);
+    if (!room) {
+        std::cerr << "failed to start " << roomName << "\n";
+        return 1;
+    }
+
+    CommandTrie vocabulary;
+    std::set<std::string> seeds{"help", "hint"};
+    if (manager.publishCommands(room, vocabulary)) {
+        enumerate(vocabulary, "", seeds);
+    }
+    std::vector<std::string> corpus(seeds.begin(), seeds.end());
+
+    std::mt19937_64 rng(7);
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    size_t exceptions = 0;
+    size_t sessions = 1;
+
+    for (size_t i = 0; i < iterations; ++i) {
+        const std::string& seed = corpus[rng() % corpus.size()];
+        std::string command = rng() % 2 ? seed : mutate(seed, rng);
+
+        auto begin = Clock::now();
+        try {
+            ProcessResult result = room->processInput(command);
+            (void)result;
+        } catch (const std::exception& e) {
+            if (exceptions++ < 5) {
+                std::cerr << "exception for '" << command << "': " << e.what() << "\n";
+            }
+        }
+        samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - begin).count());
+
+        // Fresh sessions now and then so every phase sees traffic
+        if (i % 1000 == 999) {
+            manager.releaseRoom(room);
+            room = manager.acquireRoom(roomName, context);
+            sessions++;
+            if (!room) {
+                std::cerr << "failed to restart " << roomName << "\n";
+                return 1;
+            }
+        }
+    }
+    manager.releaseRoom(room);
+
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (double s : samples) total += s;
+    std::cout << roomName << ": " << corpus.size() << " seed commands, " << iterations
+              << " inputs over " << sessions << " sessions\n"
+              << "  processInput: mean " << total / samples.size() << " ns, p50 "
+              << samples[samples.size() / 2] << " ns, p99 " << samples[samples.size() * 99 / 100]
+              << " ns\n"
+              << "  exceptions:   " << exceptions << "\n";
+    return exceptions == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200000;
+
+    CommandGrammar grammar;
+    std::vector<std::string> corpus;
+    buildGrammar(grammar, corpus);
+
+    // Matching speed over valid commands
+    CommandMatch match;
+    size_t bytes = 0;
+    size_t matched = 0;
+    size_t before = allocations.load();
+    auto begin = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        const std::string& input = corpus[i % corpus.size()];
+        matched += grammar.match(input, match) != CommandGrammar::NO_MATCH;
+        bytes += input.size();
+    }
+    double elapsedNs = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+    size_t matchAllocations = allocations.load() - before;
+
+    // Fuzz: mutated commands and raw bytes
+    std::mt19937_64 rng(1);
+    std::vector<std::string> inputs;
+    inputs.reserve(iterations);
+    for (size_t i = 0; i < iterations; ++i) {
+        if (i % 4 == 0) {
+            std::string noise(rng() % 64, '\0');
+            for (char& c : noise) c = static_cast<char>(rng() % 256);
+            inputs.push_back(std::move(noise));
+        } else {
+            inputs.push_back(mutate(corpus[rng() % corpus.size()], rng));
+        }
+    }
+    int problems = 0;
+    size_t fuzzMatched = 0;
+    before = allocations.load();
+    for (const std::string& input : inputs) {
+        int command = grammar.match(input, match);
+        fuzzMatched += command != CommandGrammar::NO_MATCH;
+        problems += checkMatch(grammar, input, match);
+    }
+    size_t fuzzAllocations = allocations.load() - before;
+
+    std::cout << "grammar patterns:    " << grammar.size() << "\n"
+              << "match:               " << elapsedNs / iterations << " ns/command, "
+              << elapsedNs / bytes << " ns/byte (" << matched << "/" << iterations << " matched)\n"
+              << "fuzz inputs:         " << inputs.size() << " (" << fuzzMatched << " matched)\n"
+              << "inconsistent:        " << problems << "\n"
+              << "allocations:         " << matchAllocations + fuzzAllocations << "\n";
+
+    int status = problems == 0 && matchAllocations + fuzzAllocations == 0 ? 0 : 1;
+    if (argc > 1) {
+        status |= fuzzRoom(argv[1], argc > 2 ? argv[2] : "Production Incident", iterations);
+    }
+    return status;
+}
@@ -0,0 +1,80 @@
+// LogGenerator throughput: a profile's log written to a file with 1, 2, 4...
+// threads up to the core count, checked to come out byte-identical, plus
+// how long a 1000-line window takes to generate on its own.
+//
+// Usage: bench_log_generator <profile> [lines] [output file]
+
+#include "framework/LogGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace devescape;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+double secondsSince(Clock::time_point begin) {
+    return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+std::string readAll(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: bench_log_generator <profile> [lines] [output file]" << std::endl;
+        return 1;
+    }
+    LogGenerator::Profile profile;
+    if (!LogGenerator::loadProfile(argv[1], profile)) {
+        return 1;
+    }
+    if (argc > 2) {
+        profile.lineCount = std::strtoull(argv[2], nullptr, 10);
+    }
+    std::string output = argc > 3 ? argv[3] : "bench_log_generator.log";
+
+    LogGenerator generator;
+    if (!generator.setProfile(profile)) {
+        return 1;
+    }
+
+    std::string reference;
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= cores; threads *= 2) {
+        auto begin = Clock::now();
+        if (!generator.writeFile(output, threads)) {
+            return 1;
+        }
+        double elapsed = secondsSince(begin);
+        std::string written = readAll(output);
+        if (threads == 1) {
+            reference = std::move(written);
+        } else if (written != reference) {
+            std::cerr << threads << " threads: output differs from 1 thread" << std::endl;
+            return 1;
+        }
+        std::cout << threads << " threads: " << profile.lineCount / elapsed / 1e6
+                  << " M lines/s, " << reference.size() / elapsed / 1e6 << " MB/s\n";
+    }
+    std::remove(output.c_str());
+
+    std::string window;
+    auto begin = Clock::now();
+    generator.generate(profile.lineCount / 2, 1000, window);
+    std::cout << "window of 1000 lines: " << secondsSince(begin) * 1e6 << " us\n";
+    return 0;
+}
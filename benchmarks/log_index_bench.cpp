@@ -0,0 +1,80 @@
+// LogIndex over a log on disk: opening it (index built or mapped), substring
+// search through the whole log against std::string_view::find, and level
+// counts from the index.
+//
+// Usage: bench_log_index <log> [needle]
+
+#include "framework/LogIndex.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace devescape;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+double secondsSince(Clock::time_point begin) {
+    return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+void report(const char* mode, size_t hits, uint64_t bytes, double elapsed) {
+    std::cout << mode << ": " << hits << " hits, " << elapsed * 1e3 << " ms, "
+              << bytes / elapsed / 1e9 << " GB/s\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: bench_log_index <log> [needle]" << std::endl;
+        return 1;
+    }
+    std::string needle = argc > 2 ? argv[2] : "pool exhausted";
+
+    LogIndex log;
+    auto begin = Clock::now();
+    if (!log.open(argv[1])) {
+        return 1;
+    }
+    std::cout << "open: " << log.getLineCount() << " lines, " << log.getBytes() / (1024.0 * 1024.0)
+              << " MiB in " << secondsSince(begin) * 1e3 << " ms\n";
+
+    // Touch every page once so both searches read from memory
+    volatile char touched = 0;
+    for (uint64_t i = 0; i < log.getBytes(); i += 4096) {
+        touched = log.getData()[i];
+    }
+    (void)touched;
+
+    size_t hits = 0;
+    begin = Clock::now();
+    for (uint64_t at = log.find(0, log.getBytes(), needle); at != LogIndex::NOT_FOUND;
+         at = log.find(at + 1, log.getBytes(), needle)) {
+        hits++;
+    }
+    report("LogIndex::find", hits, log.getBytes(), secondsSince(begin));
+
+    hits = 0;
+    std::string_view all(log.getData(), static_cast<size_t>(log.getBytes()));
+    begin = Clock::now();
+    for (size_t at = all.find(needle); at != std::string_view::npos; at = all.find(needle, at + 1)) {
+        hits++;
+    }
+    report("string_view::find", hits, log.getBytes(), secondsSince(begin));
+
+    begin = Clock::now();
+    size_t errors = log.countLevel(0, log.getLineCount(), LogIndex::LEVEL_ERROR);
+    std::cout << "countLevel(ERROR): " << errors << " lines in " << secondsSince(begin) * 1e3
+              << " ms\n";
+
+    size_t scalar = 0;
+    begin = Clock::now();
+    for (size_t line = 0; line < log.getLineCount(); ++line) {
+        scalar += log.level(line) == LogIndex::LEVEL_ERROR ? 1 : 0;
+    }
+    std::cout << "per-line level loop: " << scalar << " lines in " << secondsSince(begin) * 1e3
+              << " ms\n";
+    return 0;
+}
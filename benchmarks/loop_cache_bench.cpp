@@ -0,0 +1,78 @@
+// Per-listener cost of music: running the sequencer and synth live versus
+// reading a pre-rendered LoopCache loop, in 2048-frame blocks on one core,
+// plus how long the cache takes to build.
+//
+// Usage: bench_loop_cache [music directory] [seconds of audio per mode]
+
+#include "framework/LoopCache.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace devescape;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+const size_t BLOCK = 2048;
+const int SAMPLE_RATE = 44100;
+
+void report(const char* mode, size_t blocks, double elapsed) {
+    double perBlock = elapsed / blocks;
+    double blockSeconds = static_cast<double>(BLOCK) / SAMPLE_RATE;
+    std::cout << mode << ": " << perBlock * 1e6 << " us per block, "
+              << blockSeconds / perBlock << " listeners per core\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string directory = argc > 1 ? argv[1] : "./data/music";
+    double seconds = argc > 2 ? std::strtod(argv[2], nullptr) : 600.0;
+
+    Song songs[LoopCache::THEME_COUNT];
+    for (int theme = 0; theme < LoopCache::THEME_COUNT; ++theme) {
+        Sequencer::loadSong(directory + "/" + Sequencer::themeName(static_cast<ThemeType>(theme)) +
+                            ".pat", songs[theme]);
+    }
+    const Song& song = songs[static_cast<int>(ThemeType::CRISIS)];
+    if (!song.isLoaded()) {
+        std::cerr << "No crisis.pat in " << directory << std::endl;
+        return 1;
+    }
+
+    LoopCache cache;
+    auto begin = Clock::now();
+    size_t loops = cache.build(songs, SAMPLE_RATE);
+    double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+    std::cout << "cache: " << loops << " loops, " << cache.getBytes() / (1024.0 * 1024.0)
+              << " MiB, built in " << elapsed * 1e3 << " ms\n";
+
+    std::vector<float> buffer(BLOCK);
+    size_t blocks = static_cast<size_t>(seconds * SAMPLE_RATE / BLOCK) + 1;
+    float sink = 0.0f;
+
+    SynthEngine synth(SAMPLE_RATE);
+    Sequencer sequencer;
+    sequencer.setTier(3);
+    sequencer.play(&song, synth);
+    begin = Clock::now();
+    for (size_t b = 0; b < blocks; ++b) {
+        sequencer.render(synth, buffer.data(), BLOCK);
+        sink += buffer[b % BLOCK];
+    }
+    report("live sequencer", blocks, std::chrono::duration<double>(Clock::now() - begin).count());
+
+    LoopPlayer player;
+    player.play(cache.get(ThemeType::CRISIS, 3));
+    begin = Clock::now();
+    for (size_t b = 0; b < blocks; ++b) {
+        player.render(buffer.data(), BLOCK, 0.3f);
+        sink += buffer[b % BLOCK];
+    }
+    report("cached loop", blocks, std::chrono::duration<double>(Clock::now() - begin).count());
+
+    return sink == 12345.0f ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+// MetricStore: bytes per sample for dashboard-like series (gauges at one
+// decimal, counters, constants, one sample a second), append rate, full
+// decode rate, and the cost of the queries a live chart makes each frame:
+// a rollup of the last hour and a 60-bucket downsample of the whole day.
+//
+// Usage: bench_metric_store [series] [hours]
+
+#include "framework/MetricStore.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace devescape;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+double secondsSince(Clock::time_point begin) {
+    return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t seriesCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    int64_t hours = argc > 2 ? std::strtoll(argv[2], nullptr, 10) : 24;
+    int64_t samples = hours * 3600;
+    int64_t end = samples * 1000;
+
+    MetricStore store;
+    std::vector<MetricStore::SeriesId> series;
+    for (size_t i = 0; i < seriesCount; ++i) {
+        series.push_back(store.addSeries("services/service-" + std::to_string(i / 8) + "/metric-" +
+                                         std::to_string(i % 8)));
+    }
+
+    std::mt19937_64 random(42);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::vector<double> counters(seriesCount, 0.0);
+    auto begin = Clock::now();
+    for (int64_t second = 0; second < samples; ++second) {
+        for (size_t i = 0; i < seriesCount; ++i) {
+            double value;
+            switch (i % 4) {
+                case 0:  // latency-like gauge, one decimal
+                    value = std::round((120.0 + 15.0 * noise(random)) * 10.0) / 10.0;
+                    break;
+                case 1:  // request counter
+                    counters[i] += std::round(100.0 + 5.0 * noise(random));
+                    value = counters[i];
+                    break;
+                case 2:  // small integer gauge
+                    value = std::round(std::max(0.0, 12.0 + 3.0 * noise(random)));
+                    break;
+                default:  // configuration constant
+                    value = 20.0;
+                    break;
+            }
+            store.append(series[i], second * 1000, value);
+        }
+    }
+    double appendSeconds = secondsSince(begin);
+    uint64_t total = store.getSampleCount();
+    std::cout << seriesCount << " series x " << samples << " samples: "
+              << static_cast<double>(store.getBytes()) / static_cast<double>(total)
+              << " bytes/sample (16 raw), " << total / appendSeconds / 1e6 << " M appends/s\n";
+
+    std::vector<MetricSample> out;
+    out.reserve(static_cast<size_t>(samples));
+    begin = Clock::now();
+    for (MetricStore::SeriesId id : series) {
+        out.clear();
+        store.range(id, 0, end, out);
+    }
+    std::cout << "decode everything: " << total / secondsSince(begin) / 1e6 << " M samples/s\n";
+
+    const int rounds = 100;
+    double sink = 0.0;
+    begin = Clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (MetricStore::SeriesId id : series) {
+            sink += store.rollup(id, end - 3600 * 1000 + 500, end).mean();
+        }
+    }
+    std::cout << "rollup of the last hour: "
+              << secondsSince(begin) / (rounds * seriesCount) * 1e6 << " us/series\n";
+
+    MetricSummary buckets[60];
+    begin = Clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (MetricStore::SeriesId id : series) {
+            store.downsample(id, 0, end, 60, buckets);
+            sink += buckets[59].max;
+        }
+    }
+    std::cout << "60 buckets over " << hours << " h: "
+              << secondsSince(begin) / (rounds * seriesCount) * 1e6 << " us/series\n";
+    return sink == 0.0 ? 1 : 0;
+}
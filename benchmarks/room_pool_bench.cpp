@@ -0,0 +1,106 @@
+// Session-start latency under a burst of simultaneous starts, with and
+// without the PluginManager room pool.
+//
+// Usage: bench_room_pool <plugin directory> [room name] [burst size] [--sandbox]
+
+#include "framework/PluginManager.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace devescape;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Stats {
+    double meanUs;
+    double p50Us;
+    double p99Us;
+    double totalMs;
+};
+
+Stats summarize(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (double s : samples) total += s;
+    return {total / samples.size(), samples[samples.size() / 2], samples[samples.size() * 99 / 100],
+            total / 1000.0};
+}
+
+void report(const char* label, const Stats& stats) {
+    std::cout << label << ": mean " << stats.meanUs << " us, p50 " << stats.p50Us << " us, p99 "
+              << stats.p99Us << " us, burst " << stats.totalMs << " ms\n";
+}
+
+// Starts `burst` sessions back to back, then ends them all
+void runBurst(PluginManager& manager, const std::string& roomName, const FrameworkContext& context,
+              size_t burst, const char* label) {
+    std::vector<IEscapeRoomV2*> rooms;
+    std::vector<double> starts;
+    std::vector<double> ends;
+    rooms.reserve(burst);
+
+    for (size_t i = 0; i < burst; ++i) {
+        auto begin = Clock::now();
+        IEscapeRoomV2* room = manager.acquireRoom(roomName, context);
+        starts.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+        if (!room) {
+            std::cerr << "failed to start session " << i << "\n";
+            break;
+        }
+        rooms.push_back(room);
+    }
+
+    for (IEscapeRoomV2* room : rooms) {
+        room->processInput("help");
+        auto begin = Clock::now();
+        manager.releaseRoom(room);
+        ends.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+    }
+
+    if (starts.empty() || ends.empty()) {
+        return;
+    }
+    std::cout << label << "\n";
+    report("  session start", summarize(starts));
+    report("  session end  ", summarize(ends));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <plugin directory> [room name] [burst size] [--sandbox]\n";
+        return 1;
+    }
+    std::string roomName = argc > 2 ? argv[2] : "Production Incident";
+    size_t burst = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000;
+    bool sandbox = argc > 4 && std::strcmp(argv[4], "--sandbox") == 0;
+
+    PluginManager manager(argv[1]);
+    manager.scanForPlugins();
+    if (sandbox && !manager.setSandboxEnabled(true)) {
+        return 1;
+    }
+
+    FrameworkContext context;
+
+    manager.setRoomPoolSize(0);
+    runBurst(manager, roomName, context, burst, "no pool (create + initialize, destroy)");
+
+    manager.setRoomPoolSize(burst);
+    auto begin = Clock::now();
+    size_t warmed = manager.prewarmRooms(roomName, context, burst);
+    std::cout << "prewarmed " << warmed << " rooms in "
+              << std::chrono::duration<double, std::milli>(Clock::now() - begin).count() << " ms\n";
+    runBurst(manager, roomName, context, burst, "pool, prewarmed");
+    runBurst(manager, roomName, context, burst, "pool, reused (reset in acquireRoom)");
+
+    manager.setRoomPoolSize(0);
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Per-call overhead of a sandboxed room versus calling the plugin in-process.
+//
+// Usage: bench_sandbox_call <path/to/plugin.so> [iterations]
+
+#include "framework/SandboxedRoom.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+using namespace devescape;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Stats {
+    double meanUs;
+    double p50Us;
+    double p99Us;
+};
+
+template <typename Fn>
+Stats measure(int iterations, Fn&& fn) {
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (int i = 0; i < iterations; ++i) {
+        auto start = Clock::now();
+        fn();
+        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (double s : samples) total += s;
+    return {total / iterations, samples[iterations / 2], samples[iterations * 99 / 100]};
+}
+
+void report(const char* label, const Stats& stats) {
+    std::cout << label << ": mean " << stats.meanUs << " us, p50 " << stats.p50Us
+              << " us, p99 " << stats.p99Us << " us\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    std::cerr << "The sandbox is POSIX only\n";
+    return 1;
+#else
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <plugin.so> [iterations]\n";
+        return 1;
+    }
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 100000;
+
+    void* handle = dlopen(argv[1], RTLD_NOW);
+    if (!handle) {
+        std::cerr << dlerror() << "\n";
+        return 1;
+    }
+    auto createRoom = reinterpret_cast<SandboxedRoom::CreateRoomFunc>(dlsym(handle, "createRoom"));
+    auto destroyRoom = reinterpret_cast<SandboxedRoom::DestroyRoomFunc>(dlsym(handle, "destroyRoom"));
+    if (!createRoom || !destroyRoom) {
+        std::cerr << "plugin is missing createRoom/destroyRoom\n";
+        return 1;
+    }
+    typedef uint32_t (*GetVersionFunc)();
+    auto getVersion = reinterpret_cast<GetVersionFunc>(dlsym(handle, "getPluginVersion"));
+    uint32_t abiVersion = getVersion ? pluginAbiVersion(getVersion()) : PLUGIN_ABI_NONE;
+    if (abiVersion == PLUGIN_ABI_NONE || abiVersion > PLUGIN_ABI_CURRENT) {
+        std::cerr << "plugin ABI v" << abiVersion << " is not supported\n";
+        return 1;
+    }
+
+    FrameworkContext context;
+
+    IEscapeRoom* direct = createRoom();
+    direct->initialize(context);
+    report("in-process update()", measure(iterations, [&] { direct->update(0.016f); }));
+    destroyRoom(direct);
+
+    SandboxedRoom sandboxed(argv[1], abiVersion);
+    sandboxed.initialize(context);
+    report("sandboxed update() ", measure(iterations, [&] { sandboxed.update(0.016f); }));
+    report("sandboxed render() ", measure(iterations / 10, [&] {
+        TerminalRenderer renderer;
+        sandboxed.render(renderer);
+    }));
+    report("sandboxed processInput()", measure(iterations / 100, [&] { sandboxed.processInput("help"); }));
+
+    std::vector<std::string> batch(16, "help");
+    std::pmr::vector<ProcessResult> results;
+    report("sandboxed processInputs(16)", measure(iterations / 100, [&] {
+        results.clear();
+        sandboxed.processInputs(Span<const std::string>(batch), results);
+    }));
+
+    std::cout << "child restarts: " << sandboxed.getRestartCount() << "\n";
+    return 0;
+#endif
+}
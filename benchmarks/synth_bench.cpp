@@ -0,0 +1,98 @@
+// SynthEngine throughput on one core: all four voices rendering 2048-frame
+// blocks (the SDL buffer size) with each kernel table the CPU runs, plus
+// the largest difference from the scalar kernels.
+//
+// Usage: bench_synth [seconds of audio per kernel table]
+
+#include "framework/SynthEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace devescape;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+const size_t BLOCK = 2048;
+const int SAMPLE_RATE = 44100;
+
+void setUpVoices(SynthEngine& synth) {
+    const float frequencies[] = {493.88f, 415.30f, 293.66f, 44100.0f};
+    const float duties[] = {0.125f, 0.25f, 0.5f, 0.5f};
+    for (int i = 0; i < SynthEngine::VOICE_COUNT; ++i) {
+        SynthVoice& voice = synth.voice(i);
+        voice.enabled = true;
+        voice.frequency = frequencies[i];
+        voice.duty = duties[i];
+        voice.volume = 0.25f;
+    }
+}
+
+// Max abs difference over a few seconds of audio
+float compare(const synth::KernelTable& kernels) {
+    SynthEngine reference(SAMPLE_RATE, synth::scalarKernels());
+    SynthEngine candidate(SAMPLE_RATE, kernels);
+    setUpVoices(reference);
+    setUpVoices(candidate);
+
+    std::vector<float> expected(BLOCK + 3);
+    std::vector<float> actual(BLOCK + 3);
+    float worst = 0.0f;
+    for (int block = 0; block < 100; ++block) {
+        // Odd block sizes exercise the scalar tails too
+        size_t frames = BLOCK + block % 4;
+        reference.render(expected.data(), frames);
+        candidate.render(actual.data(), frames);
+        for (size_t i = 0; i < frames; ++i) {
+            worst = std::max(worst, std::fabs(expected[i] - actual[i]));
+        }
+    }
+    return worst;
+}
+
+void run(const synth::KernelTable& kernels, double seconds) {
+    SynthEngine synth(SAMPLE_RATE, kernels);
+    setUpVoices(synth);
+
+    std::vector<float> buffer(BLOCK);
+    size_t blocks = static_cast<size_t>(seconds * SAMPLE_RATE / BLOCK) + 1;
+
+    auto begin = Clock::now();
+    float sink = 0.0f;
+    for (size_t b = 0; b < blocks; ++b) {
+        synth.render(buffer.data(), BLOCK);
+        sink += buffer[b % BLOCK];
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    double samples = static_cast<double>(blocks * BLOCK);
+    std::cout << kernels.name << ":\n"
+              << "  " << samples / elapsed / 1e6 << " M output samples/sec/core ("
+              << samples * SynthEngine::VOICE_COUNT / elapsed / 1e6 << " M voice samples/sec), "
+              << samples / elapsed / SAMPLE_RATE << "x real time\n"
+              << "  " << elapsed * 1e6 / blocks << " us per " << BLOCK << "-frame block"
+              << (sink == 12345.0f ? " " : "") << "\n";
+    if (&kernels != &synth::scalarKernels()) {
+        std::cout << "  max difference from scalar: " << compare(kernels) << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? std::strtod(argv[1], nullptr) : 600.0;
+
+    std::cout << "dispatch picks: " << synth::bestKernels().name << "\n";
+    run(synth::scalarKernels(), seconds);
+    if (synth::sseKernels()) {
+        run(*synth::sseKernels(), seconds);
+    }
+    if (synth::avxKernels() && synth::cpuSupportsAvx()) {
+        run(*synth::avxKernels(), seconds);
+    }
+    return 0;
+}
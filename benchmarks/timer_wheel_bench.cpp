@@ -0,0 +1,61 @@
+// TimerService cost with a large number of pending timers: schedule and
+// cancel per timer, and advance() per 60 FPS frame while none are due.
+//
+// Usage: bench_timer_wheel [pending timers]
+
+#include "framework/TimerService.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace devescape;
+using Clock = TimerService::Clock;
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    TimerService timers;
+    Clock::time_point start = Clock::now();
+    std::mt19937_64 rng(1);
+    std::uniform_int_distribution<int> delaySeconds(60, 3600);
+
+    size_t fired = 0;
+    std::vector<TimerService::TimerId> ids(count);
+
+    auto begin = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        ids[i] = timers.scheduleAt(start + std::chrono::seconds(delaySeconds(rng)), [&fired]() { fired++; });
+    }
+    double scheduleNs = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / count;
+
+    // A minute of frames: nothing is due yet, so each advance should only
+    // look at the ticks that passed
+    const int frames = 60 * 60;
+    Clock::time_point now = start;
+    begin = Clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        now += std::chrono::microseconds(16667);
+        timers.advanceTo(now);
+    }
+    double frameNs = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / frames;
+
+    begin = Clock::now();
+    for (size_t i = 0; i < count; i += 2) {
+        timers.cancel(ids[i]);
+    }
+    double cancelNs = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / ((count + 1) / 2);
+
+    // Run out the clock on the other half
+    begin = Clock::now();
+    timers.advanceTo(start + std::chrono::seconds(3601));
+    double drainMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+    std::cout << "pending timers:      " << count << "\n"
+              << "schedule:            " << scheduleNs << " ns/timer\n"
+              << "advance, idle frame: " << frameNs << " ns/frame\n"
+              << "cancel:              " << cancelNs << " ns/timer\n"
+              << "fire remaining:      " << drainMs << " ms for " << fired << " timers\n";
+    return 0;
+}
@@ -0,0 +1,30 @@
+# Production Incident's log: two and a half hours of payment traffic in
+# which the database's connection pool runs dry at 10:02. The room writes
+# production_incident.log from this on first use; see LogGenerator.h for
+# the format.
+
+seed 20240315
+date 2024-03-15
+start 09:00:00
+spacing 300
+lines 30000000
+incident 10:02:00
+
+# Background noise, before and during
+always 6 ERROR "[auth-service] Token refresh failed for client {hex:4}"
+always 4 ERROR "[cdn] Upstream returned 502 for /static/app.js"
+always 260 DEBUG "[cache] hit key=session:{hex:6}"
+always 150 INFO "[queue] Published payment.created offset={int:1000000-9999999}"
+always 250 INFO "[checkout-web] GET /cart 200 {int:2-103}ms"
+
+# Normal payment traffic
+before 30 WARN "[payment-api] Slow request POST /v1/payments {int:808-1207}ms"
+before 300 INFO "[payment-api] POST /v1/payments 200 {int:8-407}ms request_id={hex:8}"
+
+# The incident: timeouts to the database, an exhausted pool, failing payments
+during 60 ERROR "[payment-api] Connection timeout: db-prod-01 after 5000ms request_id={hex:8}"
+during 30 ERROR "[db-pool] Connection pool exhausted: 20/20 active, {int:700-899} waiting"
+during 20 CRITICAL "[payment-api] POST /v1/payments 500 request_id={hex:8}"
+during 8 WARN "[circuit-breaker] Circuit breaker opened for database db-prod-01"
+during 30 WARN "[payment-api] Slow request POST /v1/payments {int:2080-6070}ms"
+during 180 INFO "[payment-api] POST /v1/payments 200 {int:48-2442}ms request_id={hex:8}"
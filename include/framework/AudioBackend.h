@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * Where AudioManager's samples go. A backend pulls mono float blocks from
+ * a render callback on a thread of its own, from start() until close():
+ *
+ *   sdl           the default sound device (initializes SDL audio itself)
+ *   null          renders in real time and discards, so timing behaves as
+ *                 with a device; null:fast renders as fast as the CPU can
+ *   wav:<file>    renders in real time into a ring buffer that a
+ *                 background thread writes out as 16-bit PCM
+ *
+ * Only the thread that opened a backend calls its methods.
+ */
+class DEVESCAPE_API AudioBackend {
+public:
+    using RenderCallback = void (*)(void* userdata, float* buffer, int frameCount);
+
+    virtual ~AudioBackend() = default;
+
+    virtual const char* getName() const = 0;
+
+    // Prepares the output; the granted rate and block size may differ
+    virtual bool open(int sampleRate, int blockFrames, RenderCallback render, void* userdata) = 0;
+    // Starts pulling blocks from render
+    virtual void start() = 0;
+    // Stops pulling (render has returned for good when this does) and
+    // releases the output
+    virtual void close() = 0;
+
+    virtual int getSampleRate() const = 0;
+    virtual int getBlockFrames() const = 0;
+    // Whether the block size is a device's output latency, so that it is
+    // worth reopening to resize; a file or discarded output has none
+    virtual bool hasDeviceLatency() const = 0;
+
+    // Parses "sdl", "null", "null:fast" or "wav:<file>" (e.g. from --audio=);
+    // nullptr for anything else
+    static std::unique_ptr<AudioBackend> create(const std::string& spec);
+};
+
+DEVESCAPE_API std::unique_ptr<AudioBackend> createSdlAudioBackend();
+
+} // namespace devescape
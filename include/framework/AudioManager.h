@@ -1,9 +1,17 @@
 #pragma once
 
+#include "framework/AudioBackend.h"
+#include "framework/AudioTiming.h"
 #include "framework/DataTypes.h"
-#include <SDL2/SDL.h>
+#include "framework/LoopCache.h"
+#include "framework/NoteStream.h"
+#include "framework/Sequencer.h"
+#include "framework/SfxMixer.h"
+#include "framework/SpscQueue.h"
+#include "framework/SynthEngine.h"
+#include <memory>
 #include <string>
-#include <map>
+#include <string_view>
 #include <vector>
 
 #if defined(_WIN32)
@@ -18,14 +26,71 @@
 
 namespace devescape {
 
+/**
+ * NES-style 4-channel synthesizer. Once the output is open the channel
+ * state belongs to the backend's render thread (see AudioBackend.h): the
+ * public calls only queue commands, which the callback applies at the start
+ * of its next block, so the callback never waits on the game thread.
+ *
+ * Themes play from pattern files (<theme>.pat in the music directory, see
+ * Sequencer.h) loaded by initialize(); a theme without one falls back to a
+ * static chord. Tension picks the tier whose tempo and arrangement play.
+ *
+ * Once the output is open every song x tier is pre-rendered into a
+ * LoopCache, and the callback plays those buffers (crossfading on theme and
+ * tier changes) instead of running the sequencer; the chord fallback still
+ * comes from the synth.
+ *
+ * Sound effects play on SfxMixer's own voices over the music, from the
+ * effect file loaded by initialize().
+ *
+ * The "events" output synthesizes nothing: the callback only advances the
+ * sequencer and queues what it does (notes, tempo, theme, volume, effect
+ * triggers) as NoteEvents for readNoteEvents(), for a remote client to play
+ * with NoteStreamPlayer. There is no loop cache in that mode.
+ *
+ * Every callback is timed into AudioTimingStats. Normally the output runs
+ * 2048-frame blocks; in low-latency mode it starts small and adaptLatency()
+ * reopens it with a larger block after underruns, or a smaller one while
+ * the callback leaves plenty of headroom. Only a sound device is resized:
+ * reopening would restart a WAV file, and the null output has no latency.
+ */
 class DEVESCAPE_API AudioManager {
 public:
     AudioManager();
     ~AudioManager();
 
+    // Opens the output: the one chosen with setOutput(), else the sound
+    // device, falling back to the null sink when there is none
     bool initialize();
     void cleanup();
 
+    // "sdl", "null", "null:fast", "wav:<file>" or "events"; call before
+    // initialize()
+    bool setOutput(const std::string& spec);
+    const char* getOutputName() const { return backend_ ? backend_->getName() : "none"; }
+
+    // Small adaptive blocks instead of 2048 frames; call before initialize()
+    void setLowLatency(bool enabled) { lowLatency_ = enabled; }
+    // Game thread, e.g. once a frame; cheap unless it resizes the buffer,
+    // which it considers at most once a second. True when it did.
+    bool adaptLatency();
+    AudioTimingSnapshot getTimingStats() const { return timing_.snapshot(); }
+
+    // Where initialize() looks for pattern files (default ./data/music)
+    void setMusicDirectory(const std::string& directory) { musicDirectory_ = directory; }
+
+    // Pre-rendered loops (on by default, in memory); with a directory they
+    // are kept there as mapped files for later runs. Call before initialize().
+    void setLoopCache(bool enabled, const std::string& directory = "") {
+        loopCacheEnabled_ = enabled;
+        loopCacheDirectory_ = directory;
+    }
+    const LoopCache& getLoopCache() const { return loopCache_; }
+
+    // Effect definitions for initialize() (default ./data/sfx/effects.sfx)
+    void setEffectsFile(const std::string& path) { effectsFile_ = path; }
+
     void playTheme(const std::string& themeName, ThemeType type);
     void stopMusic();
     void setMusicVolume(float volume);
@@ -33,34 +98,71 @@ public:
     void updateTensionLevel(float percentTimeRemaining);
     void updateForPuzzleType(PuzzleType type);
 
-    void playSoundEffect(const std::string& effectName);
+    // Named effect from the effect file; wait-free and allocation-free, and
+    // silent for unknown names
+    void playSoundEffect(std::string_view effectName);
+
+    // Game thread, with the "events" output: encodes the events queued since
+    // the last call into writer and returns how many. Call it every frame or
+    // so; events past the queue's 4096 are dropped.
+    size_t readNoteEvents(NoteStreamWriter& writer);
 
 private:
-    struct Channel {
-        enum Type { SQUARE1, SQUARE2, TRIANGLE, NOISE };
+    // Control change for the audio thread; plain data so it can be queued
+    struct Command {
+        enum Type { PLAY_THEME, STOP_MUSIC, SET_VOLUME, SET_TIER };
         Type type;
-        float frequency;
-        float duty_cycle;
-        int waveform_phase;
-        float volume;
-        bool enabled;
+        ThemeType theme;
+        float value;
     };
 
-    SDL_AudioDeviceID audioDevice_;
-    SDL_AudioSpec audioSpec_;
-    Channel channels_[4];
-    float masterVolume_;
+    std::unique_ptr<AudioBackend> backend_;
+    bool outputChosen_;  // setOutput() was called
+    bool streaming_;     // the backend's thread owns the channel state
+    bool eventOutput_;   // "events": queue NoteEvents instead of rendering
+
+    AudioTimingStats timing_;
+    bool lowLatency_;
+    int minimumBlock_;   // low-latency floor, raised by underruns
+    int quietChecks_;    // adaptLatency() checks since the last resize or underrun
+    uint64_t underrunsSeen_;
+    AudioTimingStats::Clock::time_point nextAdapt_;
+    SynthEngine synth_;  // voices 0-1 square, 2 triangle, 3 noise
+    Sequencer sequencer_;
     int sampleRate_;
 
-    ThemeType currentTheme_;
-    float tensionLevel_;
+    std::string musicDirectory_;
+    Song songs_[LoopCache::THEME_COUNT];  // loaded before the device opens
+
+    bool loopCacheEnabled_;
+    std::string loopCacheDirectory_;
+    LoopCache loopCache_;      // built before the callback starts
+    LoopPlayer loopPlayer_;    // audio thread
+    ThemeType playingTheme_;   // audio thread
+    std::vector<float> synthBuffer_;  // synth output mixed over a fading loop
+
+    std::string effectsFile_;
+    SfxMixer sfx_;
+
+    ThemeType currentTheme_;  // game thread
+    float tensionLevel_;      // game thread
+
+    SpscQueue<Command, 256> commands_;
+    SpscQueue<NoteEvent, 4096> noteEvents_;  // audio thread to readNoteEvents()
+
+    void submit(const Command& command);
+    void applyCommand(const Command& command);
 
-    static void audioCallback(void* userdata, uint8_t* stream, int len);
+    static void renderCallback(void* userdata, float* buffer, int frameCount);
+    static void noteEventCallback(void* userdata, const NoteEvent& event);
+    void emitNoteEvent(NoteEventType type, int voice, uint8_t note, uint8_t volume,
+                       uint32_t value);
+    void emitChordEvents();
     void generateAudioFrame(float* buffer, int frameCount);
-    float generateSquareWave(const Channel& ch);
-    float generateTriangleWave(const Channel& ch);
-    float generateNoiseWave(const Channel& ch);
 
+    void loadMusic();
+    void configureOutput();
+    bool reopenOutput(int blockFrames);
     void loadThemeParameters(ThemeType theme);
 };
 
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+// Microsecond histogram with four buckets per power of two (values within
+// 25% of each other share a bucket), from 0 to about 30 s
+struct DEVESCAPE_API TimingHistogram {
+    static constexpr int BUCKETS = 100;
+
+    uint64_t counts[BUCKETS] = {};
+    uint64_t total = 0;
+
+    static int bucketFor(uint64_t micros);
+    static uint64_t bucketStart(int bucket);
+
+    // Upper edge of the bucket holding the p-th fraction (0-1), in us
+    uint64_t percentile(double p) const;
+};
+
+struct DEVESCAPE_API AudioTimingSnapshot {
+    int sampleRate = 0;
+    int blockFrames = 0;
+    uint64_t callbacks = 0;
+    uint64_t underruns = 0;       // estimated, see AudioTimingStats
+    uint64_t maxIntervalMicros = 0;
+    uint64_t maxGenerateMicros = 0;
+    TimingHistogram interval;     // between callback starts
+    TimingHistogram jitter;       // |interval - block duration|
+    TimingHistogram generate;     // time inside the callback
+
+    double blockMicros() const;
+    // Share of the block duration left after the p99 callback (1 = idle)
+    double headroom() const;
+
+    void print(std::ostream& out) const;
+};
+
+/**
+ * Timing of the audio callback, written by the audio thread and readable
+ * from any thread. Every counter is a relaxed atomic, so recording is a
+ * handful of uncontended increments and a snapshot may straddle a callback
+ * (counts can be off by one block, never torn).
+ *
+ * Underruns are estimated from the callback times alone: the device is
+ * modelled as a buffer that each callback tops up by one block and that
+ * drains in real time. When it would have run dry before the callback, the
+ * callback counts as an underrun. This catches late callbacks and slow
+ * renders alike without help from the backend.
+ */
+class DEVESCAPE_API AudioTimingStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    AudioTimingStats();
+
+    AudioTimingStats(const AudioTimingStats&) = delete;
+    AudioTimingStats& operator=(const AudioTimingStats&) = delete;
+
+    // Starts a new measurement; not while callbacks are running
+    void reset(int sampleRate, int blockFrames);
+
+    // Audio thread, once per callback
+    void record(Clock::time_point start, Clock::time_point end, int frameCount);
+
+    AudioTimingSnapshot snapshot() const;
+
+private:
+    struct AtomicHistogram {
+        std::atomic<uint64_t> counts[TimingHistogram::BUCKETS];
+        void clear();
+        void add(uint64_t micros);
+        void copyTo(TimingHistogram& histogram) const;
+    };
+
+    int sampleRate_;
+    int blockFrames_;
+    std::atomic<uint64_t> callbacks_;
+    std::atomic<uint64_t> underruns_;
+    std::atomic<uint64_t> maxInterval_;
+    std::atomic<uint64_t> maxGenerate_;
+    AtomicHistogram interval_;
+    AtomicHistogram jitter_;
+    AtomicHistogram generate_;
+
+    // Audio thread only
+    Clock::time_point lastStart_;
+    double bufferedMicros_;  // modelled audio left in the device
+};
+
+} // namespace devescape
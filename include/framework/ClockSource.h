@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * Where the framework's notion of "now" comes from.
+ *
+ * REAL follows the monotonic clock, SCALED runs it faster or slower by a
+ * factor, and VIRTUAL only moves when advance() is called, so a session can
+ * be driven frame by frame as fast as the CPU allows. Switching modes keeps
+ * now() continuous, so timers already scheduled against the clock keep
+ * their order.
+ *
+ * The countdown, the timer service, autosave and event log timestamps all
+ * read the shared() clock unless handed another one. The game loop freezes
+ * it for the length of each frame, so everything stamped during a frame
+ * sees the same instant.
+ */
+class DEVESCAPE_API ClockSource {
+public:
+    using Clock = std::chrono::steady_clock;
+    using time_point = Clock::time_point;
+    using duration = Clock::duration;
+
+    enum class Mode {
+        REAL,
+        SCALED,
+        VIRTUAL
+    };
+
+    ClockSource();
+
+    ClockSource(const ClockSource&) = delete;
+    ClockSource& operator=(const ClockSource&) = delete;
+
+    // Shared by every session in the process
+    static ClockSource& shared();
+
+    // Monotonic time on this clock's timeline
+    time_point now() const;
+    // Wall-clock time for logs and checkpoints; moves with now()
+    std::chrono::system_clock::time_point wallNow() const;
+
+    void setReal();
+    void setScaled(double scale);  // scale > 0; 1000 runs a 45 minute session in 2.7 s
+    void setVirtual();
+    // Virtual, with wallNow() reading `wall` from here on (replays)
+    void setVirtualAt(std::chrono::system_clock::time_point wall);
+
+    // Holds now() at its current value until unfreeze(); time keeps passing
+    // underneath and shows up again once unfrozen
+    void freeze();
+    void unfreeze();
+
+    // Moves a virtual clock forward; ignored in the other modes
+    void advance(duration amount);
+
+    Mode getMode() const;
+    double getScale() const;
+
+    // Parses "real", "virtual" or "scaled:<factor>" (e.g. from --clock=)
+    bool configure(const std::string& spec);
+
+private:
+    Mode mode_;
+    double scale_;
+    time_point base_;           // now() at the last mode change
+    time_point realAnchor_;     // Clock::now() at the last mode change
+    time_point wallOrigin_;     // now() when wallOriginSystem_ was taken
+    std::chrono::system_clock::time_point wallOriginSystem_;
+    bool frozen_;
+    time_point frozenAt_;
+
+    mutable std::mutex mutex_;
+
+    time_point nowLocked() const;
+    void rebase(Mode mode, double scale);
+};
+
+} // namespace devescape
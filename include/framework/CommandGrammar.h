@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+struct DEVESCAPE_API CommandArgument {
+    std::string_view text;  // the token as typed
+    int64_t number = 0;     // its value, for <int> slots
+};
+
+/**
+ * Result of matching one input line. Views point into the input, which
+ * must outlive the match.
+ */
+struct DEVESCAPE_API CommandMatch {
+    static constexpr size_t MAX_ARGUMENTS = 8;
+
+    int command = -1;              // id given to CommandGrammar::add, or NO_MATCH
+    size_t argumentCount = 0;      // <int> and <word> slots, in pattern order
+    CommandArgument arguments[MAX_ARGUMENTS];
+    std::string_view rest;         // what a <rest> slot took, trimmed
+
+    std::string_view text(size_t index) const { return arguments[index].text; }
+    int64_t number(size_t index) const { return arguments[index].number; }
+};
+
+/**
+ * Command grammar for room input, declared once and matched without
+ * allocating.
+ *
+ * A pattern is a list of whitespace separated words: literals, <int>
+ * (a decimal 64-bit integer, out of range values do not match), <word>
+ * (any one token) and, last only, <rest> (everything that follows, possibly
+ * nothing). For example:
+ *
+ *     grammar.add("filter logs <word>", FILTER);
+ *     grammar.add("submit solution <int>", SUBMIT);
+ *     grammar.add("navigate <rest>", NAVIGATE);
+ *
+ * Patterns compile into a token automaton: literal transitions sit in one
+ * vector sorted by (state, token hash), so each input token costs a hash
+ * and a binary search and matching is linear in the input length. There
+ * is no backtracking - at each position a literal beats <int>, which beats
+ * <word> - except that when the walk dead-ends the deepest <rest> passed
+ * on the way matches instead.
+ */
+class DEVESCAPE_API CommandGrammar {
+public:
+    static constexpr int NO_MATCH = -1;
+
+    CommandGrammar();
+
+    // False (and reported) for a malformed pattern or one already bound
+    // to a different command
+    bool add(std::string_view pattern, int command);
+    void clear();
+
+    // Fills match and returns its command, or NO_MATCH
+    int match(std::string_view input, CommandMatch& match) const;
+
+    size_t size() const { return patterns_; }
+
+private:
+    static constexpr uint32_t NIL = 0xFFFFFFFFu;
+
+    struct State {
+        uint32_t numberNext = NIL;
+        uint32_t wordNext = NIL;
+        int command = NO_MATCH;      // input ending here
+        int restCommand = NO_MATCH;  // <rest> from here
+    };
+
+    struct Edge {
+        uint32_t from;
+        uint32_t hash;
+        uint32_t offset;  // literal text in words_
+        uint32_t length;
+        uint32_t to;
+    };
+
+    std::vector<State> states_;  // states_[0] is the start
+    std::vector<Edge> edges_;    // sorted by (from, hash)
+    std::string words_;
+    size_t patterns_;
+
+    uint32_t literal(uint32_t state, std::string_view token, uint32_t hash) const;
+    uint32_t addLiteral(uint32_t state, std::string_view token);
+};
+
+/**
+ * CommandGrammar bound to member function handlers of Owner. Handlers
+ * take the match and an output (a ProcessResult, say) to fill in.
+ */
+template <typename Owner, typename Output>
+class CommandDispatcher {
+public:
+    using Handler = void (Owner::*)(const CommandMatch&, Output&);
+
+    bool add(std::string_view pattern, Handler handler) {
+        if (!grammar_.add(pattern, static_cast<int>(handlers_.size()))) {
+            return false;
+        }
+        handlers_.push_back(handler);
+        return true;
+    }
+
+    // Runs for input nothing matches
+    void setFallback(Handler handler) { fallback_ = handler; }
+
+    // Runs the matching handler or the fallback; false if neither did
+    bool dispatch(Owner& owner, std::string_view input, Output& output) const {
+        CommandMatch match;
+        int command = grammar_.match(input, match);
+        Handler handler = command == CommandGrammar::NO_MATCH ? fallback_ : handlers_[command];
+        if (!handler) {
+            return false;
+        }
+        (owner.*handler)(match, output);
+        return true;
+    }
+
+    const CommandGrammar& getGrammar() const { return grammar_; }
+
+private:
+    CommandGrammar grammar_;
+    std::vector<Handler> handlers_;
+    Handler fallback_ = nullptr;
+};
+
+} // namespace devescape
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+struct DEVESCAPE_API Completion {
+    std::string extension;                // text every match continues with
+    std::vector<std::string> candidates;  // distinct next words, in order, when ambiguous
+    size_t matches = 0;                   // commands that start with the prefix
+};
+
+/**
+ * Character trie of a room's command vocabulary, used for tab completion.
+ * Rooms fill it through the optional publishCommands export (see
+ * StaticPluginRegistry.h).
+ *
+ * Nodes live in one vector with sorted first-child/next-sibling links, so
+ * a lookup touches only the nodes along the prefix and completing against
+ * thousands of commands takes microseconds. Candidates stop at the next
+ * word boundary, so "navigate metrics " offers the next path segment
+ * rather than every full path below it.
+ */
+class DEVESCAPE_API CommandTrie {
+public:
+    CommandTrie();
+
+    void insert(std::string_view command);
+    bool contains(std::string_view command) const;
+    void clear();
+
+    size_t size() const { return nodes_[0].entries; }
+    bool empty() const { return size() == 0; }
+
+    // At most maxCandidates candidates are listed; matches counts them all
+    Completion complete(std::string_view prefix, size_t maxCandidates = 32) const;
+
+private:
+    static constexpr uint32_t NIL = 0xFFFFFFFFu;
+
+    struct Node {
+        uint32_t firstChild = NIL;
+        uint32_t nextSibling = NIL;
+        uint32_t entries = 0;  // commands ending at or below this node
+        char label = 0;
+        bool terminal = false;
+    };
+
+    std::vector<Node> nodes_;  // nodes_[0] is the root
+
+    uint32_t find(std::string_view prefix) const;
+    uint32_t child(uint32_t node, char label) const;
+};
+
+} // namespace devescape
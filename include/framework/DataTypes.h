@@ -4,6 +4,7 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <memory_resource>
 #include <chrono>
 
 #if defined(_WIN32)
@@ -18,6 +19,10 @@
 
 namespace devescape {
 
+// The layouts of the structs below are part of the plugin ABI: rooms build
+// and return them across the plugin boundary. Changing one means a new
+// PLUGIN_ABI_* version (see IEscapeRoomV2.h).
+
 class TerminalRenderer;
 class AudioManager;
 class StateManager;
@@ -58,32 +63,71 @@ enum class ThemeType {
     FAILURE
 };
 
+// Session-scoped types are allocator-aware so a room can place them in the
+// per-session arena handed out through FrameworkContext::memoryResource.
 struct DEVESCAPE_API ProcessResult {
-    std::string outputText;
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    ProcessResult() = default;
+    explicit ProcessResult(const allocator_type& alloc) : outputText(alloc) {}
+    ProcessResult(const ProcessResult& other, const allocator_type& alloc);
+    ProcessResult(ProcessResult&& other, const allocator_type& alloc);
+    ProcessResult(const ProcessResult&) = default;
+    ProcessResult(ProcessResult&&) = default;
+    ProcessResult& operator=(const ProcessResult&) = default;
+    ProcessResult& operator=(ProcessResult&&) = default;
+
+    std::pmr::string outputText;
     bool sessionEnded = false;
     bool success = false;
     bool invalidCommand = false;
 };
 
 struct DEVESCAPE_API PuzzleState {
-    std::string id;
-    std::string title;
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    PuzzleState() = default;
+    explicit PuzzleState(const allocator_type& alloc)
+        : id(alloc), title(alloc), playerAnswer(alloc), correctAnswer(alloc) {}
+    PuzzleState(const PuzzleState& other, const allocator_type& alloc);
+    PuzzleState(PuzzleState&& other, const allocator_type& alloc);
+    PuzzleState(const PuzzleState&) = default;
+    PuzzleState(PuzzleState&&) = default;
+    PuzzleState& operator=(const PuzzleState&) = default;
+    PuzzleState& operator=(PuzzleState&&) = default;
+
+    std::pmr::string id;
+    std::pmr::string title;
     bool solved = false;
     int completionPercent = 0;
     int hintsUsed = 0;
     int wrongAttempts = 0;
     int timeSpentSeconds = 0;
-    std::string playerAnswer;
-    std::string correctAnswer;
+    std::pmr::string playerAnswer;
+    std::pmr::string correctAnswer;
     bool locked = true;
 };
 
 struct DEVESCAPE_API GameState {
-    std::map<std::string, PuzzleState> puzzles;
-    std::map<std::string, std::string> inventory;
-    std::vector<std::string> discoveredClues;
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    GameState() = default;
+    explicit GameState(const allocator_type& alloc)
+        : puzzles(alloc), inventory(alloc), discoveredClues(alloc), eventLog(alloc) {}
+    GameState(const GameState& other, const allocator_type& alloc);
+    GameState(GameState&& other, const allocator_type& alloc);
+    GameState(const GameState&) = default;
+    GameState(GameState&&) = default;
+    GameState& operator=(const GameState&) = default;
+    GameState& operator=(GameState&&) = default;
+
+    allocator_type get_allocator() const { return eventLog.get_allocator(); }
+
+    std::pmr::map<std::pmr::string, PuzzleState, std::less<>> puzzles;
+    std::pmr::map<std::pmr::string, std::pmr::string, std::less<>> inventory;
+    std::pmr::vector<std::pmr::string> discoveredClues;
     int completedPuzzleCount = 0;
-    std::vector<std::string> eventLog;
+    std::pmr::vector<std::pmr::string> eventLog;
 
     void addEvent(const std::string& event);
 };
@@ -102,6 +146,9 @@ struct DEVESCAPE_API SessionMetadata {
 struct DEVESCAPE_API FrameworkContext {
     AudioManager* audioManager = nullptr;
     StateManager* stateManager = nullptr;
+    // Session arena; rooms should build their GameState and ProcessResults
+    // from it. Never null - falls back to the default heap resource.
+    std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource();
     std::string dataDirectory;
     std::string checkpointDirectory;
 };
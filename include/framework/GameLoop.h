@@ -0,0 +1,76 @@
+#pragma once
+
+#include "framework/CommandTrie.h"
+#include "framework/DataTypes.h"
+#include "framework/LineEditor.h"
+#include "framework/SessionArena.h"
+#include "framework/SessionRecorder.h"
+#include "framework/StateManager.h"
+#include "framework/TimerService.h"
+#include "framework/TimerSystem.h"
+#include <chrono>
+#include <memory>
+#include <string>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+class AudioManager;
+class IEscapeRoomV2;
+class PluginManager;
+
+/**
+ * Plays one session at a time: loads the room, then runs frames until it
+ * is solved, ends the session or the countdown runs out, autosaving the
+ * session as it goes. Between frames it picks up rebuilt plugins and
+ * moves the live room onto the new build.
+ *
+ * The plugins, checkpoints and audio belong to the caller, which has
+ * initialized them.
+ */
+class DEVESCAPE_API GameLoop {
+public:
+    GameLoop(PluginManager& pluginManager, StateManager& stateManager, AudioManager& audioManager);
+
+    GameLoop(const GameLoop&) = delete;
+    GameLoop& operator=(const GameLoop&) = delete;
+
+    // Record the next session to path (see SessionRecorder)
+    void recordTo(const std::string& path) { recordPath_ = path; }
+
+    // A new session of the named room; false if it cannot be loaded
+    bool run(const std::string& roomName);
+    // The session in the latest autosave, room state included; false if
+    // there is none or the room cannot take its state back
+    bool resume();
+
+private:
+    PluginManager& pluginManager_;
+    StateManager& stateManager_;
+    AudioManager& audioManager_;
+    SessionArena sessionArena_;
+    FrameworkContext context_;
+    std::unique_ptr<TimerSystem> timerSystem_;
+    IEscapeRoomV2* currentRoom_;
+    bool running_;
+    std::string recordPath_;
+    SessionRecorder recorder_;
+    CommandTrie roomCommands_;
+    LineEditor editor_;
+
+    bool play(GameSession& session, bool resuming);
+    void runGameLoop(GameSession& session, TimerService& timers = TimerService::shared());
+    void startRecording(const std::string& pluginName,
+                        std::chrono::system_clock::time_point wallStart);
+};
+
+} // namespace devescape
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "framework/TimerService.h"
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -21,9 +23,15 @@ struct HintTier {
     float minTimeRemainingPercent;
 };
 
+class TimerSystem;
+
 class HintSystem {
 public:
     HintSystem();
+    ~HintSystem();
+
+    HintSystem(const HintSystem&) = delete;
+    HintSystem& operator=(const HintSystem&) = delete;
 
     void addHint(const std::string& text, int minFailedAttempts = 0, float minTimePercent = 1.0f);
 
@@ -31,8 +39,20 @@ public:
     std::string getHint(int hintLevel) const;
     int getMaxHintLevel() const { return static_cast<int>(hints_.size()); }
 
+    // Watches the tiers' time conditions with one timer each instead of
+    // waiting to be polled: onUnlock(level) runs once, on the countdown
+    // tick where the remaining time first meets the tier's threshold. The
+    // timer must have been started.
+    void watchTimeUnlocks(TimerSystem& timer, std::function<void(int)> onUnlock);
+    void stopWatching();
+    bool isTimeUnlocked(int hintLevel) const;
+
 private:
     std::vector<HintTier> hints_;
+
+    TimerService* timers_;
+    std::vector<TimerService::TimerId> unlockTimers_;
+    std::vector<bool> timeUnlocked_;
 };
 
 } // namespace devescape
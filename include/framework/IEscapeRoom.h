@@ -2,6 +2,7 @@
 
 #include "framework/DataTypes.h"
 #include "framework/TerminalRenderer.h"
+#include "framework/StaticPluginRegistry.h"
 #include <string>
 #include <cstdint>
 
@@ -68,10 +69,18 @@ public:
     #define PLUGIN_EXPORT
 #endif
 
-// Required plugin exports
+// Required plugin exports (DEVESCAPE_ROOM_PLUGIN defines them)
 extern "C" {
     PLUGIN_EXPORT devescape::IEscapeRoom* createRoom();
     PLUGIN_EXPORT void destroyRoom(devescape::IEscapeRoom* room);
     PLUGIN_EXPORT uint32_t getPluginVersion();
     PLUGIN_EXPORT const char* getPluginName();
+
+    // Optional: returns the room to its post-initialize state in place;
+    // false if the room cannot (see StaticPluginRegistry.h)
+    PLUGIN_EXPORT bool resetRoom(devescape::IEscapeRoom* room);
+
+    // Optional: adds the room's commands to the trie used for tab
+    // completion; false if the room publishes none
+    PLUGIN_EXPORT bool publishCommands(devescape::IEscapeRoom* room, devescape::CommandTrie* trie);
 }
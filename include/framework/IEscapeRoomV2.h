@@ -0,0 +1,108 @@
+#pragma once
+
+#include "framework/IEscapeRoom.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+// Plugin ABI negotiation. getPluginVersion() carries the ABI a plugin was
+// built against in its top byte and the room's own version below it.
+//
+// A bare room version (top byte 0) is PLUGIN_ABI_NONE: the plugin was
+// built before the session arena, when GameState, PuzzleState,
+// ProcessResult and the renderer's rows held std:: strings and containers.
+// Their layouts are pmr-based now, so such plugins cannot be loaded. v1 is
+// IEscapeRoom over the pmr types; v2 adds IEscapeRoomV2.
+constexpr uint32_t PLUGIN_ABI_NONE = 0;
+constexpr uint32_t PLUGIN_ABI_V1 = 1;
+constexpr uint32_t PLUGIN_ABI_V2 = 2;
+constexpr uint32_t PLUGIN_ABI_CURRENT = PLUGIN_ABI_V2;
+
+constexpr uint32_t makePluginVersion(uint32_t abiVersion, uint32_t roomVersion) {
+    return (abiVersion << 24) | (roomVersion & 0xFFFFFFu);
+}
+
+constexpr uint32_t pluginAbiVersion(uint32_t pluginVersion) {
+    return pluginVersion >> 24;
+}
+
+constexpr uint32_t pluginRoomVersion(uint32_t pluginVersion) {
+    return pluginVersion & 0xFFFFFFu;
+}
+
+// Capability bits reported by IEscapeRoomV2::getCapabilities()
+enum RoomCapability : uint32_t {
+    ROOM_CAP_NONE = 0,
+    ROOM_CAP_SNAPSHOTS = 1u << 0,           // serializeState() captures the complete room state
+    ROOM_CAP_THREAD_SAFE_RENDER = 1u << 1,  // render() may run on another thread (never concurrently)
+    ROOM_CAP_DETERMINISTIC = 1u << 2        // same commands and frame times give the same state
+};
+
+// Returned by updateFrame() so the framework can skip work on idle frames
+struct UpdateHint {
+    bool needsRedraw = true;          // anything render() draws has changed
+    float nextWakeupSeconds = 0.0f;   // no update needed before this much time passes (0: next frame)
+};
+
+// Non-owning view over a contiguous run of elements
+template <typename T>
+class Span {
+public:
+    Span() : data_(nullptr), size_(0) {}
+    Span(T* data, size_t size) : data_(data), size_(size) {}
+    template <typename Container>
+    Span(Container& container) : data_(container.data()), size_(container.size()) {}
+
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+    T& operator[](size_t index) const { return data_[index]; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    T* data_;
+    size_t size_;
+};
+
+/**
+ * Version 2 of the room interface. Plugins opt in by deriving from this
+ * class and reporting PLUGIN_ABI_V2 from getPluginVersion(); the
+ * PluginManager wraps v1 rooms in a RoomV1Adapter, so the framework only
+ * ever drives rooms through this interface. Plugins reporting no ABI are
+ * never created.
+ *
+ * The v1 per-command processInput() and update() remain part of the
+ * interface; the framework itself calls processInputs() and updateFrame().
+ */
+class DEVESCAPE_API IEscapeRoomV2 : public IEscapeRoom {
+public:
+    ~IEscapeRoomV2() override = default;
+
+    // Bitmask of RoomCapability
+    virtual uint32_t getCapabilities() const = 0;
+
+    // Handles commands in order, appending one result per command handled.
+    // Stops after a result that ends the session; returns the number handled.
+    virtual size_t processInputs(Span<const std::string> commands,
+                                 std::pmr::vector<ProcessResult>& results) = 0;
+
+    // update() that also tells the framework whether to redraw and when the
+    // room next needs time to pass
+    virtual UpdateHint updateFrame(float deltaTimeSeconds) = 0;
+};
+
+} // namespace devescape
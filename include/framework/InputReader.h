@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+enum class Key : uint8_t {
+    CHARACTER,  // printable text (one UTF-8 character) when line assembly is off
+    ENTER,
+    BACKSPACE,
+    DELETE_CHAR,  // forward delete (DELETE clashes with a Windows macro)
+    TAB,
+    ESCAPE,
+    UP,
+    DOWN,
+    LEFT,
+    RIGHT,
+    HOME,
+    END,
+    PAGE_UP,
+    PAGE_DOWN,
+    INSERT,
+    CONTROL     // Ctrl + letter; the letter is in InputEvent::control
+};
+
+struct DEVESCAPE_API InputEvent {
+    enum class Type {
+        LINE,  // a complete line, without its terminator
+        KEY
+    };
+
+    Type type = Type::KEY;
+    Key key = Key::CHARACTER;
+    char control = 0;  // 'a'..'z' for Key::CONTROL
+    std::string text;  // the line, or the character for Key::CHARACTER
+};
+
+/**
+ * Non-blocking terminal input. poll() drains everything waiting on the
+ * input in bulk reads into a ring buffer and decodes it with a table-driven
+ * state machine, so escape sequences and UTF-8 characters split across
+ * reads (or frames) come out whole.
+ *
+ * With line assembly on (the default) printable text and backspace build
+ * up a partial line that survives between polls, and only complete lines
+ * are delivered, as LINE events; every other key is a KEY event. With it
+ * off, every key is delivered, printable characters as Key::CHARACTER.
+ *
+ * A lone ESC can't be told from the start of a sequence until more input
+ * arrives; it is reported once a whole poll passes with nothing after it.
+ */
+class DEVESCAPE_API InputReader {
+public:
+    // fd is ignored on Windows, which reads the console input buffer
+    explicit InputReader(int fd = 0);
+
+    InputReader(const InputReader&) = delete;
+    InputReader& operator=(const InputReader&) = delete;
+
+    // Reader for standard input shared by the framework
+    static InputReader& standardInput();
+
+    // Reads and decodes whatever is available; returns the number of
+    // events now queued
+    size_t poll();
+
+    // Decodes bytes from somewhere other than the input (pipes, tests)
+    void feed(const char* data, size_t size);
+
+    bool nextEvent(InputEvent& event);
+    bool hasEvents() const { return !events_.empty(); }
+
+    void setLineAssembly(bool enabled) { lineAssembly_ = enabled; }
+    bool getLineAssembly() const { return lineAssembly_; }
+
+    // Text typed since the last complete line, for echoing
+    const std::string& getPartialLine() const { return partialLine_; }
+    void clearPartialLine() { partialLine_.clear(); }
+
+private:
+    static constexpr size_t RING_SIZE = 4096;  // power of two
+    static constexpr int MAX_PARAM = 9999;
+
+    enum State : uint8_t {
+        GROUND,
+        ESCAPE_SEEN,  // ESC
+        CSI,          // ESC [
+        SS3,          // ESC O
+        UTF8,         // inside a multi-byte character
+        STATE_COUNT
+    };
+
+    int fd_;
+    char ring_[RING_SIZE];
+    size_t head_;  // next byte to decode
+    size_t tail_;  // next byte to fill; both only grow, masked on access
+
+    State state_;
+    int param_;            // first numeric CSI parameter
+    bool paramClosed_;     // past the first ';'
+    bool lastWasCarriageReturn_;
+    int utf8Remaining_;
+    std::string utf8Pending_;
+    bool escapeWaiting_;   // ESC was the last byte of the previous poll
+
+    bool lineAssembly_;
+    std::string partialLine_;
+    std::deque<InputEvent> events_;
+
+    size_t readAvailable();
+    void decode();
+    void step(uint8_t byte);
+
+    void emitKey(Key key, char control = 0);
+    void emitText(const char* text, size_t size);
+    void emitControl(uint8_t byte);
+};
+
+} // namespace devescape
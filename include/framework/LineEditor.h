@@ -0,0 +1,92 @@
+#pragma once
+
+#include "framework/CommandTrie.h"
+#include "framework/InputReader.h"
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+class TerminalRenderer;
+
+/**
+ * Command line editor driven by InputReader key events (line assembly
+ * off). Supports cursor movement, word and line kills, history on the
+ * arrow keys, incremental reverse search on Ctrl-R and tab completion
+ * from the room's CommandTrie.
+ *
+ * Keys: Left/Right, Home/End (Ctrl-A/E), Backspace/Delete, Ctrl-U/K/W
+ * (kill to start/end/previous word), Up/Down (Ctrl-P/N) for history,
+ * Ctrl-R to search (again for older matches, Esc or Ctrl-G to cancel),
+ * Tab to complete (twice to list the choices).
+ */
+class DEVESCAPE_API LineEditor {
+public:
+    explicit LineEditor(size_t historyLimit = 500);
+
+    // Applies one key; returns true and sets line when Enter submits one
+    bool handle(const InputEvent& event, std::string& line);
+
+    void setCompletions(const CommandTrie* trie) { completions_ = trie; }
+    void addHistory(const std::string& line);
+    const std::deque<std::string>& getHistory() const { return history_; }
+
+    const std::string& getLine() const { return buffer_; }
+    size_t getCursor() const { return cursor_; }  // byte offset into getLine()
+    bool isSearching() const { return searching_; }
+    const std::string& getSearchQuery() const { return searchQuery_; }
+    const std::vector<std::string>& getCandidates() const { return candidates_; }
+
+    // True once something visible changed; cleared by render()
+    bool needsRedraw() const { return dirty_; }
+
+    // Draws the prompt on row y (and any completion list on the row above),
+    // scrolled so the cursor stays visible; returns the cursor's column
+    int render(TerminalRenderer& renderer, int y);
+
+private:
+    std::string buffer_;
+    size_t cursor_;
+
+    std::deque<std::string> history_;
+    size_t historyLimit_;
+    size_t historyIndex_;  // == history_.size() while editing a new line
+    std::string draft_;    // the new line while browsing history
+
+    bool searching_;
+    std::string searchQuery_;
+    size_t searchIndex_;   // history entry of the current match
+    std::string searchSaved_;
+
+    const CommandTrie* completions_;
+    std::vector<std::string> candidates_;
+    bool lastWasTab_;
+    bool dirty_;
+
+    void insert(const std::string& text);
+    void moveLeft();
+    void moveRight();
+    void eraseBefore();
+    void eraseAt();
+    void killWord();
+    void recall(size_t index);
+    void complete();
+
+    bool handleSearch(const InputEvent& event, std::string& line);
+    void searchFrom(size_t index);
+    bool submit(std::string& line);
+};
+
+} // namespace devescape
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * Synthetic logs for incident rooms, described by a small profile instead
+ * of shipped as multi-gigabyte assets.
+ *
+ * Every line is a pure function of the seed and its index: its time, its
+ * pattern and the values filling the pattern come from a random stream
+ * keyed by the index. So any window can be generated on demand, and a
+ * whole log can be written in parallel chunks that come out byte-identical
+ * for a seed whatever the thread count. Lines are in time order and read
+ * "<date>T<time>Z <LEVEL> <text>", as LogIndex expects.
+ *
+ * Log profile format (see data/logs/):
+ *
+ *     seed 20240315
+ *     date 2024-03-15
+ *     start 09:00:00                # time of day of the first line
+ *     spacing 300                   # microseconds between lines, on average
+ *     lines 30000000
+ *     incident 10:02:00             # `during` patterns take over from here
+ *
+ *     always 250 DEBUG "[cache] hit key=session:{hex:6}"
+ *     before 30 WARN "[payment-api] Slow request {int:808-1207}ms"
+ *     during 60 ERROR "[payment-api] Connection timeout request_id={hex:8}"
+ *
+ * A pattern has a period (`always`, `before` or `during` the incident), a
+ * weight among the patterns of its period, a level word and its text, in
+ * which {hex:N} stands for N random hex digits and {int:LOW-HIGH} for a
+ * random number in range.
+ */
+class DEVESCAPE_API LogGenerator {
+public:
+    struct Pattern {
+        enum class Period : uint8_t { ALWAYS, BEFORE, DURING };
+
+        Period period = Period::ALWAYS;
+        uint32_t weight = 1;
+        std::string level;
+        std::string text;
+    };
+
+    struct Profile {
+        uint64_t seed = 1;
+        std::string date = "2024-01-01";
+        uint64_t startMillis = 0;             // time of day of line 0
+        uint32_t spacingMicros = 1000;
+        uint64_t lineCount = 0;
+        uint64_t incidentMillis = ~0ull;      // no incident by default
+        std::vector<Pattern> patterns;
+    };
+
+    // Lines per chunk when writing a file; also the unit of parallel work
+    static constexpr uint64_t CHUNK_LINES = 1u << 16;
+
+    // Watches and stops a writeFile() running on another thread
+    struct WriteProgress {
+        std::atomic<uint64_t> linesWritten{0};
+        std::atomic<bool> cancel{false};  // checked between chunks
+    };
+
+    LogGenerator();
+
+    // False (and reported) for a pattern with a bad placeholder, or a
+    // period with lines but no patterns
+    bool setProfile(const Profile& profile);
+    static bool loadProfile(const std::string& path, Profile& profile);
+
+    const Profile& getProfile() const { return profile_; }
+    uint64_t getLineCount() const { return profile_.lineCount; }
+
+    // Time of day of a line, in milliseconds; never decreasing
+    uint64_t lineMillis(uint64_t line) const;
+    // First line at or after a time of day (lineCount if none)
+    uint64_t lineAtMillis(uint64_t millis) const;
+
+    // Appends lines [first, first + count), clipped to the log
+    void generate(uint64_t first, uint64_t count, std::string& out) const;
+
+    // The whole log, threads chunks at a time (0: one per core); written
+    // aside and renamed into place, never held in memory as a whole. On
+    // failure or cancellation nothing is left behind.
+    bool writeFile(const std::string& path, unsigned threads = 0,
+                   WriteProgress* progress = nullptr) const;
+
+private:
+    // A pattern split into literal text and random fields
+    struct Piece {
+        enum class Kind : uint8_t { TEXT, HEX, INT };
+
+        Kind kind = Kind::TEXT;
+        std::string text;     // TEXT, and the level word before a line's text
+        uint32_t digits = 0;  // HEX
+        uint64_t low = 0;     // INT
+        uint64_t span = 0;
+    };
+
+    struct Compiled {
+        uint32_t firstPiece = 0;
+        uint32_t pieceCount = 0;
+    };
+
+    struct Table {
+        std::vector<uint32_t> patterns;  // into compiled_
+        std::vector<uint64_t> cumulative;
+        uint64_t total = 0;
+    };
+
+    Profile profile_;
+    std::vector<Piece> pieces_;
+    std::vector<Compiled> compiled_;
+    Table before_;  // always + before
+    Table during_;  // always + during
+    uint64_t incidentLine_;
+
+    static bool compile(const std::string& text, std::vector<Piece>& pieces);
+    void appendLine(uint64_t line, std::string& out) const;
+};
+
+} // namespace devescape
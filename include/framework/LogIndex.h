@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * A text log mapped read-only and indexed by line, so rooms can query logs
+ * of many gigabytes at interactive speed: the log's pages are read on
+ * demand and nothing is copied.
+ *
+ * Lines look like "<ISO 8601 timestamp> <LEVEL> <message>" and are in time
+ * order, so a time range is two binary searches over the line index. The
+ * index holds every line's offset and a level bit per line, built with one
+ * scan for newlines and kept beside the log as <log>.idx, mapped again
+ * while the log's size and modification time match.
+ *
+ * Searches run over byte ranges with SSE2 where available (the first and
+ * last needle bytes compared 16 positions at a time); level filters test
+ * 16 lines' level bits at a time.
+ *
+ * Read-only once open: any number of threads may query it.
+ */
+class DEVESCAPE_API LogIndex {
+public:
+    // Level bits, one per line; a filter is any set of them
+    static constexpr uint8_t LEVEL_DEBUG = 1u << 0;
+    static constexpr uint8_t LEVEL_INFO = 1u << 1;
+    static constexpr uint8_t LEVEL_WARN = 1u << 2;
+    static constexpr uint8_t LEVEL_ERROR = 1u << 3;
+    static constexpr uint8_t LEVEL_CRITICAL = 1u << 4;
+    static constexpr uint8_t LEVEL_OTHER = 1u << 5;  // no level word
+    static constexpr uint8_t LEVEL_ALL = 0x3F;
+
+    static constexpr uint64_t NOT_FOUND = ~0ull;
+
+    LogIndex();
+    ~LogIndex();
+
+    LogIndex(const LogIndex&) = delete;
+    LogIndex& operator=(const LogIndex&) = delete;
+
+    // Maps the log and its index, building the index when missing or stale
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return data_ != nullptr; }
+
+    size_t getLineCount() const { return lineCount_; }
+    uint64_t getBytes() const { return bytes_; }
+    const char* getData() const { return data_; }
+
+    // Line text without its newline
+    std::string_view line(size_t index) const;
+    uint64_t lineStart(size_t index) const { return offsets_[index]; }  // [lineCount] = bytes
+    uint8_t level(size_t index) const { return levels_[index]; }
+    // The line holding a byte offset
+    size_t lineAt(uint64_t offset) const;
+
+    // First line whose timestamp compares >= prefix, or > prefix for
+    // upperBound; "2024-03-15T10:02" covers the whole minute
+    size_t lowerBound(std::string_view timestampPrefix) const;
+    size_t upperBound(std::string_view timestampPrefix) const;
+
+    // First line in [first, last) with a level in mask, or last
+    size_t findLevel(size_t first, size_t last, uint8_t mask) const;
+    size_t countLevel(size_t first, size_t last, uint8_t mask) const;
+
+    // Offset of the first needle starting in [from, to), or NOT_FOUND
+    uint64_t find(uint64_t from, uint64_t to, std::string_view needle) const;
+
+    // Level bit of a line, and of a level word (ERROR, WARN...; 0 if none)
+    static uint8_t parseLevel(std::string_view line);
+    static uint8_t levelBit(std::string_view word);
+
+private:
+    const char* data_;
+    uint64_t bytes_;
+    size_t lineCount_;
+    const uint64_t* offsets_;  // lineCount + 1
+    const uint8_t* levels_;    // lineCount
+
+    // Mapped files, or memory where they cannot be mapped
+    void* logMapping_;
+    void* indexMapping_;
+    size_t indexMappedBytes_;
+    std::string logMemory_;
+    std::vector<uint64_t> offsetMemory_;
+    std::vector<uint8_t> levelMemory_;
+
+    bool mapIndex(const std::string& path, uint64_t logBytes, int64_t logModified);
+    void buildIndex();
+    bool writeIndex(const std::string& path, int64_t logModified) const;
+};
+
+} // namespace devescape
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "framework/DataTypes.h"
+#include "framework/Sequencer.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+// A rendered loop: the last sample runs straight into the first
+struct LoopBuffer {
+    const float* samples = nullptr;
+    size_t frames = 0;
+
+    bool isValid() const { return frames > 0; }
+};
+
+/**
+ * Every theme x tension tier rendered once, a full pass through the tier's
+ * pattern order at unit master volume. The seam is crossfaded with the
+ * audio that follows it, so loops wrap without a click. Playing one back is
+ * a copy and a multiply, whatever the synth costs, and any number of
+ * LoopPlayers may read the same cache.
+ *
+ * Loops live in memory, or with a cache directory as <theme>-<tier>.loop
+ * files mapped read-only. A file is reused while its header matches the
+ * song and sample rate, and rendered again otherwise.
+ *
+ * Built once, then read-only: build() and clear() must not overlap playback.
+ */
+class DEVESCAPE_API LoopCache {
+public:
+    static constexpr int THEME_COUNT = static_cast<int>(ThemeType::FAILURE) + 1;
+
+    LoopCache();
+    ~LoopCache();
+
+    LoopCache(const LoopCache&) = delete;
+    LoopCache& operator=(const LoopCache&) = delete;
+
+    // songs[THEME_COUNT], indexed by ThemeType; unloaded songs are skipped.
+    // Returns the number of loops available afterwards.
+    size_t build(const Song* songs, int sampleRate, const std::string& directory = "");
+    void clear();
+
+    LoopBuffer get(ThemeType theme, int tier) const;
+    int getSampleRate() const { return sampleRate_; }
+    size_t getBytes() const;  // sample data held or mapped
+
+    // Renders one loop; public for benchmarks and tools
+    static void renderLoop(const Song& song, int tier, int sampleRate, std::vector<float>& out);
+
+private:
+    struct Entry {
+        std::vector<float> memory;
+        void* mapping = nullptr;  // whole file, header included
+        size_t mappedBytes = 0;
+        LoopBuffer loop;
+    };
+
+    Entry entries_[THEME_COUNT][Song::TIERS];
+    int sampleRate_;
+
+    bool mapFile(const std::string& path, uint64_t key, int sampleRate, Entry& entry);
+    static bool writeFile(const std::string& path, uint64_t key, int sampleRate,
+                          const std::vector<float>& samples);
+};
+
+/**
+ * One listener's position in the cache. Switching loops crossfades from
+ * the old one, so theme and tier changes never click.
+ *
+ * Owned by a single thread (the audio thread for AudioManager).
+ */
+class DEVESCAPE_API LoopPlayer {
+public:
+    explicit LoopPlayer(size_t crossfadeFrames = 2205);
+
+    // keepPlace carries the relative position over, for tier changes
+    void play(LoopBuffer loop, bool keepPlace = false);
+    void stop();  // fades out
+    bool isPlaying() const { return current_.loop.isValid() || fadeRemaining_ > 0; }
+    const float* getLoop() const { return current_.loop.samples; }
+
+    void setCrossfadeFrames(size_t frames) { crossfadeFrames_ = frames > 0 ? frames : 1; }
+
+    // Overwrites buffer with frameCount samples scaled by gain
+    void render(float* buffer, size_t frameCount, float gain);
+
+private:
+    struct Cursor {
+        LoopBuffer loop;
+        size_t position = 0;
+    };
+
+    Cursor current_;
+    Cursor previous_;  // fading out
+    size_t crossfadeFrames_;
+    size_t fadeRemaining_;
+
+    static void addRamp(Cursor& cursor, float* out, size_t frameCount, float gain, float step);
+};
+
+} // namespace devescape
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+struct DEVESCAPE_API MetricSample {
+    int64_t time = 0;  // milliseconds
+    double value = 0.0;
+};
+
+// Aggregate of a run of samples; count 0 when there were none
+struct DEVESCAPE_API MetricSummary {
+    uint64_t count = 0;
+    double min = 0.0;
+    double max = 0.0;
+    double sum = 0.0;
+    double last = 0.0;
+    int64_t lastTime = 0;
+
+    double mean() const { return count > 0 ? sum / static_cast<double>(count) : 0.0; }
+    void add(int64_t time, double value);
+    void merge(const MetricSummary& other);  // other's samples come later
+};
+
+/**
+ * In-memory time series under a path trie ("services/payment-api/latency").
+ * Inner nodes group series; a leaf is one series.
+ *
+ * Samples go into chunks of CHUNK_SAMPLES kept as two bit streams, one
+ * per column: timestamps as delta-of-deltas (one bit for a steady
+ * interval) and values XORed with the previous one (one bit when
+ * unchanged, otherwise only the changed bits). Each chunk also keeps the
+ * count, min, max, sum and last of its samples, so rollups and
+ * downsampling take whole chunks from that summary and decode only the
+ * chunks cut by a range or bucket edge.
+ *
+ * Not thread-safe; samples must arrive in time order per series.
+ */
+class DEVESCAPE_API MetricStore {
+public:
+    using NodeId = uint32_t;
+    using SeriesId = uint32_t;
+
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+    static constexpr NodeId ROOT = 0;
+    static constexpr uint32_t CHUNK_SAMPLES = 256;
+
+    MetricStore();
+
+    // The series at a '/'-separated path, creating it and the nodes above
+    // it as needed; NONE if the path runs through an existing series
+    SeriesId addSeries(std::string_view path);
+
+    // Trie navigation
+    NodeId findNode(std::string_view path) const;  // NONE if absent
+    NodeId child(NodeId node, std::string_view name) const;
+    const std::vector<NodeId>& children(NodeId node) const { return nodes_[node].children; }
+    NodeId parent(NodeId node) const { return nodes_[node].parent; }
+    std::string_view name(NodeId node) const { return nodes_[node].name; }
+    SeriesId series(NodeId node) const { return nodes_[node].series; }  // NONE for inner nodes
+    std::string path(NodeId node) const;
+
+    // False (sample dropped) unless time is after the series' last sample
+    bool append(SeriesId series, int64_t time, double value);
+
+    // Samples with from <= time < to, appended to out
+    void range(SeriesId series, int64_t from, int64_t to, std::vector<MetricSample>& out) const;
+    MetricSummary rollup(SeriesId series, int64_t from, int64_t to) const;
+    // [from, to) in equal buckets, out[buckets]
+    void downsample(SeriesId series, int64_t from, int64_t to, size_t buckets,
+                    MetricSummary* out) const;
+    MetricSummary summary(SeriesId series) const;  // every sample; last is the latest
+
+    size_t getSeriesCount() const { return series_.size(); }
+    uint64_t getSampleCount() const;
+    size_t getBytes() const;  // compressed chunk data
+
+private:
+    struct Node {
+        std::string name;
+        NodeId parent = NONE;
+        std::vector<NodeId> children;
+        SeriesId series = NONE;
+    };
+
+    struct BitStream {
+        std::vector<uint64_t> words;
+        uint64_t bits = 0;
+
+        void write(uint64_t value, int count);
+    };
+
+    struct Chunk {
+        int64_t start = 0;
+        BitStream times;
+        BitStream values;
+        MetricSummary summary;
+    };
+
+    // The encoder's state for the series' last chunk
+    struct Series {
+        std::vector<Chunk> chunks;
+        int64_t lastDelta = 0;
+        uint64_t lastBits = 0;
+        int leading = -1;  // of the last XOR window; -1 before the first
+        int trailing = 0;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<Series> series_;
+
+    // Chunks that may hold samples in [from, to)
+    size_t firstChunk(const Series& series, int64_t from) const;
+    template <typename Visit>
+    static void decode(const Chunk& chunk, Visit visit);
+};
+
+} // namespace devescape
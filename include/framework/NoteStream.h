@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+enum class NoteEventType : uint8_t {
+    START,          // value: the sample rate frames count at
+    THEME,          // value: ThemeType
+    TEMPO,          // value: bpm x 10
+    NOTE_ON,        // voice, note, volume (0-15, or 0xFF to keep)
+    NOTE_OFF,       // voice
+    VOLUME,         // voice, volume (0-15)
+    DUTY,           // voice, value: duty x 256
+    EFFECT,         // name
+    MASTER_VOLUME,  // value: volume x 255
+    STOP            // every voice off
+};
+
+// Plain data so it can cross from the audio thread in an SpscQueue
+struct NoteEvent {
+    static constexpr size_t NAME_SIZE = 16;
+
+    uint64_t frame = 0;  // position on the sender's timeline, in samples
+    NoteEventType type = NoteEventType::STOP;
+    uint8_t voice = 0;
+    uint8_t note = 0;
+    uint8_t volume = 0;
+    uint32_t value = 0;
+    char name[NAME_SIZE] = {};  // EFFECT, NUL-terminated
+
+    void setName(const std::string& text);
+};
+
+// Note event wire format, shared by NoteStreamWriter and NoteStreamReader.
+//
+//   varint frame delta  byte (type << 4 | voice)  payload
+//
+// with the payload by type: START/TEMPO a varint value; THEME, DUTY and
+// MASTER_VOLUME a value byte; NOTE_ON note and volume bytes; VOLUME a
+// volume byte; EFFECT a length byte and the name; nothing otherwise. A row
+// of a busy song is a dozen bytes, a held note none at all.
+
+class DEVESCAPE_API NoteStreamWriter {
+public:
+    NoteStreamWriter();
+
+    void write(const NoteEvent& event);
+
+    // Encoded bytes since the last clear(); deltas carry across clears
+    const std::string& data() const { return buffer_; }
+    void clear() { buffer_.clear(); }
+
+private:
+    std::string buffer_;
+    uint64_t lastFrame_;
+};
+
+// Decodes a stream fed in arbitrary pieces (as it arrives off the wire)
+class DEVESCAPE_API NoteStreamReader {
+public:
+    NoteStreamReader();
+
+    void feed(const char* data, size_t size);
+
+    // False when the next event is incomplete (or the stream is bad)
+    bool next(NoteEvent& event);
+    bool hasFailed() const { return failed_; }
+
+private:
+    std::string buffer_;
+    size_t offset_;
+    uint64_t lastFrame_;
+    bool failed_;
+};
+
+} // namespace devescape
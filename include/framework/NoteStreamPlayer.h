@@ -0,0 +1,82 @@
+#pragma once
+
+#include "framework/DataTypes.h"
+#include "framework/NoteStream.h"
+#include "framework/SfxMixer.h"
+#include "framework/SynthEngine.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * Client end of a note event stream (AudioManager's "events" output): the
+ * music and effects are rendered here, with the same SynthEngine and
+ * SfxMixer the game uses, from a few bytes a second of events instead of
+ * PCM. Built into devescape_audio_client, which needs no SDL.
+ *
+ * Events land on the sample they were stamped with, scaled from the
+ * sender's rate (sent in START) to this player's. The player runs `delay`
+ * samples behind the sender's timeline, so events arriving up to that late
+ * still land on time; later ones apply at the start of the next render().
+ *
+ * Single-threaded: feed() and render() from the same thread, e.g. the
+ * client's audio callback draining a socket buffer.
+ */
+class DEVESCAPE_API NoteStreamPlayer {
+public:
+    explicit NoteStreamPlayer(int sampleRate = 44100);
+
+    NoteStreamPlayer(const NoteStreamPlayer&) = delete;
+    NoteStreamPlayer& operator=(const NoteStreamPlayer&) = delete;
+
+    // The sender's effect file; EFFECT events with unknown names are silent
+    bool loadEffects(const std::string& path);
+
+    void feed(const char* data, size_t size);
+    void setDelay(size_t frames) { delay_ = frames; }
+
+    // Overwrites buffer with frameCount mono samples
+    void render(float* buffer, size_t frameCount);
+
+    bool hasFailed() const { return reader_.hasFailed(); }
+    ThemeType getTheme() const { return theme_; }
+    float getBpm() const { return bpm_; }
+    uint64_t getPosition() const { return position_; }
+
+private:
+    NoteStreamReader reader_;
+    SynthEngine synth_;
+    SfxMixer sfx_;
+    int sampleRate_;
+    uint64_t position_;       // samples rendered
+    size_t delay_;
+
+    // Timeline mapping, moved by each START
+    int senderRate_;
+    uint64_t anchorSender_;
+    double anchorClient_;
+    bool started_;
+
+    NoteEvent pending_;       // decoded but not yet due
+    bool hasPending_;
+
+    ThemeType theme_;
+    float bpm_;
+
+    double clientFrame(uint64_t senderFrame) const;
+    void apply(const NoteEvent& event);
+};
+
+} // namespace devescape
@@ -1,6 +1,11 @@
 #pragma once
 
-#include "framework/IEscapeRoom.h"
+#include "framework/IEscapeRoomV2.h"
+#include "framework/PluginManifest.h"
+#include "framework/SessionArena.h"
+#include <future>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <memory>
@@ -21,31 +26,133 @@ struct PluginInfo {
     std::string name;
     std::string path;
     std::string version;
+    uint32_t abiVersion = PLUGIN_ABI_NONE;  // negotiated from getPluginVersion()
     std::string author;
     std::string description;
-    void* handle;  // Library handle
+    void* handle = nullptr;  // Current build's library handle, null until first loaded
+    const StaticPluginEntry* staticEntry = nullptr;  // Set for plugins linked into the executable
 };
 
 class DEVESCAPE_API PluginManager {
 public:
-    PluginManager(const std::string& pluginDirectory);
+    // The manifest cache defaults to <pluginDirectory>/plugin_manifest.json
+    PluginManager(const std::string& pluginDirectory, const std::string& manifestFile = "");
     ~PluginManager();
 
-    // Plugin discovery and loading
+    // Registers a plugin compiled into the executable. Static plugins are
+    // listed by scanForPlugins() ahead of, and in place of, any shared
+    // library with the same name.
+    void addStaticPlugin(const StaticPluginEntry& entry);
+
+    // Plugin discovery - served from the manifest cache where possible;
+    // only new or changed libraries are opened, in parallel
     void scanForPlugins();
     std::vector<PluginInfo> getAvailablePlugins() const;
 
-    // Room loading
-    IEscapeRoom* loadRoom(const std::string& pluginName);
+    // Room loading. Every room is returned through the v2 interface; rooms
+    // from v1 plugins come wrapped in a RoomV1Adapter.
+    IEscapeRoomV2* loadRoom(const std::string& pluginName);
     void unloadRoom(IEscapeRoom* room, const std::string& pluginName);
 
+    // Room pool. acquireRoom() returns an initialized room in its
+    // post-initialize state, reusing a warm instance when one is idle;
+    // releaseRoom() keeps the room, up to the pool size per plugin, instead
+    // of destroying it, and it is reset when acquireRoom() hands it out
+    // again, so ending a session costs nothing. Rooms are reset through the
+    // plugin's resetRoom export, else by restoring a post-initialize
+    // snapshot (ROOM_CAP_SNAPSHOTS); rooms that support neither are not
+    // pooled. Pooled rooms outlive sessions, so each gets an arena of its
+    // own in place of context.memoryResource.
+    void setRoomPoolSize(size_t roomsPerPlugin);
+    size_t prewarmRooms(const std::string& pluginName, const FrameworkContext& context, size_t count);
+    IEscapeRoomV2* acquireRoom(const std::string& pluginName, const FrameworkContext& context);
+    void releaseRoom(IEscapeRoomV2* room);
+
+    // Hot reload (inotify; Linux only). Rebuilt plugins are loaded in the
+    // background next to the running build; call pollPluginChanges() once
+    // per frame and migrate rooms whose build is stale.
+    bool enableHotReload();
+    void pollPluginChanges();
+    bool hasNewerBuild(IEscapeRoom* room) const;
+
+    // Run rooms created from now on in a child process (see SandboxedRoom);
+    // plugins linked into the executable still run in-process
+    bool setSandboxEnabled(bool enabled);
+
+    // Moves a live room onto the newest build of its plugin by passing its
+    // serializeState() blob to a fresh instance. Returns the new room, or
+    // the old one unchanged if the transfer fails. The old library is
+    // unloaded once its last room has moved.
+    IEscapeRoomV2* migrateRoom(IEscapeRoomV2* room, const FrameworkContext& context);
+
+    // Fills trie with the room's command vocabulary through the plugin's
+    // optional publishCommands export. False if the plugin has none or the
+    // room runs in the sandbox.
+    bool publishCommands(IEscapeRoomV2* room, CommandTrie& trie);
+
 private:
+    // One loaded build of a plugin. Builds stay resident while any room
+    // created from them is alive.
+    struct LibraryGeneration {
+        std::string pluginName;
+        std::string loadedPath;
+        bool shadowCopy = false;  // loadedPath is a private copy to delete on unload
+        void* handle = nullptr;
+        const StaticPluginEntry* staticEntry = nullptr;  // entry points when linked in
+        int generation = 0;
+        int liveRooms = 0;  // includes idleRooms
+
+        std::vector<IEscapeRoomV2*> idleRooms;  // for acquireRoom(), reset unless in releasedRooms_
+        FrameworkContext poolContext;           // services the idle rooms were initialized with
+        std::string pristineState;              // serializeState() after the first pooled initialize
+    };
+
     std::string pluginDirectory_;
     std::vector<PluginInfo> plugins_;
+    std::vector<const StaticPluginEntry*> staticPlugins_;
+    PluginManifestCache manifestCache_;
+
+    std::vector<std::unique_ptr<LibraryGeneration>> libraries_;
+    std::map<IEscapeRoom*, LibraryGeneration*> roomOwners_;
+
+    struct PendingReload {
+        std::future<std::unique_ptr<LibraryGeneration>> library;
+        bool changedAgain = false;  // file rewritten while the copy was loading
+    };
+
+    int inotifyFd_;
+    int nextGeneration_;
+    std::map<std::string, PendingReload> pendingReloads_;
+    std::map<IEscapeRoom*, int> failedMigrations_;  // room -> generation it refused
 
-    bool loadPlugin(const std::string& path, PluginInfo& info);
+    bool sandboxEnabled_;
+    std::set<IEscapeRoom*> sandboxedRooms_;
+    std::set<IEscapeRoom*> releasedRooms_;  // idle rooms still holding their last session
+    std::map<IEscapeRoom*, IEscapeRoom*> adaptedRooms_;  // adapter -> plugin's v1 room
+
+    size_t roomPoolSize_;
+    std::map<IEscapeRoom*, std::unique_ptr<SessionArena>> roomArenas_;  // pooled rooms' own arenas
+
+    bool probePlugin(const std::string& path, PluginManifestEntry& entry);
+    bool loadPlugin(PluginInfo& info);
     void unloadPlugin(PluginInfo& info);
 
+    LibraryGeneration* currentGeneration(const std::string& pluginName) const;
+    void releaseGeneration(LibraryGeneration* library);
+    void startReload(const std::string& path);
+    std::unique_ptr<LibraryGeneration> loadShadowCopy(const std::string& path, int generation);
+    void installGeneration(std::unique_ptr<LibraryGeneration> library);
+    uint32_t abiVersionOf(const LibraryGeneration* library);
+    IEscapeRoomV2* createFrom(LibraryGeneration* library);
+    void destroyFrom(LibraryGeneration* library, IEscapeRoom* room);
+    LibraryGeneration* resolvePlugin(const std::string& pluginName);
+    IEscapeRoomV2* createPooled(LibraryGeneration* library, const FrameworkContext& context);
+    bool resetRoom(LibraryGeneration* library, IEscapeRoomV2* room);
+    // Whether resetRoom() has a way to reset the room, without running it
+    bool canReset(LibraryGeneration* library, IEscapeRoomV2* room);
+    void drainPool(LibraryGeneration* library);
+    void closeLibrary(void* handle);
+
 #ifdef _WIN32
     void* loadLibrary(const std::string& path);
     void* getFunction(void* handle, const char* name);
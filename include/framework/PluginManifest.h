@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * What discovery learned about one plugin library, plus the file identity
+ * it was learned from. An entry is only trusted while path, size, mtime and
+ * build id all still match the file on disk.
+ */
+struct PluginManifestEntry {
+    std::string path;
+    uint64_t fileSize = 0;
+    int64_t modifiedTime = 0;
+    std::string buildId;
+
+    std::string name;
+    uint32_t version = 0;
+};
+
+/**
+ * Persisted plugin manifest so the room menu can be built without loading
+ * any plugin library.
+ */
+class DEVESCAPE_API PluginManifestCache {
+public:
+    explicit PluginManifestCache(const std::string& cacheFile);
+
+    bool load();
+    bool save();
+
+    const PluginManifestEntry* lookup(const std::string& path, uint64_t fileSize,
+                                      int64_t modifiedTime, const std::string& buildId) const;
+    void store(const PluginManifestEntry& entry);
+
+    // Drop entries for libraries that no longer exist
+    void retainOnly(const std::vector<std::string>& paths);
+
+    bool isDirty() const { return dirty_; }
+
+    // GNU build id of an ELF file as hex, read from its PT_NOTE segments.
+    // Empty on other platforms or when the file carries none.
+    static std::string readBuildId(const std::string& path);
+
+private:
+    std::string cacheFile_;
+    std::vector<PluginManifestEntry> entries_;
+    bool dirty_;
+};
+
+} // namespace devescape
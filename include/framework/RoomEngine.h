@@ -0,0 +1,150 @@
+#pragma once
+
+#include "framework/ClockSource.h"
+#include "framework/IEscapeRoomV2.h"
+#include "framework/RoomExtension.h"
+#include "framework/RoomProgram.h"
+#include "framework/TimerService.h"
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+class CommandTrie;
+
+/**
+ * A room played from a definition file (see RoomProgram.h) instead of
+ * code. A room plugin derives from it, names its file and declares itself
+ * with DEVESCAPE_ROOM_PLUGIN as usual; reset() and publishCommands() are
+ * picked up by the plugin exports. The file is named relative to the data
+ * directory and loaded by initialize(), which has the directory; until
+ * then the metadata is the file name.
+ *
+ * The state is the current phase, the hint level and the GameState's
+ * puzzles, which are reached through a per-puzzle pointer table, so a
+ * command costs a grammar match, a rule table lookup and its actions.
+ * Snapshots use the same JSON layout as the hand-written rooms had.
+ * Puzzles that need native code are RoomExtensions the plugin adds.
+ * Hints declared with `after` are unlocked by timers on the room's own
+ * TimerService, whose virtual clock moves with update(), so they follow
+ * session time through replays, fast clocks and restored snapshots.
+ *
+ * A definition that fails to load leaves a room that says so and fails.
+ */
+class DEVESCAPE_API RoomEngine : public IEscapeRoomV2 {
+public:
+    // definitionFile is under the context's data directory, e.g.
+    // "rooms/production_incident.room"
+    explicit RoomEngine(const std::string& definitionFile);
+    ~RoomEngine() override;
+
+    bool isLoaded() const { return loaded_; }
+    const RoomProgram& getProgram() const { return program_; }
+
+    // Binds the definition's `call` and `pane` uses of name once it is
+    // loaded, which reports names it never uses; the room does not own the
+    // extension
+    void addExtension(std::string_view name, RoomExtension* extension);
+
+    // Plugin ABI v2
+    uint32_t getCapabilities() const override {
+        return ROOM_CAP_SNAPSHOTS | ROOM_CAP_THREAD_SAFE_RENDER;
+    }
+    size_t processInputs(Span<const std::string> commands,
+                         std::pmr::vector<ProcessResult>& results) override;
+    UpdateHint updateFrame(float deltaTimeSeconds) override;
+
+    // Metadata, from the definition
+    std::string getName() const override;
+    std::string getVersion() const override;
+    std::string getAuthor() const override;
+    std::string getDescription() const override;
+    uint32_t getTotalDurationSeconds() const override { return program_.durationSeconds; }
+
+    // Lifecycle
+    void initialize(const FrameworkContext& context) override;
+    void cleanup() override {}
+
+    // Back to the state initialize() left, reusing the puzzle map (room pool)
+    void reset();
+
+    // The definition's `complete` lines, for tab completion
+    void publishCommands(CommandTrie& commands) const;
+
+    // State
+    GameState getCurrentState() const override { return *gameState_; }
+    bool isCompleted() const override;
+    bool isFailed() const override { return !loaded_; }
+    int getCompletionPercentage() const override;
+
+    // Interaction
+    ProcessResult processInput(const std::string& command) override;
+    void render(TerminalRenderer& renderer) const override;
+    void update(float deltaTimeSeconds) override;
+
+    // Persistence
+    std::string serializeState() const override;
+    bool deserializeState(const std::string& data) override;
+
+    // Hints
+    std::string getHint(int hintLevel) override;
+    int getMaxHintLevel() const override { return program_.maxHintLevel; }
+    bool canUseHint() const override;
+
+    void onSessionTimeout() override;
+
+private:
+    std::string definitionFile_;
+    std::string definitionPath_;  // the file under the data directory, once initialized
+    RoomProgram program_;
+    bool loaded_;
+
+    FrameworkContext context_;
+    // Rebuilt in initialize() so it lives in the session arena from the context
+    std::optional<GameState> gameState_;
+    std::vector<PuzzleState*> puzzles_;  // by program puzzle index
+    std::vector<RoomExtension*> extensions_;  // by program extension index
+    std::vector<std::pair<std::string, RoomExtension*>> addedExtensions_;
+    uint32_t phase_;
+    int hintLevel_;
+    float timeInPhase_;
+    bool redrawPending_;  // render() output changed since the last updateFrame()
+
+    ClockSource phaseClock_;  // virtual, advanced by update()
+    TimerService phaseTimers_;
+    std::vector<TimerService::TimerId> hintTimers_;
+    float phaseSeconds_;      // since the current phase was entered
+    uint32_t unlockedHints_;  // of the current phase's hints, from the first
+
+    void load(const std::string& dataDirectory);
+    void setupPuzzles();
+    void startSession();
+    PuzzleState* phasePuzzle() const;
+
+    // Runs the first rule for verb whose test passes; false if none did
+    bool run(uint32_t verb, const CommandMatch& match, ProcessResult& result);
+    bool passes(const RoomProgram::Rule& rule, const CommandMatch& match) const;
+    void execute(const RoomProgram::Rule& rule, const CommandMatch& match, ProcessResult& result);
+    void prompt(ProcessResult& result) const;
+    void enterPhase(uint32_t phase);
+    // Unlocks the phase's hints due by phaseSeconds_ and schedules the rest
+    void scheduleHintUnlocks();
+    // The phase's hint the next `hint` gives, or NONE when it has none
+    uint32_t nextHint() const;
+    void playPhaseMusic() const;
+    std::string expand(StringPool::Id text, const CommandMatch& match) const;
+};
+
+} // namespace devescape
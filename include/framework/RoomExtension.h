@@ -0,0 +1,58 @@
+#pragma once
+
+#include "framework/CommandGrammar.h"
+#include "framework/DataTypes.h"
+#include "framework/TerminalRenderer.h"
+#include <string>
+#include <string_view>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * Native code behind a room definition: a puzzle whose logic does not fit
+ * rules and actions. The room plugin owns it and binds it to a name with
+ * RoomEngine::addExtension; the definition's `call <name> [<operation>]`
+ * actions hand it commands and a phase's `pane <name> x y w h` line gives
+ * it part of the screen.
+ *
+ * Work too long for one command can be spread over frames: while isBusy()
+ * the engine asks for an update every frame.
+ */
+class DEVESCAPE_API RoomExtension {
+public:
+    virtual ~RoomExtension() = default;
+
+    // operation is the word after the name in the call action, or empty
+    virtual void call(std::string_view operation, const CommandMatch& match,
+                      ProcessResult& result) = 0;
+
+    virtual void render(TerminalRenderer& /*renderer*/, int /*x*/, int /*y*/, int /*width*/,
+                        int /*height*/) const {}
+
+    // Called every frame, pane shown or not; true when render() output
+    // changed, which redraws while the extension is the phase's pane
+    virtual bool update(float /*deltaTimeSeconds*/) { return false; }
+    virtual bool isBusy() const { return false; }
+
+    // With the room's reset(), back to a fresh session
+    virtual void reset() {}
+
+    // The extension's part of the room's serializeState(), for a checkpoint
+    // or a new build of the plugin to pick up; empty when it keeps nothing
+    // beyond a fresh session. deserializeState() hands it to a fresh session
+    // and returns false if it cannot take it.
+    virtual std::string serializeState() const { return std::string(); }
+    virtual bool deserializeState(const std::string& /*data*/) { return true; }
+};
+
+} // namespace devescape
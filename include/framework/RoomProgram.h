@@ -0,0 +1,208 @@
+#pragma once
+
+#include "framework/CommandGrammar.h"
+#include "framework/DataTypes.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * Interned strings: each distinct text is stored once, back to back in one
+ * buffer, and named by a dense id. Ids stay valid as the pool grows.
+ */
+class DEVESCAPE_API StringPool {
+public:
+    using Id = uint32_t;
+    static constexpr Id EMPTY = 0;  // ""
+
+    StringPool();
+
+    Id intern(std::string_view text);
+    std::string_view get(Id id) const {
+        return std::string_view(text_.data() + spans_[id].offset, spans_[id].length);
+    }
+    size_t size() const { return spans_.size(); }
+
+private:
+    struct Span {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    std::string text_;
+    std::vector<Span> spans_;
+    std::vector<Id> table_;  // open addressing over hashes, 0 when free
+
+    void grow();
+};
+
+/**
+ * A room compiled from a definition file into flat, index-based tables:
+ * the player's input matches a pattern giving a verb, (phase, verb) indexes
+ * a range of rules, and the first rule whose test passes runs its actions.
+ * Every name and text is a StringPool id, so nothing is looked up by string
+ * at run time. RoomEngine plays it.
+ *
+ * Room definition format (see data/rooms/):
+ *
+ *     room "Production Incident"        # metadata: version, author,
+ *     duration 2700                     # description, title, banner
+ *     puzzle alert_analysis "Alert Analysis"
+ *     command alerts "examine <rest>"   # verb, CommandGrammar pattern
+ *     complete "examine logs"           # offered by tab completion
+ *
+ *     on hint                           # rules before any phase apply in all
+ *         hint
+ *         effect hint
+ *
+ *     phase alert_analysis "Alert Analysis"
+ *         puzzle alert_analysis         # the phase's puzzle, unlocked on entry
+ *         music crisis                  # theme, played on entry
+ *         prompt "Try: examine logs"    # reply to anything unhandled
+ *         text 3 8 alert "[CRITICAL] Payment API returned 500"
+ *         pane logs 2 10 76 10          # extension drawn at x y width height
+ *         hint "Look for [ERROR] level entries."
+ *         hint "Filter on the database." after 120
+ *         on query
+ *             call logs filter          # extension and operation
+ *         on alerts contains database   # verb and test
+ *             solve
+ *             goto metrics_navigation
+ *         on alerts
+ *             wrong
+ *             say "Not quite."
+ *
+ * Tests: none (always), `contains <word>...` (the <rest> holds every
+ * word), `number <low> <high>` (the first argument is in range) and
+ * `nonumber`. Actions: `say "text"` (lines join the reply), `event "text"`,
+ * `effect <name>`, `solve`, `wrong`, `answer` (the first argument becomes
+ * the puzzle's answer), `goto <phase>`, `end` (the room is won), `hint`
+ * and `prompt`. In say and event text, {0} to {7} stand for the arguments.
+ *
+ * Besides the command verbs, `start` runs when the session starts,
+ * `timeout` when it times out and `other` on input no pattern matches.
+ * A command with no rule that applies gets the phase's prompt. A phase
+ * marked `final` ends the room; its prompt also ends the session.
+ *
+ * A hint with `after <seconds>` is held back until the phase has run that
+ * long; a phase's hints unlock in the order they are listed.
+ */
+struct DEVESCAPE_API RoomProgram {
+    using Id = StringPool::Id;
+
+    static constexpr uint32_t VERB_START = 0;
+    static constexpr uint32_t VERB_TIMEOUT = 1;
+    static constexpr uint32_t VERB_OTHER = 2;
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+
+    enum class Test : uint8_t { ALWAYS, CONTAINS, NUMBER, NO_NUMBER };
+    enum class Op : uint8_t {
+        SAY, EVENT, EFFECT, SOLVE, WRONG, ANSWER, GOTO, END, HINT, PROMPT, CALL
+    };
+
+    struct Action {
+        Op op;
+        uint32_t operand;  // string id, phase index for GOTO, extension for CALL
+        Id argument = StringPool::EMPTY;  // CALL: the operation
+    };
+
+    struct Rule {
+        Test test = Test::ALWAYS;
+        uint32_t firstWord = 0;    // CONTAINS: into words
+        uint32_t wordCount = 0;
+        int64_t low = 0;           // NUMBER
+        int64_t high = 0;
+        uint32_t firstAction = 0;  // into actions
+        uint32_t actionCount = 0;
+    };
+
+    struct RuleRange {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    struct TextLine {
+        int x = 0;
+        int y = 0;
+        ColorType color = ColorType::DEFAULT;
+        bool bold = false;
+        Id text = StringPool::EMPTY;
+    };
+
+    struct Phase {
+        Id name = StringPool::EMPTY;
+        Id title = StringPool::EMPTY;
+        Id prompt = StringPool::EMPTY;
+        uint32_t puzzle = NONE;
+        ThemeType music = ThemeType::AMBIENT;
+        bool hasMusic = false;
+        bool final = false;
+        uint32_t firstLine = 0;  // into lines
+        uint32_t lineCount = 0;
+        uint32_t firstHint = 0;  // into hints
+        uint32_t hintCount = 0;
+        uint32_t pane = NONE;    // extension drawn in the phase, if any
+        int paneX = 0;
+        int paneY = 0;
+        int paneWidth = 0;
+        int paneHeight = 0;
+    };
+
+    struct Puzzle {
+        Id id = StringPool::EMPTY;
+        Id title = StringPool::EMPTY;
+    };
+
+    StringPool strings;
+    Id name = StringPool::EMPTY;
+    Id version = StringPool::EMPTY;
+    Id author = StringPool::EMPTY;
+    Id description = StringPool::EMPTY;
+    Id title = StringPool::EMPTY;   // header box
+    Id banner = StringPool::EMPTY;  // line under it
+    ColorType bannerColor = ColorType::DEFAULT;
+    bool bannerBold = false;
+    uint32_t durationSeconds = 0;
+
+    std::vector<Id> verbs;          // start, timeout, other, then commands
+    CommandGrammar grammar;         // pattern to verb index
+    std::vector<Id> completions;
+    std::vector<Puzzle> puzzles;
+    std::vector<Phase> phases;      // phases[0] is where the room starts
+    std::vector<Id> extensions;     // names used by call and pane
+    std::vector<TextLine> lines;
+    std::vector<Id> hints;
+    std::vector<uint32_t> hintDelays;  // by hint, seconds into the phase before it unlocks
+    std::vector<Id> words;
+    std::vector<Action> actions;
+    std::vector<Rule> rules;
+    // [phase][verb], then one row of rules for every phase
+    std::vector<RuleRange> ruleTable;
+    int maxHintLevel = 0;
+
+    static bool load(const std::string& path, RoomProgram& program);
+
+    RuleRange phaseRules(uint32_t phase, uint32_t verb) const {
+        return ruleTable[phase * verbs.size() + verb];
+    }
+    RuleRange globalRules(uint32_t verb) const {
+        return ruleTable[phases.size() * verbs.size() + verb];
+    }
+    std::string_view text(Id id) const { return strings.get(id); }
+};
+
+} // namespace devescape
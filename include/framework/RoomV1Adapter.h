@@ -0,0 +1,73 @@
+#pragma once
+
+#include "framework/IEscapeRoomV2.h"
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * Presents a v1 plugin room (one reporting PLUGIN_ABI_V1, built against
+ * the pmr data types) through IEscapeRoomV2. Batches become one
+ * processInput() per command, every frame is updated and redrawn, and no
+ * capabilities are claimed. Does not own the wrapped room.
+ */
+class DEVESCAPE_API RoomV1Adapter final : public IEscapeRoomV2 {
+public:
+    explicit RoomV1Adapter(IEscapeRoom* room) : room_(room) {}
+
+    IEscapeRoom* wrapped() const { return room_; }
+
+    // IEscapeRoomV2
+    uint32_t getCapabilities() const override { return ROOM_CAP_NONE; }
+    size_t processInputs(Span<const std::string> commands,
+                         std::pmr::vector<ProcessResult>& results) override;
+    UpdateHint updateFrame(float deltaTimeSeconds) override;
+
+    // Metadata
+    std::string getName() const override { return room_->getName(); }
+    std::string getVersion() const override { return room_->getVersion(); }
+    std::string getAuthor() const override { return room_->getAuthor(); }
+    std::string getDescription() const override { return room_->getDescription(); }
+    uint32_t getTotalDurationSeconds() const override { return room_->getTotalDurationSeconds(); }
+
+    // Lifecycle
+    void initialize(const FrameworkContext& context) override { room_->initialize(context); }
+    void cleanup() override { room_->cleanup(); }
+
+    // State
+    GameState getCurrentState() const override { return room_->getCurrentState(); }
+    bool isCompleted() const override { return room_->isCompleted(); }
+    bool isFailed() const override { return room_->isFailed(); }
+    int getCompletionPercentage() const override { return room_->getCompletionPercentage(); }
+
+    // Interaction
+    ProcessResult processInput(const std::string& command) override { return room_->processInput(command); }
+    void render(TerminalRenderer& renderer) const override { room_->render(renderer); }
+    void update(float deltaTimeSeconds) override { room_->update(deltaTimeSeconds); }
+
+    // Persistence
+    std::string serializeState() const override { return room_->serializeState(); }
+    bool deserializeState(const std::string& data) override { return room_->deserializeState(data); }
+
+    // Hints
+    std::string getHint(int hintLevel) override { return room_->getHint(hintLevel); }
+    int getMaxHintLevel() const override { return room_->getMaxHintLevel(); }
+    bool canUseHint() const override { return room_->canUseHint(); }
+
+    // Timeout
+    void onSessionTimeout() override { room_->onSessionTimeout(); }
+
+private:
+    IEscapeRoom* room_;
+};
+
+} // namespace devescape
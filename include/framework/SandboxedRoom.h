@@ -0,0 +1,162 @@
+#pragma once
+
+#include "framework/IEscapeRoomV2.h"
+#include "framework/ShmRingBuffer.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * Runs a plugin room in a child process and forwards the IEscapeRoom
+ * interface to it over a pair of shared-memory rings. The child is the
+ * devescape_sandbox helper, spawned fresh (never forked from the
+ * multi-threaded host), which loads the plugin library itself and calls
+ * serveChild().
+ *
+ * A crash or hang in the room only costs that child: a watchdog deadline
+ * on every call kills an unresponsive child and a new one is started from
+ * the room's last snapshot. Snapshots are taken at most every couple of
+ * seconds, and only after the room took commands, so a restart can lose
+ * the last moments of play. POSIX only; on Windows isSupported() is false.
+ *
+ * The child runs without the framework's AudioManager and StateManager,
+ * which belong to the host process. v1 rooms are adapted inside the child,
+ * so a processInputs() batch is always a single round trip.
+ */
+class DEVESCAPE_API SandboxedRoom : public IEscapeRoomV2 {
+public:
+    typedef IEscapeRoom* (*CreateRoomFunc)();
+    typedef void (*DestroyRoomFunc)(IEscapeRoom*);
+
+    // pluginPath is the library the helper loads; abiVersion is the
+    // plugin's negotiated ABI (see pluginAbiVersion), v1 or later
+    SandboxedRoom(const std::string& pluginPath, uint32_t abiVersion,
+                  std::chrono::milliseconds callTimeout = std::chrono::milliseconds(1000));
+    ~SandboxedRoom() override;
+
+    static bool isSupported();
+
+    // The helper executable; by default devescape_sandbox next to the
+    // running executable, else the one this build made
+    static void setHelperPath(const std::string& path);
+
+    // The helper's side: maps the shared block at sharedFd and serves one
+    // room made with createRoom until the host shuts it down. Returns the
+    // helper's exit status.
+    static int serveChild(int sharedFd, CreateRoomFunc createRoom, DestroyRoomFunc destroyRoom,
+                          uint32_t abiVersion);
+
+    // IEscapeRoomV2
+    uint32_t getCapabilities() const override { return description_.capabilities; }
+    size_t processInputs(Span<const std::string> commands,
+                         std::pmr::vector<ProcessResult>& results) override;
+    UpdateHint updateFrame(float deltaTimeSeconds) override;
+
+    // Metadata (fetched once when the child starts)
+    std::string getName() const override { return description_.name; }
+    std::string getVersion() const override { return description_.version; }
+    std::string getAuthor() const override { return description_.author; }
+    std::string getDescription() const override { return description_.description; }
+    uint32_t getTotalDurationSeconds() const override { return description_.durationSeconds; }
+
+    // Lifecycle
+    void initialize(const FrameworkContext& context) override;
+    void cleanup() override;
+
+    // State (status flags are refreshed with every update and command)
+    GameState getCurrentState() const override;
+    bool isCompleted() const override { return status_.completed; }
+    bool isFailed() const override { return status_.failed; }
+    int getCompletionPercentage() const override { return status_.completionPercent; }
+
+    // Interaction
+    ProcessResult processInput(const std::string& command) override;
+    void render(TerminalRenderer& renderer) const override;
+    void update(float deltaTimeSeconds) override;
+
+    // Persistence
+    std::string serializeState() const override;
+    bool deserializeState(const std::string& data) override;
+
+    // Hints
+    std::string getHint(int hintLevel) override;
+    int getMaxHintLevel() const override { return description_.maxHintLevel; }
+    bool canUseHint() const override { return status_.canUseHint; }
+
+    // Timeout
+    void onSessionTimeout() override;
+
+    int getRestartCount() const { return restartCount_; }
+
+private:
+    struct Description {
+        std::string name;
+        std::string version;
+        std::string author;
+        std::string description;
+        uint32_t durationSeconds = 0;
+        int maxHintLevel = 0;
+        uint32_t capabilities = ROOM_CAP_NONE;
+    };
+
+    struct Status {
+        bool completed = false;
+        bool failed = false;
+        bool canUseHint = false;
+        int completionPercent = 0;
+    };
+
+    std::string pluginPath_;
+    uint32_t abiVersion_;
+    std::chrono::milliseconds callTimeout_;
+
+    int sharedFd_;
+    void* sharedMemory_;
+    size_t sharedBytes_;
+    mutable ShmRingBuffer requests_;
+    mutable ShmRingBuffer responses_;
+    mutable int childPid_;
+    mutable int restartCount_;
+
+    bool initialized_;
+    FrameworkContext context_;
+    mutable std::string lastSnapshot_;
+    bool stateChanged_;  // since lastSnapshot_
+    std::chrono::steady_clock::time_point nextSnapshot_;
+    Description description_;
+    mutable Status status_;
+    mutable std::vector<char> request_;
+    mutable std::vector<char> reply_;
+
+    // Spawns the helper and, once initialized, hands it the context and
+    // lastSnapshot_
+    bool startChild() const;
+    void stopChild(bool graceful) const;
+    void restartChild() const;
+    // Fills description_ from the room's metadata
+    void describe();
+
+    // Sends request_ and waits for the reply in reply_; false on timeout or
+    // child death
+    bool exchange(uint32_t type) const;
+    // exchange(), restarting the child from lastSnapshot_ when it fails
+    bool call(uint32_t type) const;
+    // Refreshes lastSnapshot_ when the room took commands and the last
+    // snapshot is old enough
+    void snapshotIfDue();
+    void snapshot();
+};
+
+} // namespace devescape
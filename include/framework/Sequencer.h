@@ -0,0 +1,145 @@
+#pragma once
+
+#include "framework/DataTypes.h"
+#include "framework/NoteStream.h"
+#include "framework/SynthEngine.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+struct PatternCell {
+    static constexpr uint8_t NOTE_NONE = 0xFF;    // keep playing
+    static constexpr uint8_t NOTE_OFF = 0xFE;
+    static constexpr uint8_t VOLUME_KEEP = 0xFF;
+
+    uint8_t note = NOTE_NONE;      // MIDI note number
+    uint8_t volume = VOLUME_KEEP;  // 0-15
+};
+
+/**
+ * One theme's music, compiled from a pattern file: fixed-size patterns of
+ * four-voice rows, and per tension tier a tempo and the order the patterns
+ * play in.
+ */
+struct DEVESCAPE_API Song {
+    static constexpr int TIERS = 4;  // PressureLevel LOW to CRITICAL
+
+    struct Tier {
+        float bpm = 120.0f;
+        std::vector<uint8_t> order;
+    };
+
+    std::string name;
+    int rowsPerPattern = 16;
+    int rowsPerBeat = 4;
+    float duty[2] = {0.5f, 0.5f};  // square voices
+    Tier tiers[TIERS];
+    size_t patternCount = 0;       // 0 until loaded
+    std::vector<PatternCell> cells;  // [pattern][row][voice]
+
+    bool isLoaded() const { return patternCount > 0; }
+    const PatternCell* row(size_t pattern, int row) const {
+        return &cells[(pattern * rowsPerPattern + row) * SynthEngine::VOICE_COUNT];
+    }
+};
+
+/**
+ * Tracker-style sequencer driving a SynthEngine. Rows fall on exact sample
+ * positions inside a block (the block is rendered in pieces between them),
+ * and each row is a table lookup per voice. Tension picks a tier: its tempo
+ * applies from the next row, its pattern order from the next pattern, and
+ * pitch is never touched.
+ *
+ * Pattern file format (one per theme, see data/music/):
+ *
+ *     theme crisis
+ *     rows 16                # rows per pattern
+ *     speed 4                # rows per beat
+ *     duty 0.125 0.25        # square voices
+ *     tier 0 132 0 0 1 0     # tier, bpm, pattern order
+ *     pattern                # then `rows` lines of four cells
+ *     B4:12  G#4  D3  C7:4
+ *     --     .    .   .
+ *
+ * A cell is a note (C4, F#3, Bb2) with an optional :volume (0-15), `.` to
+ * keep the current note or `--` for note off; `#` starts a comment where a
+ * token would. Noise takes notes too; they set its clock. Tiers not given
+ * copy the one below.
+ *
+ * With an event callback set, every change it makes to the voices is also
+ * reported as a NoteEvent stamped with its sample position, which is all a
+ * NoteStreamPlayer needs to play the song elsewhere; advance() then moves
+ * the song along without rendering anything.
+ *
+ * Single-threaded like SynthEngine: AudioManager runs it on the audio thread.
+ */
+class DEVESCAPE_API Sequencer {
+public:
+    using EventCallback = void (*)(void* userdata, const NoteEvent& event);
+
+    Sequencer();
+
+    // Noise notes set the shift register clock this many times the pitch
+    static constexpr float NOISE_CLOCK_RATIO = 8.0f;
+
+    static bool loadSong(const std::string& path, Song& song);
+    static const char* themeName(ThemeType theme);
+    // A comment is a '#' starting a token; inside one it is a sharp (F#3)
+    static std::string stripComment(const std::string& line);
+    // "C4", "F#3", "Bb2" to a MIDI note number
+    static bool parseNote(const std::string& text, uint8_t& note);
+    static float noteFrequency(uint8_t note);
+    // Level of a voice at volume 15
+    static float voiceGain(int voice);
+
+    // Starts a song from its first row; the song must outlive playback
+    void play(const Song* song, SynthEngine& synth);
+    void stop(SynthEngine& synth);
+    bool isPlaying() const { return song_ != nullptr; }
+    const Song* getSong() const { return song_; }
+
+    void setTier(int tier);
+    int getTier() const { return tier_; }
+    float getBpm() const;
+
+    // Renders frameCount samples, applying rows as their sample comes up
+    void render(SynthEngine& synth, float* buffer, size_t frameCount);
+    // Same as render() without the samples, for event output
+    void advance(SynthEngine& synth, size_t frameCount);
+
+    // Events go to callback(userdata, event) as they happen; nullptr stops them
+    void setEventCallback(EventCallback callback, void* userdata);
+    // Samples rendered or advanced so far; events are stamped with it
+    uint64_t getPosition() const { return position_; }
+
+private:
+    const Song* song_;
+    int tier_;
+    size_t orderIndex_;
+    int row_;
+    double samplesUntilRow_;
+    uint64_t position_;
+    EventCallback eventCallback_;
+    void* eventUserdata_;
+    float eventBpm_;  // last TEMPO sent
+
+    void process(SynthEngine& synth, float* buffer, size_t frameCount);
+    void applyRow(SynthEngine& synth);
+    void advanceRow();
+    void emit(NoteEventType type, int voice, uint8_t note, uint8_t volume, uint32_t value);
+};
+
+} // namespace devescape
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * Per-session memory arena.
+ *
+ * A pool resource layered on a monotonic buffer: short-lived strings that are
+ * freed mid-session (event text, command results, renderer rows) are recycled
+ * by the pool, and everything the session ever allocated is returned to the
+ * global heap in one go by release().
+ */
+class DEVESCAPE_API SessionArena {
+public:
+    explicit SessionArena(std::size_t initialBytes = 64 * 1024);
+    ~SessionArena();
+
+    SessionArena(const SessionArena&) = delete;
+    SessionArena& operator=(const SessionArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &pool_; }
+
+    // Frees every allocation made through resource(). Anything still holding
+    // arena memory (room state, renderers) must be destroyed first.
+    void release();
+
+private:
+    std::unique_ptr<std::byte[]> initialBuffer_;
+    std::size_t initialBytes_;
+    std::pmr::monotonic_buffer_resource monotonic_;
+    std::pmr::unsynchronized_pool_resource pool_;
+};
+
+} // namespace devescape
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "framework/ClockSource.h"
+#include "framework/IEscapeRoomV2.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+// Identifies what a recording was made against
+struct DEVESCAPE_API RecordingHeader {
+    std::string pluginName;
+    uint32_t pluginVersion = 0;  // as from getPluginVersion(): ABI in the top byte
+    std::string roomVersion;     // IEscapeRoom::getVersion()
+    std::chrono::system_clock::time_point wallStart;  // clock's wall time as the first frame began
+    std::string initialState;    // serializeState() at that point; replays start from it
+};
+
+// Binary recording layout, shared by SessionRecorder and SessionReplayer.
+//
+//   magic[8]  pluginName  varint pluginVersion  roomVersion
+//   varint wallStart (ns since the epoch)  initialState  record...
+//
+// Strings are a varint length followed by the bytes. Each record starts
+// with a varint (count << 3 | kind); frames follow it with the zigzag
+// varint difference between this and the previous frame's delta in clock
+// ticks, then `count` command strings. Idle frames at a steady frame rate
+// take two or three bytes.
+namespace recording {
+
+constexpr char MAGIC[8] = {'D', 'E', 'V', 'R', 'E', 'C', 0, 1};
+
+enum RecordKind : uint32_t {
+    RECORD_FRAME = 0,          // delta, commands
+    RECORD_TIMEOUT_FRAME = 1,  // delta; the countdown ran out this frame
+    RECORD_CHECKPOINT = 2,     // u64 state hash, varint state length
+    RECORD_RELOAD = 3,         // the room was migrated to a rebuilt plugin
+    RECORD_END = 4             // final state hash and length
+};
+
+constexpr uint32_t KIND_BITS = 3;
+
+// FNV-1a over serializeState()
+DEVESCAPE_API uint64_t hashState(const std::string& state);
+
+} // namespace recording
+
+/**
+ * Writes a session recording: every frame's delta and input batch as the
+ * game loop handed them to the room, plus a hash of serializeState() at
+ * each checkpoint. Writes are buffered and flushed at checkpoints, so a
+ * crashed session keeps everything up to its last autosave.
+ */
+class DEVESCAPE_API SessionRecorder {
+public:
+    SessionRecorder();
+    ~SessionRecorder();
+
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    bool open(const std::string& path, const RecordingHeader& header);
+    bool isOpen() const { return out_.is_open(); }
+
+    void recordFrame(ClockSource::duration delta, Span<const std::string> commands);
+    void recordTimeoutFrame(ClockSource::duration delta);
+    void recordReload();
+    void recordCheckpoint(const std::string& state);
+
+    // Writes the final state and closes the file
+    void close(const std::string& finalState);
+
+    uint64_t getFrameCount() const { return frames_; }
+
+private:
+    std::ofstream out_;
+    std::string buffer_;
+    int64_t lastDeltaTicks_;
+    uint64_t frames_;
+
+    void writeRecord(uint32_t kind, uint64_t count);
+    void writeVarint(uint64_t value);
+    void writeString(const std::string& value);
+    void writeDelta(ClockSource::duration delta);
+    void writeState(const std::string& state);
+    void flush();
+};
+
+} // namespace devescape
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "framework/SessionRecorder.h"
+#include "framework/IEscapeRoomV2.h"
+#include <cstdint>
+#include <string>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+enum class ReplaySpeed {
+    RECORDED,  // frames paced at their recorded deltas
+    FAST       // no waiting between frames
+};
+
+struct DEVESCAPE_API ReplayReport {
+    uint64_t frames = 0;
+    uint64_t commands = 0;
+    int checkpointsVerified = 0;
+    int checkpointsMismatched = 0;
+    int64_t firstMismatchFrame = -1;  // frames replayed before the first bad checkpoint
+    bool reachedEnd = false;          // the recording's final state was compared
+    bool sessionEnded = false;        // the room ended the session
+    bool timedOut = false;
+    double realSeconds = 0.0;         // wall time the replay took
+    double sessionSeconds = 0.0;      // recorded time covered
+    std::string error;                // set for unreadable or truncated recordings
+
+    bool passed() const { return error.empty() && reachedEnd && checkpointsMismatched == 0; }
+};
+
+/**
+ * Replays a SessionRecorder file into a room. Each frame goes through the
+ * same steps as the game loop - timeout, the input batch through
+ * processInputs(), then updateFrame() deferred to the room's requested
+ * wakeup - using the recorded deltas, so a deterministic room ends up in
+ * the same state; serializeState() is checked against every recorded
+ * checkpoint.
+ *
+ * The room is first restored to the recorded initial state, and the clock
+ * runs virtually from the recorded start, so event timestamps come out the
+ * same; it goes back to its previous mode afterwards. The room should come
+ * from the plugin named in the header.
+ */
+class DEVESCAPE_API SessionReplayer {
+public:
+    SessionReplayer();
+
+    bool load(const std::string& path);
+    const RecordingHeader& getHeader() const { return header_; }
+    uint64_t getFrameCount() const { return frameCount_; }
+
+    // Stops at the first mismatched checkpoint unless keepGoing is set
+    ReplayReport replay(IEscapeRoomV2& room, ReplaySpeed speed, bool keepGoing = false,
+                        ClockSource& clock = ClockSource::shared()) const;
+
+private:
+    std::string data_;
+    size_t recordsOffset_;
+    RecordingHeader header_;
+    uint64_t frameCount_;
+};
+
+} // namespace devescape
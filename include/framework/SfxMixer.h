@@ -0,0 +1,129 @@
+#pragma once
+
+#include "framework/SpscQueue.h"
+#include "framework/SynthEngine.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+// One step of an effect program: a waveform held for `seconds` while pitch
+// slides exponentially and volume linearly from start to end
+struct SfxStep {
+    Waveform waveform = Waveform::SQUARE;
+    float duty = 0.5f;
+    float startFrequency = 440.0f;  // Hz; for noise, the shift register clock
+    float endFrequency = 440.0f;
+    float startVolume = 1.0f;       // 0-1
+    float endVolume = 1.0f;
+    float seconds = 0.05f;
+};
+
+struct SfxEffect {
+    std::string name;
+    int priority = 0;     // higher effects steal voices from lower ones
+    size_t firstStep = 0;
+    size_t stepCount = 0;
+};
+
+/**
+ * One-shot sound effects on a fixed pool of voices, separate from the
+ * music's four. Named effects are compiled from an effect file into step
+ * programs before playback; triggers then cross from the game thread in a
+ * wait-free queue and start on a free voice, or steal one when all are
+ * sounding.
+ *
+ * Effect file format (see data/sfx/effects.sfx):
+ *
+ *     effect solve 2          # name, priority
+ *     square:0.5  C5      12      60    # waveform[:duty], pitch, volume, ms
+ *     square:0.5  G5->C6  12->0   240   # a->b slides over the step
+ *
+ * Pitch is a note (as in pattern files; noise notes set its clock) or a
+ * frequency in Hz, volume is 0-15.
+ *
+ * trigger() is the only call for the game thread; everything else belongs
+ * to the audio thread once it is mixing, or comes before it starts.
+ */
+class DEVESCAPE_API SfxMixer {
+public:
+    static constexpr int VOICE_COUNT = 8;
+    static constexpr int NO_EFFECT = -1;
+
+    enum class StealPolicy : uint8_t {
+        OLDEST,           // the longest-sounding voice, whatever its priority
+        LOWEST_PRIORITY   // the oldest of the lowest priority, never a higher one
+    };
+
+    explicit SfxMixer(int sampleRate = 44100,
+                      const synth::KernelTable& kernels = synth::bestKernels());
+
+    SfxMixer(const SfxMixer&) = delete;
+    SfxMixer& operator=(const SfxMixer&) = delete;
+
+    bool loadEffects(const std::string& path);
+    int findEffect(std::string_view name) const;  // NO_EFFECT if unknown
+    size_t getEffectCount() const { return effects_.size(); }
+    const SfxEffect& getEffect(int effect) const { return effects_[effect]; }
+
+    void setSampleRate(int sampleRate) { sampleRate_ = sampleRate; }
+    void setStealPolicy(StealPolicy policy) { policy_ = policy; }
+    void setGain(float gain) { gain_ = gain; }
+
+    // Game thread. No locks, no allocation; false when the queue is full
+    bool trigger(int effect);
+
+    // Starts queued effects, then adds every sounding voice into buffer
+    void mix(float* buffer, size_t frameCount);
+    // Instead of mix(), when the effects play elsewhere: the next queued
+    // trigger, false when there is none
+    bool popTrigger(int& effect);
+
+    int getActiveVoices() const;
+    uint32_t getStolenCount() const { return stolen_.load(std::memory_order_relaxed); }
+    uint32_t getDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Voice {
+        int effect = NO_EFFECT;  // NO_EFFECT while free
+        int priority = 0;
+        uint64_t startedAt = 0;  // start sequence number, for age
+        size_t step = 0;
+        uint32_t stepFrame = 0;
+        uint32_t stepFrames = 0;
+        double phase = 0.0;
+        uint32_t lfsr = 0xACE1u;
+    };
+
+    std::vector<SfxStep> steps_;
+    std::vector<SfxEffect> effects_;  // sorted by name
+    Voice voices_[VOICE_COUNT];
+    SpscQueue<int32_t, 64> triggers_;
+    uint64_t started_;
+    int sampleRate_;
+    float gain_;
+    StealPolicy policy_;
+    const synth::KernelTable* kernels_;
+    std::atomic<uint32_t> stolen_;
+    std::atomic<uint32_t> dropped_;  // queue full, or outranked by every voice
+
+    void start(int effect);
+    void enterStep(Voice& voice, size_t step);
+    void renderVoice(Voice& voice, float* buffer, size_t frameCount);
+};
+
+} // namespace devescape
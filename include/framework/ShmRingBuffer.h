@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * Single-producer/single-consumer ring of framed messages that lives in
+ * memory shared between two processes. All state, including the futex word
+ * used to park an idle reader, is inside the mapped block, so the ring works
+ * between any processes that map it.
+ */
+class DEVESCAPE_API ShmRingBuffer {
+public:
+    struct Header;
+
+    // Bytes of shared memory needed for a ring with the given payload capacity
+    // (a power of two).
+    static size_t requiredBytes(size_t capacity);
+
+    ShmRingBuffer() : header_(nullptr), data_(nullptr), capacity_(0) {}
+
+    // Formats a fresh ring in memory; call once before the peer attaches.
+    static ShmRingBuffer create(void* memory, size_t capacity);
+    // The peer's view of a ring that create() formatted, mapped elsewhere.
+    static ShmRingBuffer attach(void* memory);
+
+    // Producer side. Fails if the message does not fit right now.
+    bool write(uint32_t type, const void* payload, uint32_t length);
+
+    // Consumer side. Non-blocking; the payload buffer is reused between calls.
+    bool read(uint32_t& type, std::vector<char>& payload);
+
+    // Spins briefly, then sleeps until a message arrives or the timeout passes.
+    bool waitReadable(std::chrono::microseconds timeout);
+
+    void reset();
+    size_t maxMessageSize() const { return capacity_ / 2; }
+
+private:
+    Header* header_;
+    char* data_;
+    size_t capacity_;
+
+    void copyIn(uint64_t position, const void* src, size_t length);
+    void copyOut(uint64_t position, void* dst, size_t length) const;
+    void notify();
+};
+
+struct ShmRingBuffer::Header {
+    alignas(64) std::atomic<uint64_t> head;      // bytes published by the producer
+    alignas(64) std::atomic<uint64_t> tail;      // bytes consumed by the consumer
+    alignas(64) std::atomic<uint32_t> wakeSequence;
+    std::atomic<uint32_t> sleepers;
+    uint64_t capacity;
+};
+
+} // namespace devescape
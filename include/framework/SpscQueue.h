@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace devescape {
+
+/**
+ * Bounded single-producer/single-consumer queue for handing small POD
+ * messages to a real-time thread (the audio callback).
+ *
+ * push() and pop() are wait-free: each is a copy plus one acquire load and
+ * one release store, and never locks or allocates. Each side caches the
+ * other's index and only re-reads it when the queue looks full (producer)
+ * or empty (consumer), so the shared cache lines are touched rarely.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscQueue items are copied from the real-time thread");
+
+public:
+    SpscQueue() : head_(0), tailCache_(0), tail_(0), headCache_(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side; false when the queue is full
+    bool push(const T& item) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tailCache_ == Capacity) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head - tailCache_ == Capacity) {
+                return false;
+            }
+        }
+        slots_[head & (Capacity - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when the queue is empty
+    bool pop(T& item) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == headCache_) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail == headCache_) {
+                return false;
+            }
+        }
+        item = slots_[tail & (Capacity - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    alignas(64) std::atomic<uint64_t> head_;  // written by the producer
+    uint64_t tailCache_;                      // producer's copy of tail_
+    alignas(64) std::atomic<uint64_t> tail_;  // written by the consumer
+    uint64_t headCache_;                      // consumer's copy of head_
+    alignas(64) T slots_[Capacity];
+};
+
+} // namespace devescape
@@ -20,6 +20,7 @@ namespace devescape {
 struct GameSession {
     SessionMetadata metadata;
     GameState currentRoomState;
+    std::string roomSnapshot;  // the room's serializeState(), restored on resume
     int timeRemainingSeconds;
 };
 
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace devescape {
+
+class IEscapeRoom;
+class CommandTrie;
+
+/**
+ * A room plugin linked into the executable (DEVESCAPE_STATIC_PLUGINS) rather
+ * than loaded from a shared library. Holds the same entry points a plugin
+ * library exports.
+ */
+struct StaticPluginEntry {
+    const char* name;
+    uint32_t (*getPluginVersion)();
+    IEscapeRoom* (*createRoom)();
+    void (*destroyRoom)(IEscapeRoom*);
+    bool (*resetRoom)(IEscapeRoom*);
+    bool (*publishCommands)(IEscapeRoom*, CommandTrie*);
+};
+
+namespace detail {
+
+template <typename Room, typename = void>
+struct HasReset : std::false_type {};
+
+template <typename Room>
+struct HasReset<Room, std::void_t<decltype(std::declval<Room&>().reset())>> : std::true_type {};
+
+// Backs the optional resetRoom export: rooms with a reset() member can be
+// returned to their post-initialize state in place, which lets the
+// PluginManager's room pool reuse them without a snapshot round trip.
+template <typename Room>
+bool resetRoom(IEscapeRoom* room) {
+    if constexpr (HasReset<Room>::value) {
+        static_cast<Room*>(room)->reset();
+        return true;
+    } else {
+        return false;
+    }
+}
+
+template <typename Room, typename = void>
+struct HasPublishCommands : std::false_type {};
+
+template <typename Room>
+struct HasPublishCommands<Room, std::void_t<decltype(std::declval<const Room&>().publishCommands(
+                                    std::declval<CommandTrie&>()))>> : std::true_type {};
+
+// Backs the optional publishCommands export: rooms with a
+// publishCommands(CommandTrie&) const member hand the framework their
+// command vocabulary for tab completion.
+template <typename Room>
+bool publishCommands(IEscapeRoom* room, CommandTrie* trie) {
+    if constexpr (HasPublishCommands<Room>::value) {
+        static_cast<const Room*>(room)->publishCommands(*trie);
+        return true;
+    } else {
+        return false;
+    }
+}
+
+} // namespace detail
+
+// Defined by the executable in a source generated at configure time from
+// DEVESCAPE_STATIC_PLUGINS (see src/StaticPlugins.cpp.in).
+std::vector<const StaticPluginEntry*> staticPluginEntries();
+
+} // namespace devescape
+
+// Declares a room plugin's entry points. Plugins built as shared libraries
+// get the extern "C" exports the PluginManager looks up; plugins compiled
+// into the executable get a StaticPluginEntry named <id>_entry instead.
+// RoomClass must be fully qualified.
+#ifdef DEVESCAPE_STATIC_PLUGIN
+#define DEVESCAPE_ROOM_PLUGIN(Id, RoomClass, Name, Version)                                  \
+    namespace devescape {                                                                    \
+    namespace static_plugins {                                                               \
+    static IEscapeRoom* Id##_createRoom() { return new RoomClass(); }                        \
+    static void Id##_destroyRoom(IEscapeRoom* room) { delete room; }                         \
+    static uint32_t Id##_getPluginVersion() { return Version; }                              \
+    extern const StaticPluginEntry Id##_entry;                                               \
+    const StaticPluginEntry Id##_entry = {Name, &Id##_getPluginVersion, &Id##_createRoom,    \
+                                          &Id##_destroyRoom, &detail::resetRoom<RoomClass>,  \
+                                          &detail::publishCommands<RoomClass>};              \
+    }                                                                                        \
+    }
+#else
+#define DEVESCAPE_ROOM_PLUGIN(Id, RoomClass, Name, Version)                                  \
+    extern "C" {                                                                             \
+    PLUGIN_EXPORT devescape::IEscapeRoom* createRoom() { return new RoomClass(); }           \
+    PLUGIN_EXPORT void destroyRoom(devescape::IEscapeRoom* room) { delete room; }            \
+    PLUGIN_EXPORT uint32_t getPluginVersion() { return Version; }                            \
+    PLUGIN_EXPORT const char* getPluginName() { return Name; }                               \
+    PLUGIN_EXPORT bool resetRoom(devescape::IEscapeRoom* room) {                             \
+        return devescape::detail::resetRoom<RoomClass>(room);                                \
+    }                                                                                        \
+    PLUGIN_EXPORT bool publishCommands(devescape::IEscapeRoom* room,                         \
+                                       devescape::CommandTrie* trie) {                       \
+        return devescape::detail::publishCommands<RoomClass>(room, trie);                    \
+    }                                                                                        \
+    }
+#endif
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "framework/SynthKernels.h"
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+enum class Waveform : uint8_t {
+    SQUARE,
+    TRIANGLE,
+    NOISE
+};
+
+struct SynthVoice {
+    Waveform waveform = Waveform::SQUARE;
+    float frequency = 440.0f;  // Hz; for noise, the shift register clock
+    float duty = 0.5f;         // square only
+    float volume = 0.25f;
+    bool enabled = false;
+
+    double phase = 0.0;        // cycles, [0, 1)
+    uint32_t lfsr = 0xACE1u;   // noise only; bit 0 is the output
+};
+
+/**
+ * NES-style four voice synthesizer (two squares, triangle, noise) that
+ * renders whole blocks. Each voice is a phase accumulator, so frequency
+ * sets pitch; squares and triangle go through the block kernels of
+ * SynthKernels.h, picked for the CPU at startup.
+ *
+ * Not thread-safe: the owner (the audio thread, once AudioManager has
+ * opened its device) changes voices between render() calls.
+ */
+class DEVESCAPE_API SynthEngine {
+public:
+    static constexpr int VOICE_COUNT = 4;
+
+    explicit SynthEngine(int sampleRate = 44100,
+                         const synth::KernelTable& kernels = synth::bestKernels());
+
+    SynthVoice& voice(int index) { return voices_[index]; }
+    const SynthVoice& voice(int index) const { return voices_[index]; }
+
+    void setSampleRate(int sampleRate) { sampleRate_ = sampleRate; }
+    int getSampleRate() const { return sampleRate_; }
+    void setMasterVolume(float volume) { masterVolume_ = volume; }
+    float getMasterVolume() const { return masterVolume_; }
+    const synth::KernelTable& getKernels() const { return *kernels_; }
+
+    // Overwrites buffer with frameCount mono samples
+    void render(float* buffer, size_t frameCount);
+
+private:
+    SynthVoice voices_[VOICE_COUNT];
+    int sampleRate_;
+    float masterVolume_;
+    const synth::KernelTable* kernels_;
+};
+
+} // namespace devescape
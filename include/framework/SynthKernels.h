@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+namespace synth {
+
+/**
+ * Block oscillator kernels. Each adds gain * waveform into out[0, count)
+ * for a phase accumulator starting at `phase` (cycles, in [0, 1)) and
+ * stepping `increment` cycles per sample (below 0.5), and returns the phase
+ * after the block. Square and triangle are band-limited with PolyBLEP and
+ * PolyBLAMP residuals at their discontinuities.
+ *
+ * This header is shared with the AVX translation unit, so it must stay free
+ * of inline functions (an AVX-encoded copy could be picked by the linker).
+ */
+struct KernelTable {
+    const char* name;
+    double (*addSquare)(float* out, size_t count, double phase, double increment, float duty,
+                        float gain);
+    double (*addTriangle)(float* out, size_t count, double phase, double increment, float gain);
+};
+
+DEVESCAPE_API const KernelTable& scalarKernels();
+DEVESCAPE_API const KernelTable* sseKernels();  // nullptr where not built
+DEVESCAPE_API const KernelTable* avxKernels();  // nullptr where not built; check cpuSupportsAvx()
+
+DEVESCAPE_API bool cpuSupportsAvx();
+
+// Widest table the CPU runs, chosen once
+DEVESCAPE_API const KernelTable& bestKernels();
+
+// Shift register noise. Serial, so it has no vector versions: the register
+// steps each time the phase wraps (increment up to 1) and its output holds
+// in between, so the increment sets the noise colour.
+DEVESCAPE_API double addNoise(float* out, size_t count, double phase, double increment,
+                              uint32_t& lfsr, float gain);
+
+} // namespace synth
+} // namespace devescape
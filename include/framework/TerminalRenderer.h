@@ -1,7 +1,9 @@
 #pragma once
 
 #include "framework/DataTypes.h"
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #if defined(_WIN32)
@@ -14,14 +16,20 @@
   #define DEVESCAPE_API
 #endif
 
+#ifndef _WIN32
+struct termios;
+#endif
+
 namespace devescape {
 
 class DEVESCAPE_API TerminalRenderer {
 public:
-    TerminalRenderer();
+    // Row storage comes from the given resource (normally the session arena).
+    explicit TerminalRenderer(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     ~TerminalRenderer();
 
     void initialize();
+    void resize(int width, int height);
 
     void drawBox(int x, int y, int w, int h, const std::string& title);
     void drawText(int x, int y, const std::string& text, ColorType color = ColorType::DEFAULT, bool bold = false);
@@ -31,16 +39,23 @@ public:
     void clearScreen();
     void render();
     void setCursorVisible(bool visible);
+    void setCursorPosition(int x, int y);  // moves the terminal's cursor after render()
 
     int getWidth() const { return width_; }
     int getHeight() const { return height_; }
 
+    // Raw row access, used to move whole frames between processes
+    std::string_view getLine(int y) const;
+    void setLine(int y, std::string_view line);
+
     std::string getColorCode(ColorType color, bool bold = false) const;
 
 private:
+    // Rooms render through inline members, so this layout is part of the
+    // plugin ABI (see IEscapeRoomV2.h)
     int width_;
     int height_;
-    std::vector<std::string> screenBuffer_;
+    std::pmr::vector<std::pmr::string> screenBuffer_;
 
     void initializeBuffer();
     std::string formatTime(int seconds) const;
@@ -54,12 +69,13 @@ public:
     static void enableCtrlC();
     static void setRawMode();
     static void restoreTerminalMode();
+    // Next complete line typed, or empty; see InputReader for key events
     static std::string readInputNonBlocking();
 
 private:
     static bool originalModeStored_;
 #ifndef _WIN32
-    static struct termios originalTermios_;
+    static ::termios originalTermios_;
 #endif
 };
 
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "framework/ClockSource.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+  #if defined(DEVESCAPE_EXPORTS)
+    #define DEVESCAPE_API __declspec(dllexport)
+  #else
+    #define DEVESCAPE_API __declspec(dllimport)
+  #endif
+#else
+  #define DEVESCAPE_API
+#endif
+
+namespace devescape {
+
+/**
+ * Process-wide timer service on a hierarchical timing wheel.
+ *
+ * Four wheels of 256 slots each cover 1, 256, 65536 and 16777216 ticks per
+ * slot; a timer sits in the coarsest wheel that still resolves it and is
+ * cascaded down as its time approaches. Scheduling and cancelling are O(1),
+ * and advancing skips empty slots of the finest wheel through a bitmap, so
+ * it costs one step per occupied slot or 256-tick block plus the timers
+ * that actually fire, however many are pending.
+ *
+ * Time comes from a ClockSource (the shared one unless given another) and
+ * is only read in advance(), which the game loop calls once per frame;
+ * callbacks run inside advance() on the calling thread and may schedule or
+ * cancel timers themselves.
+ */
+class DEVESCAPE_API TimerService {
+public:
+    using Clock = ClockSource::Clock;
+    using Callback = std::function<void()>;
+    using TimerId = uint64_t;
+
+    static constexpr TimerId INVALID_TIMER = 0;
+
+    explicit TimerService(std::chrono::microseconds tick = std::chrono::milliseconds(1),
+                          ClockSource& clock = ClockSource::shared());
+    ~TimerService();
+
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+
+    // Shared by every session in the process
+    static TimerService& shared();
+
+    ClockSource& getClock() const { return clock_; }
+
+    // One-shot timers; delays round up to whole ticks
+    TimerId scheduleAfter(Clock::duration delay, Callback callback);
+    TimerId scheduleAt(Clock::time_point when, Callback callback);
+
+    // Fires every period, first one period from now. Periods are kept on
+    // the tick grid, so a late advance() never shifts later firings.
+    TimerId schedulePeriodic(Clock::duration period, Callback callback);
+
+    // False if the timer already fired (one-shot) or was cancelled
+    bool cancel(TimerId id);
+    bool isPending(TimerId id) const;
+    size_t pendingCount() const;
+
+    // Runs every callback that is due; returns the number that ran.
+    // advance() reads the clock, advanceTo() takes a time on its timeline.
+    size_t advance();
+    size_t advanceTo(Clock::time_point now);
+
+private:
+    static constexpr int WHEEL_BITS = 8;
+    static constexpr uint32_t WHEEL_SLOTS = 1u << WHEEL_BITS;
+    static constexpr int WHEEL_LEVELS = 4;
+    static constexpr uint32_t NIL = 0xFFFFFFFFu;
+    static constexpr uint32_t EXPIRING = 0xFFFFFFFEu;  // Node::slot while its tick runs
+
+    struct Node {
+        uint64_t expires = 0;  // absolute tick
+        uint64_t period = 0;   // ticks; 0 for one-shot
+        Callback callback;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        uint32_t slot = NIL;   // level * WHEEL_SLOTS + index, NIL when not linked
+        uint32_t generation = 1;
+    };
+
+    ClockSource& clock_;
+    Clock::time_point epoch_;
+    Clock::duration tick_;
+    uint64_t currentTick_;  // next tick to run
+    size_t pending_;
+    bool advancing_;
+
+    std::deque<Node> nodes_;  // deque: nodes stay put while callbacks schedule more
+    std::vector<uint32_t> freeNodes_;
+    uint32_t slots_[WHEEL_LEVELS * WHEEL_SLOTS];
+    uint64_t occupied_[WHEEL_SLOTS / 64];  // non-empty slots of the finest wheel
+    std::vector<std::pair<uint32_t, uint32_t>> due_;  // node, generation of the tick being run
+
+    mutable std::recursive_mutex mutex_;
+
+    TimerId schedule(uint64_t expires, uint64_t period, Callback callback);
+    uint64_t ticksUntil(Clock::time_point when) const;
+    Node* lookup(TimerId id);
+    const Node* lookup(TimerId id) const;
+
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+    void cascade(int level);
+    uint64_t nextBusyTick() const;
+    size_t runTick();
+};
+
+} // namespace devescape
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "framework/DataTypes.h"
+#include "framework/TimerService.h"
 #include <chrono>
 
 #if defined(_WIN32)
@@ -17,14 +18,31 @@ namespace devescape {
 
 class AudioManager;
 
+// Session countdown. Counts down once a second on a TimerService timer
+// anchored at start(), so frame timing never makes it drift; the timer
+// service must be advanced (once per frame) for the count to move.
 class DEVESCAPE_API TimerSystem {
 public:
-    TimerSystem(int totalSeconds, AudioManager* audioMgr);
+    TimerSystem(int totalSeconds, AudioManager* audioMgr,
+                TimerService& timers = TimerService::shared());
+    ~TimerSystem();
+
+    TimerSystem(const TimerSystem&) = delete;
+    TimerSystem& operator=(const TimerSystem&) = delete;
 
     void start();
-    void update(float deltaTime);
+    void stop();
     bool isExpired() const;
 
+    // Runs callback once on the tick the countdown reaches secondsRemaining
+    // (on the next advance if it already has), after the countdown has
+    // moved to it. Cancel through getTimerService().
+    // Only while running: INVALID_TIMER before start() or after stop().
+    TimerService::TimerId scheduleAtRemaining(int secondsRemaining,
+                                              TimerService::Callback callback);
+    TimerService& getTimerService() const { return timers_; }
+
+    int getTotalSeconds() const { return totalSeconds_; }
     int getSecondsRemaining() const { return secondsRemaining_; }
     int getSecondsElapsed() const { return totalSeconds_ - secondsRemaining_; }
     float getPercentRemaining() const;
@@ -33,10 +51,16 @@ public:
 private:
     int totalSeconds_;
     int secondsRemaining_;
-    float accumulatedTime_;
     PressureLevel pressureLevel_;
     AudioManager* audioManager_;
 
+    TimerService& timers_;
+    TimerService::TimerId countdownTimer_;
+    TimerService::Clock::time_point startedAt_;
+    int ticksAhead_;  // seconds counted early by scheduleAtRemaining callbacks
+
+    void tick();
+    void countdownTick();
     void updatePressureLevel();
 };
 
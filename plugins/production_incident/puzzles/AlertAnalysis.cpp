@@ -1,3 +1,558 @@
-// Puzzle implementation stub
-// This would contain detailed puzzle logic in production
-// Currently integrated into ProductionIncidentRoom.cpp
+#include "AlertAnalysis.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using devescape::LogGenerator;
+using devescape::LogIndex;
+
+namespace production_incident {
+
+namespace {
+
+// First slice within the command, then a slice per frame
+constexpr std::chrono::milliseconds COMMAND_BUDGET(50);
+constexpr std::chrono::milliseconds FRAME_BUDGET(8);
+// Between clock checks
+constexpr uint64_t SLICE_BYTES = 4u << 20;
+constexpr size_t SLICE_LINES = 1u << 18;
+
+const char* const LEVEL_NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR", "CRITICAL", "other"};
+
+int levelSlot(uint8_t level) {
+    int slot = 0;
+    while (slot < 5 && !(level & (1u << slot))) {
+        slot++;
+    }
+    return slot;
+}
+
+devescape::ColorType levelColor(uint8_t level) {
+    switch (level) {
+        case LogIndex::LEVEL_CRITICAL:
+            return devescape::ColorType::ALERT;
+        case LogIndex::LEVEL_ERROR:
+            return devescape::ColorType::ERROR_COLOR;
+        case LogIndex::LEVEL_WARN:
+            return devescape::ColorType::WARNING;
+        case LogIndex::LEVEL_DEBUG:
+            return devescape::ColorType::PENDING;
+        default:
+            return devescape::ColorType::DEFAULT;
+    }
+}
+
+// 1234567 -> "1,234,567"
+std::string grouped(size_t value) {
+    std::string digits = std::to_string(value);
+    for (int i = static_cast<int>(digits.size()) - 3; i > 0; i -= 3) {
+        digits.insert(static_cast<size_t>(i), 1, ',');
+    }
+    return digits;
+}
+
+// One writer per log at a time: rooms in a pool share the file, and so do
+// sandboxed rooms in their own processes (hence the lock file too)
+std::mutex& preparationMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+void say(devescape::ProcessResult& result, const std::string& text) {
+    if (!result.outputText.empty()) {
+        result.outputText += '\n';
+    }
+    result.outputText += text;
+}
+
+// Words and "quoted phrases"
+std::vector<std::string> splitQuery(std::string_view text) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < text.size()) {
+        if (text[i] == ' ' || text[i] == '\t') {
+            i++;
+            continue;
+        }
+        size_t end;
+        if (text[i] == '"') {
+            end = text.find('"', i + 1);
+            end = end == std::string_view::npos ? text.size() : end;
+            tokens.emplace_back(text.substr(i + 1, end - i - 1));
+            i = end + 1;
+            continue;
+        }
+        end = text.find_first_of(" \t", i);
+        end = end == std::string_view::npos ? text.size() : end;
+        tokens.emplace_back(text.substr(i, end - i));
+        i = end;
+    }
+    return tokens;
+}
+
+} // namespace
+
+AlertAnalysis::AlertAnalysis()
+    : stage_(Stage::CLOSED)
+    , writeLines_(0)
+    , shownStage_(Stage::CLOSED)
+    , shownPercent_(0)
+    , hasQuery_(false)
+    , scanning_(false)
+    , cursor_(0)
+    , matchCount_(0)
+    , levelCounts_{}
+    , scroll_(0)
+    , restoredScroll_(0)
+    , restorePending_(false)
+    , pageLines_(0) {
+}
+
+AlertAnalysis::~AlertAnalysis() {
+    stopPreparing();
+}
+
+bool AlertAnalysis::open(const std::string& profilePath, const std::string& logPath) {
+    reset();
+    Stage stage = stage_.load();
+    if (profilePath == profilePath_ && logPath == logPath_ && stage != Stage::CLOSED &&
+        stage != Stage::FAILED) {
+        return true;  // already ready, or on its way
+    }
+    stopPreparing();
+    log_.close();
+    datePrefix_.clear();
+    profilePath_ = profilePath;
+    logPath_ = logPath;
+
+    LogGenerator::Profile profile;
+    LogGenerator generator;
+    if (!LogGenerator::loadProfile(profilePath, profile) || !generator.setProfile(profile)) {
+        stage_ = Stage::FAILED;
+        return false;
+    }
+    writeProgress_.linesWritten = 0;
+    writeProgress_.cancel = false;
+    writeLines_ = 0;
+    stage_ = Stage::INDEXING;
+    preparer_ = std::thread(&AlertAnalysis::prepare, this, std::move(generator));
+    return true;
+}
+
+void AlertAnalysis::prepare(LogGenerator generator) {
+    std::lock_guard<std::mutex> guard(preparationMutex());
+#ifndef _WIN32
+    int lockFd = ::open((logPath_ + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+    if (lockFd >= 0) {
+        flock(lockFd, LOCK_EX);
+    }
+#endif
+
+    // Written from the profile on first use, and again after it changes;
+    // a write killed midway left only the temporary file, cleared here
+    std::error_code ec;
+    bool stale = !fs::exists(logPath_, ec) ||
+                 fs::last_write_time(profilePath_, ec) > fs::last_write_time(logPath_, ec);
+    std::remove((logPath_ + ".tmp").c_str());
+    std::remove((logPath_ + ".idx.tmp").c_str());
+    bool ready = true;
+    if (stale) {
+        writeLines_ = generator.getLineCount();
+        stage_ = Stage::WRITING;
+        unsigned cores = std::thread::hardware_concurrency();
+        ready = generator.writeFile(logPath_, cores > 1 ? cores - 1 : 1, &writeProgress_);
+        stage_ = Stage::INDEXING;
+    }
+    if (ready && !writeProgress_.cancel) {
+        ready = log_.open(logPath_) && log_.getLineCount() > 0;
+        if (ready) {
+            std::string_view first = log_.line(0);
+            size_t t = first.find('T');
+            datePrefix_ = t != std::string_view::npos && t < 16 ? std::string(first.substr(0, t + 1))
+                                                                 : "";
+        } else {
+            log_.close();
+        }
+    }
+
+#ifndef _WIN32
+    if (lockFd >= 0) {
+        flock(lockFd, LOCK_UN);
+        close(lockFd);
+    }
+#endif
+    if (!ready && !writeProgress_.cancel) {
+        std::cerr << "Alert Analysis: the incident log " << logPath_
+                  << " could not be prepared; log commands are unavailable" << std::endl;
+    }
+    stage_.store(ready && !writeProgress_.cancel ? Stage::READY : Stage::FAILED);
+}
+
+void AlertAnalysis::stopPreparing() {
+    writeProgress_.cancel = true;
+    if (preparer_.joinable()) {
+        preparer_.join();
+    }
+}
+
+std::string AlertAnalysis::preparation() const {
+    if (stage_.load() == Stage::WRITING && writeLines_ > 0) {
+        uint64_t written = std::min(writeProgress_.linesWritten.load(), writeLines_);
+        return "Writing the incident log: " + std::to_string(written * 100 / writeLines_) +
+               "% of " + grouped(writeLines_) + " lines";
+    }
+    return "Preparing the incident log...";
+}
+
+bool AlertAnalysis::isBusy() const {
+    Stage stage = stage_.load();
+    return scanning_ || restorePending_ || stage == Stage::WRITING || stage == Stage::INDEXING;
+}
+
+void AlertAnalysis::reset() {
+    query_ = Query();
+    hasQuery_ = false;
+    scanning_ = false;
+    cursor_ = 0;
+    matchCount_ = 0;
+    std::fill(std::begin(levelCounts_), std::end(levelCounts_), 0);
+    shown_.clear();
+    scroll_ = 0;
+    restoredScroll_ = 0;
+    restorePending_ = false;
+    restoredQuery_.clear();
+}
+
+std::string AlertAnalysis::serializeState() const {
+    if (!hasQuery_) {
+        return std::string();
+    }
+    nlohmann::json j;
+    j["query"] = query_.source;
+    j["scroll"] = scroll_;
+    return j.dump();
+}
+
+bool AlertAnalysis::deserializeState(const std::string& data) {
+    try {
+        nlohmann::json j = nlohmann::json::parse(data);
+        restoredQuery_ = j.at("query").get<std::string>();
+        restoredScroll_ = j.value("scroll", size_t(0));
+    } catch (...) {
+        return false;
+    }
+    restorePending_ = true;
+    return true;
+}
+
+void AlertAnalysis::call(std::string_view operation, const devescape::CommandMatch& match,
+                         devescape::ProcessResult& result) {
+    Stage stage = stage_.load();
+    if (stage == Stage::WRITING || stage == Stage::INDEXING) {
+        say(result, preparation() + "; try again in a moment.");
+        return;
+    }
+    if (stage != Stage::READY) {
+        say(result, "The incident log is not available.");
+        return;
+    }
+
+    if (operation == "scroll") {
+        restoredScroll_ = 0;
+        size_t page = std::max<size_t>(pageLines_, 1);
+        size_t bottom = shown_.size() > page ? shown_.size() - page : 0;
+        if (match.rest.find("top") != std::string_view::npos) {
+            scroll_ = 0;
+        } else if (match.rest.find("bottom") != std::string_view::npos) {
+            scroll_ = bottom;
+        } else if (match.rest.find("up") != std::string_view::npos) {
+            scroll_ -= std::min(scroll_, page);
+        } else {
+            scroll_ = std::min(scroll_ + page, bottom);
+        }
+        return;
+    }
+
+    Query query;
+    std::string error;
+    if (!parse(operation == "examine" ? std::string_view() : match.rest, query, error)) {
+        say(result, error);
+        return;
+    }
+    start(query);
+    scan(COMMAND_BUDGET);
+
+    if (operation == "examine") {
+        say(result, grouped(log_.getLineCount()) + " lines from " +
+                        std::string(log_.line(0).substr(0, 19)) + " to " +
+                        std::string(log_.line(log_.getLineCount() - 1).substr(0, 19)) + ".");
+        say(result, "Narrow them down: filter logs ERROR, count ERROR from 10:00 to 10:10");
+    } else if (operation == "count") {
+        say(result, scanning_ ? "Counting... " + progress() + "; the pane shows the total."
+                              : totals());
+    } else {
+        say(result, progress());
+    }
+}
+
+bool AlertAnalysis::parse(std::string_view text, Query& query, std::string& error) const {
+    query = Query();
+    query.source = text;
+    query.lastLine = log_.getLineCount();
+
+    std::vector<std::string> tokens = splitQuery(text);
+    uint8_t levels = 0;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const std::string& token = tokens[i];
+        if (token == "from" || token == "to") {
+            std::string prefix;
+            if (i + 1 >= tokens.size() || !timePrefix(tokens[i + 1], prefix)) {
+                error = "'" + token + "' needs a time, like 10:02 or 10:02:30";
+                return false;
+            }
+            if (token == "from") {
+                query.firstLine = log_.lowerBound(prefix);
+            } else {
+                query.lastLine = log_.upperBound(prefix);
+            }
+            query.text += (query.text.empty() ? "" : " ") + token;
+            i++;
+            query.text += " " + tokens[i];
+            continue;
+        } else if (uint8_t bit = LogIndex::levelBit(token)) {
+            levels |= bit;
+        } else if (token.size() > 1 && token[0] == '-') {
+            query.excluded.push_back(token.substr(1));
+        } else if (!token.empty()) {
+            query.terms.push_back(token);
+        }
+        query.text += (query.text.empty() ? "" : " ") + token;
+    }
+    if (levels != 0) {
+        query.levels = levels;
+    }
+    query.lastLine = std::max(query.firstLine, query.lastLine);
+    for (size_t i = 1; i < query.terms.size(); ++i) {
+        if (query.terms[i].size() > query.terms[query.anchor].size()) {
+            query.anchor = i;
+        }
+    }
+    return true;
+}
+
+bool AlertAnalysis::timePrefix(std::string_view token, std::string& prefix) const {
+    // A full timestamp prefix, or HH:MM[:SS] on the log's first day
+    if (token.find('T') != std::string_view::npos) {
+        prefix = std::string(token);
+        return true;
+    }
+    if (token.size() != 5 && token.size() != 8) {
+        return false;
+    }
+    for (size_t i = 0; i < token.size(); ++i) {
+        bool colon = i % 3 == 2;
+        if (colon ? token[i] != ':' : (token[i] < '0' || token[i] > '9')) {
+            return false;
+        }
+    }
+    prefix = datePrefix_ + std::string(token);
+    return true;
+}
+
+void AlertAnalysis::start(const Query& query) {
+    query_ = query;
+    hasQuery_ = true;
+    scanning_ = true;
+    cursor_ = query_.firstLine;
+    matchCount_ = 0;
+    std::fill(std::begin(levelCounts_), std::end(levelCounts_), 0);
+    shown_.clear();
+    scroll_ = 0;
+    restoredScroll_ = 0;
+    restorePending_ = false;
+}
+
+bool AlertAnalysis::scan(Clock::duration budget) {
+    if (!scanning_) {
+        return false;
+    }
+    Clock::time_point deadline = Clock::now() + budget;
+    const std::string* anchor = query_.terms.empty() ? nullptr : &query_.terms[query_.anchor];
+    uint64_t end = log_.lineStart(query_.lastLine);
+
+    auto record = [this](size_t line, uint8_t level) {
+        matchCount_++;
+        levelCounts_[levelSlot(level)]++;
+        if (shown_.size() < MAX_SHOWN) {
+            shown_.push_back(line);
+        }
+    };
+
+    while (cursor_ < query_.lastLine) {
+        size_t sliceEnd;
+        if (anchor) {
+            // Slices end on line boundaries, so no match straddles two
+            uint64_t from = log_.lineStart(cursor_);
+            sliceEnd = from + SLICE_BYTES >= end
+                           ? query_.lastLine
+                           : std::max(cursor_ + 1, log_.lineAt(from + SLICE_BYTES));
+            uint64_t to = log_.lineStart(sliceEnd);
+            for (uint64_t hit = log_.find(from, to, *anchor); hit != LogIndex::NOT_FOUND;
+                 hit = log_.find(from, to, *anchor)) {
+                size_t line = log_.lineAt(hit);
+                uint8_t level = log_.level(line);
+                if ((level & query_.levels) && accepts(log_.line(line))) {
+                    record(line, level);
+                }
+                from = log_.lineStart(line + 1);
+            }
+        } else {
+            // Only the level bits, unless words are excluded
+            sliceEnd = std::min(query_.lastLine, cursor_ + SLICE_LINES);
+            for (size_t line = log_.findLevel(cursor_, sliceEnd, query_.levels); line < sliceEnd;
+                 line = log_.findLevel(line + 1, sliceEnd, query_.levels)) {
+                uint8_t level = log_.level(line);
+                if (query_.excluded.empty() || accepts(log_.line(line))) {
+                    record(line, level);
+                }
+            }
+        }
+        cursor_ = sliceEnd;
+        if (Clock::now() >= deadline) {
+            break;
+        }
+    }
+    scanning_ = cursor_ < query_.lastLine;
+    return true;
+}
+
+bool AlertAnalysis::accepts(std::string_view line) const {
+    for (const std::string& term : query_.terms) {
+        if (line.find(term) == std::string_view::npos) {
+            return false;
+        }
+    }
+    for (const std::string& word : query_.excluded) {
+        if (line.find(word) != std::string_view::npos) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AlertAnalysis::update(float /*deltaTimeSeconds*/) {
+    Stage stage = stage_.load();
+    if (stage != Stage::READY) {
+        if (stage == Stage::FAILED) {
+            restorePending_ = false;  // nothing to run a restored query on
+        }
+        // Redrawn as preparation moves on a percent or a stage
+        int percent = 0;
+        if (stage == Stage::WRITING && writeLines_ > 0) {
+            percent = static_cast<int>(writeProgress_.linesWritten.load() * 100 / writeLines_);
+        }
+        bool changed = stage != shownStage_ || percent != shownPercent_;
+        shownStage_ = stage;
+        shownPercent_ = percent;
+        return changed;
+    }
+    if (shownStage_ != Stage::READY) {
+        shownStage_ = Stage::READY;
+        return true;
+    }
+    if (restorePending_) {
+        // A restored session's query, scrolled back as its matches come in
+        Query query;
+        std::string error;
+        size_t scroll = restoredScroll_;
+        if (parse(restoredQuery_, query, error)) {
+            start(query);
+            restoredScroll_ = scroll;
+        }
+        restorePending_ = false;
+    }
+    bool moved = scan(FRAME_BUDGET);
+    if (restoredScroll_ > 0) {
+        scroll_ = std::min(restoredScroll_, shown_.size());
+        if (scroll_ == restoredScroll_ || !scanning_) {
+            restoredScroll_ = 0;
+        }
+    }
+    return moved;
+}
+
+std::string AlertAnalysis::progress() const {
+    std::string text = grouped(matchCount_) + (matchCount_ == 1 ? " matching line" :
+                                                                  " matching lines");
+    if (scanning_) {
+        size_t span = std::max<size_t>(query_.lastLine - query_.firstLine, 1);
+        text += " so far (" + std::to_string((cursor_ - query_.firstLine) * 100 / span) +
+                "% searched)";
+    }
+    return text;
+}
+
+std::string AlertAnalysis::totals() const {
+    std::string text = progress();
+    std::string levels;
+    for (int slot = 0; slot < LEVEL_COUNT; ++slot) {
+        if (levelCounts_[slot] > 0) {
+            levels += (levels.empty() ? "" : ", ") + std::string(LEVEL_NAMES[slot]) + " " +
+                      grouped(levelCounts_[slot]);
+        }
+    }
+    return levels.empty() ? text : text + ": " + levels;
+}
+
+void AlertAnalysis::render(devescape::TerminalRenderer& renderer, int x, int y, int width,
+                           int height) const {
+    Stage stage = stage_.load();
+    if (stage == Stage::WRITING || stage == Stage::INDEXING) {
+        renderer.drawText(x, y, preparation(), devescape::ColorType::PENDING);
+        return;
+    }
+    if (stage != Stage::READY) {
+        renderer.drawText(x, y, "Incident log unavailable", devescape::ColorType::ERROR_COLOR);
+        return;
+    }
+    size_t columns = static_cast<size_t>(std::max(width, 0));
+    pageLines_ = static_cast<size_t>(std::max(height - 1, 0));
+
+    std::string status;
+    if (!hasQuery_) {
+        status = "incident.log: " + grouped(log_.getLineCount()) + " lines, " +
+                 grouped(static_cast<size_t>(log_.getBytes() >> 20)) + " MB";
+    } else {
+        status = (query_.text.empty() ? std::string("all") : "[" + query_.text + "]") + " " +
+                 progress();
+        if (!shown_.empty()) {
+            size_t last = std::min(scroll_ + pageLines_, shown_.size());
+            status += " | " + grouped(scroll_ + 1) + "-" + grouped(last);
+        }
+    }
+    renderer.drawText(x, y, status.substr(0, columns), devescape::ColorType::STATUS);
+
+    for (size_t row = 0; row < pageLines_ && scroll_ + row < shown_.size(); ++row) {
+        size_t line = shown_[scroll_ + row];
+        // The date is the same on every line; the time is enough
+        std::string_view text = log_.line(line);
+        if (!datePrefix_.empty() && text.substr(0, datePrefix_.size()) == datePrefix_) {
+            text.remove_prefix(datePrefix_.size());
+        }
+        text = text.substr(0, columns);
+        renderer.drawText(x, y + 1 + static_cast<int>(row), std::string(text),
+                          levelColor(log_.level(line)));
+    }
+}
+
+} // namespace production_incident
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "framework/LogGenerator.h"
+#include "framework/LogIndex.h"
+#include "framework/RoomExtension.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace production_incident {
+
+/**
+ * The Alert Analysis puzzle's log console: grep-like queries over the
+ * incident log, a LogIndex of a few hours of payment traffic in which the
+ * database goes bad. LogGenerator writes the log from the room's log
+ * profile the first time it is needed, on a worker thread: writing and
+ * indexing a 30 million line log takes seconds, and commands say how far
+ * along it is until then.
+ *
+ *     filter logs ERROR database from 10:02 to 10:05 -timeout
+ *
+ * Level words (DEBUG, INFO, WARN, ERROR, CRITICAL) pick levels, `from`
+ * and `to` take HH:MM[:SS] or a full timestamp prefix, -word excludes and
+ * every other word or "quoted phrase" must appear. `count` takes the same
+ * query and reports totals per level.
+ *
+ * A query runs in slices against a time budget: the first slice within the
+ * command, the rest over the following frames, so matches stream into the
+ * pane while the scan goes on. Searches with words jump between hits of the
+ * longest one; level-only searches walk the level bits.
+ *
+ * Its saved state is the last query and the scroll position; restored, the
+ * query runs again once the log is ready.
+ */
+class AlertAnalysis final : public devescape::RoomExtension {
+public:
+    AlertAnalysis();
+    ~AlertAnalysis() override;
+
+    // Starts getting the log ready in the background: generated from the
+    // profile if missing or older, then indexed. False (and reported) if
+    // the profile cannot be used.
+    bool open(const std::string& profilePath, const std::string& logPath);
+
+    void call(std::string_view operation, const devescape::CommandMatch& match,
+              devescape::ProcessResult& result) override;
+    void render(devescape::TerminalRenderer& renderer, int x, int y, int width,
+                int height) const override;
+    bool update(float deltaTimeSeconds) override;
+    bool isBusy() const override;
+    void reset() override;
+    std::string serializeState() const override;
+    bool deserializeState(const std::string& data) override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Stage { CLOSED, WRITING, INDEXING, READY, FAILED };
+
+    struct Query {
+        std::string text;
+        std::string source;                 // as typed, to run again on restore
+        uint8_t levels = devescape::LogIndex::LEVEL_ALL;
+        std::vector<std::string> terms;     // all must appear
+        std::vector<std::string> excluded;  // none may
+        size_t anchor = 0;                  // longest term, searched for
+        size_t firstLine = 0;
+        size_t lastLine = 0;
+    };
+
+    static constexpr size_t MAX_SHOWN = 100000;  // matches kept for scrolling
+    static constexpr int LEVEL_COUNT = 6;
+
+    // Owned by the preparing thread until stage_ is READY
+    devescape::LogIndex log_;
+    std::string datePrefix_;  // "YYYY-MM-DDT" of the first line, for bare times
+
+    std::string profilePath_;
+    std::string logPath_;
+    std::atomic<Stage> stage_;
+    devescape::LogGenerator::WriteProgress writeProgress_;
+    uint64_t writeLines_;  // 0 when the log was already there
+    std::thread preparer_;
+    Stage shownStage_;     // as last drawn
+    int shownPercent_;
+
+    Query query_;
+    bool hasQuery_;
+    bool scanning_;
+    size_t cursor_;  // next line to scan
+    size_t matchCount_;
+    size_t levelCounts_[LEVEL_COUNT];
+    std::vector<size_t> shown_;  // first MAX_SHOWN matching lines
+    size_t scroll_;              // first of them in the pane
+    size_t restoredScroll_;      // scrolled to as matches arrive
+    bool restorePending_;        // restoredQuery_ runs once the log is ready
+    std::string restoredQuery_;
+    mutable size_t pageLines_;   // rows the pane had last render
+
+    void prepare(devescape::LogGenerator generator);
+    void stopPreparing();
+    std::string preparation() const;
+
+    // False with a reason for a query that cannot run
+    bool parse(std::string_view text, Query& query, std::string& error) const;
+    bool timePrefix(std::string_view token, std::string& prefix) const;
+    void start(const Query& query);
+    // Scans until the query is done or the budget runs out; true if it moved
+    bool scan(Clock::duration budget);
+    bool accepts(std::string_view line) const;
+    std::string progress() const;
+    std::string totals() const;
+};
+
+} // namespace production_incident
@@ -1,3 +1,419 @@
-// Puzzle implementation stub
-// This would contain detailed puzzle logic in production
-// Currently integrated into ProductionIncidentRoom.cpp
+#include "MetricsNavigation.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+
+using devescape::MetricStore;
+using devescape::MetricSummary;
+
+namespace production_incident {
+
+namespace {
+
+constexpr int64_t SAMPLE_MILLIS = 1000;
+constexpr int64_t START_MILLIS = (10 * 3600 + 15 * 60) * 1000;    // 10:15:00, when play starts
+constexpr int64_t INCIDENT_MILLIS = (10 * 3600 + 2 * 60) * 1000;  // 10:02:00
+constexpr int64_t HISTORY_MILLIS = 30 * 60 * 1000;
+constexpr int64_t BASELINE_FROM = START_MILLIS - HISTORY_MILLIS;  // before the incident
+constexpr int64_t BASELINE_TO = BASELINE_FROM + 10 * 60 * 1000;
+constexpr int64_t WINDOW_MILLIS = HISTORY_MILLIS;  // charted, the onset in view
+constexpr int64_t RECENT_MILLIS = 5 * 60 * 1000;   // summed up for a series
+constexpr int64_t DAY_MILLIS = 24 * 3600 * 1000;
+constexpr uint64_t SEED = 20240315;
+
+const char SPARK_RAMP[] = "_.-:=+*#%@";
+constexpr int SPARK_LEVELS = sizeof(SPARK_RAMP) - 1;
+constexpr int NAME_COLUMNS = 16;
+constexpr int VALUE_COLUMNS = 14;
+
+// A metric drifts from its normal level to its incident level over the ramp
+// after 10:02, with noise around the level
+struct Model {
+    const char* path;
+    const char* unit;
+    double normal;
+    double incident;
+    double noise;  // relative
+    double rampSeconds;
+    double ceiling;  // 0 for none; reaching it is an alert
+    bool whole;
+};
+
+const Model MODELS[] = {
+    {"services/payment-api/latency", "ms", 120, 2847, 0.08, 240, 0, false},
+    {"services/payment-api/error_rate", "%", 0.2, 23.4, 0.1, 180, 0, false},
+    {"services/payment-api/throughput", "req/s", 100, 100, 0.05, 0, 0, false},
+    {"services/payment-api/dependencies/cache/hit_rate", "%", 94, 91, 0.01, 60, 0, false},
+    {"services/payment-api/dependencies/cache/evictions", "/s", 3, 3, 0.5, 0, 0, true},
+    {"services/payment-api/dependencies/database/connection_pool/active", "", 15, 20, 0.15, 90, 20,
+     true},
+    {"services/payment-api/dependencies/database/connection_pool/max", "", 20, 20, 0, 0, 0, true},
+    {"services/payment-api/dependencies/database/connection_pool/waiting", "", 0, 847, 0.1, 600, 0,
+     true},
+    {"services/payment-api/dependencies/database/connection_pool/wait_time", "ms", 2, 15000, 0.1,
+     600, 0, false},
+    {"services/payment-api/dependencies/database/query_time", "ms", 150, 500, 0.05, 120, 0, false},
+    {"services/payment-api/dependencies/database/replication_lag", "s", 0.2, 0.3, 0.3, 60, 0,
+     false},
+    {"services/payment-api/dependencies/queue/depth", "", 12, 14, 0.3, 0, 0, true},
+    {"services/checkout-web/latency", "ms", 85, 90, 0.1, 0, 0, false},
+    {"services/checkout-web/throughput", "req/s", 240, 230, 0.05, 0, 0, false},
+    {"services/auth-service/latency", "ms", 35, 36, 0.1, 0, 0, false},
+    {"services/auth-service/error_rate", "%", 0.1, 0.1, 0.3, 0, 0, false},
+};
+
+constexpr size_t MODEL_COUNT = sizeof(MODELS) / sizeof(MODELS[0]);
+
+// Uniform in [-1, 1), a pure function of the metric and the time
+double noise(size_t metric, int64_t time) {
+    uint64_t z = SEED + metric * 0x9E3779B97F4A7C15ull + static_cast<uint64_t>(time);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return static_cast<double>(z >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+double modelValue(size_t metric, int64_t time) {
+    const Model& model = MODELS[metric];
+    double progress = 0.0;
+    if (time >= INCIDENT_MILLIS) {
+        double seconds = static_cast<double>(time - INCIDENT_MILLIS) / 1000.0;
+        progress = model.rampSeconds > 0 ? std::min(seconds / model.rampSeconds, 1.0) : 1.0;
+    }
+    double level = model.normal + (model.incident - model.normal) * progress;
+    double value = std::max(level * (1.0 + model.noise * noise(metric, time)), 0.0);
+    if (model.ceiling > 0) {
+        value = std::min(value, model.ceiling);
+    }
+    return model.whole ? std::round(value) : value;
+}
+
+// The history up to the start time is the same in every session, so it is
+// simulated once and copied
+const MetricStore& history() {
+    static const MetricStore store = [] {
+        MetricStore built;
+        std::vector<MetricStore::SeriesId> series;
+        for (const Model& model : MODELS) {
+            series.push_back(built.addSeries(model.path));
+        }
+        for (int64_t time = BASELINE_FROM; time <= START_MILLIS; time += SAMPLE_MILLIS) {
+            for (size_t metric = 0; metric < MODEL_COUNT; ++metric) {
+                built.append(series[metric], time, modelValue(metric, time));
+            }
+        }
+        return built;
+    }();
+    return store;
+}
+
+std::string formatValue(double value, const Model& model) {
+    double magnitude = std::fabs(value);
+    const char* format = model.whole || magnitude >= 100 ? "%.0f%s%s"
+                         : magnitude >= 10               ? "%.1f%s%s"
+                                                         : "%.2f%s%s";
+    const char* unit = model.unit;
+    char text[32];
+    std::snprintf(text, sizeof(text), format, value,
+                  *unit && *unit != '%' && *unit != '/' ? " " : "", unit);
+    return text;
+}
+
+std::string formatTime(int64_t millis) {
+    int64_t seconds = millis / 1000;
+    char text[16];
+    std::snprintf(text, sizeof(text), "%02d:%02d:%02d", static_cast<int>(seconds / 3600 % 24),
+                  static_cast<int>(seconds / 60 % 60), static_cast<int>(seconds % 60));
+    return text;
+}
+
+std::string lowercase(std::string_view text) {
+    std::string result(text);
+    for (char& c : result) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+// Path words; slashes and arrows separate them too
+std::vector<std::string> splitPath(std::string_view text) {
+    std::vector<std::string> words;
+    size_t i = 0;
+    while (i < text.size()) {
+        size_t end = text.find_first_of(" \t/", i);
+        end = end == std::string_view::npos ? text.size() : end;
+        std::string word = lowercase(text.substr(i, end - i));
+        if (!word.empty() && word != "->" && word != ">" && word != "\xE2\x86\x92") {
+            words.push_back(std::move(word));
+        }
+        i = end + 1;
+    }
+    return words;
+}
+
+void say(devescape::ProcessResult& result, const std::string& text) {
+    if (!result.outputText.empty()) {
+        result.outputText += '\n';
+    }
+    result.outputText += text;
+}
+
+} // namespace
+
+MetricsNavigation::MetricsNavigation()
+    : services_(MetricStore::ROOT)
+    , current_(MetricStore::ROOT)
+    , selected_(MetricStore::NONE)
+    , now_(START_MILLIS)
+    , pending_(0.0f) {
+    build();
+}
+
+void MetricsNavigation::build() {
+    store_ = history();
+    series_.clear();
+    for (const Model& model : MODELS) {
+        series_.push_back(store_.series(store_.findNode(model.path)));
+    }
+    services_ = store_.findNode("services");
+    current_ = services_;
+    selected_ = MetricStore::NONE;
+    now_ = START_MILLIS;
+    pending_ = 0.0f;
+}
+
+void MetricsNavigation::sample(int64_t time) {
+    for (size_t metric = 0; metric < MODEL_COUNT; ++metric) {
+        store_.append(series_[metric], time, modelValue(metric, time));
+    }
+    now_ = time;
+}
+
+void MetricsNavigation::reset() {
+    build();
+}
+
+std::string MetricsNavigation::serializeState() const {
+    nlohmann::json j;
+    j["now"] = now_;
+    j["current"] = store_.path(current_);
+    if (selected_ != MetricStore::NONE) {
+        j["selected"] = store_.path(selected_);
+    }
+    return j.dump();
+}
+
+bool MetricsNavigation::deserializeState(const std::string& data) {
+    build();
+    int64_t now = 0;
+    NodeId current = MetricStore::NONE;
+    NodeId selected = MetricStore::NONE;
+    try {
+        nlohmann::json j = nlohmann::json::parse(data);
+        now = j.at("now").get<int64_t>();
+        current = store_.findNode(j.at("current").get<std::string>());
+        if (j.contains("selected")) {
+            selected = store_.findNode(j["selected"].get<std::string>());
+        }
+        if (j.contains("selected") && selected == MetricStore::NONE) {
+            return false;
+        }
+    } catch (...) {
+        return false;
+    }
+    if (current == MetricStore::NONE || now < START_MILLIS || now >= DAY_MILLIS) {
+        return false;
+    }
+
+    for (int64_t time = now_ + SAMPLE_MILLIS; time <= now; time += SAMPLE_MILLIS) {
+        sample(time);
+    }
+    current_ = current;
+    selected_ = selected;
+    return true;
+}
+
+bool MetricsNavigation::update(float deltaTimeSeconds) {
+    pending_ += deltaTimeSeconds;
+    bool sampled = false;
+    while (pending_ >= 1.0f) {
+        pending_ -= 1.0f;
+        sample(now_ + SAMPLE_MILLIS);
+        sampled = true;
+    }
+    return sampled;
+}
+
+MetricsNavigation::NodeId MetricsNavigation::step(NodeId node, std::string_view word) const {
+    if (NodeId exact = store_.child(node, word); exact != MetricStore::NONE) {
+        return exact;
+    }
+    // Part of a name, if only one child has it
+    NodeId found = MetricStore::NONE;
+    for (NodeId child : store_.children(node)) {
+        if (store_.name(child).find(word) != std::string_view::npos) {
+            if (found != MetricStore::NONE) {
+                return MetricStore::NONE;
+            }
+            found = child;
+        }
+    }
+    return found;
+}
+
+MetricsNavigation::NodeId MetricsNavigation::locate(NodeId node, std::string_view word) const {
+    NodeId found = step(node, word);
+    for (NodeId child : store_.children(node)) {
+        if (found != MetricStore::NONE) {
+            break;
+        }
+        found = locate(child, word);
+    }
+    return found;
+}
+
+void MetricsNavigation::call(std::string_view /*operation*/, const devescape::CommandMatch& match,
+                             devescape::ProcessResult& result) {
+    std::vector<std::string> words = splitPath(match.rest);
+    if (!words.empty() && words.front() == "metrics") {
+        words.erase(words.begin());
+    }
+
+    NodeId node = current_;
+    bool first = true;
+    for (const std::string& word : words) {
+        if (word == ".." || word == "up" || word == "back") {
+            if (node != services_) {
+                node = store_.parent(node);
+            }
+            first = false;
+            continue;
+        }
+        NodeId next = step(node, word);
+        if (next == MetricStore::NONE && first) {
+            next = word == "services" ? services_ : locate(services_, word);
+        }
+        first = false;
+        if (next == MetricStore::NONE) {
+            std::string names;
+            for (NodeId child : store_.children(node)) {
+                names += (names.empty() ? "" : ", ") + std::string(store_.name(child));
+            }
+            say(result, "No '" + word + "' under " + store_.path(node) +
+                            (names.empty() ? "." : ". Try: " + names));
+            break;
+        }
+        node = next;
+    }
+
+    if (store_.series(node) != MetricStore::NONE) {
+        selected_ = node;
+        current_ = store_.parent(node);
+    } else {
+        selected_ = MetricStore::NONE;
+        current_ = node;
+    }
+    say(result, describe(node));
+}
+
+std::string MetricsNavigation::describe(NodeId node) const {
+    MetricStore::SeriesId id = store_.series(node);
+    if (id != MetricStore::NONE) {
+        const Model& model = MODELS[id];
+        MetricSummary window = store_.rollup(id, now_ - RECENT_MILLIS, now_ + 1);
+        MetricSummary baseline = store_.rollup(id, BASELINE_FROM, BASELINE_TO);
+        return store_.path(node) + ": " + formatValue(window.last, model) + " at " +
+               formatTime(now_) + "; last 5 min " + formatValue(window.min, model) + " to " +
+               formatValue(window.max, model) + ", avg " + formatValue(window.mean(), model) +
+               "; normal " + formatValue(baseline.mean(), model);
+    }
+
+    std::string text = store_.path(node) + ":";
+    bool any = false;
+    for (NodeId child : store_.children(node)) {
+        MetricStore::SeriesId childId = store_.series(child);
+        text += any ? ", " : " ";
+        any = true;
+        text += std::string(store_.name(child));
+        if (childId == MetricStore::NONE) {
+            text += "/";
+        } else {
+            text += " " + formatValue(store_.summary(childId).last, MODELS[childId]);
+        }
+    }
+    return text;
+}
+
+void MetricsNavigation::render(devescape::TerminalRenderer& renderer, int x, int y, int width,
+                               int height) const {
+    size_t columns = static_cast<size_t>(std::max(width, 0));
+    std::string status = formatTime(now_ - WINDOW_MILLIS).substr(0, 5) + "-" +
+                         formatTime(now_).substr(0, 5) + "  " + store_.path(current_);
+    renderer.drawText(x, y, status.substr(0, columns), devescape::ColorType::STATUS);
+
+    int sparkWidth = std::max(width - NAME_COLUMNS - VALUE_COLUMNS - 2, 8);
+    std::vector<MetricSummary> buckets(static_cast<size_t>(sparkWidth));
+    int row = 1;
+    for (NodeId child : store_.children(current_)) {
+        if (row >= height) {
+            break;
+        }
+        std::string name(store_.name(child));
+        MetricStore::SeriesId id = store_.series(child);
+        if (id == MetricStore::NONE) {
+            size_t below = store_.children(child).size();
+            std::string line = name + "/  (" + std::to_string(below) +
+                               (below == 1 ? " entry)" : " entries)");
+            renderer.drawText(x, y + row++, line.substr(0, columns), devescape::ColorType::ACCENT);
+            continue;
+        }
+
+        // Bucket means scaled between the lowest and highest of them
+        store_.downsample(id, now_ - WINDOW_MILLIS + SAMPLE_MILLIS, now_ + SAMPLE_MILLIS,
+                          buckets.size(), buckets.data());
+        double low = 0.0;
+        double high = 0.0;
+        bool seen = false;
+        for (const MetricSummary& bucket : buckets) {
+            if (bucket.count > 0) {
+                low = seen ? std::min(low, bucket.mean()) : bucket.mean();
+                high = seen ? std::max(high, bucket.mean()) : bucket.mean();
+                seen = true;
+            }
+        }
+        std::string spark;
+        for (const MetricSummary& bucket : buckets) {
+            if (bucket.count == 0) {
+                spark += ' ';
+            } else if (high - low <= 1e-9 * std::max(std::fabs(high), 1.0)) {
+                spark += SPARK_RAMP[SPARK_LEVELS / 2];
+            } else {
+                double scaled = (bucket.mean() - low) / (high - low);
+                spark += SPARK_RAMP[static_cast<int>(scaled * (SPARK_LEVELS - 1) + 0.5)];
+            }
+        }
+
+        // Alert colors: at a ceiling, or well off the pre-incident normal
+        const Model& model = MODELS[id];
+        double last = store_.summary(id).last;
+        double normal = store_.rollup(id, BASELINE_FROM, BASELINE_TO).mean();
+        devescape::ColorType color = devescape::ColorType::DEFAULT;
+        if (model.ceiling > 0 && last >= model.ceiling) {
+            color = devescape::ColorType::ALERT;
+        } else if (last > normal * 2.0 + 1.0 || last < normal * 0.5 - 1.0) {
+            color = devescape::ColorType::WARNING;
+        } else if (child == selected_) {
+            color = devescape::ColorType::ACCENT;
+        }
+
+        name.resize(NAME_COLUMNS - 1, ' ');
+        std::string value = formatValue(last, model);
+        value.insert(0, value.size() < VALUE_COLUMNS ? VALUE_COLUMNS - value.size() : 0, ' ');
+        std::string line = (child == selected_ ? ">" : " ") + name + spark + " " + value;
+        renderer.drawText(x, y + row++, line.substr(0, columns), color);
+    }
+}
+
+} // namespace production_incident
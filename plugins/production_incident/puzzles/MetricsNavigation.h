@@ -0,0 +1,63 @@
+#pragma once
+
+#include "framework/MetricStore.h"
+#include "framework/RoomExtension.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace production_incident {
+
+/**
+ * The Metrics Navigation puzzle's dashboard: a MetricStore of the payment
+ * platform's metrics, simulated from half an hour before the player arrives
+ * and sampled live every second after, with the database connection pool
+ * running dry from 10:02 on.
+ *
+ *     navigate metrics payment-api dependencies database connection_pool
+ *
+ * Path words walk the tree from the current node; a first word that does
+ * not fit there is looked up anywhere below services. A word may be part
+ * of a name (`pool`) and `..` goes up. The pane charts the last half hour
+ * of every series under the current node, downsampled from the store on
+ * each render.
+ *
+ * Its saved state is the simulated time and where the player is in the
+ * tree; restored, the store is sampled up to that time again.
+ */
+class MetricsNavigation final : public devescape::RoomExtension {
+public:
+    MetricsNavigation();
+
+    void call(std::string_view operation, const devescape::CommandMatch& match,
+              devescape::ProcessResult& result) override;
+    void render(devescape::TerminalRenderer& renderer, int x, int y, int width,
+                int height) const override;
+    bool update(float deltaTimeSeconds) override;
+    void reset() override;
+    std::string serializeState() const override;
+    bool deserializeState(const std::string& data) override;
+
+private:
+    using NodeId = devescape::MetricStore::NodeId;
+
+    devescape::MetricStore store_;
+    std::vector<devescape::MetricStore::SeriesId> series_;  // per simulated metric, in order
+    NodeId services_;
+    NodeId current_;
+    NodeId selected_;  // series last navigated to, if under current_
+    int64_t now_;      // time of the latest samples, ms of the day
+    float pending_;    // seconds towards the next sample
+
+    // A fresh store holding the history up to the start time
+    void build();
+    void sample(int64_t time);
+    // A child named word, or the one child whose name has it; NONE if none
+    NodeId step(NodeId node, std::string_view word) const;
+    // The same, searched depth first below node
+    NodeId locate(NodeId node, std::string_view word) const;
+    std::string describe(NodeId node) const;
+};
+
+} // namespace production_incident
@@ -0,0 +1,244 @@
+#include "framework/AudioBackend.h"
+#include "framework/SpscQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace devescape {
+
+namespace {
+
+// Pulls blocks on its own thread, in real time or flat out, and hands each
+// to consume(); what a device's callback thread does, without the device
+class RenderThreadBackend : public AudioBackend {
+public:
+    explicit RenderThreadBackend(bool paced)
+        : paced_(paced)
+        , sampleRate_(0)
+        , blockFrames_(0)
+        , render_(nullptr)
+        , userdata_(nullptr)
+        , running_(false) {
+    }
+
+    bool open(int sampleRate, int blockFrames, RenderCallback render, void* userdata) override {
+        sampleRate_ = sampleRate;
+        blockFrames_ = blockFrames;
+        render_ = render;
+        userdata_ = userdata;
+        return true;
+    }
+
+    void start() override {
+        if (running_.exchange(true)) {
+            return;
+        }
+        thread_ = std::thread(&RenderThreadBackend::run, this);
+    }
+
+    void close() override {
+        running_.store(false);
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    int getSampleRate() const override { return sampleRate_; }
+    int getBlockFrames() const override { return blockFrames_; }
+    bool hasDeviceLatency() const override { return false; }
+
+protected:
+    // Render thread; false stops it
+    virtual bool consume(const float* block, int frameCount) = 0;
+
+    bool isRunning() const { return running_.load(std::memory_order_relaxed); }
+
+private:
+    bool paced_;
+    int sampleRate_;
+    int blockFrames_;
+    RenderCallback render_;
+    void* userdata_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    void run() {
+        using Clock = std::chrono::steady_clock;
+        std::vector<float> block(static_cast<size_t>(blockFrames_));
+        auto blockTime = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(blockFrames_) / sampleRate_));
+        auto deadline = Clock::now();
+
+        while (running_.load(std::memory_order_relaxed)) {
+            render_(userdata_, block.data(), blockFrames_);
+            if (!consume(block.data(), blockFrames_)) {
+                break;
+            }
+            if (paced_) {
+                // Deadlines advance by whole blocks, so sleep overshoot
+                // does not add up
+                deadline += blockTime;
+                std::this_thread::sleep_until(deadline);
+            }
+        }
+    }
+};
+
+class NullAudioBackend : public RenderThreadBackend {
+public:
+    explicit NullAudioBackend(bool paced)
+        : RenderThreadBackend(paced) {
+    }
+
+    ~NullAudioBackend() override {
+        close();
+    }
+
+    const char* getName() const override { return "null"; }
+
+protected:
+    bool consume(const float*, int) override { return true; }
+};
+
+// Mono 16-bit PCM. The render thread only pushes samples into the ring;
+// the writer thread converts them and does all the file I/O, so a slow
+// disk never stalls rendering until the ring is full.
+class WavAudioBackend : public RenderThreadBackend {
+public:
+    explicit WavAudioBackend(const std::string& path)
+        : RenderThreadBackend(true)
+        , path_(path)
+        , ring_(std::make_unique<Ring>())
+        , rendering_(false)
+        , dataBytes_(0) {
+    }
+
+    ~WavAudioBackend() override {
+        close();
+    }
+
+    const char* getName() const override { return "wav"; }
+
+    bool open(int sampleRate, int blockFrames, RenderCallback render, void* userdata) override {
+        file_.open(path_, std::ios::binary | std::ios::trunc);
+        if (!file_) {
+            std::cerr << "Failed to open " << path_ << " for audio output" << std::endl;
+            return false;
+        }
+        dataBytes_ = 0;
+        writeHeader(sampleRate);  // sizes are patched in on close
+        return RenderThreadBackend::open(sampleRate, blockFrames, render, userdata);
+    }
+
+    void start() override {
+        rendering_.store(true);
+        writer_ = std::thread(&WavAudioBackend::writeLoop, this);
+        RenderThreadBackend::start();
+    }
+
+    void close() override {
+        RenderThreadBackend::close();
+        // The writer drains what the render thread left, then exits
+        rendering_.store(false);
+        if (writer_.joinable()) {
+            writer_.join();
+        }
+        if (file_.is_open()) {
+            writeHeader(getSampleRate());
+            file_.close();
+        }
+    }
+
+protected:
+    bool consume(const float* block, int frameCount) override {
+        for (int i = 0; i < frameCount; ++i) {
+            // A file has no deadline: wait for the writer rather than drop
+            while (!ring_->push(block[i])) {
+                if (!isRunning()) {
+                    return false;
+                }
+                std::this_thread::yield();
+            }
+        }
+        return true;
+    }
+
+private:
+    using Ring = SpscQueue<float, 65536>;  // about 1.5 s at 44.1kHz
+
+    std::string path_;
+    std::unique_ptr<Ring> ring_;
+    std::atomic<bool> rendering_;
+    std::thread writer_;
+    std::ofstream file_;
+    uint32_t dataBytes_;
+
+    void writeLoop() {
+        std::vector<int16_t> chunk;
+        chunk.reserve(4096);
+        for (;;) {
+            bool finished = !rendering_.load(std::memory_order_acquire);
+            float sample;
+            while (chunk.size() < chunk.capacity() && ring_->pop(sample)) {
+                float clamped = std::max(-1.0f, std::min(1.0f, sample));
+                chunk.push_back(static_cast<int16_t>(clamped * 32767.0f));
+            }
+            if (!chunk.empty()) {
+                file_.write(reinterpret_cast<const char*>(chunk.data()),
+                            static_cast<std::streamsize>(chunk.size() * sizeof(int16_t)));
+                dataBytes_ += static_cast<uint32_t>(chunk.size() * sizeof(int16_t));
+                chunk.clear();
+                continue;
+            }
+            if (finished) {
+                return;  // rendering had stopped and the ring is empty
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    void writeHeader(int sampleRate) {
+        auto u32 = [this](uint32_t value) { file_.write(reinterpret_cast<const char*>(&value), 4); };
+        auto u16 = [this](uint16_t value) { file_.write(reinterpret_cast<const char*>(&value), 2); };
+
+        // Little-endian fields, as on every platform we build for
+        file_.seekp(0);
+        file_.write("RIFF", 4);
+        u32(36 + dataBytes_);
+        file_.write("WAVEfmt ", 8);
+        u32(16);
+        u16(1);  // PCM
+        u16(1);  // mono
+        u32(static_cast<uint32_t>(sampleRate));
+        u32(static_cast<uint32_t>(sampleRate) * 2);  // bytes per second
+        u16(2);                                      // bytes per frame
+        u16(16);
+        file_.write("data", 4);
+        u32(dataBytes_);
+        file_.seekp(0, std::ios::end);
+    }
+};
+
+} // namespace
+
+std::unique_ptr<AudioBackend> AudioBackend::create(const std::string& spec) {
+    if (spec == "sdl") {
+        return createSdlAudioBackend();
+    }
+    if (spec == "null" || spec == "null:fast") {
+        return std::make_unique<NullAudioBackend>(spec == "null");
+    }
+    if (spec.compare(0, 4, "wav:") == 0 && spec.size() > 4) {
+        return std::make_unique<WavAudioBackend>(spec.substr(4));
+    }
+    std::cerr << "Unknown audio output '" << spec << "' (expected sdl, null, null:fast or wav:<file>)"
+              << std::endl;
+    return nullptr;
+}
+
+} // namespace devescape
@@ -1,9 +1,22 @@
 #include "framework/AudioManager.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
 namespace devescape {
 
+namespace {
+
+constexpr int DEFAULT_BLOCK_FRAMES = 2048;
+constexpr int LOW_LATENCY_START_FRAMES = 256;
+constexpr int LOW_LATENCY_MIN_FRAMES = 128;
+constexpr int LOW_LATENCY_MAX_FRAMES = 4096;
+
+// adaptLatency() shrinks the block after this many quiet seconds
+constexpr int QUIET_CHECKS_TO_SHRINK = 5;
+
+} // namespace
+
 // Note frequency table (A4 = 440Hz)
 static const float NOTE_FREQUENCIES[] = {
     261.63f, 277.18f, 293.66f, 311.13f, 329.63f, 349.23f,  // C4-F4
@@ -12,20 +25,24 @@ static const float NOTE_FREQUENCIES[] = {
 };
 
 AudioManager::AudioManager()
-    : audioDevice_(0)
+    : outputChosen_(false)
+    , streaming_(false)
+    , eventOutput_(false)
+    , lowLatency_(false)
+    , minimumBlock_(LOW_LATENCY_MIN_FRAMES)
+    , quietChecks_(0)
+    , underrunsSeen_(0)
+    , synth_(44100)
     , sampleRate_(44100)
-    , masterVolume_(0.3f)
+    , musicDirectory_("./data/music")
+    , loopCacheEnabled_(true)
+    , playingTheme_(ThemeType::AMBIENT)
+    , effectsFile_("./data/sfx/effects.sfx")
     , currentTheme_(ThemeType::AMBIENT)
     , tensionLevel_(0.0f) {
 
-    for (int i = 0; i < 4; ++i) {
-        channels_[i].type = static_cast<Channel::Type>(i);
-        channels_[i].frequency = 440.0f;
-        channels_[i].duty_cycle = 0.5f;
-        channels_[i].waveform_phase = 0;
-        channels_[i].volume = 0.25f;
-        channels_[i].enabled = false;
-    }
+    // Noise clocks once per sample
+    synth_.voice(3).frequency = static_cast<float>(sampleRate_);
 }
 
 AudioManager::~AudioManager() {
@@ -33,58 +50,236 @@ AudioManager::~AudioManager() {
 }
 
 bool AudioManager::initialize() {
-    SDL_AudioSpec desiredSpec;
-    SDL_zero(desiredSpec);
+    loadMusic();
+    if (!sfx_.loadEffects(effectsFile_)) {
+        std::cerr << "No sound effects loaded from " << effectsFile_ << std::endl;
+    }
+
+    if (!backend_) {
+        backend_ = createSdlAudioBackend();
+    }
+    int blockFrames = lowLatency_ ? LOW_LATENCY_START_FRAMES : DEFAULT_BLOCK_FRAMES;
+    if (!backend_->open(sampleRate_, blockFrames, renderCallback, this)) {
+        if (outputChosen_) {
+            backend_.reset();
+            return false;
+        }
+        // No sound device (servers, CI): keep the synth running unheard
+        std::cerr << "No audio device; using the null output" << std::endl;
+        backend_ = AudioBackend::create("null");
+        backend_->open(sampleRate_, blockFrames, renderCallback, this);
+    }
 
-    desiredSpec.freq = sampleRate_;
-    desiredSpec.format = AUDIO_F32SYS;
-    desiredSpec.channels = 1;
-    desiredSpec.samples = 2048;
-    desiredSpec.callback = audioCallback;
-    desiredSpec.userdata = this;
+    configureOutput();
+
+    // Commands applied before the output opened started the live sequencer
+    if (loopCache_.get(playingTheme_, sequencer_.getTier()).isValid() && sequencer_.isPlaying()) {
+        sequencer_.stop(synth_);
+        loopPlayer_.play(loopCache_.get(playingTheme_, sequencer_.getTier()));
+    }
+
+    streaming_ = true;
+    backend_->start();
+    return true;
+}
+
+bool AudioManager::adaptLatency() {
+    auto now = AudioTimingStats::Clock::now();
+    if (!lowLatency_ || !streaming_ || !backend_->hasDeviceLatency() || now < nextAdapt_) {
+        return false;
+    }
+    nextAdapt_ = now + std::chrono::seconds(1);
+
+    AudioTimingSnapshot stats = timing_.snapshot();
+    int block = stats.blockFrames;
+    if (stats.underruns > underrunsSeen_) {
+        // Never come back down to a size that underran
+        underrunsSeen_ = stats.underruns;
+        quietChecks_ = 0;
+        minimumBlock_ = std::min(LOW_LATENCY_MAX_FRAMES, std::max(minimumBlock_, block * 2));
+        return block < LOW_LATENCY_MAX_FRAMES && reopenOutput(block * 2);
+    }
 
-    audioDevice_ = SDL_OpenAudioDevice(nullptr, 0, &desiredSpec, &audioSpec_, 0);
+    // Shrink only with most of the block to spare in both render time and
+    // callback timing
+    bool roomy = stats.headroom() > 0.75 &&
+                 stats.jitter.percentile(0.99) < stats.blockMicros() / 2.0;
+    quietChecks_ = roomy ? quietChecks_ + 1 : 0;
+    if (quietChecks_ >= QUIET_CHECKS_TO_SHRINK && block / 2 >= minimumBlock_) {
+        quietChecks_ = 0;
+        return reopenOutput(block / 2);
+    }
+    return false;
+}
 
-    if (audioDevice_ == 0) {
-        std::cerr << "Failed to open audio device: " << SDL_GetError() << std::endl;
+bool AudioManager::reopenOutput(int blockFrames) {
+    // Closing stops the callback, so the channel state is safe to leave
+    // as it is; commands queue up until the output starts again
+    int previous = backend_->getBlockFrames();
+    backend_->close();
+    if (!backend_->open(sampleRate_, blockFrames, renderCallback, this) &&
+        !backend_->open(sampleRate_, previous, renderCallback, this)) {
+        std::cerr << "Failed to reopen audio output" << std::endl;
+        streaming_ = false;
+        Command command;
+        while (commands_.pop(command)) {
+            applyCommand(command);
+        }
         return false;
     }
+    configureOutput();
+    underrunsSeen_ = 0;
+    backend_->start();
+    return true;
+}
 
-    SDL_PauseAudioDevice(audioDevice_, 0);  // Start playback
+bool AudioManager::setOutput(const std::string& spec) {
+    // Events still need the callback's clock, which the paced null sink keeps
+    bool events = spec == "events";
+    std::unique_ptr<AudioBackend> backend = AudioBackend::create(events ? "null" : spec);
+    if (!backend) {
+        return false;
+    }
+    backend_ = std::move(backend);
+    outputChosen_ = true;
+    eventOutput_ = events;
+    sequencer_.setEventCallback(events ? noteEventCallback : nullptr, this);
     return true;
 }
 
+void AudioManager::loadMusic() {
+    int loaded = 0;
+    for (int theme = 0; theme <= static_cast<int>(ThemeType::FAILURE); ++theme) {
+        std::string path = musicDirectory_ + "/" +
+                           Sequencer::themeName(static_cast<ThemeType>(theme)) + ".pat";
+        loaded += Sequencer::loadSong(path, songs_[theme]) ? 1 : 0;
+    }
+    if (loaded == 0) {
+        std::cerr << "No pattern files in " << musicDirectory_ << "; themes play as chords"
+                  << std::endl;
+    }
+}
+
+void AudioManager::configureOutput() {
+    // The output has not started, so the channel state is still ours. It
+    // may run at another rate than asked for.
+    int sampleRate = backend_->getSampleRate();
+    int blockFrames = backend_->getBlockFrames();
+    synth_.setSampleRate(sampleRate);
+    synth_.voice(3).frequency = static_cast<float>(sampleRate);
+    sfx_.setSampleRate(sampleRate);
+    synthBuffer_.assign(blockFrames > 0 ? blockFrames : DEFAULT_BLOCK_FRAMES, 0.0f);
+    timing_.reset(sampleRate, blockFrames);
+
+    if (eventOutput_) {
+        // The client maps our sample positions onto its own timeline
+        emitNoteEvent(NoteEventType::START, 0, 0, 0, static_cast<uint32_t>(sampleRate));
+        emitNoteEvent(NoteEventType::MASTER_VOLUME, 0, 0, 0,
+                      static_cast<uint32_t>(std::lround(synth_.getMasterVolume() * 255.0f)));
+        return;
+    }
+
+    loopPlayer_.setCrossfadeFrames(static_cast<size_t>(sampleRate / 20));  // 50ms
+    if (loopCacheEnabled_ && loopCache_.getSampleRate() != sampleRate) {
+        // A reopen at a new rate: the player must let go of the old loops
+        bool looping = loopPlayer_.getLoop() != nullptr;
+        loopPlayer_ = LoopPlayer(static_cast<size_t>(sampleRate / 20));
+        loopCache_.build(songs_, sampleRate, loopCacheDirectory_);
+        if (looping) {
+            loopPlayer_.play(loopCache_.get(playingTheme_, sequencer_.getTier()));
+        }
+    }
+}
+
 void AudioManager::cleanup() {
-    if (audioDevice_ != 0) {
-        SDL_CloseAudioDevice(audioDevice_);
-        audioDevice_ = 0;
+    if (streaming_) {
+        backend_->close();
+        streaming_ = false;
+        loopPlayer_.stop();
+        loopCache_.clear();
+
+        // The callback has stopped, so this thread may consume what it left
+        Command command;
+        while (commands_.pop(command)) {
+            applyCommand(command);
+        }
+    }
+}
+
+void AudioManager::submit(const Command& command) {
+    // Without a running output there is no audio thread to race with
+    if (!streaming_) {
+        applyCommand(command);
+        return;
+    }
+    // A full queue means the callback has stalled for hundreds of changes;
+    // dropping one is better than blocking the frame
+    commands_.push(command);
+}
+
+void AudioManager::applyCommand(const Command& command) {
+    switch (command.type) {
+        case Command::PLAY_THEME: {
+            playingTheme_ = command.theme;
+            emitNoteEvent(NoteEventType::THEME, 0, 0, 0, static_cast<uint32_t>(command.theme));
+            const Song& song = songs_[static_cast<int>(command.theme)];
+            LoopBuffer loop = loopCache_.get(command.theme, sequencer_.getTier());
+            if (loop.isValid()) {
+                sequencer_.stop(synth_);
+                loopPlayer_.play(loop);
+            } else if (!song.isLoaded()) {
+                loopPlayer_.stop();
+                sequencer_.stop(synth_);
+                loadThemeParameters(command.theme);
+                emitChordEvents();
+            } else if (sequencer_.getSong() != &song) {
+                loopPlayer_.stop();
+                sequencer_.play(&song, synth_);
+            }
+            break;
+        }
+        case Command::STOP_MUSIC:
+            loopPlayer_.stop();
+            sequencer_.stop(synth_);
+            break;
+        case Command::SET_VOLUME:
+            synth_.setMasterVolume(command.value);
+            emitNoteEvent(NoteEventType::MASTER_VOLUME, 0, 0, 0,
+                          static_cast<uint32_t>(std::lround(command.value * 255.0f)));
+            break;
+        case Command::SET_TIER:
+            sequencer_.setTier(static_cast<int>(command.value));
+            if (loopPlayer_.getLoop()) {
+                // Same theme, so keep the place in the arrangement
+                loopPlayer_.play(loopCache_.get(playingTheme_, sequencer_.getTier()), true);
+            }
+            break;
     }
 }
 
 void AudioManager::playTheme(const std::string& themeName, ThemeType type) {
     currentTheme_ = type;
-    loadThemeParameters(type);
+    submit({Command::PLAY_THEME, type, 0.0f});
 }
 
 void AudioManager::stopMusic() {
-    for (int i = 0; i < 4; ++i) {
-        channels_[i].enabled = false;
-    }
+    submit({Command::STOP_MUSIC, currentTheme_, 0.0f});
 }
 
 void AudioManager::setMusicVolume(float volume) {
-    masterVolume_ = std::max(0.0f, std::min(1.0f, volume));
+    submit({Command::SET_VOLUME, currentTheme_, std::max(0.0f, std::min(1.0f, volume))});
 }
 
 void AudioManager::updateTensionLevel(float percentTimeRemaining) {
     tensionLevel_ = 1.0f - percentTimeRemaining;
 
-    // Adjust tempo based on tension
-    float tempoMultiplier = 1.0f + (tensionLevel_ * 0.5f);  // Up to 50% faster
-
-    for (int i = 0; i < 4; ++i) {
-        channels_[i].frequency *= tempoMultiplier;
-    }
+    // Same thresholds as TimerSystem's pressure levels; the tier sets the
+    // song's tempo and arrangement, never its pitch
+    int tier = percentTimeRemaining > 0.5f ? 0
+             : percentTimeRemaining > 0.25f ? 1
+             : percentTimeRemaining > 0.1f ? 2
+             : 3;
+    submit({Command::SET_TIER, currentTheme_, static_cast<float>(tier)});
 }
 
 void AudioManager::updateForPuzzleType(PuzzleType type) {
@@ -108,128 +303,184 @@ void AudioManager::updateForPuzzleType(PuzzleType type) {
     }
 }
 
-void AudioManager::playSoundEffect(const std::string& effectName) {
-    // Trigger one-shot sound effect on noise channel
-    channels_[3].enabled = true;
-    channels_[3].volume = 0.4f;
+void AudioManager::playSoundEffect(std::string_view effectName) {
+    // Nothing would drain the triggers without a running output
+    if (streaming_) {
+        sfx_.trigger(sfx_.findEffect(effectName));
+    }
 }
 
-void AudioManager::audioCallback(void* userdata, uint8_t* stream, int len) {
-    AudioManager* manager = static_cast<AudioManager*>(userdata);
-    float* fstream = reinterpret_cast<float*>(stream);
-    int frameCount = len / sizeof(float);
+size_t AudioManager::readNoteEvents(NoteStreamWriter& writer) {
+    size_t count = 0;
+    NoteEvent event;
+    while (noteEvents_.pop(event)) {
+        writer.write(event);
+        count++;
+    }
+    return count;
+}
 
-    manager->generateAudioFrame(fstream, frameCount);
+void AudioManager::noteEventCallback(void* userdata, const NoteEvent& event) {
+    static_cast<AudioManager*>(userdata)->noteEvents_.push(event);
 }
 
-void AudioManager::generateAudioFrame(float* buffer, int frameCount) {
-    for (int i = 0; i < frameCount; ++i) {
-        float sample = 0.0f;
+void AudioManager::emitNoteEvent(NoteEventType type, int voice, uint8_t note, uint8_t volume,
+                                 uint32_t value) {
+    if (!eventOutput_) {
+        return;
+    }
+    NoteEvent event;
+    event.frame = sequencer_.getPosition();
+    event.type = type;
+    event.voice = static_cast<uint8_t>(voice);
+    event.note = note;
+    event.volume = volume;
+    event.value = value;
+    noteEvents_.push(event);
+}
 
-        // Mix all enabled channels
-        if (channels_[0].enabled) {
-            sample += generateSquareWave(channels_[0]) * channels_[0].volume;
-        }
-        if (channels_[1].enabled) {
-            sample += generateSquareWave(channels_[1]) * channels_[1].volume;
-        }
-        if (channels_[2].enabled) {
-            sample += generateTriangleWave(channels_[2]) * channels_[2].volume;
+void AudioManager::emitChordEvents() {
+    // The chord is set as frequencies; send the nearest notes
+    for (int voice = 0; voice < SynthEngine::VOICE_COUNT; ++voice) {
+        const SynthVoice& source = synth_.voice(voice);
+        if (!source.enabled) {
+            emitNoteEvent(NoteEventType::NOTE_OFF, voice, 0, 0, 0);
+            continue;
         }
-        if (channels_[3].enabled) {
-            sample += generateNoiseWave(channels_[3]) * channels_[3].volume;
-        }
-
-        buffer[i] = sample * masterVolume_;
-
-        // Advance waveform phases
-        for (int ch = 0; ch < 4; ++ch) {
-            channels_[ch].waveform_phase = (channels_[ch].waveform_phase + 1) % 8192;
+        if (voice < 2) {
+            emitNoteEvent(NoteEventType::DUTY, voice, 0, 0,
+                          static_cast<uint32_t>(std::lround(source.duty * 256.0f)));
         }
+        float frequency = voice == 3 ? source.frequency / Sequencer::NOISE_CLOCK_RATIO
+                                     : source.frequency;
+        long note = std::lround(69.0 + 12.0 * std::log2(frequency / 440.0));
+        long volume = std::lround(source.volume / Sequencer::voiceGain(voice) * 15.0f);
+        emitNoteEvent(NoteEventType::NOTE_ON, voice,
+                      static_cast<uint8_t>(std::max(0L, std::min(127L, note))),
+                      static_cast<uint8_t>(std::max(0L, std::min(15L, volume))), 0);
     }
 }
 
-float AudioManager::generateSquareWave(const Channel& ch) {
-    float phase = static_cast<float>(ch.waveform_phase) / 8192.0f;
-    return (phase < ch.duty_cycle) ? 1.0f : -1.0f;
+void AudioManager::renderCallback(void* userdata, float* buffer, int frameCount) {
+    AudioManager* manager = static_cast<AudioManager*>(userdata);
+    auto start = AudioTimingStats::Clock::now();
+    manager->generateAudioFrame(buffer, frameCount);
+    manager->timing_.record(start, AudioTimingStats::Clock::now(), frameCount);
 }
 
-float AudioManager::generateTriangleWave(const Channel& ch) {
-    float phase = static_cast<float>(ch.waveform_phase) / 8192.0f;
-    return 4.0f * std::abs(phase - 0.5f) - 1.0f;
-}
+void AudioManager::generateAudioFrame(float* buffer, int frameCount) {
+    // Control changes land on block boundaries
+    Command command;
+    while (commands_.pop(command)) {
+        applyCommand(command);
+    }
 
-float AudioManager::generateNoiseWave(const Channel& ch) {
-    // Simple white noise using LFSR-like approach
-    static uint32_t lfsr = 0xACE1u;
-    lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
-    return (lfsr & 1) ? 1.0f : -1.0f;
+    size_t frames = static_cast<size_t>(frameCount);
+    if (eventOutput_) {
+        // Effects start on the block boundary, as mix() would start them
+        int effect = SfxMixer::NO_EFFECT;
+        while (sfx_.popTrigger(effect)) {
+            NoteEvent event;
+            event.frame = sequencer_.getPosition();
+            event.type = NoteEventType::EFFECT;
+            event.setName(sfx_.getEffect(effect).name);
+            noteEvents_.push(event);
+        }
+        sequencer_.advance(synth_, frames);
+        std::fill(buffer, buffer + frames, 0.0f);
+        return;
+    }
+
+    if (!loopPlayer_.isPlaying()) {
+        sequencer_.render(synth_, buffer, frames);
+    } else {
+        loopPlayer_.render(buffer, frames, synth_.getMasterVolume());
+        bool synthActive = false;
+        for (int voice = 0; voice < SynthEngine::VOICE_COUNT; ++voice) {
+            synthActive = synthActive || synth_.voice(voice).enabled;
+        }
+        // Only while a loop fades out into the chord fallback
+        for (size_t done = 0; synthActive && done < frames; done += synthBuffer_.size()) {
+            size_t chunk = std::min(frames - done, synthBuffer_.size());
+            sequencer_.render(synth_, synthBuffer_.data(), chunk);
+            for (size_t i = 0; i < chunk; ++i) {
+                buffer[done + i] += synthBuffer_[i];
+            }
+        }
+    }
+
+    sfx_.mix(buffer, frames);
 }
 
 void AudioManager::loadThemeParameters(ThemeType theme) {
+    SynthVoice& square1 = synth_.voice(0);
+    SynthVoice& square2 = synth_.voice(1);
+    SynthVoice& triangle = synth_.voice(2);
+    SynthVoice& noise = synth_.voice(3);
+
     // Define musical themes
     switch (theme) {
         case ThemeType::CRISIS:
             // Staccato, urgent
-            channels_[0].enabled = true;
-            channels_[0].frequency = NOTE_FREQUENCIES[11];  // B4
-            channels_[0].duty_cycle = 0.125f;
-            channels_[1].enabled = true;
-            channels_[1].frequency = NOTE_FREQUENCIES[7];   // G#4
-            channels_[1].duty_cycle = 0.25f;
-            channels_[2].enabled = true;
-            channels_[2].frequency = NOTE_FREQUENCIES[2];   // D4 bass
-            channels_[3].enabled = true;
+            square1.enabled = true;
+            square1.frequency = NOTE_FREQUENCIES[11];  // B4
+            square1.duty = 0.125f;
+            square2.enabled = true;
+            square2.frequency = NOTE_FREQUENCIES[7];   // G#4
+            square2.duty = 0.25f;
+            triangle.enabled = true;
+            triangle.frequency = NOTE_FREQUENCIES[2];  // D4 bass
+            noise.enabled = true;
             break;
 
         case ThemeType::FOCUS:
             // Methodical, steady
-            channels_[0].enabled = true;
-            channels_[0].frequency = NOTE_FREQUENCIES[12];  // C5 melody
-            channels_[0].duty_cycle = 0.5f;
-            channels_[1].enabled = true;
-            channels_[1].frequency = NOTE_FREQUENCIES[7];   // G4 harmony
-            channels_[1].duty_cycle = 0.5f;
-            channels_[2].enabled = true;
-            channels_[2].frequency = NOTE_FREQUENCIES[0];   // C4 bass
-            channels_[3].enabled = false;
+            square1.enabled = true;
+            square1.frequency = NOTE_FREQUENCIES[12];  // C5 melody
+            square1.duty = 0.5f;
+            square2.enabled = true;
+            square2.frequency = NOTE_FREQUENCIES[7];   // G4 harmony
+            square2.duty = 0.5f;
+            triangle.enabled = true;
+            triangle.frequency = NOTE_FREQUENCIES[0];  // C4 bass
+            noise.enabled = false;
             break;
 
         case ThemeType::COMPLEX:
             // Arpeggios, layered
-            channels_[0].enabled = true;
-            channels_[0].frequency = NOTE_FREQUENCIES[12];  // C5
-            channels_[0].duty_cycle = 0.5f;
-            channels_[1].enabled = true;
-            channels_[1].frequency = NOTE_FREQUENCIES[16];  // E5
-            channels_[1].duty_cycle = 0.25f;
-            channels_[2].enabled = true;
-            channels_[2].frequency = NOTE_FREQUENCIES[0];   // C4
-            channels_[3].enabled = true;
+            square1.enabled = true;
+            square1.frequency = NOTE_FREQUENCIES[12];  // C5
+            square1.duty = 0.5f;
+            square2.enabled = true;
+            square2.frequency = NOTE_FREQUENCIES[16];  // E5
+            square2.duty = 0.25f;
+            triangle.enabled = true;
+            triangle.frequency = NOTE_FREQUENCIES[0];  // C4
+            noise.enabled = true;
             break;
 
         case ThemeType::VICTORY:
             // Triumphant, ascending
-            channels_[0].enabled = true;
-            channels_[0].frequency = NOTE_FREQUENCIES[17];  // F5
-            channels_[0].duty_cycle = 0.5f;
-            channels_[1].enabled = true;
-            channels_[1].frequency = NOTE_FREQUENCIES[14];  // D5
-            channels_[1].duty_cycle = 0.5f;
-            channels_[2].enabled = true;
-            channels_[2].frequency = NOTE_FREQUENCIES[0];   // C4
-            channels_[3].enabled = true;
+            square1.enabled = true;
+            square1.frequency = NOTE_FREQUENCIES[17];  // F5
+            square1.duty = 0.5f;
+            square2.enabled = true;
+            square2.frequency = NOTE_FREQUENCIES[14];  // D5
+            square2.duty = 0.5f;
+            triangle.enabled = true;
+            triangle.frequency = NOTE_FREQUENCIES[0];  // C4
+            noise.enabled = true;
             break;
 
         default:  // AMBIENT
             // Sparse, calm
-            channels_[0].enabled = true;
-            channels_[0].frequency = NOTE_FREQUENCIES[0];   // C4
-            channels_[0].duty_cycle = 0.5f;
-            channels_[1].enabled = false;
-            channels_[2].enabled = true;
-            channels_[2].frequency = NOTE_FREQUENCIES[0];   // C4
-            channels_[3].enabled = false;
+            square1.enabled = true;
+            square1.frequency = NOTE_FREQUENCIES[0];   // C4
+            square1.duty = 0.5f;
+            square2.enabled = false;
+            triangle.enabled = true;
+            triangle.frequency = NOTE_FREQUENCIES[0];  // C4
+            noise.enabled = false;
             break;
     }
 }
@@ -0,0 +1,163 @@
+#include "framework/AudioTiming.h"
+#include <algorithm>
+
+namespace devescape {
+
+namespace {
+
+// The device model holds this many blocks: the one playing and the one
+// queued behind it, as with SDL's double buffering
+constexpr double DEVICE_BLOCKS = 2.0;
+
+void storeMax(std::atomic<uint64_t>& target, uint64_t value) {
+    // Single writer, so no compare-exchange loop is needed
+    if (value > target.load(std::memory_order_relaxed)) {
+        target.store(value, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+int TimingHistogram::bucketFor(uint64_t micros) {
+    if (micros < 4) {
+        return static_cast<int>(micros);
+    }
+    int msb = 0;
+    for (uint64_t v = micros; v > 1; v >>= 1) {
+        msb++;
+    }
+    int bucket = (msb - 1) * 4 + static_cast<int>((micros >> (msb - 2)) & 3);
+    return std::min(bucket, BUCKETS - 1);
+}
+
+uint64_t TimingHistogram::bucketStart(int bucket) {
+    if (bucket < 4) {
+        return static_cast<uint64_t>(bucket);
+    }
+    int msb = bucket / 4 + 1;
+    return static_cast<uint64_t>(4 + bucket % 4) << (msb - 2);
+}
+
+uint64_t TimingHistogram::percentile(double p) const {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; ++bucket) {
+        seen += counts[bucket];
+        if (seen >= rank) {
+            return bucket + 1 < BUCKETS ? bucketStart(bucket + 1) : bucketStart(bucket);
+        }
+    }
+    return bucketStart(BUCKETS - 1);
+}
+
+double AudioTimingSnapshot::blockMicros() const {
+    return sampleRate > 0 ? blockFrames * 1e6 / sampleRate : 0.0;
+}
+
+double AudioTimingSnapshot::headroom() const {
+    double block = blockMicros();
+    if (block <= 0.0 || generate.total == 0) {
+        return 1.0;
+    }
+    return 1.0 - static_cast<double>(generate.percentile(0.99)) / block;
+}
+
+void AudioTimingSnapshot::print(std::ostream& out) const {
+    out << "Audio: " << callbacks << " callbacks of " << blockFrames << " frames ("
+        << blockMicros() / 1000.0 << " ms), " << underruns << " estimated underruns\n"
+        << "  interval p50/p99/max: " << std::min(interval.percentile(0.5), maxIntervalMicros)
+        << "/" << std::min(interval.percentile(0.99), maxIntervalMicros) << "/"
+        << maxIntervalMicros << " us, jitter p99 "
+        << jitter.percentile(0.99) << " us\n"
+        << "  generate p50/p99/max: " << std::min(generate.percentile(0.5), maxGenerateMicros)
+        << "/" << std::min(generate.percentile(0.99), maxGenerateMicros) << "/"
+        << maxGenerateMicros << " us, headroom "
+        << static_cast<int>(headroom() * 100.0) << "%\n";
+}
+
+void AudioTimingStats::AtomicHistogram::clear() {
+    for (std::atomic<uint64_t>& count : counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+void AudioTimingStats::AtomicHistogram::add(uint64_t micros) {
+    counts[TimingHistogram::bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void AudioTimingStats::AtomicHistogram::copyTo(TimingHistogram& histogram) const {
+    histogram.total = 0;
+    for (int bucket = 0; bucket < TimingHistogram::BUCKETS; ++bucket) {
+        histogram.counts[bucket] = counts[bucket].load(std::memory_order_relaxed);
+        histogram.total += histogram.counts[bucket];
+    }
+}
+
+AudioTimingStats::AudioTimingStats() {
+    reset(0, 0);
+}
+
+void AudioTimingStats::reset(int sampleRate, int blockFrames) {
+    sampleRate_ = sampleRate;
+    blockFrames_ = blockFrames;
+    callbacks_.store(0, std::memory_order_relaxed);
+    underruns_.store(0, std::memory_order_relaxed);
+    maxInterval_.store(0, std::memory_order_relaxed);
+    maxGenerate_.store(0, std::memory_order_relaxed);
+    interval_.clear();
+    jitter_.clear();
+    generate_.clear();
+    lastStart_ = Clock::time_point();
+    bufferedMicros_ = 0.0;
+}
+
+void AudioTimingStats::record(Clock::time_point start, Clock::time_point end, int frameCount) {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    double blockMicros = sampleRate_ > 0 ? frameCount * 1e6 / sampleRate_ : 0.0;
+    uint64_t generateMicros = static_cast<uint64_t>(duration_cast<microseconds>(end - start).count());
+    generate_.add(generateMicros);
+    storeMax(maxGenerate_, generateMicros);
+
+    if (callbacks_.load(std::memory_order_relaxed) > 0) {
+        uint64_t intervalMicros =
+            static_cast<uint64_t>(duration_cast<microseconds>(start - lastStart_).count());
+        interval_.add(intervalMicros);
+        storeMax(maxInterval_, intervalMicros);
+        double late = static_cast<double>(intervalMicros) - blockMicros;
+        jitter_.add(static_cast<uint64_t>(late < 0.0 ? -late : late));
+
+        // The device played on while this callback was due and running
+        bufferedMicros_ -= static_cast<double>(intervalMicros);
+    } else {
+        bufferedMicros_ = DEVICE_BLOCKS * blockMicros;
+    }
+    if (bufferedMicros_ - static_cast<double>(generateMicros) < 0.0) {
+        underruns_.fetch_add(1, std::memory_order_relaxed);
+        bufferedMicros_ = static_cast<double>(generateMicros);
+    }
+    bufferedMicros_ = std::min(bufferedMicros_ + blockMicros, DEVICE_BLOCKS * blockMicros);
+
+    lastStart_ = start;
+    callbacks_.fetch_add(1, std::memory_order_relaxed);
+}
+
+AudioTimingSnapshot AudioTimingStats::snapshot() const {
+    AudioTimingSnapshot snapshot;
+    snapshot.sampleRate = sampleRate_;
+    snapshot.blockFrames = blockFrames_;
+    snapshot.callbacks = callbacks_.load(std::memory_order_relaxed);
+    snapshot.underruns = underruns_.load(std::memory_order_relaxed);
+    snapshot.maxIntervalMicros = maxInterval_.load(std::memory_order_relaxed);
+    snapshot.maxGenerateMicros = maxGenerate_.load(std::memory_order_relaxed);
+    interval_.copyTo(snapshot.interval);
+    jitter_.copyTo(snapshot.jitter);
+    generate_.copyTo(snapshot.generate);
+    return snapshot;
+}
+
+} // namespace devescape
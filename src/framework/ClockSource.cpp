@@ -0,0 +1,132 @@
+#include "framework/ClockSource.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace devescape {
+
+ClockSource::ClockSource()
+    : mode_(Mode::REAL)
+    , scale_(1.0)
+    , base_(Clock::now())
+    , realAnchor_(base_)
+    , wallOrigin_(base_)
+    , wallOriginSystem_(std::chrono::system_clock::now())
+    , frozen_(false) {
+}
+
+ClockSource& ClockSource::shared() {
+    static ClockSource clock;
+    return clock;
+}
+
+ClockSource::time_point ClockSource::now() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nowLocked();
+}
+
+ClockSource::time_point ClockSource::nowLocked() const {
+    if (frozen_) {
+        return frozenAt_;
+    }
+    switch (mode_) {
+        case Mode::REAL:
+            return base_ + (Clock::now() - realAnchor_);
+        case Mode::SCALED: {
+            std::chrono::duration<double> elapsed = Clock::now() - realAnchor_;
+            return base_ + std::chrono::duration_cast<duration>(elapsed * scale_);
+        }
+        case Mode::VIRTUAL:
+            return base_;
+    }
+    return base_;
+}
+
+std::chrono::system_clock::time_point ClockSource::wallNow() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wallOriginSystem_ +
+           std::chrono::duration_cast<std::chrono::system_clock::duration>(nowLocked() - wallOrigin_);
+}
+
+void ClockSource::rebase(Mode mode, double scale) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frozen_ = false;
+    base_ = nowLocked();
+    realAnchor_ = Clock::now();
+    mode_ = mode;
+    scale_ = scale;
+}
+
+void ClockSource::setReal() {
+    rebase(Mode::REAL, 1.0);
+}
+
+void ClockSource::setScaled(double scale) {
+    if (!(scale > 0.0)) {
+        std::cerr << "Clock scale must be positive, got " << scale << std::endl;
+        return;
+    }
+    rebase(Mode::SCALED, scale);
+}
+
+void ClockSource::setVirtual() {
+    rebase(Mode::VIRTUAL, 0.0);
+}
+
+void ClockSource::setVirtualAt(std::chrono::system_clock::time_point wall) {
+    setVirtual();
+    std::lock_guard<std::mutex> lock(mutex_);
+    wallOrigin_ = base_;
+    wallOriginSystem_ = wall;
+}
+
+void ClockSource::freeze() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frozenAt_ = nowLocked();
+    frozen_ = true;
+}
+
+void ClockSource::unfreeze() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frozen_ = false;
+}
+
+void ClockSource::advance(duration amount) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mode_ == Mode::VIRTUAL && amount > duration::zero()) {
+        base_ += amount;
+    }
+}
+
+ClockSource::Mode ClockSource::getMode() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mode_;
+}
+
+double ClockSource::getScale() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return scale_;
+}
+
+bool ClockSource::configure(const std::string& spec) {
+    if (spec == "real") {
+        setReal();
+        return true;
+    }
+    if (spec == "virtual") {
+        setVirtual();
+        return true;
+    }
+    if (spec.compare(0, 7, "scaled:") == 0) {
+        char* end = nullptr;
+        double scale = std::strtod(spec.c_str() + 7, &end);
+        if (end != spec.c_str() + 7 && *end == '\0' && scale > 0.0) {
+            setScaled(scale);
+            return true;
+        }
+    }
+    std::cerr << "Unknown clock '" << spec << "' (expected real, virtual or scaled:<factor>)" << std::endl;
+    return false;
+}
+
+} // namespace devescape
@@ -0,0 +1,257 @@
+#include "framework/CommandGrammar.h"
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+
+namespace devescape {
+
+namespace {
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+size_t skipSpace(std::string_view text, size_t pos) {
+    while (pos < text.size() && isSpace(text[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+size_t tokenEnd(std::string_view text, size_t pos) {
+    while (pos < text.size() && !isSpace(text[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+std::string_view trimEnd(std::string_view text) {
+    while (!text.empty() && isSpace(text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// FNV-1a
+uint32_t hashToken(std::string_view token) {
+    uint32_t hash = 2166136261u;
+    for (char c : token) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+// value is only written when the whole token is a number
+bool parseInteger(std::string_view token, int64_t& value) {
+    const char* end = token.data() + token.size();
+    int64_t parsed = 0;
+    auto [ptr, error] = std::from_chars(token.data(), end, parsed);
+    if (error != std::errc() || ptr != end) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+enum class Slot { LITERAL, INT, WORD, REST };
+
+Slot slotOf(std::string_view token) {
+    if (token == "<int>") return Slot::INT;
+    if (token == "<word>") return Slot::WORD;
+    if (token == "<rest>") return Slot::REST;
+    return Slot::LITERAL;
+}
+
+} // namespace
+
+CommandGrammar::CommandGrammar()
+    : patterns_(0) {
+    states_.emplace_back();
+}
+
+void CommandGrammar::clear() {
+    states_.clear();
+    states_.emplace_back();
+    edges_.clear();
+    words_.clear();
+    patterns_ = 0;
+}
+
+uint32_t CommandGrammar::literal(uint32_t state, std::string_view token, uint32_t hash) const {
+    auto it = std::lower_bound(edges_.begin(), edges_.end(), std::make_pair(state, hash),
+                               [](const Edge& edge, const std::pair<uint32_t, uint32_t>& key) {
+                                   return edge.from < key.first ||
+                                          (edge.from == key.first && edge.hash < key.second);
+                               });
+    for (; it != edges_.end() && it->from == state && it->hash == hash; ++it) {
+        if (std::string_view(words_).substr(it->offset, it->length) == token) {
+            return it->to;
+        }
+    }
+    return NIL;
+}
+
+uint32_t CommandGrammar::addLiteral(uint32_t state, std::string_view token) {
+    uint32_t hash = hashToken(token);
+    uint32_t next = literal(state, token, hash);
+    if (next != NIL) {
+        return next;
+    }
+
+    next = static_cast<uint32_t>(states_.size());
+    states_.emplace_back();
+    Edge edge{state, hash, static_cast<uint32_t>(words_.size()),
+              static_cast<uint32_t>(token.size()), next};
+    words_.append(token);
+
+    auto at = std::upper_bound(edges_.begin(), edges_.end(), edge, [](const Edge& a, const Edge& b) {
+        return a.from < b.from || (a.from == b.from && a.hash < b.hash);
+    });
+    edges_.insert(at, edge);
+    return next;
+}
+
+bool CommandGrammar::add(std::string_view pattern, int command) {
+    if (command < 0) {
+        std::cerr << "Invalid command id " << command << " for pattern: " << pattern << std::endl;
+        return false;
+    }
+
+    // Validate the whole pattern before touching the automaton
+    size_t slots = 0;
+    size_t words = 0;
+    bool restSeen = false;
+    for (size_t pos = skipSpace(pattern, 0); pos < pattern.size();) {
+        size_t end = tokenEnd(pattern, pos);
+        std::string_view token = pattern.substr(pos, end - pos);
+        pos = skipSpace(pattern, end);
+        words++;
+
+        Slot slot = slotOf(token);
+        if (restSeen) {
+            std::cerr << "<rest> must end the pattern: " << pattern << std::endl;
+            return false;
+        }
+        if (slot == Slot::LITERAL && token.front() == '<' && token.back() == '>') {
+            std::cerr << "Unknown slot " << token << " in pattern: " << pattern << std::endl;
+            return false;
+        }
+        if (slot == Slot::INT || slot == Slot::WORD) {
+            slots++;
+        }
+        restSeen = slot == Slot::REST;
+    }
+    if (words == 0 || (words == 1 && restSeen)) {
+        std::cerr << "Pattern needs at least one word: '" << pattern << "'" << std::endl;
+        return false;
+    }
+    if (slots > CommandMatch::MAX_ARGUMENTS) {
+        std::cerr << "Pattern has more than " << CommandMatch::MAX_ARGUMENTS
+                  << " slots: " << pattern << std::endl;
+        return false;
+    }
+
+    uint32_t state = 0;
+    for (size_t pos = skipSpace(pattern, 0); pos < pattern.size();) {
+        size_t end = tokenEnd(pattern, pos);
+        std::string_view token = pattern.substr(pos, end - pos);
+        pos = skipSpace(pattern, end);
+
+        switch (slotOf(token)) {
+            case Slot::LITERAL:
+                state = addLiteral(state, token);
+                break;
+            case Slot::INT:
+                if (states_[state].numberNext == NIL) {
+                    states_[state].numberNext = static_cast<uint32_t>(states_.size());
+                    states_.emplace_back();
+                }
+                state = states_[state].numberNext;
+                break;
+            case Slot::WORD:
+                if (states_[state].wordNext == NIL) {
+                    states_[state].wordNext = static_cast<uint32_t>(states_.size());
+                    states_.emplace_back();
+                }
+                state = states_[state].wordNext;
+                break;
+            case Slot::REST: {
+                int& bound = states_[state].restCommand;
+                if (bound != NO_MATCH && bound != command) {
+                    std::cerr << "Pattern already bound to another command: " << pattern << std::endl;
+                    return false;
+                }
+                patterns_ += bound == NO_MATCH ? 1 : 0;
+                bound = command;
+                return true;
+            }
+        }
+    }
+
+    int& bound = states_[state].command;
+    if (bound != NO_MATCH && bound != command) {
+        std::cerr << "Pattern already bound to another command: " << pattern << std::endl;
+        return false;
+    }
+    patterns_ += bound == NO_MATCH ? 1 : 0;
+    bound = command;
+    return true;
+}
+
+int CommandGrammar::match(std::string_view input, CommandMatch& match) const {
+    match.command = NO_MATCH;
+    match.argumentCount = 0;
+    match.rest = std::string_view();
+
+    // Deepest <rest> passed so far, with the arguments taken before it
+    int restCommand = NO_MATCH;
+    size_t restArguments = 0;
+    std::string_view rest;
+
+    uint32_t state = 0;
+    size_t pos = skipSpace(input, 0);
+    for (;;) {
+        const State& current = states_[state];
+        if (current.restCommand != NO_MATCH) {
+            restCommand = current.restCommand;
+            restArguments = match.argumentCount;
+            rest = trimEnd(input.substr(pos));
+        }
+        if (pos == input.size()) {
+            break;
+        }
+
+        size_t end = tokenEnd(input, pos);
+        std::string_view token = input.substr(pos, end - pos);
+        pos = skipSpace(input, end);
+
+        uint32_t next = literal(state, token, hashToken(token));
+        if (next == NIL) {
+            int64_t value = 0;
+            if (current.numberNext != NIL && parseInteger(token, value)) {
+                next = current.numberNext;
+            } else if (current.wordNext != NIL) {
+                next = current.wordNext;
+            }
+            if (next != NIL) {
+                match.arguments[match.argumentCount++] = CommandArgument{token, value};
+            }
+        }
+        if (next == NIL) {
+            state = NIL;
+            break;
+        }
+        state = next;
+    }
+
+    if (state != NIL && states_[state].command != NO_MATCH) {
+        match.command = states_[state].command;
+    } else if (restCommand != NO_MATCH) {
+        match.command = restCommand;
+        match.argumentCount = restArguments;
+        match.rest = rest;
+    }
+    return match.command;
+}
+
+} // namespace devescape
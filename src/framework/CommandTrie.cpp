@@ -0,0 +1,144 @@
+#include "framework/CommandTrie.h"
+#include <utility>
+
+namespace devescape {
+
+CommandTrie::CommandTrie() {
+    nodes_.emplace_back();
+}
+
+void CommandTrie::clear() {
+    nodes_.clear();
+    nodes_.emplace_back();
+}
+
+uint32_t CommandTrie::child(uint32_t node, char label) const {
+    // Siblings are sorted, so give up once past the label
+    for (uint32_t c = nodes_[node].firstChild; c != NIL; c = nodes_[c].nextSibling) {
+        if (nodes_[c].label == label) {
+            return c;
+        }
+        if (static_cast<unsigned char>(nodes_[c].label) > static_cast<unsigned char>(label)) {
+            break;
+        }
+    }
+    return NIL;
+}
+
+uint32_t CommandTrie::find(std::string_view prefix) const {
+    uint32_t node = 0;
+    for (char c : prefix) {
+        node = child(node, c);
+        if (node == NIL) {
+            break;
+        }
+    }
+    return node;
+}
+
+bool CommandTrie::contains(std::string_view command) const {
+    uint32_t node = find(command);
+    return node != NIL && nodes_[node].terminal;
+}
+
+void CommandTrie::insert(std::string_view command) {
+    if (command.empty() || contains(command)) {
+        return;
+    }
+
+    uint32_t node = 0;
+    nodes_[0].entries++;
+    for (char c : command) {
+        // Find the sorted insertion point among the children
+        uint32_t previous = NIL;
+        uint32_t current = nodes_[node].firstChild;
+        while (current != NIL &&
+               static_cast<unsigned char>(nodes_[current].label) < static_cast<unsigned char>(c)) {
+            previous = current;
+            current = nodes_[current].nextSibling;
+        }
+
+        if (current == NIL || nodes_[current].label != c) {
+            uint32_t created = static_cast<uint32_t>(nodes_.size());
+            Node fresh;
+            fresh.label = c;
+            fresh.nextSibling = current;
+            nodes_.push_back(fresh);
+            if (previous == NIL) {
+                nodes_[node].firstChild = created;
+            } else {
+                nodes_[previous].nextSibling = created;
+            }
+            current = created;
+        }
+
+        node = current;
+        nodes_[node].entries++;
+    }
+    nodes_[node].terminal = true;
+}
+
+Completion CommandTrie::complete(std::string_view prefix, size_t maxCandidates) const {
+    Completion completion;
+    uint32_t node = find(prefix);
+    if (node == NIL) {
+        return completion;
+    }
+    completion.matches = nodes_[node].entries;
+
+    // Extend while there is exactly one way to continue
+    while (!nodes_[node].terminal && nodes_[node].firstChild != NIL &&
+           nodes_[nodes_[node].firstChild].nextSibling == NIL) {
+        node = nodes_[node].firstChild;
+        completion.extension.push_back(nodes_[node].label);
+    }
+
+    if (nodes_[node].firstChild == NIL || (nodes_[node].terminal && completion.matches == 1)) {
+        return completion;
+    }
+
+    // List distinct continuations up to the next word boundary, depth
+    // first in sibling (sorted) order
+    std::string base(prefix);
+    base += completion.extension;
+    if (nodes_[node].terminal) {
+        completion.candidates.push_back(base);
+    }
+
+    std::string word;
+    std::vector<std::pair<uint32_t, size_t>> stack;  // node, word length before it
+    for (uint32_t c = nodes_[node].firstChild; c != NIL; c = nodes_[c].nextSibling) {
+        stack.emplace_back(c, 0);
+    }
+    // Reverse so the smallest label is visited first
+    for (size_t i = 0, j = stack.size(); i + 1 < j; ++i, --j) {
+        std::swap(stack[i], stack[j - 1]);
+    }
+
+    while (!stack.empty() && completion.candidates.size() < maxCandidates) {
+        auto [current, depth] = stack.back();
+        stack.pop_back();
+        word.resize(depth);
+        word.push_back(nodes_[current].label);
+
+        const Node& n = nodes_[current];
+        bool boundary = n.label == ' ' && depth > 0;
+        if (n.terminal || boundary) {
+            completion.candidates.push_back(base + word);
+            if (boundary) {
+                continue;
+            }
+        }
+
+        size_t mark = stack.size();
+        for (uint32_t c = n.firstChild; c != NIL; c = nodes_[c].nextSibling) {
+            stack.emplace_back(c, depth + 1);
+        }
+        for (size_t i = mark, j = stack.size(); i + 1 < j; ++i, --j) {
+            std::swap(stack[i], stack[j - 1]);
+        }
+    }
+    return completion;
+}
+
+} // namespace devescape
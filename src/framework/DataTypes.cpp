@@ -1,23 +1,86 @@
 #include "framework/DataTypes.h"
+#include "framework/ClockSource.h"
 #include <chrono>
-#include <sstream>
-#include <iomanip>
+#include <ctime>
 
 namespace devescape {
 
+ProcessResult::ProcessResult(const ProcessResult& other, const allocator_type& alloc)
+    : outputText(other.outputText, alloc)
+    , sessionEnded(other.sessionEnded)
+    , success(other.success)
+    , invalidCommand(other.invalidCommand) {
+}
+
+ProcessResult::ProcessResult(ProcessResult&& other, const allocator_type& alloc)
+    : outputText(std::move(other.outputText), alloc)
+    , sessionEnded(other.sessionEnded)
+    , success(other.success)
+    , invalidCommand(other.invalidCommand) {
+}
+
+PuzzleState::PuzzleState(const PuzzleState& other, const allocator_type& alloc)
+    : id(other.id, alloc)
+    , title(other.title, alloc)
+    , solved(other.solved)
+    , completionPercent(other.completionPercent)
+    , hintsUsed(other.hintsUsed)
+    , wrongAttempts(other.wrongAttempts)
+    , timeSpentSeconds(other.timeSpentSeconds)
+    , playerAnswer(other.playerAnswer, alloc)
+    , correctAnswer(other.correctAnswer, alloc)
+    , locked(other.locked) {
+}
+
+PuzzleState::PuzzleState(PuzzleState&& other, const allocator_type& alloc)
+    : id(std::move(other.id), alloc)
+    , title(std::move(other.title), alloc)
+    , solved(other.solved)
+    , completionPercent(other.completionPercent)
+    , hintsUsed(other.hintsUsed)
+    , wrongAttempts(other.wrongAttempts)
+    , timeSpentSeconds(other.timeSpentSeconds)
+    , playerAnswer(std::move(other.playerAnswer), alloc)
+    , correctAnswer(std::move(other.correctAnswer), alloc)
+    , locked(other.locked) {
+}
+
+GameState::GameState(const GameState& other, const allocator_type& alloc)
+    : puzzles(other.puzzles, alloc)
+    , inventory(other.inventory, alloc)
+    , discoveredClues(other.discoveredClues, alloc)
+    , completedPuzzleCount(other.completedPuzzleCount)
+    , eventLog(other.eventLog, alloc) {
+}
+
+GameState::GameState(GameState&& other, const allocator_type& alloc)
+    : puzzles(std::move(other.puzzles), alloc)
+    , inventory(std::move(other.inventory), alloc)
+    , discoveredClues(std::move(other.discoveredClues), alloc)
+    , completedPuzzleCount(other.completedPuzzleCount)
+    , eventLog(std::move(other.eventLog), alloc) {
+}
+
 void GameState::addEvent(const std::string& event) {
-    auto now = std::chrono::system_clock::now();
+    // Stamped from the framework clock so fast-forwarded sessions log the
+    // time the player would have seen
+    auto now = ClockSource::shared().wallNow();
     auto time_t = std::chrono::system_clock::to_time_t(now);
 
-    std::ostringstream oss;
     std::tm tm;
 #ifdef _WIN32
     localtime_s(&tm, &time_t);
 #else
     localtime_r(&time_t, &tm);
 #endif
-    oss << std::put_time(&tm, "%Y-%m-%dT%H:%M:%SZ") << ": " << event;
-    eventLog.push_back(oss.str());
+    char stamp[32];
+    size_t len = std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+    // Build the entry directly in the log's allocator instead of going
+    // through an ostringstream on the global heap.
+    std::pmr::string& entry = eventLog.emplace_back();
+    entry.reserve(len + 2 + event.size());
+    entry.append(stamp, len).append(": ").append(event);
 }
 
 } // namespace devescape
@@ -1,236 +1,286 @@
+#include "framework/GameLoop.h"
 #include "framework/PluginManager.h"
-#include "framework/StateManager.h"
 #include "framework/AudioManager.h"
 #include "framework/TerminalRenderer.h"
-#include "framework/TimerSystem.h"
-#include "framework/IEscapeRoom.h"
+#include "framework/ClockSource.h"
+#include "framework/IEscapeRoomV2.h"
+#include "framework/InputReader.h"
 #include <iostream>
 #include <thread>
-#include <chrono>
 
 namespace devescape {
 
-class GameLoop {
-public:
-    GameLoop(const std::string& pluginDir, const std::string& checkpointDir)
-        : pluginManager_(pluginDir)
-        , stateManager_(checkpointDir)
-        , timerSystem_(nullptr)
-        , currentRoom_(nullptr)
-        , running_(false) {
+GameLoop::GameLoop(PluginManager& pluginManager, StateManager& stateManager,
+                   AudioManager& audioManager)
+    : pluginManager_(pluginManager)
+    , stateManager_(stateManager)
+    , audioManager_(audioManager)
+    , timerSystem_(nullptr)
+    , currentRoom_(nullptr)
+    , running_(false) {
+}
+
+bool GameLoop::run(const std::string& roomName) {
+    using std::chrono::system_clock;
+
+    GameSession session;
+    auto startedAt = ClockSource::shared().wallNow();
+    session.metadata.id = "session_" + std::to_string(system_clock::to_time_t(startedAt));
+    session.metadata.roomName = roomName;
+    session.metadata.playerName = "player";
+    session.metadata.startedAt = startedAt;
+    session.metadata.status = "in_progress";
+    return play(session, false);
+}
+
+bool GameLoop::resume() {
+    GameSession session;
+    if (!stateManager_.loadAutoCheckpoint(session)) {
+        std::cerr << "No session to resume\n";
+        return false;
     }
-
-    ~GameLoop() {
-        cleanup();
+    if (session.metadata.status != "in_progress") {
+        std::cerr << "The last session has ended (" << session.metadata.status << ")\n";
+        return false;
     }
-
-    bool initialize() {
-        // Initialize SDL for audio
-        if (SDL_Init(SDL_INIT_AUDIO) < 0) {
-            std::cerr << "SDL initialization failed: " << SDL_GetError() << std::endl;
-            return false;
-        }
-
-        // Initialize audio
-        if (!audioManager_.initialize()) {
-            return false;
-        }
-
-        // Scan for plugins
-        pluginManager_.scanForPlugins();
-
-        return true;
+    if (session.roomSnapshot.empty()) {
+        std::cerr << "The last checkpoint holds no room state to resume from\n";
+        return false;
+    }
+    std::cout << "Resuming session: " << session.metadata.roomName << "\n";
+    std::cout << "Time remaining: " << session.timeRemainingSeconds << " seconds\n";
+    return play(session, true);
+}
+
+bool GameLoop::play(GameSession& session, bool resuming) {
+    // Initialize framework context
+    context_.audioManager = &audioManager_;
+    context_.stateManager = &stateManager_;
+    context_.dataDirectory = "./data";
+    context_.checkpointDirectory = "./data/checkpoints";
+    context_.memoryResource = sessionArena_.resource();
+
+    // Take an initialized room, warm from the pool when one is idle
+    currentRoom_ = pluginManager_.acquireRoom(session.metadata.roomName, context_);
+    if (!currentRoom_) {
+        return false;
     }
 
-    void cleanup() {
-        if (currentRoom_) {
-            currentRoom_->cleanup();
-        }
+    // Get room duration
+    session.metadata.totalTimeSeconds = currentRoom_->getTotalDurationSeconds();
+    if (!resuming) {
+        session.timeRemainingSeconds = session.metadata.totalTimeSeconds;
+    } else if (!currentRoom_->deserializeState(session.roomSnapshot)) {
+        std::cerr << "Room " << session.metadata.roomName
+                  << " cannot restore the checkpointed state\n";
+        pluginManager_.releaseRoom(currentRoom_);
+        currentRoom_ = nullptr;
+        sessionArena_.release();
+        return false;
+    }
 
-        TerminalControl::restoreTerminalMode();
-        audioManager_.cleanup();
-        SDL_Quit();
+    // Create timer
+    timerSystem_ = std::make_unique<TimerSystem>(session.timeRemainingSeconds, &audioManager_);
+
+    // Tab completion from the room's vocabulary, if it publishes one
+    roomCommands_.clear();
+    pluginManager_.publishCommands(currentRoom_, roomCommands_);
+    editor_.setCompletions(&roomCommands_);
+
+    // Set up terminal
+    TerminalControl::setRawMode();
+
+    // Start main game loop
+    runGameLoop(session);
+
+    TerminalControl::restoreTerminalMode();
+
+    // Cleanup - the room goes back to the pool reset for the next
+    // session; its state lives in its own arena, not the session's
+    pluginManager_.releaseRoom(currentRoom_);
+    currentRoom_ = nullptr;
+    timerSystem_.reset();
+    sessionArena_.release();
+    return true;
+}
+
+void GameLoop::runGameLoop(GameSession& session, TimerService& timers) {
+    using namespace std::chrono;
+
+    const float FRAME_TIME = 1.0f / 60.0f;  // 60 FPS
+    const auto FRAME_DURATION = duration_cast<ClockSource::duration>(duration<float>(FRAME_TIME));
+
+    // Frame times, the countdown and autosave all run on the timer
+    // service's clock; a virtual clock moves one frame per iteration
+    // without sleeping, so whole sessions replay as fast as they compute.
+    // The clock is frozen while a frame runs so that everything in it is
+    // stamped with the frame's time.
+    ClockSource& clock = timers.getClock();
+    clock.freeze();
+    auto frameStart = clock.now();
+    timerSystem_->start();
+    running_ = true;
+
+    if (!recordPath_.empty()) {
+        startRecording(session.metadata.roomName, clock.wallNow());
     }
 
-    void run() {
-        // Display available rooms
-        auto plugins = pluginManager_.getAvailablePlugins();
-        if (plugins.empty()) {
-            std::cout << "No escape rooms found. Please add plugins to the plugins/ directory.\n";
-            return;
+    // Auto-save at session start and every 30 seconds after, on the clock
+    // rather than the frame count
+    auto autosave = [this, &session, &clock]() {
+        session.timeRemainingSeconds = timerSystem_->getSecondsRemaining();
+        session.metadata.timeElapsedSeconds = timerSystem_->getSecondsElapsed();
+        session.metadata.checkpointedAt = clock.wallNow();
+        session.roomSnapshot = currentRoom_->serializeState();
+        stateManager_.createAutoCheckpoint(session);
+        if (recorder_.isOpen()) {
+            recorder_.recordCheckpoint(session.roomSnapshot);
         }
-
-        std::cout << "Available Escape Rooms:\n";
-        for (size_t i = 0; i < plugins.size(); ++i) {
-            std::cout << (i + 1) << ". " << plugins[i].name << "\n";
+    };
+    autosave();
+    TimerService::TimerId autosaveTimer = timers.schedulePeriodic(seconds(30), autosave);
+    clock.unfreeze();
+
+    TerminalRenderer renderer(sessionArena_.resource());
+    InputReader& input = InputReader::standardInput();
+    input.setLineAssembly(false);  // keys go to the line editor
+
+    std::vector<std::string> commands;
+    std::pmr::vector<ProcessResult> results(sessionArena_.resource());
+    float pendingUpdateSeconds = 0.0f;  // time the room has not been told about yet
+    float nextWakeupSeconds = 0.0f;
+    bool redraw = true;
+    int lastTimerSeconds = -1;
+
+    while (running_) {
+        clock.freeze();
+        auto now = clock.now();
+        ClockSource::duration frameDelta = now - frameStart;
+        float deltaTime = duration<float>(frameDelta).count();
+        frameStart = now;
+
+        // Run due timers (countdown, auto-save, ...)
+        timers.advance();
+
+        if (timerSystem_->isExpired()) {
+            recorder_.recordTimeoutFrame(frameDelta);
+            currentRoom_->onSessionTimeout();
+            running_ = false;
+            break;
         }
 
-        // Check for resume option
-        if (stateManager_.hasRecentCheckpoint()) {
-            std::cout << "\nR. Resume previous session\n";
+        // Pick up rebuilt plugins between frames
+        pluginManager_.pollPluginChanges();
+        if (pluginManager_.hasNewerBuild(currentRoom_)) {
+            currentRoom_ = pluginManager_.migrateRoom(currentRoom_, context_);
+            recorder_.recordReload();
+            roomCommands_.clear();
+            pluginManager_.publishCommands(currentRoom_, roomCommands_);
+            nextWakeupSeconds = 0.0f;
+            redraw = true;
         }
 
-        std::cout << "\nSelect a room (or Q to quit): ";
-        std::string choice;
-        std::getline(std::cin, choice);
-
-        if (choice == "Q" || choice == "q") {
-            return;
-        }
-
-        GameSession session;
-        bool resuming = false;
-
-        if ((choice == "R" || choice == "r") && stateManager_.hasRecentCheckpoint()) {
-            if (stateManager_.loadAutoCheckpoint(session)) {
-                resuming = true;
-                std::cout << "Resuming session: " << session.metadata.roomName << "\n";
-                std::cout << "Time remaining: " << session.timeRemainingSeconds << " seconds\n";
+        // Process input (non-blocking); keys go through the line editor
+        // and every line submitted since the last frame goes to the room
+        // as one batch
+        commands.clear();
+        input.poll();
+        std::string line;
+        for (InputEvent event; input.nextEvent(event);) {
+            if (!editor_.handle(event, line) || line.empty()) {
+                continue;
             }
-        }
-
-        if (!resuming) {
-            try {
-                size_t idx = std::stoi(choice) - 1;
-                if (idx < plugins.size()) {
-                    session.metadata.id = "session_" + std::to_string(std::time(nullptr));
-                    session.metadata.roomName = plugins[idx].name;
-                    session.metadata.playerName = "player";
-                    session.metadata.startedAt = std::chrono::system_clock::now();
-                    session.metadata.status = "in_progress";
-                } else {
-                    std::cout << "Invalid selection.\n";
-                    return;
-                }
-            } catch (...) {
-                std::cout << "Invalid input.\n";
-                return;
+            if (line == "surrender") {
+                std::cout << "\nType 'I SURRENDER' three times to quit:\n";
+                // Simplified - would require actual surrender confirmation
             }
+            commands.push_back(std::move(line));
         }
+        recorder_.recordFrame(frameDelta, Span<const std::string>(commands));
 
-        // Load the room
-        currentRoom_ = pluginManager_.loadRoom(session.metadata.roomName);
-        if (!currentRoom_) {
-            std::cout << "Failed to load room.\n";
-            return;
-        }
-
-        // Get room duration
-        session.metadata.totalTimeSeconds = currentRoom_->getTotalDurationSeconds();
-        if (!resuming) {
-            session.timeRemainingSeconds = session.metadata.totalTimeSeconds;
-        }
-
-        // Create timer
-        timerSystem_ = std::make_unique<TimerSystem>(session.timeRemainingSeconds, &audioManager_);
-
-        // Initialize framework context
-        FrameworkContext context;
-        context.audioManager = &audioManager_;
-        context.stateManager = &stateManager_;
-        context.dataDirectory = "./data";
-        context.checkpointDirectory = "./data/checkpoints";
-
-        // Initialize room
-        currentRoom_->initialize(context);
-
-        if (resuming) {
-            // Restore room state
-            std::string serializedState = "{}";  // Would come from session
-            currentRoom_->deserializeState(serializedState);
-        }
+        if (!commands.empty()) {
+            results.clear();
+            currentRoom_->processInputs(Span<const std::string>(commands), results);
+            redraw = true;
 
-        // Set up terminal
-        TerminalControl::setRawMode();
-
-        // Start main game loop
-        runGameLoop(session);
-
-        // Cleanup
-        pluginManager_.unloadRoom(currentRoom_, session.metadata.roomName);
-        currentRoom_ = nullptr;
-    }
-
-private:
-    void runGameLoop(GameSession& session) {
-        using namespace std::chrono;
-
-        const float FRAME_TIME = 1.0f / 60.0f;  // 60 FPS
-        auto frameStart = steady_clock::now();
-
-        timerSystem_->start();
-        running_ = true;
-
-        int frameCounter = 0;
-
-        while (running_) {
-            auto now = steady_clock::now();
-            float deltaTime = duration<float>(now - frameStart).count();
-            frameStart = now;
-
-            // Update timer
-            timerSystem_->update(deltaTime);
-
-            if (timerSystem_->isExpired()) {
-                currentRoom_->onSessionTimeout();
+            bool sessionEnded = false;
+            for (const auto& result : results) {
+                sessionEnded = sessionEnded || result.sessionEnded;
+            }
+            if (sessionEnded) {
                 running_ = false;
                 break;
             }
+        }
 
-            // Process input (non-blocking)
-            std::string input = TerminalControl::readInputNonBlocking();
-            if (!input.empty()) {
-                if (input == "surrender") {
-                    std::cout << "\nType 'I SURRENDER' three times to quit:\n";
-                    // Simplified - would require actual surrender confirmation
-                }
-
-                ProcessResult result = currentRoom_->processInput(input);
-                if (result.sessionEnded) {
-                    running_ = false;
-                    break;
-                }
-            }
-
-            // Update room
-            currentRoom_->update(deltaTime);
+        // Update room - skipped until its requested wakeup unless commands
+        // arrived; the skipped time is passed on at the next update
+        pendingUpdateSeconds += deltaTime;
+        if (!commands.empty() || pendingUpdateSeconds >= nextWakeupSeconds) {
+            UpdateHint hint = currentRoom_->updateFrame(pendingUpdateSeconds);
+            pendingUpdateSeconds = 0.0f;
+            nextWakeupSeconds = hint.nextWakeupSeconds;
+            redraw = redraw || hint.needsRedraw;
+        }
 
-            // Render
-            TerminalRenderer renderer;
+        // Render only when the room, the timer display or the command
+        // line changed
+        int timerSeconds = timerSystem_->getSecondsRemaining();
+        if (redraw || timerSeconds != lastTimerSeconds || editor_.needsRedraw()) {
             currentRoom_->render(renderer);
-            renderer.drawTimer(70, 0, timerSystem_->getSecondsRemaining(), 
-                             timerSystem_->getPressureLevel());
+            renderer.drawTimer(70, 0, timerSeconds, timerSystem_->getPressureLevel());
+            int promptRow = renderer.getHeight() - 1;
+            int cursorColumn = editor_.render(renderer, promptRow);
             renderer.render();
+            renderer.setCursorPosition(cursorColumn, promptRow);
+            redraw = false;
+            lastTimerSeconds = timerSeconds;
+        }
 
-            // Auto-save every 30 seconds (1800 frames at 60 FPS)
-            if (frameCounter % 1800 == 0) {
-                session.timeRemainingSeconds = timerSystem_->getSecondsRemaining();
-                session.metadata.timeElapsedSeconds = timerSystem_->getSecondsElapsed();
-                session.metadata.checkpointedAt = system_clock::now();
-                stateManager_.createAutoCheckpoint(session);
-            }
-
-            frameCounter++;
+        // In low-latency mode the audio buffer follows measured headroom
+        audioManager_.adaptLatency();
 
-            // Frame limiting
-            auto frameEnd = steady_clock::now();
-            float frameDuration = duration<float>(frameEnd - frameStart).count();
-            if (frameDuration < FRAME_TIME) {
-                std::this_thread::sleep_for(duration<float>(FRAME_TIME - frameDuration));
-            }
+        // Frame limiting - in real time even when the clock is scaled
+        clock.unfreeze();
+        if (clock.getMode() == ClockSource::Mode::VIRTUAL) {
+            clock.advance(FRAME_DURATION);
+            continue;
+        }
+        auto frameEnd = clock.now();
+        float frameDuration = duration<float>(frameEnd - frameStart).count() / clock.getScale();
+        if (frameDuration < FRAME_TIME) {
+            std::this_thread::sleep_for(duration<float>(FRAME_TIME - frameDuration));
         }
-
-        // Final save
-        session.metadata.status = currentRoom_->isCompleted() ? "completed" : "failed";
-        stateManager_.createAutoCheckpoint(session);
     }
 
-    PluginManager pluginManager_;
-    StateManager stateManager_;
-    AudioManager audioManager_;
-    std::unique_ptr<TimerSystem> timerSystem_;
-    IEscapeRoom* currentRoom_;
-    bool running_;
-};
+    clock.unfreeze();
+    input.setLineAssembly(true);
+    timers.cancel(autosaveTimer);
+    timerSystem_->stop();
+    session.roomSnapshot = currentRoom_->serializeState();
+    recorder_.close(session.roomSnapshot);
+
+    // Final save
+    session.metadata.status = currentRoom_->isCompleted() ? "completed" : "failed";
+    stateManager_.createAutoCheckpoint(session);
+}
+
+void GameLoop::startRecording(const std::string& pluginName,
+                              std::chrono::system_clock::time_point wallStart) {
+    RecordingHeader header;
+    header.pluginName = pluginName;
+    header.roomVersion = currentRoom_->getVersion();
+    header.wallStart = wallStart;
+    header.initialState = currentRoom_->serializeState();
+    for (const PluginInfo& info : pluginManager_.getAvailablePlugins()) {
+        if (info.name == pluginName) {
+            header.pluginVersion = makePluginVersion(info.abiVersion,
+                                                     static_cast<uint32_t>(std::stoul(info.version)));
+        }
+    }
+    if (recorder_.open(recordPath_, header)) {
+        std::cout << "Recording session to " << recordPath_ << "\n";
+    }
+}
 
 } // namespace devescape
@@ -1,8 +1,14 @@
 #include "framework/HintSystem.h"
+#include "framework/TimerSystem.h"
+#include <cmath>
 
 namespace devescape {
 
-HintSystem::HintSystem() = default;
+HintSystem::HintSystem() : timers_(nullptr) {}
+
+HintSystem::~HintSystem() {
+    stopWatching();
+}
 
 void HintSystem::addHint(const std::string& text, int minFailedAttempts, float minTimePercent) {
     HintTier tier;
@@ -33,4 +39,36 @@ std::string HintSystem::getHint(int hintLevel) const {
     return hints_[hintLevel].text;
 }
 
+
+void HintSystem::watchTimeUnlocks(TimerSystem& timer, std::function<void(int)> onUnlock) {
+    stopWatching();
+    timers_ = &timer.getTimerService();
+    timeUnlocked_.assign(hints_.size(), false);
+
+    for (size_t level = 0; level < hints_.size(); ++level) {
+        int threshold = static_cast<int>(
+            std::floor(hints_[level].minTimeRemainingPercent * timer.getTotalSeconds()));
+        unlockTimers_.push_back(timer.scheduleAtRemaining(threshold, [this, level, onUnlock]() {
+            timeUnlocked_[level] = true;
+            if (onUnlock) {
+                onUnlock(static_cast<int>(level));
+            }
+        }));
+    }
+}
+
+void HintSystem::stopWatching() {
+    if (timers_) {
+        for (TimerService::TimerId id : unlockTimers_) {
+            timers_->cancel(id);
+        }
+    }
+    unlockTimers_.clear();
+    timers_ = nullptr;
+}
+
+bool HintSystem::isTimeUnlocked(int hintLevel) const {
+    return hintLevel >= 0 && hintLevel < static_cast<int>(timeUnlocked_.size()) && timeUnlocked_[hintLevel];
+}
+
 } // namespace devescape
@@ -0,0 +1,403 @@
+#include "framework/InputReader.h"
+#include <algorithm>
+#include <array>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace devescape {
+
+namespace {
+
+// Byte classes the decoder distinguishes
+enum ByteClass : uint8_t {
+    B_CONTROL,   // C0 controls other than ESC
+    B_ESCAPE,    // 0x1B
+    B_DIGIT,     // 0-9
+    B_SEMICOLON,
+    B_BRACKET,   // [
+    B_LETTER_O,  // O
+    B_FINAL,     // other 0x40-0x7E: ends a sequence
+    B_OTHER,     // space, punctuation, private markers
+    B_DELETE,    // 0x7F
+    B_LEAD2,     // UTF-8 lead bytes
+    B_LEAD3,
+    B_LEAD4,
+    B_CONTINUATION,
+    B_INVALID,
+    BYTE_CLASS_COUNT
+};
+
+constexpr std::array<uint8_t, 256> makeByteClasses() {
+    std::array<uint8_t, 256> classes{};
+    for (int b = 0; b < 256; ++b) {
+        uint8_t c = B_INVALID;
+        if (b < 0x20) c = B_CONTROL;
+        else if (b < 0x30) c = B_OTHER;
+        else if (b < 0x3A) c = B_DIGIT;
+        else if (b < 0x40) c = B_OTHER;
+        else if (b < 0x7F) c = B_FINAL;
+        else if (b == 0x7F) c = B_DELETE;
+        else if (b < 0xC0) c = B_CONTINUATION;
+        else if (b < 0xE0) c = B_LEAD2;
+        else if (b < 0xF0) c = B_LEAD3;
+        else if (b < 0xF8) c = B_LEAD4;
+        classes[b] = c;
+    }
+    classes[0x1B] = B_ESCAPE;
+    classes[';'] = B_SEMICOLON;
+    classes['['] = B_BRACKET;
+    classes['O'] = B_LETTER_O;
+    return classes;
+}
+
+constexpr std::array<uint8_t, 256> BYTE_CLASSES = makeByteClasses();
+
+enum Action : uint8_t {
+    A_IGNORE,
+    A_PRINT,
+    A_CONTROL,
+    A_BACKSPACE,
+    A_ESCAPE_START,
+    A_ESCAPE_AGAIN,      // ESC ESC: the first was a lone Escape
+    A_ESCAPE_REPROCESS,  // ESC then something that starts no sequence
+    A_SEQUENCE_START,
+    A_PARAM_DIGIT,
+    A_PARAM_NEXT,
+    A_CSI_DISPATCH,
+    A_SS3_DISPATCH,
+    A_REPROCESS,         // abandon the sequence and decode the byte afresh
+    A_UTF8_START,
+    A_UTF8_CONTINUE
+};
+
+struct Transition {
+    Action action;
+    uint8_t next;
+};
+
+// Indexed by InputReader::State; kept in the same order
+enum : uint8_t { S_GROUND, S_ESCAPE, S_CSI, S_SS3, S_UTF8 };
+
+constexpr Transition TRANSITIONS[5][BYTE_CLASS_COUNT] = {
+    // GROUND
+    {{A_CONTROL, S_GROUND}, {A_ESCAPE_START, S_ESCAPE}, {A_PRINT, S_GROUND}, {A_PRINT, S_GROUND},
+     {A_PRINT, S_GROUND}, {A_PRINT, S_GROUND}, {A_PRINT, S_GROUND}, {A_PRINT, S_GROUND},
+     {A_BACKSPACE, S_GROUND}, {A_UTF8_START, S_UTF8}, {A_UTF8_START, S_UTF8},
+     {A_UTF8_START, S_UTF8}, {A_IGNORE, S_GROUND}, {A_IGNORE, S_GROUND}},
+    // ESC
+    {{A_ESCAPE_REPROCESS, S_GROUND}, {A_ESCAPE_AGAIN, S_ESCAPE}, {A_ESCAPE_REPROCESS, S_GROUND},
+     {A_ESCAPE_REPROCESS, S_GROUND}, {A_SEQUENCE_START, S_CSI}, {A_SEQUENCE_START, S_SS3},
+     {A_ESCAPE_REPROCESS, S_GROUND}, {A_ESCAPE_REPROCESS, S_GROUND},
+     {A_ESCAPE_REPROCESS, S_GROUND}, {A_ESCAPE_REPROCESS, S_GROUND},
+     {A_ESCAPE_REPROCESS, S_GROUND}, {A_ESCAPE_REPROCESS, S_GROUND},
+     {A_ESCAPE_REPROCESS, S_GROUND}, {A_ESCAPE_REPROCESS, S_GROUND}},
+    // ESC [
+    {{A_CONTROL, S_CSI}, {A_ESCAPE_START, S_ESCAPE}, {A_PARAM_DIGIT, S_CSI}, {A_PARAM_NEXT, S_CSI},
+     {A_IGNORE, S_CSI}, {A_CSI_DISPATCH, S_GROUND}, {A_CSI_DISPATCH, S_GROUND}, {A_IGNORE, S_CSI},
+     {A_IGNORE, S_CSI}, {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND},
+     {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND}},
+    // ESC O
+    {{A_CONTROL, S_SS3}, {A_ESCAPE_START, S_ESCAPE}, {A_IGNORE, S_SS3}, {A_IGNORE, S_SS3},
+     {A_SS3_DISPATCH, S_GROUND}, {A_SS3_DISPATCH, S_GROUND}, {A_SS3_DISPATCH, S_GROUND},
+     {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND},
+     {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND},
+     {A_REPROCESS, S_GROUND}},
+    // UTF-8 continuation expected
+    {{A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND},
+     {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND},
+     {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND},
+     {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND}, {A_REPROCESS, S_GROUND},
+     {A_UTF8_CONTINUE, S_UTF8}, {A_REPROCESS, S_GROUND}},
+};
+
+// Final bytes of ESC [ and ESC O sequences; CHARACTER marks "no key"
+constexpr std::array<Key, 128> makeFinalKeys() {
+    std::array<Key, 128> keys{};
+    for (Key& key : keys) {
+        key = Key::CHARACTER;
+    }
+    keys['A'] = Key::UP;
+    keys['B'] = Key::DOWN;
+    keys['C'] = Key::RIGHT;
+    keys['D'] = Key::LEFT;
+    keys['H'] = Key::HOME;
+    keys['F'] = Key::END;
+    keys['Z'] = Key::TAB;  // shift-tab
+    return keys;
+}
+
+constexpr std::array<Key, 128> FINAL_KEYS = makeFinalKeys();
+
+// ESC [ n ~
+constexpr Key TILDE_KEYS[] = {
+    Key::CHARACTER, Key::HOME, Key::INSERT, Key::DELETE_CHAR, Key::END,
+    Key::PAGE_UP, Key::PAGE_DOWN, Key::HOME, Key::END
+};
+
+} // namespace
+
+InputReader::InputReader(int fd)
+    : fd_(fd)
+    , head_(0)
+    , tail_(0)
+    , state_(GROUND)
+    , param_(0)
+    , paramClosed_(false)
+    , lastWasCarriageReturn_(false)
+    , utf8Remaining_(0)
+    , escapeWaiting_(false)
+    , lineAssembly_(true) {
+}
+
+InputReader& InputReader::standardInput() {
+    static InputReader reader(0);
+    return reader;
+}
+
+size_t InputReader::poll() {
+    size_t received = readAvailable();
+    decode();
+
+    // A lone ESC is only known to be one when nothing follows it
+    if (state_ == ESCAPE_SEEN) {
+        if (received == 0 && escapeWaiting_) {
+            state_ = GROUND;
+            escapeWaiting_ = false;
+            emitKey(Key::ESCAPE);
+        } else {
+            escapeWaiting_ = true;
+        }
+    } else {
+        escapeWaiting_ = false;
+    }
+    return events_.size();
+}
+
+void InputReader::feed(const char* data, size_t size) {
+    while (size > 0) {
+        if (tail_ - head_ == RING_SIZE) {
+            decode();
+        }
+        size_t start = tail_ & (RING_SIZE - 1);
+        size_t chunk = std::min(size, std::min(RING_SIZE - (tail_ - head_), RING_SIZE - start));
+        std::copy(data, data + chunk, ring_ + start);
+        tail_ += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+    decode();
+}
+
+size_t InputReader::readAvailable() {
+    size_t received = 0;
+#ifdef _WIN32
+    HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+    DWORD pending = 0;
+    while (GetNumberOfConsoleInputEvents(input, &pending) && pending > 0) {
+        INPUT_RECORD records[64];
+        DWORD count = 0;
+        if (!ReadConsoleInputA(input, records, std::min<DWORD>(pending, 64), &count) || count == 0) {
+            break;
+        }
+        for (DWORD i = 0; i < count; ++i) {
+            const KEY_EVENT_RECORD& key = records[i].Event.KeyEvent;
+            if (records[i].EventType != KEY_EVENT || !key.bKeyDown || key.uChar.AsciiChar == 0) {
+                continue;
+            }
+            for (WORD repeat = 0; repeat < std::max<WORD>(key.wRepeatCount, 1); ++repeat) {
+                if (tail_ - head_ == RING_SIZE) {
+                    decode();
+                }
+                ring_[tail_++ & (RING_SIZE - 1)] = key.uChar.AsciiChar;
+                received++;
+            }
+        }
+    }
+#else
+    // Raw mode (VMIN 0, VTIME 0) makes read() return at once when empty
+    for (;;) {
+        if (tail_ - head_ == RING_SIZE) {
+            decode();
+        }
+        size_t start = tail_ & (RING_SIZE - 1);
+        size_t space = std::min(RING_SIZE - (tail_ - head_), RING_SIZE - start);
+        ssize_t count = ::read(fd_, ring_ + start, space);
+        if (count <= 0) {
+            break;
+        }
+        tail_ += static_cast<size_t>(count);
+        received += static_cast<size_t>(count);
+        if (static_cast<size_t>(count) < space) {
+            break;  // drained
+        }
+    }
+#endif
+    return received;
+}
+
+void InputReader::decode() {
+    while (head_ != tail_) {
+        uint8_t byte = static_cast<uint8_t>(ring_[head_ & (RING_SIZE - 1)]);
+        head_++;
+        step(byte);
+        lastWasCarriageReturn_ = byte == '\r';
+    }
+}
+
+void InputReader::step(uint8_t byte) {
+    const Transition& transition = TRANSITIONS[state_][BYTE_CLASSES[byte]];
+    state_ = static_cast<State>(transition.next);
+
+    switch (transition.action) {
+        case A_IGNORE:
+            break;
+        case A_PRINT: {
+            char c = static_cast<char>(byte);
+            emitText(&c, 1);
+            break;
+        }
+        case A_CONTROL:
+            emitControl(byte);
+            break;
+        case A_BACKSPACE:
+            emitKey(Key::BACKSPACE);
+            break;
+        case A_ESCAPE_START:
+            break;
+        case A_ESCAPE_AGAIN:
+            emitKey(Key::ESCAPE);
+            break;
+        case A_ESCAPE_REPROCESS:
+            emitKey(Key::ESCAPE);
+            step(byte);
+            break;
+        case A_SEQUENCE_START:
+            param_ = 0;
+            paramClosed_ = false;
+            break;
+        case A_PARAM_DIGIT:
+            if (!paramClosed_) {
+                param_ = std::min(param_ * 10 + (byte - '0'), MAX_PARAM);
+            }
+            break;
+        case A_PARAM_NEXT:
+            // Only the first parameter picks the key; the rest are modifiers
+            paramClosed_ = true;
+            break;
+        case A_CSI_DISPATCH: {
+            int param = param_;
+            Key key = Key::CHARACTER;
+            if (byte == '~') {
+                if (param > 0 && param < static_cast<int>(sizeof(TILDE_KEYS) / sizeof(TILDE_KEYS[0]))) {
+                    key = TILDE_KEYS[param];
+                }
+            } else {
+                key = FINAL_KEYS[byte & 0x7F];
+            }
+            if (key != Key::CHARACTER) {
+                emitKey(key);
+            }
+            break;
+        }
+        case A_SS3_DISPATCH:
+            if (FINAL_KEYS[byte & 0x7F] != Key::CHARACTER) {
+                emitKey(FINAL_KEYS[byte & 0x7F]);
+            }
+            break;
+        case A_REPROCESS:
+            utf8Pending_.clear();
+            step(byte);
+            break;
+        case A_UTF8_START:
+            utf8Pending_.assign(1, static_cast<char>(byte));
+            utf8Remaining_ = byte < 0xE0 ? 1 : byte < 0xF0 ? 2 : 3;
+            break;
+        case A_UTF8_CONTINUE:
+            utf8Pending_.push_back(static_cast<char>(byte));
+            if (--utf8Remaining_ == 0) {
+                state_ = GROUND;
+                emitText(utf8Pending_.data(), utf8Pending_.size());
+                utf8Pending_.clear();
+            }
+            break;
+    }
+}
+
+void InputReader::emitControl(uint8_t byte) {
+    switch (byte) {
+        case '\r':
+            emitKey(Key::ENTER);
+            break;
+        case '\n':
+            // CR LF is one Enter
+            if (!lastWasCarriageReturn_) {
+                emitKey(Key::ENTER);
+            }
+            break;
+        case '\t':
+            emitKey(Key::TAB);
+            break;
+        case '\b':
+            emitKey(Key::BACKSPACE);
+            break;
+        default:
+            if (byte >= 1 && byte <= 26) {
+                emitKey(Key::CONTROL, static_cast<char>('a' + byte - 1));
+            }
+            break;
+    }
+}
+
+void InputReader::emitText(const char* text, size_t size) {
+    if (lineAssembly_) {
+        partialLine_.append(text, size);
+        return;
+    }
+    InputEvent& event = events_.emplace_back();
+    event.type = InputEvent::Type::KEY;
+    event.key = Key::CHARACTER;
+    event.text.assign(text, size);
+}
+
+void InputReader::emitKey(Key key, char control) {
+    if (lineAssembly_) {
+        if (key == Key::ENTER) {
+            InputEvent& event = events_.emplace_back();
+            event.type = InputEvent::Type::LINE;
+            event.key = Key::ENTER;
+            event.text.swap(partialLine_);
+            partialLine_.clear();
+            return;
+        }
+        if (key == Key::BACKSPACE) {
+            // Remove one whole UTF-8 character
+            while (!partialLine_.empty() &&
+                   (static_cast<uint8_t>(partialLine_.back()) & 0xC0) == 0x80) {
+                partialLine_.pop_back();
+            }
+            if (!partialLine_.empty()) {
+                partialLine_.pop_back();
+            }
+            return;
+        }
+    }
+    InputEvent& event = events_.emplace_back();
+    event.type = InputEvent::Type::KEY;
+    event.key = key;
+    event.control = control;
+}
+
+bool InputReader::nextEvent(InputEvent& event) {
+    if (events_.empty()) {
+        return false;
+    }
+    event = std::move(events_.front());
+    events_.pop_front();
+    return true;
+}
+
+} // namespace devescape
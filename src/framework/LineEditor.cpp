@@ -0,0 +1,345 @@
+#include "framework/LineEditor.h"
+#include "framework/TerminalRenderer.h"
+#include <algorithm>
+
+namespace devescape {
+
+namespace {
+
+bool isContinuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+// Columns taken by the first `bytes` bytes, one per UTF-8 character
+size_t columnsOf(const std::string& text, size_t bytes) {
+    size_t columns = 0;
+    for (size_t i = 0; i < bytes && i < text.size(); ++i) {
+        columns += isContinuation(text[i]) ? 0 : 1;
+    }
+    return columns;
+}
+
+// Byte offset of the character at the given column
+size_t byteOfColumn(const std::string& text, size_t column) {
+    size_t i = 0;
+    for (; i < text.size(); ++i) {
+        if (!isContinuation(text[i])) {
+            if (column == 0) {
+                break;
+            }
+            column--;
+        }
+    }
+    return i;
+}
+
+} // namespace
+
+LineEditor::LineEditor(size_t historyLimit)
+    : cursor_(0)
+    , historyLimit_(std::max<size_t>(historyLimit, 1))
+    , historyIndex_(0)
+    , searching_(false)
+    , searchIndex_(0)
+    , completions_(nullptr)
+    , lastWasTab_(false)
+    , dirty_(true) {
+}
+
+bool LineEditor::handle(const InputEvent& event, std::string& line) {
+    if (event.type == InputEvent::Type::LINE) {
+        // Cooked input (line assembly on) goes straight through
+        line = event.text;
+        addHistory(line);
+        return true;
+    }
+
+    if (searching_) {
+        return handleSearch(event, line);
+    }
+
+    bool tab = event.key == Key::TAB;
+    if (!tab && !candidates_.empty()) {
+        candidates_.clear();
+        dirty_ = true;
+    }
+    lastWasTab_ = tab && lastWasTab_;
+
+    switch (event.key) {
+        case Key::CHARACTER:
+            insert(event.text);
+            break;
+        case Key::ENTER:
+            return submit(line);
+        case Key::BACKSPACE:
+            eraseBefore();
+            break;
+        case Key::DELETE_CHAR:
+            eraseAt();
+            break;
+        case Key::LEFT:
+            moveLeft();
+            break;
+        case Key::RIGHT:
+            moveRight();
+            break;
+        case Key::HOME:
+            cursor_ = 0;
+            dirty_ = true;
+            break;
+        case Key::END:
+            cursor_ = buffer_.size();
+            dirty_ = true;
+            break;
+        case Key::UP:
+            if (historyIndex_ > 0) {
+                if (historyIndex_ == history_.size()) {
+                    draft_ = buffer_;
+                }
+                recall(historyIndex_ - 1);
+            }
+            break;
+        case Key::DOWN:
+            if (historyIndex_ + 1 < history_.size()) {
+                recall(historyIndex_ + 1);
+            } else if (historyIndex_ < history_.size()) {
+                historyIndex_ = history_.size();
+                buffer_ = draft_;
+                cursor_ = buffer_.size();
+                dirty_ = true;
+            }
+            break;
+        case Key::TAB:
+            complete();
+            lastWasTab_ = true;
+            break;
+        case Key::CONTROL: {
+            InputEvent mapped;
+            switch (event.control) {
+                case 'a': mapped.key = Key::HOME; break;
+                case 'e': mapped.key = Key::END; break;
+                case 'b': mapped.key = Key::LEFT; break;
+                case 'f': mapped.key = Key::RIGHT; break;
+                case 'p': mapped.key = Key::UP; break;
+                case 'n': mapped.key = Key::DOWN; break;
+                case 'd': mapped.key = Key::DELETE_CHAR; break;
+                case 'u':
+                    buffer_.erase(0, cursor_);
+                    cursor_ = 0;
+                    dirty_ = true;
+                    return false;
+                case 'k':
+                    buffer_.erase(cursor_);
+                    dirty_ = true;
+                    return false;
+                case 'w':
+                    killWord();
+                    return false;
+                case 'r':
+                    searching_ = true;
+                    searchQuery_.clear();
+                    searchSaved_ = buffer_;
+                    searchIndex_ = history_.size();
+                    dirty_ = true;
+                    return false;
+                default:
+                    return false;
+            }
+            return handle(mapped, line);
+        }
+        default:
+            break;
+    }
+    return false;
+}
+
+bool LineEditor::handleSearch(const InputEvent& event, std::string& line) {
+    if (event.key == Key::CHARACTER) {
+        searchQuery_ += event.text;
+        searchFrom(std::min(searchIndex_, history_.size() - (history_.empty() ? 0 : 1)));
+        dirty_ = true;
+        return false;
+    }
+    if (event.key == Key::BACKSPACE) {
+        while (!searchQuery_.empty() && isContinuation(searchQuery_.back())) {
+            searchQuery_.pop_back();
+        }
+        if (!searchQuery_.empty()) {
+            searchQuery_.pop_back();
+        }
+        if (!history_.empty()) {
+            searchFrom(history_.size() - 1);
+        }
+        dirty_ = true;
+        return false;
+    }
+    if (event.key == Key::CONTROL && event.control == 'r') {
+        if (searchIndex_ > 0 && searchIndex_ <= history_.size()) {
+            searchFrom(searchIndex_ - 1);
+        }
+        dirty_ = true;
+        return false;
+    }
+    if (event.key == Key::ESCAPE || (event.key == Key::CONTROL && event.control == 'g')) {
+        searching_ = false;
+        buffer_ = searchSaved_;
+        cursor_ = buffer_.size();
+        historyIndex_ = history_.size();
+        dirty_ = true;
+        return false;
+    }
+
+    // Anything else accepts the match and is then handled as usual
+    searching_ = false;
+    dirty_ = true;
+    return handle(event, line);
+}
+
+void LineEditor::searchFrom(size_t index) {
+    if (history_.empty() || searchQuery_.empty()) {
+        return;
+    }
+    for (size_t i = std::min(index, history_.size() - 1) + 1; i-- > 0;) {
+        size_t found = history_[i].find(searchQuery_);
+        if (found != std::string::npos) {
+            searchIndex_ = i;
+            historyIndex_ = i;
+            buffer_ = history_[i];
+            cursor_ = found;
+            return;
+        }
+    }
+}
+
+bool LineEditor::submit(std::string& line) {
+    line = buffer_;
+    addHistory(buffer_);
+    buffer_.clear();
+    draft_.clear();
+    cursor_ = 0;
+    historyIndex_ = history_.size();
+    candidates_.clear();
+    dirty_ = true;
+    return true;
+}
+
+void LineEditor::addHistory(const std::string& line) {
+    if (!line.empty() && (history_.empty() || history_.back() != line)) {
+        history_.push_back(line);
+        if (history_.size() > historyLimit_) {
+            history_.pop_front();
+        }
+    }
+    historyIndex_ = history_.size();
+}
+
+void LineEditor::recall(size_t index) {
+    historyIndex_ = index;
+    buffer_ = history_[index];
+    cursor_ = buffer_.size();
+    dirty_ = true;
+}
+
+void LineEditor::insert(const std::string& text) {
+    buffer_.insert(cursor_, text);
+    cursor_ += text.size();
+    dirty_ = true;
+}
+
+void LineEditor::moveLeft() {
+    if (cursor_ == 0) {
+        return;
+    }
+    do {
+        cursor_--;
+    } while (cursor_ > 0 && isContinuation(buffer_[cursor_]));
+    dirty_ = true;
+}
+
+void LineEditor::moveRight() {
+    if (cursor_ >= buffer_.size()) {
+        return;
+    }
+    do {
+        cursor_++;
+    } while (cursor_ < buffer_.size() && isContinuation(buffer_[cursor_]));
+    dirty_ = true;
+}
+
+void LineEditor::eraseBefore() {
+    size_t end = cursor_;
+    moveLeft();
+    buffer_.erase(cursor_, end - cursor_);
+}
+
+void LineEditor::eraseAt() {
+    size_t start = cursor_;
+    moveRight();
+    buffer_.erase(start, cursor_ - start);
+    cursor_ = start;
+}
+
+void LineEditor::killWord() {
+    size_t end = cursor_;
+    while (cursor_ > 0 && buffer_[cursor_ - 1] == ' ') {
+        cursor_--;
+    }
+    while (cursor_ > 0 && buffer_[cursor_ - 1] != ' ') {
+        cursor_--;
+    }
+    buffer_.erase(cursor_, end - cursor_);
+    dirty_ = true;
+}
+
+void LineEditor::complete() {
+    if (!completions_) {
+        return;
+    }
+
+    Completion completion = completions_->complete(std::string_view(buffer_).substr(0, cursor_));
+    if (completion.matches == 0) {
+        return;
+    }
+    if (!completion.extension.empty()) {
+        insert(completion.extension);
+        return;
+    }
+    // Nothing to add: a second Tab lists what could come next
+    if (lastWasTab_) {
+        candidates_ = std::move(completion.candidates);
+        dirty_ = true;
+    }
+}
+
+int LineEditor::render(TerminalRenderer& renderer, int y) {
+    int width = renderer.getWidth();
+    std::string prompt = searching_ ? "(reverse-i-search)`" + searchQuery_ + "': " : "> ";
+
+    // Scroll horizontally so the cursor stays on screen
+    size_t available = static_cast<size_t>(std::max<int>(width - static_cast<int>(prompt.size()) - 1, 1));
+    size_t cursorColumn = columnsOf(buffer_, cursor_);
+    size_t firstColumn = cursorColumn >= available ? cursorColumn - available + 1 : 0;
+    size_t first = byteOfColumn(buffer_, firstColumn);
+    size_t last = byteOfColumn(buffer_, firstColumn + available);
+
+    std::string row = prompt + buffer_.substr(first, last - first);
+    row.resize(std::max<size_t>(row.size(), static_cast<size_t>(width)), ' ');
+    renderer.setLine(y, row);
+
+    if (y > 0) {
+        std::string list;
+        for (const std::string& candidate : candidates_) {
+            list += candidate;
+            list += "   ";
+        }
+        list.resize(static_cast<size_t>(width), ' ');
+        if (!candidates_.empty()) {
+            renderer.setLine(y - 1, list);
+        }
+    }
+
+    dirty_ = false;
+    return static_cast<int>(prompt.size() + cursorColumn - firstColumn);
+}
+
+} // namespace devescape
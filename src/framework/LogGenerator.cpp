@@ -0,0 +1,426 @@
+#include "framework/LogGenerator.h"
+#include "framework/Sequencer.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace devescape {
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+    // splitmix64 finalizer
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// The random stream of one line: the same seed and index give the same draws
+struct LineRandom {
+    uint64_t state;
+
+    LineRandom(uint64_t seed, uint64_t line)
+        : state(mix(seed) ^ (line * 0xD1B54A32D192ED03ull)) {
+    }
+
+    uint64_t next() {
+        state += 0x9E3779B97F4A7C15ull;
+        return mix(state);
+    }
+};
+
+void appendNumber(std::string& out, uint64_t value, int width) {
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    for (int i = count; i < width; ++i) {
+        out += '0';
+    }
+    while (count > 0) {
+        out += digits[--count];
+    }
+}
+
+// HH:MM[:SS[.mmm]] to milliseconds
+bool parseTime(const std::string& text, uint64_t& millis) {
+    unsigned hours = 0;
+    unsigned minutes = 0;
+    unsigned seconds = 0;
+    unsigned fraction = 0;
+    int fields = std::sscanf(text.c_str(), "%u:%u:%u.%u", &hours, &minutes, &seconds, &fraction);
+    if (fields < 2 || minutes > 59 || seconds > 59 || fraction > 999) {
+        return false;
+    }
+    millis = ((hours * 60ull + minutes) * 60 + seconds) * 1000 + fraction;
+    return true;
+}
+
+} // namespace
+
+LogGenerator::LogGenerator()
+    : incidentLine_(0) {
+}
+
+bool LogGenerator::compile(const std::string& text, std::vector<Piece>& pieces) {
+    Piece literal;
+    size_t i = 0;
+    while (i < text.size()) {
+        if (text[i] != '{') {
+            literal.text += text[i++];
+            continue;
+        }
+        size_t close = text.find('}', i);
+        if (close == std::string::npos) {
+            return false;
+        }
+        std::string field = text.substr(i + 1, close - i - 1);
+        Piece piece;
+        unsigned long long low = 0;
+        unsigned long long high = 0;
+        unsigned digits = 0;
+        char end = 0;
+        if (std::sscanf(field.c_str(), "hex:%u%c", &digits, &end) == 1 && digits >= 1 &&
+            digits <= 16) {
+            piece.kind = Piece::Kind::HEX;
+            piece.digits = digits;
+        } else if (std::sscanf(field.c_str(), "int:%llu-%llu%c", &low, &high, &end) == 2 &&
+                   low <= high) {
+            piece.kind = Piece::Kind::INT;
+            piece.low = low;
+            piece.span = high - low + 1;
+        } else {
+            return false;
+        }
+        if (!literal.text.empty()) {
+            pieces.push_back(literal);
+            literal.text.clear();
+        }
+        pieces.push_back(piece);
+        i = close + 1;
+    }
+    literal.text += '\n';
+    pieces.push_back(literal);
+    return true;
+}
+
+bool LogGenerator::setProfile(const Profile& profile) {
+    if (profile.spacingMicros == 0) {
+        std::cerr << "Log profile spacing must be at least 1 microsecond" << std::endl;
+        return false;
+    }
+
+    std::vector<Piece> pieces;
+    std::vector<Compiled> compiled;
+    Table before;
+    Table during;
+    for (const Pattern& pattern : profile.patterns) {
+        Compiled entry;
+        entry.firstPiece = static_cast<uint32_t>(pieces.size());
+        if (!compile(pattern.level + " " + pattern.text, pieces)) {
+            std::cerr << "Bad placeholder in log pattern \"" << pattern.text << "\"" << std::endl;
+            return false;
+        }
+        entry.pieceCount = static_cast<uint32_t>(pieces.size()) - entry.firstPiece;
+        uint32_t index = static_cast<uint32_t>(compiled.size());
+        compiled.push_back(entry);
+
+        for (Table* table : {&before, &during}) {
+            bool applies = pattern.period == Pattern::Period::ALWAYS ||
+                           (table == &before) == (pattern.period == Pattern::Period::BEFORE);
+            if (applies && pattern.weight > 0) {
+                table->total += pattern.weight;
+                table->patterns.push_back(index);
+                table->cumulative.push_back(table->total);
+            }
+        }
+    }
+
+    profile_ = profile;
+    pieces_ = std::move(pieces);
+    compiled_ = std::move(compiled);
+    before_ = std::move(before);
+    during_ = std::move(during);
+    incidentLine_ = profile_.incidentMillis == ~0ull ? profile_.lineCount
+                                                     : lineAtMillis(profile_.incidentMillis);
+
+    if ((incidentLine_ > 0 && before_.total == 0) ||
+        (incidentLine_ < profile_.lineCount && during_.total == 0)) {
+        std::cerr << "Log profile has lines before or during the incident but no patterns for them"
+                  << std::endl;
+        profile_.lineCount = 0;
+        return false;
+    }
+    return true;
+}
+
+bool LogGenerator::loadProfile(const std::string& path, Profile& profile) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Cannot open log profile " << path << std::endl;
+        return false;
+    }
+
+    Profile loaded;
+    std::string line;
+    int lineNumber = 0;
+
+    auto fail = [&](const std::string& message) {
+        std::cerr << path << ":" << lineNumber << ": " << message << std::endl;
+        return false;
+    };
+
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream in(Sequencer::stripComment(line));
+        std::string keyword;
+        if (!(in >> keyword)) {
+            continue;
+        }
+
+        std::string value;
+        if (keyword == "always" || keyword == "before" || keyword == "during") {
+            Pattern pattern;
+            pattern.period = keyword == "always" ? Pattern::Period::ALWAYS
+                           : keyword == "before" ? Pattern::Period::BEFORE
+                                                 : Pattern::Period::DURING;
+            if (!(in >> pattern.weight >> pattern.level >> std::quoted(pattern.text))) {
+                return fail("pattern needs a weight, a level and \"text\"");
+            }
+            loaded.patterns.push_back(std::move(pattern));
+        } else if (!(in >> value)) {
+            return fail("'" + keyword + "' needs a value");
+        } else if (keyword == "seed") {
+            loaded.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (keyword == "date") {
+            loaded.date = value;
+        } else if (keyword == "start") {
+            if (!parseTime(value, loaded.startMillis)) {
+                return fail("start needs a time like 09:00:00");
+            }
+        } else if (keyword == "incident") {
+            if (!parseTime(value, loaded.incidentMillis)) {
+                return fail("incident needs a time like 10:02:00");
+            }
+        } else if (keyword == "spacing") {
+            loaded.spacingMicros = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (keyword == "lines") {
+            loaded.lineCount = std::strtoull(value.c_str(), nullptr, 10);
+        } else {
+            return fail("unknown keyword '" + keyword + "'");
+        }
+    }
+
+    profile = std::move(loaded);
+    return true;
+}
+
+uint64_t LogGenerator::lineMillis(uint64_t line) const {
+    // Each line lands somewhere in its own spacing-wide slot
+    LineRandom random(profile_.seed, line);
+    uint64_t micros = line * profile_.spacingMicros + random.next() % profile_.spacingMicros;
+    return profile_.startMillis + micros / 1000;
+}
+
+uint64_t LogGenerator::lineAtMillis(uint64_t millis) const {
+    uint64_t low = 0;
+    uint64_t high = profile_.lineCount;
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (lineMillis(middle) < millis) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+void LogGenerator::appendLine(uint64_t line, std::string& out) const {
+    LineRandom random(profile_.seed, line);
+    uint64_t micros = line * profile_.spacingMicros + random.next() % profile_.spacingMicros;
+    uint64_t millis = profile_.startMillis + micros / 1000;
+
+    out += profile_.date;
+    out += 'T';
+    appendNumber(out, millis / 3600000, 2);
+    out += ':';
+    appendNumber(out, millis / 60000 % 60, 2);
+    out += ':';
+    appendNumber(out, millis / 1000 % 60, 2);
+    out += '.';
+    appendNumber(out, millis % 1000, 3);
+    out += "Z ";
+
+    const Table& table = line >= incidentLine_ ? during_ : before_;
+    uint64_t roll = random.next() % table.total;
+    size_t slot = static_cast<size_t>(
+        std::upper_bound(table.cumulative.begin(), table.cumulative.end(), roll) -
+        table.cumulative.begin());
+    const Compiled& pattern = compiled_[table.patterns[slot]];
+
+    static const char HEX[] = "0123456789abcdef";
+    for (uint32_t i = pattern.firstPiece; i < pattern.firstPiece + pattern.pieceCount; ++i) {
+        const Piece& piece = pieces_[i];
+        switch (piece.kind) {
+            case Piece::Kind::TEXT:
+                out += piece.text;
+                break;
+            case Piece::Kind::HEX: {
+                uint64_t value = random.next();
+                for (uint32_t digit = piece.digits; digit-- > 0;) {
+                    out += HEX[(value >> (digit * 4)) & 0xF];
+                }
+                break;
+            }
+            case Piece::Kind::INT:
+                appendNumber(out, piece.low + random.next() % piece.span, 1);
+                break;
+        }
+    }
+}
+
+void LogGenerator::generate(uint64_t first, uint64_t count, std::string& out) const {
+    uint64_t last = std::min(profile_.lineCount, first + std::min(count, profile_.lineCount));
+    for (uint64_t line = first; line < last; ++line) {
+        appendLine(line, out);
+    }
+}
+
+bool LogGenerator::writeFile(const std::string& path, unsigned threads,
+                             WriteProgress* progress) const {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    uint64_t chunks = (profile_.lineCount + CHUNK_LINES - 1) / CHUNK_LINES;
+    threads = static_cast<unsigned>(std::min<uint64_t>(threads, std::max<uint64_t>(chunks, 1)));
+
+    std::error_code ec;
+    fs::path parent = fs::path(path).parent_path();
+    if (!parent.empty()) {
+        fs::create_directories(parent, ec);
+    }
+    std::string temp = path + ".tmp";
+#ifndef _WIN32
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Cannot write log " << temp << std::endl;
+        return false;
+    }
+#else
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Cannot write log " << temp << std::endl;
+        return false;
+    }
+#endif
+
+    // Workers take chunks in order and format them on their own; a chunk's
+    // offset is known once the one before it has been formatted, so only
+    // that hand-off is serialized and memory stays at a chunk per worker
+    std::atomic<uint64_t> nextChunk(0);
+    std::mutex mutex;
+    std::condition_variable placed;
+    uint64_t placedChunks = 0;
+    uint64_t placedBytes = 0;
+    bool failed = false;
+
+    auto work = [&]() {
+        std::string buffer;
+        for (uint64_t chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+            if (progress && progress->cancel.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lock(mutex);
+                failed = true;
+                placed.notify_all();
+                return;
+            }
+            buffer.clear();
+            generate(chunk * CHUNK_LINES, CHUNK_LINES, buffer);
+
+            uint64_t offset = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                placed.wait(lock, [&]() { return placedChunks == chunk || failed; });
+                if (failed) {
+                    return;
+                }
+                offset = placedBytes;
+                placedBytes += buffer.size();
+#ifdef _WIN32
+                // No positioned writes here; chunks go out in order under the lock
+                failed = !file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+#endif
+                placedChunks++;
+            }
+            placed.notify_all();
+
+#ifndef _WIN32
+            size_t written = 0;
+            while (written < buffer.size()) {
+                ssize_t result = pwrite(fd, buffer.data() + written, buffer.size() - written,
+                                        static_cast<off_t>(offset + written));
+                if (result <= 0) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    failed = true;
+                    placed.notify_all();
+                    return;
+                }
+                written += static_cast<size_t>(result);
+            }
+#else
+            (void)offset;
+#endif
+            if (progress) {
+                uint64_t lines = std::min(CHUNK_LINES, profile_.lineCount - chunk * CHUNK_LINES);
+                progress->linesWritten.fetch_add(lines, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+#ifndef _WIN32
+    failed = close(fd) != 0 || failed;
+#else
+    file.close();
+    failed = !file || failed;
+#endif
+    if (!failed) {
+        fs::rename(temp, path, ec);
+        failed = static_cast<bool>(ec);
+    }
+    if (failed) {
+        if (!progress || !progress->cancel.load()) {
+            std::cerr << "Failed to write log " << path << std::endl;
+        }
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace devescape
@@ -0,0 +1,429 @@
+#include "framework/LogIndex.h"
+#include <algorithm>
+#include <bitset>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define DEVESCAPE_LOG_SSE 1
+  #include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace devescape {
+
+namespace {
+
+const char INDEX_MAGIC[8] = {'D', 'X', 'L', 'O', 'G', 'I', 'X', '1'};
+
+// <log>.idx: this header, the line offsets, then the level bits
+struct IndexFileHeader {
+    char magic[8];
+    uint64_t logBytes;
+    int64_t logModified;
+    uint64_t lineCount;
+};
+
+int lowestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+#ifndef _WIN32
+// Whole file, read-only; nullptr on failure
+void* mapReadOnly(const std::string& path, size_t& bytes) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    bytes = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    return mapping == MAP_FAILED ? nullptr : mapping;
+}
+#endif
+
+} // namespace
+
+LogIndex::LogIndex()
+    : data_(nullptr)
+    , bytes_(0)
+    , lineCount_(0)
+    , offsets_(nullptr)
+    , levels_(nullptr)
+    , logMapping_(nullptr)
+    , indexMapping_(nullptr)
+    , indexMappedBytes_(0) {
+}
+
+LogIndex::~LogIndex() {
+    close();
+}
+
+void LogIndex::close() {
+#ifndef _WIN32
+    if (logMapping_) {
+        munmap(logMapping_, static_cast<size_t>(bytes_));
+    }
+    if (indexMapping_) {
+        munmap(indexMapping_, indexMappedBytes_);
+    }
+#endif
+    logMapping_ = nullptr;
+    indexMapping_ = nullptr;
+    indexMappedBytes_ = 0;
+    logMemory_.clear();
+    offsetMemory_.clear();
+    levelMemory_.clear();
+    data_ = nullptr;
+    bytes_ = 0;
+    lineCount_ = 0;
+    offsets_ = nullptr;
+    levels_ = nullptr;
+}
+
+bool LogIndex::open(const std::string& path) {
+    close();
+
+    std::error_code ec;
+    int64_t modified = static_cast<int64_t>(
+        fs::last_write_time(path, ec).time_since_epoch().count());
+    if (ec) {
+        std::cerr << "Cannot open log " << path << std::endl;
+        return false;
+    }
+
+#ifndef _WIN32
+    size_t bytes = 0;
+    logMapping_ = mapReadOnly(path, bytes);
+    if (!logMapping_) {
+        std::cerr << "Cannot map log " << path << std::endl;
+        return false;
+    }
+    // Queries scan forward through it
+    madvise(logMapping_, bytes, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(logMapping_);
+    bytes_ = bytes;
+#else
+    // No mapping here; the log is read into memory
+    std::ifstream file(path, std::ios::binary);
+    logMemory_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (logMemory_.empty()) {
+        std::cerr << "Cannot read log " << path << std::endl;
+        return false;
+    }
+    data_ = logMemory_.data();
+    bytes_ = logMemory_.size();
+#endif
+
+    std::string indexPath = path + ".idx";
+    if (mapIndex(indexPath, bytes_, modified)) {
+        return true;
+    }
+    buildIndex();
+    // Without a writable directory the index just stays in memory
+    if (writeIndex(indexPath, modified)) {
+        offsetMemory_ = std::vector<uint64_t>();
+        levelMemory_ = std::vector<uint8_t>();
+        if (!mapIndex(indexPath, bytes_, modified)) {
+            buildIndex();
+        }
+    }
+    return true;
+}
+
+bool LogIndex::mapIndex(const std::string& path, uint64_t logBytes, int64_t logModified) {
+    IndexFileHeader header;
+#ifndef _WIN32
+    size_t bytes = 0;
+    void* mapping = mapReadOnly(path, bytes);
+    if (!mapping) {
+        return false;
+    }
+    if (bytes < sizeof(header)) {
+        munmap(mapping, bytes);
+        return false;
+    }
+    std::memcpy(&header, mapping, sizeof(header));
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+    }
+#endif
+
+    bool valid = std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+                 header.logBytes == logBytes && header.logModified == logModified;
+#ifndef _WIN32
+    if (!valid || sizeof(header) + (header.lineCount + 1) * sizeof(uint64_t) +
+                      header.lineCount != bytes) {
+        munmap(mapping, bytes);
+        return false;
+    }
+    indexMapping_ = mapping;
+    indexMappedBytes_ = bytes;
+    const char* base = static_cast<const char*>(mapping) + sizeof(header);
+    offsets_ = reinterpret_cast<const uint64_t*>(base);
+    levels_ = reinterpret_cast<const uint8_t*>(base + (header.lineCount + 1) * sizeof(uint64_t));
+#else
+    if (!valid) {
+        return false;
+    }
+    offsetMemory_.resize(static_cast<size_t>(header.lineCount + 1));
+    levelMemory_.resize(static_cast<size_t>(header.lineCount));
+    if (!file.read(reinterpret_cast<char*>(offsetMemory_.data()),
+                   offsetMemory_.size() * sizeof(uint64_t)) ||
+        !file.read(reinterpret_cast<char*>(levelMemory_.data()), levelMemory_.size())) {
+        offsetMemory_.clear();
+        levelMemory_.clear();
+        return false;
+    }
+    offsets_ = offsetMemory_.data();
+    levels_ = levelMemory_.data();
+#endif
+    lineCount_ = static_cast<size_t>(header.lineCount);
+    return true;
+}
+
+void LogIndex::buildIndex() {
+    offsetMemory_.clear();
+    levelMemory_.clear();
+    offsetMemory_.push_back(0);
+
+    // Newlines, 16 bytes to a compare
+    const char* data = data_;
+    uint64_t i = 0;
+#if defined(DEVESCAPE_LOG_SSE)
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= bytes_; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        while (mask != 0) {
+            offsetMemory_.push_back(i + lowestBit(mask) + 1);
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < bytes_; ++i) {
+        if (data[i] == '\n') {
+            offsetMemory_.push_back(i + 1);
+        }
+    }
+    // An unterminated last line still counts
+    if (offsetMemory_.back() != bytes_) {
+        offsetMemory_.push_back(bytes_);
+    }
+
+    lineCount_ = offsetMemory_.size() - 1;
+    offsets_ = offsetMemory_.data();
+    levelMemory_.resize(lineCount_);
+    for (size_t line = 0; line < lineCount_; ++line) {
+        levelMemory_[line] = parseLevel(this->line(line));
+    }
+    levels_ = levelMemory_.data();
+}
+
+bool LogIndex::writeIndex(const std::string& path, int64_t logModified) const {
+    IndexFileHeader header = {};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.logBytes = bytes_;
+    header.logModified = logModified;
+    header.lineCount = lineCount_;
+
+    // Written aside and renamed, so a mapped index is never rewritten
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+            !file.write(reinterpret_cast<const char*>(offsets_),
+                        (lineCount_ + 1) * sizeof(uint64_t)) ||
+            !file.write(reinterpret_cast<const char*>(levels_), lineCount_)) {
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string_view LogIndex::line(size_t index) const {
+    uint64_t start = offsets_[index];
+    uint64_t end = offsets_[index + 1];
+    if (end > start && data_[end - 1] == '\n') {
+        end--;
+    }
+    if (end > start && data_[end - 1] == '\r') {
+        end--;
+    }
+    return std::string_view(data_ + start, static_cast<size_t>(end - start));
+}
+
+size_t LogIndex::lineAt(uint64_t offset) const {
+    const uint64_t* next = std::upper_bound(offsets_, offsets_ + lineCount_, offset);
+    return static_cast<size_t>(next - offsets_) - 1;
+}
+
+size_t LogIndex::lowerBound(std::string_view timestampPrefix) const {
+    size_t low = 0;
+    size_t high = lineCount_;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (line(middle).substr(0, timestampPrefix.size()) < timestampPrefix) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+size_t LogIndex::upperBound(std::string_view timestampPrefix) const {
+    size_t low = 0;
+    size_t high = lineCount_;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (line(middle).substr(0, timestampPrefix.size()) <= timestampPrefix) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+size_t LogIndex::findLevel(size_t first, size_t last, uint8_t mask) const {
+    size_t i = first;
+#if defined(DEVESCAPE_LOG_SSE)
+    const __m128i bits = _mm_set1_epi8(static_cast<char>(mask));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= last; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(levels_ + i));
+        uint32_t none = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(chunk, bits), zero)));
+        if (none != 0xFFFF) {
+            return i + lowestBit(~none & 0xFFFF);
+        }
+    }
+#endif
+    for (; i < last; ++i) {
+        if (levels_[i] & mask) {
+            return i;
+        }
+    }
+    return last;
+}
+
+size_t LogIndex::countLevel(size_t first, size_t last, uint8_t mask) const {
+    size_t count = 0;
+    size_t i = first;
+#if defined(DEVESCAPE_LOG_SSE)
+    const __m128i bits = _mm_set1_epi8(static_cast<char>(mask));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= last; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(levels_ + i));
+        uint32_t none = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(chunk, bits), zero)));
+        count += 16 - std::bitset<16>(none).count();
+    }
+#endif
+    for (; i < last; ++i) {
+        count += (levels_[i] & mask) ? 1 : 0;
+    }
+    return count;
+}
+
+uint64_t LogIndex::find(uint64_t from, uint64_t to, std::string_view needle) const {
+    to = std::min(to, bytes_);
+    if (from >= to || needle.size() > to - from) {
+        return NOT_FOUND;
+    }
+    if (needle.empty()) {
+        return from;
+    }
+    const char* data = data_;
+    const size_t length = needle.size();
+    uint64_t i = from;
+#if defined(DEVESCAPE_LOG_SSE)
+    // A candidate has the needle's first byte at i and its last at
+    // i + length - 1; only those get compared in full
+    const __m128i first = _mm_set1_epi8(needle.front());
+    const __m128i last = _mm_set1_epi8(needle.back());
+    for (; i + length - 1 + 16 <= to; i += 16) {
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + length - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last))));
+        while (mask != 0) {
+            int bit = lowestBit(mask);
+            if (length <= 2 || std::memcmp(data + i + bit + 1, needle.data() + 1, length - 2) == 0) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    std::string_view rest(data + i, static_cast<size_t>(to - i));
+    size_t found = rest.find(needle);
+    return found == std::string_view::npos ? NOT_FOUND : i + found;
+}
+
+uint8_t LogIndex::parseLevel(std::string_view line) {
+    // The word after the timestamp
+    size_t start = line.find(' ');
+    if (start == std::string_view::npos) {
+        return LEVEL_OTHER;
+    }
+    start++;
+    size_t end = line.find(' ', start);
+    uint8_t bit = levelBit(line.substr(start, end == std::string_view::npos ? end : end - start));
+    return bit != 0 ? bit : LEVEL_OTHER;
+}
+
+uint8_t LogIndex::levelBit(std::string_view word) {
+    static const struct {
+        const char* word;
+        uint8_t bit;
+    } LEVELS[] = {
+        {"DEBUG", LEVEL_DEBUG}, {"TRACE", LEVEL_DEBUG},     {"INFO", LEVEL_INFO},
+        {"WARN", LEVEL_WARN},   {"WARNING", LEVEL_WARN},    {"ERROR", LEVEL_ERROR},
+        {"CRITICAL", LEVEL_CRITICAL}, {"FATAL", LEVEL_CRITICAL},
+    };
+    for (const auto& entry : LEVELS) {
+        if (word == entry.word) {
+            return entry.bit;
+        }
+    }
+    return 0;
+}
+
+} // namespace devescape
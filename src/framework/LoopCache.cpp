@@ -0,0 +1,315 @@
+#include "framework/LoopCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace devescape {
+
+namespace {
+
+constexpr char LOOP_MAGIC[8] = {'D', 'E', 'V', 'L', 'O', 'O', 'P', 1};
+
+// Loop files: this header, then `frames` native floats
+struct LoopFileHeader {
+    char magic[8];
+    uint64_t key;  // song and tier the loop was rendered from
+    uint32_t sampleRate;
+    uint32_t reserved;
+    uint64_t frames;
+};
+static_assert(sizeof(LoopFileHeader) == 32, "keeps the samples aligned");
+
+// Length of the seam crossfade, 10ms at 44.1kHz
+constexpr size_t SEAM_FRAMES = 441;
+
+// FNV-1a
+void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+}
+
+uint64_t loopKey(const Song& song, int tier) {
+    uint64_t hash = 14695981039346656037ull;
+    const Song::Tier& settings = song.tiers[tier];
+    hashBytes(hash, &song.rowsPerPattern, sizeof(song.rowsPerPattern));
+    hashBytes(hash, &song.rowsPerBeat, sizeof(song.rowsPerBeat));
+    hashBytes(hash, song.duty, sizeof(song.duty));
+    hashBytes(hash, &settings.bpm, sizeof(settings.bpm));
+    hashBytes(hash, settings.order.data(), settings.order.size());
+    hashBytes(hash, song.cells.data(), song.cells.size() * sizeof(PatternCell));
+    return hash;
+}
+
+} // namespace
+
+LoopCache::LoopCache()
+    : sampleRate_(0) {
+}
+
+LoopCache::~LoopCache() {
+    clear();
+}
+
+void LoopCache::clear() {
+    for (auto& theme : entries_) {
+        for (Entry& entry : theme) {
+#ifndef _WIN32
+            if (entry.mapping) {
+                munmap(entry.mapping, entry.mappedBytes);
+            }
+#endif
+            entry = Entry();
+        }
+    }
+    sampleRate_ = 0;
+}
+
+size_t LoopCache::build(const Song* songs, int sampleRate, const std::string& directory) {
+    clear();
+    sampleRate_ = sampleRate;
+
+    size_t built = 0;
+    std::vector<float> samples;
+    for (int theme = 0; theme < THEME_COUNT; ++theme) {
+        const Song& song = songs[theme];
+        if (!song.isLoaded()) {
+            continue;
+        }
+        for (int tier = 0; tier < Song::TIERS; ++tier) {
+            Entry& entry = entries_[theme][tier];
+            uint64_t key = loopKey(song, tier);
+            std::string path;
+            if (!directory.empty()) {
+                path = directory + "/" + Sequencer::themeName(static_cast<ThemeType>(theme)) +
+                       "-" + std::to_string(tier) + ".loop";
+                if (mapFile(path, key, sampleRate, entry)) {
+                    built++;
+                    continue;
+                }
+            }
+
+            renderLoop(song, tier, sampleRate, samples);
+            if (!path.empty() && writeFile(path, key, sampleRate, samples) &&
+                mapFile(path, key, sampleRate, entry)) {
+                built++;
+                continue;
+            }
+            // No usable directory: keep it in memory
+            entry.memory = samples;
+            entry.loop.samples = entry.memory.data();
+            entry.loop.frames = entry.memory.size();
+            built++;
+        }
+    }
+    return built;
+}
+
+LoopBuffer LoopCache::get(ThemeType theme, int tier) const {
+    int index = static_cast<int>(theme);
+    if (index < 0 || index >= THEME_COUNT || tier < 0 || tier >= Song::TIERS) {
+        return LoopBuffer();
+    }
+    return entries_[index][tier].loop;
+}
+
+size_t LoopCache::getBytes() const {
+    size_t bytes = 0;
+    for (const auto& theme : entries_) {
+        for (const Entry& entry : theme) {
+            bytes += entry.loop.frames * sizeof(float);
+        }
+    }
+    return bytes;
+}
+
+void LoopCache::renderLoop(const Song& song, int tier, int sampleRate, std::vector<float>& out) {
+    const Song::Tier& settings = song.tiers[tier];
+    double samplesPerRow = sampleRate * 60.0 / (static_cast<double>(settings.bpm) * song.rowsPerBeat);
+    double rows = static_cast<double>(settings.order.size()) * song.rowsPerPattern;
+    size_t frames = std::max<size_t>(1, static_cast<size_t>(std::llround(rows * samplesPerRow)));
+    size_t seam = std::min(frames, SEAM_FRAMES);
+
+    SynthEngine synth(sampleRate);
+    synth.setMasterVolume(1.0f);  // players apply the volume
+    Sequencer sequencer;
+    sequencer.setTier(tier);
+    sequencer.play(&song, synth);
+
+    // Render past the end: the song has looped by then, so blending that
+    // into the start makes the wrap continuous
+    out.resize(frames + seam);
+    sequencer.render(synth, out.data(), out.size());
+    for (size_t i = 0; i < seam; ++i) {
+        float weight = (static_cast<float>(i) + 0.5f) / static_cast<float>(seam);
+        out[i] = out[i] * weight + out[frames + i] * (1.0f - weight);
+    }
+    out.resize(frames);
+}
+
+bool LoopCache::mapFile(const std::string& path, uint64_t key, int sampleRate, Entry& entry) {
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(LoopFileHeader))) {
+        close(fd);
+        return false;
+    }
+    size_t bytes = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    LoopFileHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    if (std::memcmp(header.magic, LOOP_MAGIC, sizeof(LOOP_MAGIC)) != 0 || header.key != key ||
+        header.sampleRate != static_cast<uint32_t>(sampleRate) || header.frames == 0 ||
+        sizeof(header) + header.frames * sizeof(float) != bytes) {
+        munmap(mapping, bytes);
+        return false;
+    }
+
+    entry.mapping = mapping;
+    entry.mappedBytes = bytes;
+    entry.loop.samples = reinterpret_cast<const float*>(static_cast<const char*>(mapping) +
+                                                        sizeof(header));
+    entry.loop.frames = static_cast<size_t>(header.frames);
+    return true;
+#else
+    // No mapping here; the file still saves rendering it again
+    std::ifstream file(path, std::ios::binary);
+    LoopFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, LOOP_MAGIC, sizeof(LOOP_MAGIC)) != 0 || header.key != key ||
+        header.sampleRate != static_cast<uint32_t>(sampleRate) || header.frames == 0) {
+        return false;
+    }
+    entry.memory.resize(static_cast<size_t>(header.frames));
+    if (!file.read(reinterpret_cast<char*>(entry.memory.data()),
+                   entry.memory.size() * sizeof(float))) {
+        entry.memory.clear();
+        return false;
+    }
+    entry.loop.samples = entry.memory.data();
+    entry.loop.frames = entry.memory.size();
+    return true;
+#endif
+}
+
+bool LoopCache::writeFile(const std::string& path, uint64_t key, int sampleRate,
+                          const std::vector<float>& samples) {
+    LoopFileHeader header = {};
+    std::memcpy(header.magic, LOOP_MAGIC, sizeof(LOOP_MAGIC));
+    header.key = key;
+    header.sampleRate = static_cast<uint32_t>(sampleRate);
+    header.frames = samples.size();
+
+    // Written aside and renamed, so a mapped file is never rewritten
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+            !file.write(reinterpret_cast<const char*>(samples.data()),
+                        samples.size() * sizeof(float))) {
+            std::cerr << "Failed to write loop cache file " << temp << std::endl;
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+LoopPlayer::LoopPlayer(size_t crossfadeFrames)
+    : crossfadeFrames_(crossfadeFrames > 0 ? crossfadeFrames : 1)
+    , fadeRemaining_(0) {
+}
+
+void LoopPlayer::play(LoopBuffer loop, bool keepPlace) {
+    if (loop.samples == current_.loop.samples) {
+        return;
+    }
+    size_t position = 0;
+    if (keepPlace && current_.loop.isValid() && loop.isValid()) {
+        position = static_cast<size_t>(static_cast<uint64_t>(current_.position) * loop.frames /
+                                       current_.loop.frames);
+    }
+    previous_ = current_;
+    current_.loop = loop;
+    current_.position = position;
+    fadeRemaining_ = crossfadeFrames_;
+}
+
+void LoopPlayer::stop() {
+    play(LoopBuffer());
+}
+
+void LoopPlayer::render(float* buffer, size_t frameCount, float gain) {
+    std::fill(buffer, buffer + frameCount, 0.0f);
+
+    size_t done = 0;
+    if (fadeRemaining_ > 0) {
+        size_t fade = std::min(frameCount, fadeRemaining_);
+        float step = 1.0f / static_cast<float>(crossfadeFrames_);
+        float outgoing = static_cast<float>(fadeRemaining_) * step;
+        if (previous_.loop.isValid()) {
+            addRamp(previous_, buffer, fade, gain * outgoing, -gain * step);
+        }
+        if (current_.loop.isValid()) {
+            addRamp(current_, buffer, fade, gain * (1.0f - outgoing), gain * step);
+        }
+        fadeRemaining_ -= fade;
+        if (fadeRemaining_ == 0) {
+            previous_ = Cursor();
+        }
+        done = fade;
+    }
+
+    if (current_.loop.isValid() && done < frameCount) {
+        addRamp(current_, buffer + done, frameCount - done, gain, 0.0f);
+    }
+}
+
+void LoopPlayer::addRamp(Cursor& cursor, float* out, size_t frameCount, float gain, float step) {
+    size_t done = 0;
+    while (done < frameCount) {
+        size_t chunk = std::min(frameCount - done, cursor.loop.frames - cursor.position);
+        const float* source = cursor.loop.samples + cursor.position;
+        float* target = out + done;
+
+        if (step == 0.0f) {
+            for (size_t i = 0; i < chunk; ++i) {
+                target[i] += source[i] * gain;
+            }
+        } else {
+            for (size_t i = 0; i < chunk; ++i) {
+                target[i] += source[i] * (gain + step * static_cast<float>(i));
+            }
+            gain += step * static_cast<float>(chunk);
+        }
+
+        done += chunk;
+        cursor.position += chunk;
+        if (cursor.position == cursor.loop.frames) {
+            cursor.position = 0;
+        }
+    }
+}
+
+} // namespace devescape
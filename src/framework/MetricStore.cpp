@@ -0,0 +1,427 @@
+#include "framework/MetricStore.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+namespace devescape {
+
+namespace {
+
+uint64_t lowBits(int count) {
+    return count >= 64 ? ~0ull : (1ull << count) - 1;
+}
+
+int leadingZeros(uint64_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, bits);
+    return 63 - static_cast<int>(index);
+#else
+    return __builtin_clzll(bits);
+#endif
+}
+
+int trailingZeros(uint64_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+uint64_t toBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double fromBits(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int64_t signExtend(uint64_t value, int count) {
+    uint64_t sign = 1ull << (count - 1);
+    return static_cast<int64_t>((value ^ sign) - sign);
+}
+
+// Reads what BitStream::write wrote, most significant bit first
+class BitReader {
+public:
+    explicit BitReader(const uint64_t* words) : words_(words), position_(0) {}
+
+    // 1 to 64 bits
+    uint64_t read(int count) {
+        const uint64_t* word = words_ + position_ / 64;
+        int used = static_cast<int>(position_ % 64);
+        position_ += static_cast<uint64_t>(count);
+        if (used + count <= 64) {
+            return (word[0] << used) >> (64 - count);
+        }
+        int spill = used + count - 64;  // bits from the next word
+        return (word[0] & lowBits(64 - used)) << spill | word[1] >> (64 - spill);
+    }
+
+private:
+    const uint64_t* words_;
+    uint64_t position_;
+};
+
+// Delta-of-delta codes: 0 for none, then 7, 9 and 12 bit ranges, then raw
+int64_t readDelta(BitReader& reader) {
+    if (!reader.read(1)) {
+        return 0;
+    }
+    if (!reader.read(1)) {
+        return signExtend(reader.read(7), 7);
+    }
+    if (!reader.read(1)) {
+        return signExtend(reader.read(9), 9);
+    }
+    if (!reader.read(1)) {
+        return signExtend(reader.read(12), 12);
+    }
+    return static_cast<int64_t>(reader.read(64));
+}
+
+} // namespace
+
+void MetricSummary::add(int64_t time, double value) {
+    if (count == 0) {
+        min = value;
+        max = value;
+    } else {
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+    ++count;
+    sum += value;
+    last = value;
+    lastTime = time;
+}
+
+void MetricSummary::merge(const MetricSummary& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    count += other.count;
+    sum += other.sum;
+    last = other.last;
+    lastTime = other.lastTime;
+}
+
+void MetricStore::BitStream::write(uint64_t value, int count) {
+    value &= lowBits(count);
+    while (count > 0) {
+        int used = static_cast<int>(bits % 64);
+        if (used == 0) {
+            words.push_back(0);
+        }
+        int take = std::min(64 - used, count);
+        uint64_t part = (value >> (count - take)) & lowBits(take);
+        words.back() |= part << (64 - used - take);
+        bits += take;
+        count -= take;
+    }
+}
+
+MetricStore::MetricStore() {
+    nodes_.emplace_back();
+}
+
+MetricStore::SeriesId MetricStore::addSeries(std::string_view path) {
+    NodeId node = ROOT;
+    bool named = false;
+    while (!path.empty()) {
+        size_t slash = path.find('/');
+        std::string_view part = path.substr(0, slash);
+        path = slash == std::string_view::npos ? std::string_view() : path.substr(slash + 1);
+        if (part.empty()) {
+            continue;
+        }
+        if (nodes_[node].series != NONE) {
+            return NONE;
+        }
+        NodeId next = child(node, part);
+        if (next == NONE) {
+            next = static_cast<NodeId>(nodes_.size());
+            nodes_.emplace_back();
+            nodes_.back().name = std::string(part);
+            nodes_.back().parent = node;
+            nodes_[node].children.push_back(next);
+        }
+        node = next;
+        named = true;
+    }
+    if (!named) {
+        return NONE;
+    }
+    Node& leaf = nodes_[node];
+    if (leaf.series == NONE) {
+        if (!leaf.children.empty()) {
+            return NONE;
+        }
+        leaf.series = static_cast<SeriesId>(series_.size());
+        series_.emplace_back();
+    }
+    return leaf.series;
+}
+
+MetricStore::NodeId MetricStore::findNode(std::string_view path) const {
+    NodeId node = ROOT;
+    while (!path.empty() && node != NONE) {
+        size_t slash = path.find('/');
+        std::string_view part = path.substr(0, slash);
+        path = slash == std::string_view::npos ? std::string_view() : path.substr(slash + 1);
+        if (!part.empty()) {
+            node = child(node, part);
+        }
+    }
+    return node;
+}
+
+MetricStore::NodeId MetricStore::child(NodeId node, std::string_view name) const {
+    for (NodeId candidate : nodes_[node].children) {
+        if (nodes_[candidate].name == name) {
+            return candidate;
+        }
+    }
+    return NONE;
+}
+
+std::string MetricStore::path(NodeId node) const {
+    std::vector<NodeId> chain;
+    for (; node != ROOT && node != NONE; node = nodes_[node].parent) {
+        chain.push_back(node);
+    }
+    std::string result;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (!result.empty()) {
+            result += '/';
+        }
+        result += nodes_[*it].name;
+    }
+    return result;
+}
+
+bool MetricStore::append(SeriesId id, int64_t time, double value) {
+    if (id >= series_.size()) {
+        return false;
+    }
+    Series& series = series_[id];
+    uint64_t bits = toBits(value);
+
+    if (series.chunks.empty() || series.chunks.back().summary.count == CHUNK_SAMPLES) {
+        if (!series.chunks.empty()) {
+            Chunk& full = series.chunks.back();
+            if (time <= full.summary.lastTime) {
+                return false;
+            }
+            full.times.words.shrink_to_fit();
+            full.values.words.shrink_to_fit();
+        }
+        series.chunks.emplace_back();
+        Chunk& chunk = series.chunks.back();
+        chunk.start = time;
+        chunk.times.write(static_cast<uint64_t>(time), 64);
+        chunk.values.write(bits, 64);
+        chunk.summary.add(time, value);
+        series.lastDelta = 0;
+        series.lastBits = bits;
+        series.leading = -1;
+        return true;
+    }
+
+    Chunk& chunk = series.chunks.back();
+    if (time <= chunk.summary.lastTime) {
+        return false;
+    }
+
+    int64_t delta = time - chunk.summary.lastTime;
+    int64_t deltaOfDelta = delta - series.lastDelta;
+    series.lastDelta = delta;
+    BitStream& times = chunk.times;
+    if (deltaOfDelta == 0) {
+        times.write(0, 1);
+    } else if (deltaOfDelta >= -64 && deltaOfDelta < 64) {
+        times.write(0b10, 2);
+        times.write(static_cast<uint64_t>(deltaOfDelta), 7);
+    } else if (deltaOfDelta >= -256 && deltaOfDelta < 256) {
+        times.write(0b110, 3);
+        times.write(static_cast<uint64_t>(deltaOfDelta), 9);
+    } else if (deltaOfDelta >= -2048 && deltaOfDelta < 2048) {
+        times.write(0b1110, 4);
+        times.write(static_cast<uint64_t>(deltaOfDelta), 12);
+    } else {
+        times.write(0b1111, 4);
+        times.write(static_cast<uint64_t>(deltaOfDelta), 64);
+    }
+
+    // Unchanged: one bit. Changed bits inside the last window: the window.
+    // Otherwise a new window: 5 bits of leading zeros, 6 of length.
+    uint64_t difference = bits ^ series.lastBits;
+    series.lastBits = bits;
+    BitStream& values = chunk.values;
+    if (difference == 0) {
+        values.write(0, 1);
+    } else {
+        int leading = std::min(leadingZeros(difference), 31);
+        int trailing = trailingZeros(difference);
+        if (series.leading >= 0 && leading >= series.leading && trailing >= series.trailing) {
+            values.write(0b10, 2);
+            values.write(difference >> series.trailing, 64 - series.leading - series.trailing);
+        } else {
+            int meaningful = 64 - leading - trailing;
+            values.write(0b11, 2);
+            values.write(static_cast<uint64_t>(leading), 5);
+            values.write(static_cast<uint64_t>(meaningful & 63), 6);  // 64 as 0
+            values.write(difference >> trailing, meaningful);
+            series.leading = leading;
+            series.trailing = trailing;
+        }
+    }
+    chunk.summary.add(time, value);
+    return true;
+}
+
+template <typename Visit>
+void MetricStore::decode(const Chunk& chunk, Visit visit) {
+    if (chunk.summary.count == 0) {
+        return;
+    }
+    BitReader times(chunk.times.words.data());
+    BitReader values(chunk.values.words.data());
+    int64_t time = static_cast<int64_t>(times.read(64));
+    uint64_t bits = values.read(64);
+    visit(time, fromBits(bits));
+
+    int64_t delta = 0;
+    int leading = 0;
+    int trailing = 0;
+    for (uint64_t i = 1; i < chunk.summary.count; ++i) {
+        delta += readDelta(times);
+        time += delta;
+        if (values.read(1)) {
+            if (values.read(1)) {
+                leading = static_cast<int>(values.read(5));
+                int meaningful = static_cast<int>(values.read(6));
+                trailing = 64 - leading - (meaningful == 0 ? 64 : meaningful);
+            }
+            bits ^= values.read(64 - leading - trailing) << trailing;
+        }
+        visit(time, fromBits(bits));
+    }
+}
+
+size_t MetricStore::firstChunk(const Series& series, int64_t from) const {
+    auto after = std::upper_bound(series.chunks.begin(), series.chunks.end(), from,
+                                  [](int64_t time, const Chunk& chunk) { return time < chunk.start; });
+    return after == series.chunks.begin() ? 0 : static_cast<size_t>(after - series.chunks.begin()) - 1;
+}
+
+void MetricStore::range(SeriesId id, int64_t from, int64_t to,
+                        std::vector<MetricSample>& out) const {
+    if (id >= series_.size()) {
+        return;
+    }
+    const Series& series = series_[id];
+    for (size_t i = firstChunk(series, from); i < series.chunks.size() && series.chunks[i].start < to; ++i) {
+        decode(series.chunks[i], [&](int64_t time, double value) {
+            if (time >= from && time < to) {
+                out.push_back(MetricSample{time, value});
+            }
+        });
+    }
+}
+
+MetricSummary MetricStore::rollup(SeriesId id, int64_t from, int64_t to) const {
+    MetricSummary result;
+    if (id >= series_.size()) {
+        return result;
+    }
+    const Series& series = series_[id];
+    for (size_t i = firstChunk(series, from); i < series.chunks.size() && series.chunks[i].start < to; ++i) {
+        const Chunk& chunk = series.chunks[i];
+        if (chunk.start >= from && chunk.summary.lastTime < to) {
+            result.merge(chunk.summary);
+            continue;
+        }
+        decode(chunk, [&](int64_t time, double value) {
+            if (time >= from && time < to) {
+                result.add(time, value);
+            }
+        });
+    }
+    return result;
+}
+
+void MetricStore::downsample(SeriesId id, int64_t from, int64_t to, size_t buckets,
+                             MetricSummary* out) const {
+    std::fill(out, out + buckets, MetricSummary());
+    if (id >= series_.size() || buckets == 0 || to <= from) {
+        return;
+    }
+    const Series& series = series_[id];
+    int64_t span = to - from;
+    int64_t count = static_cast<int64_t>(buckets);
+    auto bucketOf = [&](int64_t time) {
+        return static_cast<size_t>((time - from) * count / span);
+    };
+    for (size_t i = firstChunk(series, from); i < series.chunks.size() && series.chunks[i].start < to; ++i) {
+        const Chunk& chunk = series.chunks[i];
+        if (chunk.start >= from && chunk.summary.lastTime < to
+            && bucketOf(chunk.start) == bucketOf(chunk.summary.lastTime)) {
+            out[bucketOf(chunk.start)].merge(chunk.summary);
+            continue;
+        }
+        decode(chunk, [&](int64_t time, double value) {
+            if (time >= from && time < to) {
+                out[bucketOf(time)].add(time, value);
+            }
+        });
+    }
+}
+
+MetricSummary MetricStore::summary(SeriesId id) const {
+    MetricSummary result;
+    if (id < series_.size()) {
+        for (const Chunk& chunk : series_[id].chunks) {
+            result.merge(chunk.summary);
+        }
+    }
+    return result;
+}
+
+uint64_t MetricStore::getSampleCount() const {
+    uint64_t count = 0;
+    for (const Series& series : series_) {
+        for (const Chunk& chunk : series.chunks) {
+            count += chunk.summary.count;
+        }
+    }
+    return count;
+}
+
+size_t MetricStore::getBytes() const {
+    size_t bytes = 0;
+    for (const Series& series : series_) {
+        for (const Chunk& chunk : series.chunks) {
+            bytes += (chunk.times.words.capacity() + chunk.values.words.capacity()) * sizeof(uint64_t);
+        }
+    }
+    return bytes;
+}
+
+} // namespace devescape
@@ -0,0 +1,178 @@
+#include "framework/NoteStream.h"
+#include <algorithm>
+#include <cstring>
+
+namespace devescape {
+
+namespace {
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+// False when the buffer ends first
+bool getVarint(const std::string& in, size_t& offset, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (offset >= in.size()) {
+            return false;
+        }
+        uint8_t byte = static_cast<uint8_t>(in[offset++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+void NoteEvent::setName(const std::string& text) {
+    size_t length = std::min(text.size(), NAME_SIZE - 1);
+    std::memcpy(name, text.data(), length);
+    name[length] = '\0';
+}
+
+NoteStreamWriter::NoteStreamWriter()
+    : lastFrame_(0) {
+}
+
+void NoteStreamWriter::write(const NoteEvent& event) {
+    // Events are in order; anything stamped earlier goes out as "now"
+    uint64_t frame = std::max(event.frame, lastFrame_);
+    putVarint(buffer_, frame - lastFrame_);
+    lastFrame_ = frame;
+    buffer_ += static_cast<char>(static_cast<uint8_t>(event.type) << 4 | (event.voice & 0x0F));
+
+    switch (event.type) {
+        case NoteEventType::START:
+        case NoteEventType::TEMPO:
+            putVarint(buffer_, event.value);
+            break;
+        case NoteEventType::THEME:
+        case NoteEventType::DUTY:
+        case NoteEventType::MASTER_VOLUME:
+            buffer_ += static_cast<char>(std::min<uint32_t>(event.value, 255));
+            break;
+        case NoteEventType::NOTE_ON:
+            buffer_ += static_cast<char>(event.note);
+            buffer_ += static_cast<char>(event.volume);
+            break;
+        case NoteEventType::VOLUME:
+            buffer_ += static_cast<char>(event.volume);
+            break;
+        case NoteEventType::EFFECT: {
+            size_t length = strnlen(event.name, NoteEvent::NAME_SIZE);
+            buffer_ += static_cast<char>(length);
+            buffer_.append(event.name, length);
+            break;
+        }
+        case NoteEventType::NOTE_OFF:
+        case NoteEventType::STOP:
+            break;
+    }
+}
+
+NoteStreamReader::NoteStreamReader()
+    : offset_(0)
+    , lastFrame_(0)
+    , failed_(false) {
+}
+
+void NoteStreamReader::feed(const char* data, size_t size) {
+    // Drop what has been consumed before growing the buffer
+    if (offset_ > 0) {
+        buffer_.erase(0, offset_);
+        offset_ = 0;
+    }
+    buffer_.append(data, size);
+}
+
+bool NoteStreamReader::next(NoteEvent& event) {
+    if (failed_) {
+        return false;
+    }
+
+    size_t offset = offset_;
+    uint64_t delta = 0;
+    if (!getVarint(buffer_, offset, delta) || offset >= buffer_.size()) {
+        return false;
+    }
+    uint8_t header = static_cast<uint8_t>(buffer_[offset++]);
+    if ((header >> 4) > static_cast<uint8_t>(NoteEventType::STOP)) {
+        failed_ = true;
+        return false;
+    }
+
+    NoteEvent decoded;
+    decoded.type = static_cast<NoteEventType>(header >> 4);
+    decoded.voice = header & 0x0F;
+
+    auto byte = [&](uint8_t& out) {
+        if (offset >= buffer_.size()) {
+            return false;
+        }
+        out = static_cast<uint8_t>(buffer_[offset++]);
+        return true;
+    };
+
+    uint8_t small = 0;
+    uint64_t value = 0;
+    switch (decoded.type) {
+        case NoteEventType::START:
+        case NoteEventType::TEMPO:
+            if (!getVarint(buffer_, offset, value)) {
+                return false;
+            }
+            decoded.value = static_cast<uint32_t>(value);
+            break;
+        case NoteEventType::THEME:
+        case NoteEventType::DUTY:
+        case NoteEventType::MASTER_VOLUME:
+            if (!byte(small)) {
+                return false;
+            }
+            decoded.value = small;
+            break;
+        case NoteEventType::NOTE_ON:
+            if (!byte(decoded.note) || !byte(decoded.volume)) {
+                return false;
+            }
+            break;
+        case NoteEventType::VOLUME:
+            if (!byte(decoded.volume)) {
+                return false;
+            }
+            break;
+        case NoteEventType::EFFECT:
+            if (!byte(small)) {
+                return false;
+            }
+            if (small >= NoteEvent::NAME_SIZE) {
+                failed_ = true;
+                return false;
+            }
+            if (buffer_.size() - offset < small) {
+                return false;
+            }
+            std::memcpy(decoded.name, buffer_.data() + offset, small);
+            offset += small;
+            break;
+        case NoteEventType::NOTE_OFF:
+        case NoteEventType::STOP:
+            break;
+    }
+
+    lastFrame_ += delta;
+    decoded.frame = lastFrame_;
+    offset_ = offset;
+    event = decoded;
+    return true;
+}
+
+} // namespace devescape
@@ -0,0 +1,120 @@
+#include "framework/NoteStreamPlayer.h"
+#include "framework/Sequencer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace devescape {
+
+NoteStreamPlayer::NoteStreamPlayer(int sampleRate)
+    : synth_(sampleRate)
+    , sfx_(sampleRate)
+    , sampleRate_(sampleRate)
+    , position_(0)
+    , delay_(0)
+    , senderRate_(sampleRate)
+    , anchorSender_(0)
+    , anchorClient_(0.0)
+    , started_(false)
+    , hasPending_(false)
+    , theme_(ThemeType::AMBIENT)
+    , bpm_(0.0f) {
+}
+
+bool NoteStreamPlayer::loadEffects(const std::string& path) {
+    return sfx_.loadEffects(path);
+}
+
+void NoteStreamPlayer::feed(const char* data, size_t size) {
+    reader_.feed(data, size);
+}
+
+double NoteStreamPlayer::clientFrame(uint64_t senderFrame) const {
+    // Frames before the anchor (a stream joined late) come out negative and
+    // so apply at once
+    double senderOffset = static_cast<double>(senderFrame) - static_cast<double>(anchorSender_);
+    return anchorClient_ + senderOffset * sampleRate_ / senderRate_;
+}
+
+void NoteStreamPlayer::render(float* buffer, size_t frameCount) {
+    size_t done = 0;
+    while (done < frameCount) {
+        // Apply everything due by this sample, then render up to the next
+        size_t chunk = frameCount - done;
+        while (hasPending_ || reader_.next(pending_)) {
+            hasPending_ = true;
+            if (!started_ && pending_.type != NoteEventType::START) {
+                // Joined mid-stream: this event's sample is "now"
+                started_ = true;
+                anchorSender_ = pending_.frame;
+                anchorClient_ = static_cast<double>(position_ + done + delay_);
+            }
+            double due = std::ceil(clientFrame(pending_.frame));
+            double now = static_cast<double>(position_ + done);
+            if (due > now) {
+                chunk = std::min(chunk, static_cast<size_t>(due - now));
+                break;
+            }
+            apply(pending_);
+            hasPending_ = false;
+        }
+
+        synth_.render(buffer + done, chunk);
+        sfx_.mix(buffer + done, chunk);
+        done += chunk;
+    }
+    position_ += frameCount;
+}
+
+void NoteStreamPlayer::apply(const NoteEvent& event) {
+    int voice = event.voice % SynthEngine::VOICE_COUNT;
+    SynthVoice& target = synth_.voice(voice);
+
+    switch (event.type) {
+        case NoteEventType::START:
+            // Later STARTs (the sender reopened its output) keep the place
+            anchorClient_ = started_ ? clientFrame(event.frame)
+                                     : static_cast<double>(position_ + delay_);
+            anchorSender_ = event.frame;
+            senderRate_ = event.value > 0 ? static_cast<int>(event.value) : sampleRate_;
+            started_ = true;
+            break;
+        case NoteEventType::THEME:
+            theme_ = static_cast<ThemeType>(event.value);
+            break;
+        case NoteEventType::TEMPO:
+            bpm_ = event.value / 10.0f;
+            break;
+        case NoteEventType::NOTE_ON: {
+            float frequency = Sequencer::noteFrequency(event.note);
+            target.frequency = voice == 3 ? frequency * Sequencer::NOISE_CLOCK_RATIO : frequency;
+            target.enabled = true;
+            if (event.volume != PatternCell::VOLUME_KEEP) {
+                target.volume = Sequencer::voiceGain(voice) * event.volume / 15.0f;
+            }
+            break;
+        }
+        case NoteEventType::NOTE_OFF:
+            target.enabled = false;
+            break;
+        case NoteEventType::VOLUME:
+            target.volume = Sequencer::voiceGain(voice) * event.volume / 15.0f;
+            break;
+        case NoteEventType::DUTY:
+            target.duty = event.value / 256.0f;
+            break;
+        case NoteEventType::EFFECT:
+            sfx_.trigger(sfx_.findEffect(event.name));
+            break;
+        case NoteEventType::MASTER_VOLUME:
+            synth_.setMasterVolume(event.value / 255.0f);
+            break;
+        case NoteEventType::STOP:
+            for (int i = 0; i < SynthEngine::VOICE_COUNT; ++i) {
+                synth_.voice(i).enabled = false;
+            }
+            bpm_ = 0.0f;
+            break;
+    }
+}
+
+} // namespace devescape
@@ -1,31 +1,122 @@
 #include "framework/PluginManager.h"
+#include "framework/SandboxedRoom.h"
+#include "framework/RoomV1Adapter.h"
 #include <iostream>
 #include <filesystem>
+#include <future>
 
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <dlfcn.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
 #endif
 
 namespace fs = std::filesystem;
 
 namespace devescape {
 
-PluginManager::PluginManager(const std::string& pluginDirectory)
-    : pluginDirectory_(pluginDirectory) {
+namespace {
+
+// Pooled rooms only hold their own game state
+constexpr size_t ROOM_ARENA_BYTES = 16 * 1024;
+
+typedef bool (*ResetRoomFunc)(IEscapeRoom*);
+typedef bool (*PublishCommandsFunc)(IEscapeRoom*, CommandTrie*);
+
+bool sameServices(const FrameworkContext& a, const FrameworkContext& b) {
+    return a.audioManager == b.audioManager && a.stateManager == b.stateManager &&
+           a.dataDirectory == b.dataDirectory && a.checkpointDirectory == b.checkpointDirectory;
+}
+
+} // namespace
+
+PluginManager::PluginManager(const std::string& pluginDirectory, const std::string& manifestFile)
+    : pluginDirectory_(pluginDirectory)
+    , manifestCache_(manifestFile.empty() ? pluginDirectory + "/plugin_manifest.json" : manifestFile)
+    , inotifyFd_(-1)
+    , nextGeneration_(1)
+    , sandboxEnabled_(false)
+    , roomPoolSize_(4) {
     fs::create_directories(pluginDirectory);
 }
 
 PluginManager::~PluginManager() {
+    for (auto& [path, pending] : pendingReloads_) {
+        if (auto library = pending.library.get()) {
+            closeLibrary(library->handle);
+            std::error_code ec;
+            fs::remove(library->loadedPath, ec);
+        }
+    }
+    pendingReloads_.clear();
+
+    // Idle pooled rooms go while their builds are still current
+    std::vector<LibraryGeneration*> pooled;
+    for (const auto& library : libraries_) {
+        if (!library->idleRooms.empty()) {
+            pooled.push_back(library.get());
+        }
+    }
+    for (LibraryGeneration* library : pooled) {
+        drainPool(library);
+    }
+
     for (auto& plugin : plugins_) {
-        unloadPlugin(plugin);
+        plugin.handle = nullptr;
     }
+    while (!libraries_.empty()) {
+        releaseGeneration(libraries_.back().get());
+    }
+
+#ifdef __linux__
+    if (inotifyFd_ >= 0) {
+        close(inotifyFd_);
+    }
+#endif
+}
+
+void PluginManager::addStaticPlugin(const StaticPluginEntry& entry) {
+    for (const StaticPluginEntry* existing : staticPlugins_) {
+        if (existing == &entry) {
+            return;
+        }
+    }
+    staticPlugins_.push_back(&entry);
 }
 
 void PluginManager::scanForPlugins() {
+    for (auto& plugin : plugins_) {
+        unloadPlugin(plugin);
+    }
     plugins_.clear();
 
+    for (const StaticPluginEntry* entry : staticPlugins_) {
+        PluginInfo info;
+        info.name = entry->name;
+        info.path = std::string("static:") + entry->name;
+        info.version = std::to_string(pluginRoomVersion(entry->getPluginVersion()));
+        info.abiVersion = pluginAbiVersion(entry->getPluginVersion());
+        info.author = "Unknown";
+        info.description = "Escape room plugin (built in)";
+        info.staticEntry = entry;
+        plugins_.push_back(info);
+        std::cout << "Found plugin: " << info.name << " (built in)" << std::endl;
+    }
+
+    manifestCache_.load();
+
+    struct Candidate {
+        std::string path;
+        uint64_t fileSize;
+        int64_t modifiedTime;
+        std::string buildId;
+    };
+    std::vector<Candidate> candidates;
+
     try {
         for (const auto& entry : fs::directory_iterator(pluginDirectory_)) {
             if (entry.is_regular_file()) {
@@ -36,24 +127,91 @@ void PluginManager::scanForPlugins() {
 #else
                 if (ext == ".so") {
 #endif
-                    PluginInfo info;
-                    if (loadPlugin(entry.path().string(), info)) {
-                        plugins_.push_back(info);
-                        std::cout << "Loaded plugin: " << info.name << std::endl;
-                    }
+                    Candidate candidate;
+                    candidate.path = entry.path().string();
+                    candidate.fileSize = entry.file_size();
+                    candidate.modifiedTime = entry.last_write_time().time_since_epoch().count();
+                    candidate.buildId = PluginManifestCache::readBuildId(candidate.path);
+                    candidates.push_back(std::move(candidate));
                 }
             }
         }
     } catch (const fs::filesystem_error& e) {
         std::cerr << "Error scanning plugins: " << e.what() << std::endl;
     }
+
+    // Resolve from the cache first; anything new or changed is probed in parallel
+    std::vector<PluginManifestEntry> entries(candidates.size());
+    std::vector<std::future<bool>> probes(candidates.size());
+    std::vector<std::string> paths;
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const Candidate& candidate = candidates[i];
+        paths.push_back(candidate.path);
+
+        const PluginManifestEntry* cached = manifestCache_.lookup(
+            candidate.path, candidate.fileSize, candidate.modifiedTime, candidate.buildId);
+        if (cached) {
+            entries[i] = *cached;
+            continue;
+        }
+
+        entries[i].path = candidate.path;
+        entries[i].fileSize = candidate.fileSize;
+        entries[i].modifiedTime = candidate.modifiedTime;
+        entries[i].buildId = candidate.buildId;
+        probes[i] = std::async(std::launch::async, [this, &entries, i]() {
+            return probePlugin(entries[i].path, entries[i]);
+        });
+    }
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (probes[i].valid()) {
+            if (!probes[i].get()) {
+                continue;
+            }
+            manifestCache_.store(entries[i]);
+        }
+
+        // A built-in copy of the same room takes precedence
+        bool shadowed = false;
+        for (const StaticPluginEntry* entry : staticPlugins_) {
+            shadowed = shadowed || entries[i].name == entry->name;
+        }
+        if (shadowed) {
+            std::cout << "Skipping plugin " << entries[i].name << " (built in): " << entries[i].path
+                      << std::endl;
+            continue;
+        }
+        if (pluginAbiVersion(entries[i].version) == PLUGIN_ABI_NONE) {
+            std::cerr << "Skipping plugin " << entries[i].name << ": it reports no plugin ABI"
+                      << " and must be rebuilt against this framework (" << entries[i].path << ")"
+                      << std::endl;
+            continue;
+        }
+
+        PluginInfo info;
+        info.name = entries[i].name;
+        info.path = entries[i].path;
+        info.version = std::to_string(pluginRoomVersion(entries[i].version));
+        info.abiVersion = pluginAbiVersion(entries[i].version);
+        info.author = "Unknown";
+        info.description = "Escape room plugin";
+        plugins_.push_back(info);
+        std::cout << "Found plugin: " << info.name << std::endl;
+    }
+
+    manifestCache_.retainOnly(paths);
+    if (manifestCache_.isDirty() && !manifestCache_.save()) {
+        std::cerr << "Failed to write plugin manifest cache" << std::endl;
+    }
 }
 
 std::vector<PluginInfo> PluginManager::getAvailablePlugins() const {
     return plugins_;
 }
 
-bool PluginManager::loadPlugin(const std::string& path, PluginInfo& info) {
+bool PluginManager::probePlugin(const std::string& path, PluginManifestEntry& entry) {
     void* handle = loadLibrary(path);
     if (!handle) {
         std::cerr << "Failed to load plugin: " << path << std::endl;
@@ -67,46 +225,218 @@ bool PluginManager::loadPlugin(const std::string& path, PluginInfo& info) {
     auto getName = reinterpret_cast<GetNameFunc>(getFunction(handle, "getPluginName"));
     auto getVersion = reinterpret_cast<GetVersionFunc>(getFunction(handle, "getPluginVersion"));
 
-    if (!getName || !getVersion) {
+    bool valid = getName && getVersion;
+    if (valid) {
+        entry.name = getName();
+        entry.version = getVersion();
+    } else {
         std::cerr << "Plugin missing required exports: " << path << std::endl;
-#ifdef _WIN32
-        FreeLibrary(static_cast<HMODULE>(handle));
-#else
-        dlclose(handle);
-#endif
-        return false;
     }
 
-    info.name = getName();
-    info.path = path;
-    info.version = std::to_string(getVersion());
-    info.handle = handle;
-    info.author = "Unknown";
-    info.description = "Escape room plugin";
+    // Discovery only needs the metadata; the library is opened again on selection
+    closeLibrary(handle);
+    return valid;
+}
+
+bool PluginManager::loadPlugin(PluginInfo& info) {
+    if (info.staticEntry) {
+        if (!currentGeneration(info.name)) {
+            auto library = std::make_unique<LibraryGeneration>();
+            library->pluginName = info.name;
+            library->loadedPath = info.path;
+            library->staticEntry = info.staticEntry;
+            library->generation = nextGeneration_++;
+            libraries_.push_back(std::move(library));
+        }
+        return true;
+    }
+
+    if (info.handle) {
+        return true;
+    }
+
+    // With hot reload on, even the first build runs from a copy so that a
+    // rebuild overwriting the file in place cannot corrupt mapped code
+    std::unique_ptr<LibraryGeneration> library;
+    if (inotifyFd_ >= 0) {
+        library = loadShadowCopy(info.path, nextGeneration_++);
+    } else if (void* handle = loadLibrary(info.path)) {
+        library = std::make_unique<LibraryGeneration>();
+        library->pluginName = info.name;
+        library->loadedPath = info.path;
+        library->handle = handle;
+        library->generation = nextGeneration_++;
+    }
 
+    if (!library) {
+        std::cerr << "Failed to load plugin: " << info.path << std::endl;
+        return false;
+    }
+
+    library->pluginName = info.name;
+    info.handle = library->handle;
+    libraries_.push_back(std::move(library));
     return true;
 }
 
 void PluginManager::unloadPlugin(PluginInfo& info) {
-    if (info.handle) {
-#ifdef _WIN32
-        FreeLibrary(static_cast<HMODULE>(info.handle));
-#else
-        dlclose(info.handle);
-#endif
-        info.handle = nullptr;
+    // Builds with live rooms stay resident until those rooms are destroyed
+    LibraryGeneration* library = currentGeneration(info.name);
+    if (library) {
+        drainPool(library);
+    }
+    info.handle = nullptr;
+    if (library && library->liveRooms == 0) {
+        releaseGeneration(library);
     }
 }
 
-IEscapeRoom* PluginManager::loadRoom(const std::string& pluginName) {
+PluginManager::LibraryGeneration* PluginManager::currentGeneration(const std::string& pluginName) const {
     for (const auto& plugin : plugins_) {
-        if (plugin.name == pluginName) {
-            typedef IEscapeRoom* (*CreateRoomFunc)();
-            auto createRoom = reinterpret_cast<CreateRoomFunc>(getFunction(plugin.handle, "createRoom"));
+        if (plugin.name == pluginName && plugin.staticEntry) {
+            for (const auto& library : libraries_) {
+                if (library->staticEntry == plugin.staticEntry) {
+                    return library.get();
+                }
+            }
+        } else if (plugin.name == pluginName && plugin.handle) {
+            for (const auto& library : libraries_) {
+                if (library->handle == plugin.handle) {
+                    return library.get();
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+void PluginManager::releaseGeneration(LibraryGeneration* library) {
+    if (library->handle) {
+        closeLibrary(library->handle);
+    }
+
+    // Reloaded builds run from a private copy; remove it with the handle
+    if (library->shadowCopy) {
+        std::error_code ec;
+        fs::remove(library->loadedPath, ec);
+    }
 
-            if (createRoom) {
-                return createRoom();
+    for (auto it = libraries_.begin(); it != libraries_.end(); ++it) {
+        if (it->get() == library) {
+            libraries_.erase(it);
+            break;
+        }
+    }
+}
+
+uint32_t PluginManager::abiVersionOf(const LibraryGeneration* library) {
+    typedef uint32_t (*GetVersionFunc)();
+    GetVersionFunc getVersion = library->staticEntry
+                                    ? library->staticEntry->getPluginVersion
+                                    : reinterpret_cast<GetVersionFunc>(
+                                          getFunction(library->handle, "getPluginVersion"));
+    return getVersion ? pluginAbiVersion(getVersion()) : PLUGIN_ABI_NONE;
+}
+
+IEscapeRoomV2* PluginManager::createFrom(LibraryGeneration* library) {
+    SandboxedRoom::CreateRoomFunc createRoom = nullptr;
+    SandboxedRoom::DestroyRoomFunc destroyRoom = nullptr;
+    if (library->staticEntry) {
+        createRoom = library->staticEntry->createRoom;
+        destroyRoom = library->staticEntry->destroyRoom;
+    } else {
+        createRoom = reinterpret_cast<SandboxedRoom::CreateRoomFunc>(
+            getFunction(library->handle, "createRoom"));
+        destroyRoom = reinterpret_cast<SandboxedRoom::DestroyRoomFunc>(
+            getFunction(library->handle, "destroyRoom"));
+    }
+    if (!createRoom || !destroyRoom) {
+        return nullptr;
+    }
+
+    uint32_t abiVersion = abiVersionOf(library);
+    if (abiVersion == PLUGIN_ABI_NONE) {
+        std::cerr << "Plugin " << library->pluginName << " reports no plugin ABI; it predates the"
+                  << " session arena's data types and must be rebuilt against this framework"
+                  << std::endl;
+        return nullptr;
+    }
+    if (abiVersion > PLUGIN_ABI_CURRENT) {
+        std::cerr << "Plugin " << library->pluginName << " needs plugin ABI v" << abiVersion
+                  << "; this framework supports up to v" << PLUGIN_ABI_CURRENT << std::endl;
+        return nullptr;
+    }
+
+    // The sandbox helper loads the plugin from its library, which a
+    // linked-in plugin does not have
+    bool sandboxed = sandboxEnabled_ && !library->staticEntry;
+    if (sandboxEnabled_ && library->staticEntry) {
+        std::cerr << "Plugin " << library->pluginName
+                  << " is linked into the executable; running it outside the sandbox" << std::endl;
+    }
+
+    IEscapeRoomV2* room = nullptr;
+    if (sandboxed) {
+        room = new SandboxedRoom(library->loadedPath, abiVersion);
+        sandboxedRooms_.insert(room);
+    } else if (IEscapeRoom* created = createRoom()) {
+        // v2 plugins hand back an IEscapeRoomV2 through the v1 entry point
+        if (abiVersion >= PLUGIN_ABI_V2) {
+            room = static_cast<IEscapeRoomV2*>(created);
+        } else {
+            room = new RoomV1Adapter(created);
+            adaptedRooms_[room] = created;
+        }
+    }
+
+    if (room) {
+        library->liveRooms++;
+        roomOwners_[room] = library;
+    }
+    return room;
+}
+
+void PluginManager::destroyFrom(LibraryGeneration* library, IEscapeRoom* room) {
+    auto adapted = adaptedRooms_.find(room);
+    if (sandboxedRooms_.erase(room)) {
+        // The proxy is ours; the plugin's instance dies with the child
+        delete room;
+    } else {
+        IEscapeRoom* pluginRoom = room;
+        if (adapted != adaptedRooms_.end()) {
+            pluginRoom = adapted->second;
+            adaptedRooms_.erase(adapted);
+            delete room;
+        }
+
+        auto destroyRoom = library->staticEntry
+                               ? library->staticEntry->destroyRoom
+                               : reinterpret_cast<SandboxedRoom::DestroyRoomFunc>(
+                                     getFunction(library->handle, "destroyRoom"));
+        if (destroyRoom) {
+            destroyRoom(pluginRoom);
+        }
+    }
+
+    // The room's own arena (pooled rooms) outlives the room
+    releasedRooms_.erase(room);
+    roomArenas_.erase(room);
+    roomOwners_.erase(room);
+    failedMigrations_.erase(room);
+    library->liveRooms--;
+
+    if (library->liveRooms == 0 && library != currentGeneration(library->pluginName)) {
+        releaseGeneration(library);
+    }
+}
+
+PluginManager::LibraryGeneration* PluginManager::resolvePlugin(const std::string& pluginName) {
+    for (auto& plugin : plugins_) {
+        if (plugin.name == pluginName) {
+            if (!loadPlugin(plugin)) {
+                return nullptr;
             }
+            return currentGeneration(pluginName);
         }
     }
 
@@ -114,18 +444,426 @@ IEscapeRoom* PluginManager::loadRoom(const std::string& pluginName) {
     return nullptr;
 }
 
+IEscapeRoomV2* PluginManager::loadRoom(const std::string& pluginName) {
+    LibraryGeneration* library = resolvePlugin(pluginName);
+    return library ? createFrom(library) : nullptr;
+}
+
 void PluginManager::unloadRoom(IEscapeRoom* room, const std::string& pluginName) {
-    for (const auto& plugin : plugins_) {
-        if (plugin.name == pluginName) {
-            typedef void (*DestroyRoomFunc)(IEscapeRoom*);
-            auto destroyRoom = reinterpret_cast<DestroyRoomFunc>(getFunction(plugin.handle, "destroyRoom"));
+    if (!room) {
+        return;
+    }
+
+    // Rooms remember the build they came from, which after a hot reload
+    // may no longer be the plugin's current one
+    auto owner = roomOwners_.find(room);
+    if (owner != roomOwners_.end()) {
+        destroyFrom(owner->second, room);
+        return;
+    }
+
+    std::cerr << "Room was not created by plugin: " << pluginName << std::endl;
+}
+
+void PluginManager::setRoomPoolSize(size_t roomsPerPlugin) {
+    roomPoolSize_ = roomsPerPlugin;
+    for (const auto& library : libraries_) {
+        while (library->idleRooms.size() > roomPoolSize_) {
+            IEscapeRoomV2* room = library->idleRooms.back();
+            library->idleRooms.pop_back();
+            room->cleanup();
+            destroyFrom(library.get(), room);
+        }
+    }
+}
+
+size_t PluginManager::prewarmRooms(const std::string& pluginName, const FrameworkContext& context,
+                                   size_t count) {
+    LibraryGeneration* library = resolvePlugin(pluginName);
+    if (!library) {
+        return 0;
+    }
+    if (!sameServices(library->poolContext, context)) {
+        drainPool(library);
+        library->poolContext = context;
+    }
 
-            if (destroyRoom && room) {
-                destroyRoom(room);
+    size_t warmed = 0;
+    while (warmed < count && library->idleRooms.size() < roomPoolSize_) {
+        // Fresh rooms are pristine whether or not they can be reset later
+        IEscapeRoomV2* room = createPooled(library, context);
+        if (!room) {
+            break;
+        }
+        library->idleRooms.push_back(room);
+        ++warmed;
+    }
+    return warmed;
+}
+
+IEscapeRoomV2* PluginManager::acquireRoom(const std::string& pluginName, const FrameworkContext& context) {
+    LibraryGeneration* library = resolvePlugin(pluginName);
+    if (!library) {
+        return nullptr;
+    }
+
+    // Idle rooms hold on to the services they were initialized with
+    if (!sameServices(library->poolContext, context)) {
+        drainPool(library);
+        library->poolContext = context;
+    }
+
+    while (!library->idleRooms.empty()) {
+        IEscapeRoomV2* room = library->idleRooms.back();
+        library->idleRooms.pop_back();
+        if (!releasedRooms_.erase(room) || resetRoom(library, room)) {
+            return room;
+        }
+        room->cleanup();
+        destroyFrom(library, room);
+    }
+    return createPooled(library, context);
+}
+
+void PluginManager::releaseRoom(IEscapeRoomV2* room) {
+    auto owner = roomOwners_.find(room);
+    if (owner == roomOwners_.end()) {
+        std::cerr << "Room was not created by the plugin manager" << std::endl;
+        return;
+    }
+    LibraryGeneration* library = owner->second;
+
+    // Rooms from loadRoom() live in the caller's arena, and stale builds
+    // are on their way out; neither is kept. The reset waits for the next
+    // acquireRoom(), off the end of this session.
+    bool poolable = roomArenas_.count(room) && library == currentGeneration(library->pluginName) &&
+                    library->idleRooms.size() < roomPoolSize_ && canReset(library, room);
+    if (poolable) {
+        library->idleRooms.push_back(room);
+        releasedRooms_.insert(room);
+        return;
+    }
+
+    room->cleanup();
+    destroyFrom(library, room);
+}
+
+IEscapeRoomV2* PluginManager::createPooled(LibraryGeneration* library, const FrameworkContext& context) {
+    IEscapeRoomV2* room = createFrom(library);
+    if (!room) {
+        return nullptr;
+    }
+
+    auto arena = std::make_unique<SessionArena>(ROOM_ARENA_BYTES);
+    FrameworkContext roomContext = context;
+    roomContext.memoryResource = arena->resource();
+    roomArenas_[room] = std::move(arena);
+
+    room->initialize(roomContext);
+    if (library->pristineState.empty() && (room->getCapabilities() & ROOM_CAP_SNAPSHOTS)) {
+        library->pristineState = room->serializeState();
+    }
+    return room;
+}
+
+bool PluginManager::resetRoom(LibraryGeneration* library, IEscapeRoomV2* room) {
+    // In-process rooms may reset themselves; sandbox proxies and rooms
+    // without the export fall back to the post-initialize snapshot
+    if (!sandboxedRooms_.count(room)) {
+        IEscapeRoom* pluginRoom = room;
+        auto adapted = adaptedRooms_.find(room);
+        if (adapted != adaptedRooms_.end()) {
+            pluginRoom = adapted->second;
+        }
+
+        ResetRoomFunc reset = library->staticEntry
+                                  ? library->staticEntry->resetRoom
+                                  : reinterpret_cast<ResetRoomFunc>(getFunction(library->handle, "resetRoom"));
+        if (reset && reset(pluginRoom)) {
+            return true;
+        }
+    }
+
+    return (room->getCapabilities() & ROOM_CAP_SNAPSHOTS) && !library->pristineState.empty() &&
+           room->deserializeState(library->pristineState);
+}
+
+bool PluginManager::canReset(LibraryGeneration* library, IEscapeRoomV2* room) {
+    if (!sandboxedRooms_.count(room) &&
+        (library->staticEntry ? library->staticEntry->resetRoom != nullptr
+                              : getFunction(library->handle, "resetRoom") != nullptr)) {
+        return true;
+    }
+    return (room->getCapabilities() & ROOM_CAP_SNAPSHOTS) && !library->pristineState.empty();
+}
+
+bool PluginManager::publishCommands(IEscapeRoomV2* room, CommandTrie& trie) {
+    auto owner = roomOwners_.find(room);
+    if (owner == roomOwners_.end() || sandboxedRooms_.count(room)) {
+        return false;
+    }
+    LibraryGeneration* library = owner->second;
+
+    IEscapeRoom* pluginRoom = room;
+    auto adapted = adaptedRooms_.find(room);
+    if (adapted != adaptedRooms_.end()) {
+        pluginRoom = adapted->second;
+    }
+
+    PublishCommandsFunc publish =
+        library->staticEntry
+            ? library->staticEntry->publishCommands
+            : reinterpret_cast<PublishCommandsFunc>(getFunction(library->handle, "publishCommands"));
+    return publish && publish(pluginRoom, &trie);
+}
+
+void PluginManager::drainPool(LibraryGeneration* library) {
+    // The last destroyFrom() may release a stale build, so work on a copy
+    std::vector<IEscapeRoomV2*> idle;
+    idle.swap(library->idleRooms);
+    for (IEscapeRoomV2* room : idle) {
+        room->cleanup();
+        destroyFrom(library, room);
+    }
+}
+
+bool PluginManager::setSandboxEnabled(bool enabled) {
+    if (enabled && !SandboxedRoom::isSupported()) {
+        std::cerr << "Room sandbox is not supported on this platform" << std::endl;
+        return false;
+    }
+    sandboxEnabled_ = enabled;
+    return true;
+}
+
+bool PluginManager::enableHotReload() {
+#ifdef __linux__
+    if (inotifyFd_ >= 0) {
+        return true;
+    }
+
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0) {
+        std::cerr << "Hot reload unavailable: inotify_init1 failed" << std::endl;
+        return false;
+    }
+
+    // IN_CLOSE_WRITE covers in-place rebuilds, IN_MOVED_TO atomic installs
+    if (inotify_add_watch(inotifyFd_, pluginDirectory_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cerr << "Hot reload unavailable: cannot watch " << pluginDirectory_ << std::endl;
+        close(inotifyFd_);
+        inotifyFd_ = -1;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PluginManager::pollPluginChanges() {
+#ifdef __linux__
+    if (inotifyFd_ < 0) {
+        return;
+    }
+
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(inotifyFd_, buffer, sizeof(buffer))) > 0) {
+        for (char* ptr = buffer; ptr < buffer + length;) {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->len == 0) {
+                continue;
             }
-            return;
+
+            fs::path changed = fs::path(pluginDirectory_) / event->name;
+            if (changed.extension() != ".so") {
+                continue;
+            }
+            startReload(changed.string());
         }
     }
+#endif
+
+    for (auto it = pendingReloads_.begin(); it != pendingReloads_.end();) {
+        auto& pending = it->second;
+        if (pending.library.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+
+        std::unique_ptr<LibraryGeneration> library = pending.library.get();
+        if (library) {
+            installGeneration(std::move(library));
+        } else {
+            std::cerr << "Hot reload failed to load: " << it->first << std::endl;
+        }
+
+        std::string path = it->first;
+        bool changedAgain = pending.changedAgain;
+        it = pendingReloads_.erase(it);
+        if (changedAgain) {
+            startReload(path);
+        }
+    }
+}
+
+void PluginManager::startReload(const std::string& path) {
+    // Only plugins already in use need a new build loaded; the rest are
+    // picked up from disk when first selected
+    bool inUse = false;
+    for (const auto& plugin : plugins_) {
+        if (fs::path(plugin.path).filename() == fs::path(path).filename() && plugin.handle) {
+            inUse = true;
+        }
+    }
+    if (!inUse) {
+        return;
+    }
+
+    auto pending = pendingReloads_.find(path);
+    if (pending != pendingReloads_.end()) {
+        pending->second.changedAgain = true;
+        return;
+    }
+
+    int generation = nextGeneration_++;
+    pendingReloads_[path].library = std::async(std::launch::async, [this, path, generation]() {
+        return loadShadowCopy(path, generation);
+    });
+}
+
+std::unique_ptr<PluginManager::LibraryGeneration> PluginManager::loadShadowCopy(const std::string& path,
+                                                                                int generation) {
+    // The loader returns the already-open handle for a path it has seen, so
+    // each build is opened from its own copy
+    fs::path source(path);
+    fs::path shadowDir = fs::path(pluginDirectory_) / ".hot";
+    fs::path shadow = shadowDir / (source.stem().string() + "." + std::to_string(generation) +
+                                   source.extension().string());
+
+    std::error_code ec;
+    fs::create_directories(shadowDir, ec);
+    fs::copy_file(source, shadow, fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+        return nullptr;
+    }
+
+    void* handle = loadLibrary(shadow.string());
+    if (!handle) {
+        fs::remove(shadow, ec);
+        return nullptr;
+    }
+
+    typedef const char* (*GetNameFunc)();
+    auto getName = reinterpret_cast<GetNameFunc>(getFunction(handle, "getPluginName"));
+    if (!getName || !getFunction(handle, "createRoom") || !getFunction(handle, "destroyRoom")) {
+        closeLibrary(handle);
+        fs::remove(shadow, ec);
+        return nullptr;
+    }
+
+    auto library = std::make_unique<LibraryGeneration>();
+    library->pluginName = getName();
+    library->loadedPath = shadow.string();
+    library->shadowCopy = true;
+    library->handle = handle;
+    library->generation = generation;
+    return library;
+}
+
+void PluginManager::installGeneration(std::unique_ptr<LibraryGeneration> library) {
+    PluginInfo* plugin = nullptr;
+    for (auto& candidate : plugins_) {
+        if (candidate.name == library->pluginName) {
+            plugin = &candidate;
+        }
+    }
+
+    if (!plugin) {
+        std::cerr << "Hot reload ignored unknown plugin: " << library->pluginName << std::endl;
+        libraries_.push_back(std::move(library));
+        releaseGeneration(libraries_.back().get());
+        return;
+    }
+
+    LibraryGeneration* previous = currentGeneration(plugin->name);
+    plugin->handle = library->handle;
+    std::cout << "Reloaded plugin: " << plugin->name << " (build " << library->generation << ")"
+              << std::endl;
+    libraries_.push_back(std::move(library));
+
+    // Idle pooled rooms belong to the old build; draining releases it
+    // once its last room is gone
+    if (previous && !previous->idleRooms.empty()) {
+        drainPool(previous);
+    } else if (previous && previous->liveRooms == 0) {
+        releaseGeneration(previous);
+    }
+}
+
+bool PluginManager::hasNewerBuild(IEscapeRoom* room) const {
+    auto owner = roomOwners_.find(room);
+    if (owner == roomOwners_.end()) {
+        return false;
+    }
+
+    LibraryGeneration* current = currentGeneration(owner->second->pluginName);
+    if (!current || current == owner->second) {
+        return false;
+    }
+
+    auto failed = failedMigrations_.find(room);
+    return failed == failedMigrations_.end() || failed->second != current->generation;
+}
+
+IEscapeRoomV2* PluginManager::migrateRoom(IEscapeRoomV2* room, const FrameworkContext& context) {
+    if (!hasNewerBuild(room)) {
+        return room;
+    }
+
+    LibraryGeneration* owner = roomOwners_[room];
+    LibraryGeneration* current = currentGeneration(owner->pluginName);
+
+    std::string state = room->serializeState();
+
+    IEscapeRoomV2* replacement = createFrom(current);
+    if (!replacement) {
+        failedMigrations_[room] = current->generation;
+        return room;
+    }
+
+    // A pooled room's successor gets an arena of its own as well
+    FrameworkContext replacementContext = context;
+    if (roomArenas_.count(room)) {
+        auto arena = std::make_unique<SessionArena>(ROOM_ARENA_BYTES);
+        replacementContext.memoryResource = arena->resource();
+        roomArenas_[replacement] = std::move(arena);
+    }
+
+    replacement->initialize(replacementContext);
+    if (!replacement->deserializeState(state)) {
+        std::cerr << "Hot reload: new build rejected state, keeping old build of "
+                  << owner->pluginName << std::endl;
+        replacement->cleanup();
+        destroyFrom(current, replacement);
+        failedMigrations_[room] = current->generation;
+        return room;
+    }
+
+    room->cleanup();
+    destroyFrom(owner, room);
+    return replacement;
+}
+
+void PluginManager::closeLibrary(void* handle) {
+#ifdef _WIN32
+    FreeLibrary(static_cast<HMODULE>(handle));
+#else
+    dlclose(handle);
+#endif
 }
 
 #ifdef _WIN32
@@ -0,0 +1,195 @@
+#include "framework/PluginManifest.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__linux__)
+#include <elf.h>
+#endif
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace devescape {
+
+namespace {
+
+constexpr int MANIFEST_FORMAT_VERSION = 1;
+
+#if defined(__linux__)
+template <typename Ehdr, typename Phdr, typename Nhdr>
+std::string findBuildId(std::ifstream& file) {
+    Ehdr header;
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return "";
+    if (header.e_phentsize != sizeof(Phdr)) return "";
+
+    for (int i = 0; i < header.e_phnum; ++i) {
+        Phdr segment;
+        file.seekg(header.e_phoff + static_cast<std::streamoff>(i) * sizeof(Phdr));
+        if (!file.read(reinterpret_cast<char*>(&segment), sizeof(segment))) return "";
+        if (segment.p_type != PT_NOTE || segment.p_filesz > 64 * 1024) continue;
+
+        std::vector<char> notes(segment.p_filesz);
+        file.seekg(segment.p_offset);
+        if (!file.read(notes.data(), notes.size())) return "";
+
+        size_t offset = 0;
+        while (offset + sizeof(Nhdr) <= notes.size()) {
+            Nhdr note;
+            std::memcpy(&note, notes.data() + offset, sizeof(note));
+            offset += sizeof(note);
+
+            size_t nameSize = (note.n_namesz + 3) & ~size_t(3);
+            size_t descSize = (note.n_descsz + 3) & ~size_t(3);
+            if (offset + nameSize + descSize > notes.size()) break;
+
+            const char* name = notes.data() + offset;
+            const auto* desc = reinterpret_cast<const unsigned char*>(name + nameSize);
+            if (note.n_type == NT_GNU_BUILD_ID && note.n_namesz == 4 &&
+                std::memcmp(name, "GNU", 4) == 0) {
+                static const char HEX[] = "0123456789abcdef";
+                std::string id;
+                id.reserve(note.n_descsz * 2);
+                for (size_t b = 0; b < note.n_descsz; ++b) {
+                    id += HEX[desc[b] >> 4];
+                    id += HEX[desc[b] & 0xF];
+                }
+                return id;
+            }
+            offset += nameSize + descSize;
+        }
+    }
+    return "";
+}
+#endif
+
+} // namespace
+
+PluginManifestCache::PluginManifestCache(const std::string& cacheFile)
+    : cacheFile_(cacheFile)
+    , dirty_(false) {
+}
+
+bool PluginManifestCache::load() {
+    entries_.clear();
+    dirty_ = false;
+
+    std::ifstream file(cacheFile_);
+    if (!file.is_open()) return false;
+
+    try {
+        json j = json::parse(file);
+        if (j.value("format", 0) != MANIFEST_FORMAT_VERSION) {
+            return false;
+        }
+
+        for (const auto& item : j["plugins"]) {
+            PluginManifestEntry entry;
+            entry.path = item["path"];
+            entry.fileSize = item["size"];
+            entry.modifiedTime = item["mtime"];
+            entry.buildId = item["build_id"];
+            entry.name = item["name"];
+            entry.version = item["version"];
+            entries_.push_back(std::move(entry));
+        }
+        return true;
+    } catch (const std::exception&) {
+        entries_.clear();
+        return false;
+    }
+}
+
+bool PluginManifestCache::save() {
+    json plugins = json::array();
+    for (const auto& entry : entries_) {
+        plugins.push_back({
+            {"path", entry.path},
+            {"size", entry.fileSize},
+            {"mtime", entry.modifiedTime},
+            {"build_id", entry.buildId},
+            {"name", entry.name},
+            {"version", entry.version}
+        });
+    }
+
+    json j;
+    j["format"] = MANIFEST_FORMAT_VERSION;
+    j["plugins"] = plugins;
+
+    // Write then rename so a crash never leaves a truncated manifest behind
+    std::string tempFile = cacheFile_ + ".tmp";
+    {
+        std::ofstream file(tempFile);
+        if (!file.is_open()) return false;
+        file << j.dump(2);
+        if (!file) return false;
+    }
+
+    std::error_code ec;
+    fs::rename(tempFile, cacheFile_, ec);
+    if (ec) return false;
+
+    dirty_ = false;
+    return true;
+}
+
+const PluginManifestEntry* PluginManifestCache::lookup(const std::string& path, uint64_t fileSize,
+                                                       int64_t modifiedTime,
+                                                       const std::string& buildId) const {
+    for (const auto& entry : entries_) {
+        if (entry.path == path && entry.fileSize == fileSize &&
+            entry.modifiedTime == modifiedTime && entry.buildId == buildId) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void PluginManifestCache::store(const PluginManifestEntry& entry) {
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [&](const PluginManifestEntry& e) { return e.path == entry.path; });
+    if (it != entries_.end()) {
+        *it = entry;
+    } else {
+        entries_.push_back(entry);
+    }
+    dirty_ = true;
+}
+
+void PluginManifestCache::retainOnly(const std::vector<std::string>& paths) {
+    auto end = std::remove_if(entries_.begin(), entries_.end(), [&](const PluginManifestEntry& e) {
+        return std::find(paths.begin(), paths.end(), e.path) == paths.end();
+    });
+    if (end != entries_.end()) {
+        entries_.erase(end, entries_.end());
+        dirty_ = true;
+    }
+}
+
+std::string PluginManifestCache::readBuildId(const std::string& path) {
+#if defined(__linux__)
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return "";
+
+    unsigned char ident[EI_NIDENT];
+    if (!file.read(reinterpret_cast<char*>(ident), sizeof(ident))) return "";
+    if (std::memcmp(ident, ELFMAG, SELFMAG) != 0) return "";
+
+    if (ident[EI_CLASS] == ELFCLASS64) {
+        return findBuildId<Elf64_Ehdr, Elf64_Phdr, Elf64_Nhdr>(file);
+    }
+    if (ident[EI_CLASS] == ELFCLASS32) {
+        return findBuildId<Elf32_Ehdr, Elf32_Phdr, Elf32_Nhdr>(file);
+    }
+    return "";
+#else
+    (void)path;
+    return "";
+#endif
+}
+
+} // namespace devescape
@@ -0,0 +1,652 @@
+#include "framework/RoomEngine.h"
+#include "framework/AudioManager.h"
+#include "framework/CommandTrie.h"
+#include "framework/Sequencer.h"
+#include "framework/TerminalRenderer.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using json = nlohmann::json;
+
+namespace devescape {
+
+namespace {
+
+// Switched to virtual before the phase timers take their epoch from it, so
+// whole seconds of update() land on their tick grid
+ClockSource& stopped(ClockSource& clock) {
+    clock.setVirtual();
+    return clock;
+}
+
+} // namespace
+
+RoomEngine::RoomEngine(const std::string& definitionFile)
+    : definitionFile_(definitionFile)
+    , definitionPath_(definitionFile)
+    , loaded_(false)
+    , phase_(0)
+    , hintLevel_(0)
+    , timeInPhase_(0.0f)
+    , redrawPending_(true)
+    , phaseTimers_(std::chrono::milliseconds(10), stopped(phaseClock_))
+    , phaseSeconds_(0.0f)
+    , unlockedHints_(0) {
+    gameState_.emplace();
+}
+
+RoomEngine::~RoomEngine() = default;
+
+void RoomEngine::addExtension(std::string_view name, RoomExtension* extension) {
+    addedExtensions_.emplace_back(std::string(name), extension);
+}
+
+void RoomEngine::load(const std::string& dataDirectory) {
+    std::string path = (dataDirectory.empty() ? "./data" : dataDirectory) + "/" + definitionFile_;
+    if (loaded_ && path == definitionPath_) {
+        return;  // a pooled room initialized again
+    }
+    definitionPath_ = path;
+    program_ = RoomProgram();
+    loaded_ = RoomProgram::load(definitionPath_, program_);
+
+    extensions_.assign(program_.extensions.size(), nullptr);
+    for (const auto& [name, extension] : addedExtensions_) {
+        bool used = false;
+        for (size_t index = 0; index < program_.extensions.size(); ++index) {
+            if (program_.text(program_.extensions[index]) == name) {
+                extensions_[index] = extension;
+                used = true;
+            }
+        }
+        if (loaded_ && !used) {
+            std::cerr << definitionPath_ << ": the room adds extension '" << name
+                      << "' but the definition never uses it" << std::endl;
+        }
+    }
+    for (size_t index = 0; index < extensions_.size(); ++index) {
+        if (!extensions_[index]) {
+            std::cerr << definitionPath_ << ": extension '"
+                      << program_.text(program_.extensions[index])
+                      << "' is used but the room did not add it" << std::endl;
+        }
+    }
+}
+
+std::string RoomEngine::getName() const {
+    return loaded_ ? std::string(program_.text(program_.name)) : definitionPath_;
+}
+
+std::string RoomEngine::getVersion() const {
+    return std::string(program_.text(program_.version));
+}
+
+std::string RoomEngine::getAuthor() const {
+    return std::string(program_.text(program_.author));
+}
+
+std::string RoomEngine::getDescription() const {
+    return std::string(program_.text(program_.description));
+}
+
+void RoomEngine::initialize(const FrameworkContext& context) {
+    context_ = context;
+    gameState_.emplace(context_.memoryResource);
+    load(context_.dataDirectory);
+    if (loaded_) {
+        setupPuzzles();
+        startSession();
+    }
+}
+
+void RoomEngine::setupPuzzles() {
+    uint32_t firstPuzzle = program_.phases[0].puzzle;
+    puzzles_.clear();
+    for (uint32_t index = 0; index < program_.puzzles.size(); ++index) {
+        const RoomProgram::Puzzle& puzzle = program_.puzzles[index];
+        std::string_view id = program_.text(puzzle.id);
+        std::string_view title = program_.text(puzzle.title);
+
+        PuzzleState state(context_.memoryResource);
+        state.id.assign(id.data(), id.size());
+        state.title.assign(title.data(), title.size());
+        state.locked = index != firstPuzzle;
+        // Map nodes never move, so the pointers hold for the session
+        PuzzleState& slot = gameState_->puzzles[state.id];
+        slot = state;
+        puzzles_.push_back(&slot);
+    }
+}
+
+void RoomEngine::reset() {
+    phase_ = 0;
+    hintLevel_ = 0;
+    timeInPhase_ = 0.0f;
+    phaseSeconds_ = 0.0f;
+
+    for (uint32_t index = 0; index < puzzles_.size(); ++index) {
+        PuzzleState& puzzle = *puzzles_[index];
+        puzzle.solved = false;
+        puzzle.locked = index != program_.phases[0].puzzle;
+        puzzle.completionPercent = 0;
+        puzzle.hintsUsed = 0;
+        puzzle.wrongAttempts = 0;
+        puzzle.timeSpentSeconds = 0;
+        puzzle.playerAnswer.clear();
+    }
+    gameState_->inventory.clear();
+    gameState_->discoveredClues.clear();
+    gameState_->eventLog.clear();
+    gameState_->completedPuzzleCount = 0;
+    for (RoomExtension* extension : extensions_) {
+        if (extension) {
+            extension->reset();
+        }
+    }
+
+    if (loaded_) {
+        startSession();
+    }
+}
+
+void RoomEngine::startSession() {
+    redrawPending_ = true;
+    scheduleHintUnlocks();
+    ProcessResult ignored(context_.memoryResource);
+    run(RoomProgram::VERB_START, CommandMatch(), ignored);
+    playPhaseMusic();
+}
+
+void RoomEngine::publishCommands(CommandTrie& commands) const {
+    for (StringPool::Id completion : program_.completions) {
+        commands.insert(program_.text(completion));
+    }
+}
+
+bool RoomEngine::isCompleted() const {
+    return loaded_ && program_.phases[phase_].final;
+}
+
+int RoomEngine::getCompletionPercentage() const {
+    if (puzzles_.empty()) {
+        return 0;
+    }
+    int completed = 0;
+    for (const PuzzleState* puzzle : puzzles_) {
+        completed += puzzle->solved ? 1 : 0;
+    }
+    return completed * 100 / static_cast<int>(puzzles_.size());
+}
+
+size_t RoomEngine::processInputs(Span<const std::string> commands,
+                                 std::pmr::vector<ProcessResult>& results) {
+    size_t handled = 0;
+    for (const std::string& command : commands) {
+        results.push_back(processInput(command));
+        ++handled;
+        if (results.back().sessionEnded) {
+            break;
+        }
+    }
+    return handled;
+}
+
+ProcessResult RoomEngine::processInput(const std::string& command) {
+    ProcessResult result(context_.memoryResource);
+    redrawPending_ = true;
+    if (!loaded_) {
+        result.outputText = "This room's definition (" + definitionPath_ + ") did not load.";
+        result.sessionEnded = true;
+        return result;
+    }
+
+    CommandMatch match;
+    int verb = program_.grammar.match(command, match);
+    if (verb == CommandGrammar::NO_MATCH) {
+        verb = static_cast<int>(RoomProgram::VERB_OTHER);
+    }
+    if (!run(static_cast<uint32_t>(verb), match, result)) {
+        prompt(result);
+    }
+    return result;
+}
+
+bool RoomEngine::run(uint32_t verb, const CommandMatch& match, ProcessResult& result) {
+    // The phase's own rules, then those for every phase
+    RoomProgram::RuleRange ranges[] = {program_.phaseRules(phase_, verb),
+                                       program_.globalRules(verb)};
+    for (const RoomProgram::RuleRange& range : ranges) {
+        for (uint32_t i = range.first; i < range.first + range.count; ++i) {
+            const RoomProgram::Rule& rule = program_.rules[i];
+            if (passes(rule, match)) {
+                execute(rule, match, result);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool RoomEngine::passes(const RoomProgram::Rule& rule, const CommandMatch& match) const {
+    switch (rule.test) {
+        case RoomProgram::Test::ALWAYS:
+            return true;
+        case RoomProgram::Test::CONTAINS:
+            for (uint32_t i = 0; i < rule.wordCount; ++i) {
+                std::string_view word = program_.text(program_.words[rule.firstWord + i]);
+                if (match.rest.find(word) == std::string_view::npos) {
+                    return false;
+                }
+            }
+            return true;
+        case RoomProgram::Test::NUMBER:
+            return match.argumentCount > 0 && match.number(0) >= rule.low &&
+                   match.number(0) <= rule.high;
+        case RoomProgram::Test::NO_NUMBER:
+            return match.argumentCount == 0;
+    }
+    return false;
+}
+
+void RoomEngine::execute(const RoomProgram::Rule& rule, const CommandMatch& match,
+                         ProcessResult& result) {
+    PuzzleState* puzzle = phasePuzzle();
+
+    for (uint32_t i = rule.firstAction; i < rule.firstAction + rule.actionCount; ++i) {
+        const RoomProgram::Action& action = program_.actions[i];
+        switch (action.op) {
+            case RoomProgram::Op::SAY:
+                if (!result.outputText.empty()) {
+                    result.outputText += '\n';
+                }
+                result.outputText += expand(action.operand, match);
+                break;
+            case RoomProgram::Op::EVENT:
+                gameState_->addEvent(expand(action.operand, match));
+                break;
+            case RoomProgram::Op::EFFECT:
+                if (context_.audioManager) {
+                    context_.audioManager->playSoundEffect(program_.text(action.operand));
+                }
+                break;
+            case RoomProgram::Op::SOLVE:
+                if (puzzle) {
+                    puzzle->solved = true;
+                }
+                break;
+            case RoomProgram::Op::WRONG:
+                if (puzzle) {
+                    puzzle->wrongAttempts++;
+                }
+                break;
+            case RoomProgram::Op::ANSWER:
+                if (puzzle && match.argumentCount > 0) {
+                    puzzle->playerAnswer.assign(match.text(0).data(), match.text(0).size());
+                }
+                break;
+            case RoomProgram::Op::GOTO:
+                enterPhase(action.operand);
+                puzzle = phasePuzzle();
+                break;
+            case RoomProgram::Op::END:
+                result.sessionEnded = true;
+                result.success = true;
+                break;
+            case RoomProgram::Op::HINT: {
+                if (!result.outputText.empty()) {
+                    result.outputText += '\n';
+                }
+                uint32_t hint = nextHint();
+                uint32_t first = program_.phases[phase_].firstHint;
+                if (hint != RoomProgram::NONE && hint - first >= unlockedHints_) {
+                    int wait = static_cast<int>(
+                        std::ceil(static_cast<float>(program_.hintDelays[hint]) - phaseSeconds_));
+                    result.outputText += "The next hint unlocks in " +
+                                         std::to_string(std::max(wait, 1)) + " s.";
+                    break;
+                }
+                result.outputText += getHint(hintLevel_);
+                hintLevel_++;
+                break;
+            }
+            case RoomProgram::Op::PROMPT:
+                prompt(result);
+                break;
+            case RoomProgram::Op::CALL:
+                if (RoomExtension* extension = extensions_[action.operand]) {
+                    extension->call(program_.text(action.argument), match, result);
+                }
+                break;
+        }
+    }
+}
+
+void RoomEngine::prompt(ProcessResult& result) const {
+    const RoomProgram::Phase& phase = program_.phases[phase_];
+    if (!result.outputText.empty()) {
+        result.outputText += '\n';
+    }
+    std::string_view text = program_.text(phase.prompt);
+    result.outputText.append(text.data(), text.size());
+    if (phase.final) {
+        result.sessionEnded = true;
+        result.success = true;
+    }
+}
+
+void RoomEngine::enterPhase(uint32_t phase) {
+    const RoomProgram::Phase& previous = program_.phases[phase_];
+    phase_ = phase;
+    if (PuzzleState* puzzle = phasePuzzle()) {
+        puzzle->locked = false;
+    }
+
+    const RoomProgram::Phase& next = program_.phases[phase_];
+    if (next.hasMusic && !(previous.hasMusic && previous.music == next.music)) {
+        playPhaseMusic();
+    }
+
+    phaseSeconds_ = 0.0f;
+    scheduleHintUnlocks();
+}
+
+void RoomEngine::scheduleHintUnlocks() {
+    for (TimerService::TimerId id : hintTimers_) {
+        phaseTimers_.cancel(id);
+    }
+    hintTimers_.clear();
+
+    const RoomProgram::Phase& phase = program_.phases[phase_];
+    unlockedHints_ = 0;
+    for (uint32_t index = 0; index < phase.hintCount; ++index) {
+        float due = static_cast<float>(program_.hintDelays[phase.firstHint + index]) - phaseSeconds_;
+        if (due <= 0.0f) {
+            unlockedHints_ = index + 1;
+            continue;
+        }
+        auto delay = std::chrono::duration_cast<TimerService::Clock::duration>(
+            std::chrono::duration<float>(due));
+        hintTimers_.push_back(phaseTimers_.scheduleAfter(delay, [this, index]() {
+            unlockedHints_ = index + 1;
+            gameState_->addEvent("A new hint is available");
+            redrawPending_ = true;
+        }));
+    }
+}
+
+uint32_t RoomEngine::nextHint() const {
+    const RoomProgram::Phase& phase = program_.phases[phase_];
+    if (phase.hintCount == 0) {
+        return RoomProgram::NONE;
+    }
+    // The last hint repeats once the phase runs out
+    uint32_t level = static_cast<uint32_t>(std::max(0, hintLevel_));
+    return phase.firstHint + std::min(level, phase.hintCount - 1);
+}
+
+bool RoomEngine::canUseHint() const {
+    if (!loaded_ || hintLevel_ >= getMaxHintLevel()) {
+        return false;
+    }
+    uint32_t hint = nextHint();
+    return hint == RoomProgram::NONE || hint - program_.phases[phase_].firstHint < unlockedHints_;
+}
+
+void RoomEngine::playPhaseMusic() const {
+    const RoomProgram::Phase& phase = program_.phases[phase_];
+    if (context_.audioManager && phase.hasMusic) {
+        context_.audioManager->playTheme(Sequencer::themeName(phase.music), phase.music);
+    }
+}
+
+PuzzleState* RoomEngine::phasePuzzle() const {
+    uint32_t puzzle = program_.phases[phase_].puzzle;
+    return puzzle < puzzles_.size() ? puzzles_[puzzle] : nullptr;
+}
+
+std::string RoomEngine::expand(StringPool::Id text, const CommandMatch& match) const {
+    std::string_view source = program_.text(text);
+    std::string expanded;
+    expanded.reserve(source.size());
+    for (size_t i = 0; i < source.size(); ++i) {
+        // {0} to {7}: the matched arguments
+        if (source[i] == '{' && i + 2 < source.size() && source[i + 2] == '}' &&
+            source[i + 1] >= '0' && source[i + 1] <= '7') {
+            size_t argument = static_cast<size_t>(source[i + 1] - '0');
+            if (argument < match.argumentCount) {
+                expanded += match.text(argument);
+            }
+            i += 2;
+            continue;
+        }
+        expanded += source[i];
+    }
+    return expanded;
+}
+
+void RoomEngine::render(TerminalRenderer& renderer) const {
+    renderer.clearScreen();
+    if (!loaded_) {
+        renderer.drawText(0, 0, "Room definition " + definitionPath_ + " did not load",
+                          ColorType::ERROR_COLOR, true);
+        return;
+    }
+
+    // Header
+    renderer.drawBox(0, 0, 80, 3, std::string(program_.text(program_.title)));
+    renderer.drawText(5, 1, std::string(program_.text(program_.banner)), program_.bannerColor,
+                      program_.bannerBold);
+
+    // Progress, and a held-back hint once it unlocks
+    renderer.drawProgressBar(5, 4, getCompletionPercentage() / 100.0f, 60, ColorType::ACCENT);
+    renderer.drawText(67, 4, std::to_string(getCompletionPercentage()) + "%", ColorType::STATUS);
+    uint32_t hint = nextHint();
+    if (hint != RoomProgram::NONE && program_.hintDelays[hint] > 0 &&
+        hint - program_.phases[phase_].firstHint < unlockedHints_) {
+        renderer.drawText(73, 4, "[hint]", ColorType::WARNING);
+    }
+
+    // Current phase
+    const RoomProgram::Phase& phase = program_.phases[phase_];
+    renderer.drawBox(0, 6, 80, 15, std::string(program_.text(phase.title)));
+    for (uint32_t i = phase.firstLine; i < phase.firstLine + phase.lineCount; ++i) {
+        const RoomProgram::TextLine& line = program_.lines[i];
+        renderer.drawText(line.x, line.y, std::string(program_.text(line.text)), line.color,
+                          line.bold);
+    }
+    if (phase.pane != RoomProgram::NONE && extensions_[phase.pane]) {
+        extensions_[phase.pane]->render(renderer, phase.paneX, phase.paneY, phase.paneWidth,
+                                        phase.paneHeight);
+    }
+
+    // Command prompt
+    renderer.drawText(0, 22, "> _", ColorType::ACCENT);
+}
+
+void RoomEngine::update(float deltaTimeSeconds) {
+    timeInPhase_ += deltaTimeSeconds;
+    phaseSeconds_ += deltaTimeSeconds;
+    if (PuzzleState* puzzle = phasePuzzle()) {
+        puzzle->timeSpentSeconds = static_cast<int>(timeInPhase_);
+    }
+    if (!hintTimers_.empty()) {
+        phaseClock_.advance(std::chrono::duration_cast<ClockSource::duration>(
+            std::chrono::duration<float>(deltaTimeSeconds)));
+        phaseTimers_.advance();
+    }
+}
+
+UpdateHint RoomEngine::updateFrame(float deltaTimeSeconds) {
+    update(deltaTimeSeconds);
+
+    // The screen only changes on commands and work in the shown pane; time
+    // matters once per whole second, when the puzzle's time-spent counter ticks
+    uint32_t pane = program_.phases[phase_].pane;
+    bool busy = false;
+    for (size_t index = 0; index < extensions_.size(); ++index) {
+        if (RoomExtension* extension = extensions_[index]) {
+            bool changed = extension->update(deltaTimeSeconds);
+            redrawPending_ |= changed && index == pane;
+            busy |= extension->isBusy();
+        }
+    }
+
+    UpdateHint hint;
+    hint.needsRedraw = redrawPending_;
+    hint.nextWakeupSeconds = busy ? 0.0f : 1.0f - std::fmod(timeInPhase_, 1.0f);
+    redrawPending_ = false;
+    return hint;
+}
+
+std::string RoomEngine::serializeState() const {
+    json j;
+    j["phase"] = phase_;
+    j["hint_level"] = hintLevel_;
+    j["time_in_puzzle"] = timeInPhase_;
+    j["time_in_phase"] = phaseSeconds_;
+
+    // Full puzzle and event state so a new build of the plugin can take over
+    // a live session (hot reload) without the player noticing
+    json puzzles = json::object();
+    for (const auto& [id, puzzle] : gameState_->puzzles) {
+        puzzles[std::string(id.data(), id.size())] = {
+            {"solved", puzzle.solved},
+            {"locked", puzzle.locked},
+            {"wrong_attempts", puzzle.wrongAttempts},
+            {"hints_used", puzzle.hintsUsed},
+            {"time_spent_seconds", puzzle.timeSpentSeconds},
+            {"player_answer", std::string(puzzle.playerAnswer.data(), puzzle.playerAnswer.size())}
+        };
+    }
+    j["puzzles"] = puzzles;
+
+    json events = json::array();
+    for (const auto& event : gameState_->eventLog) {
+        events.push_back(std::string(event.data(), event.size()));
+    }
+    j["event_log"] = events;
+
+    json inventory = json::object();
+    for (const auto& [item, value] : gameState_->inventory) {
+        inventory[std::string(item.data(), item.size())] = std::string(value.data(), value.size());
+    }
+    j["inventory"] = inventory;
+    json clues = json::array();
+    for (const auto& clue : gameState_->discoveredClues) {
+        clues.push_back(std::string(clue.data(), clue.size()));
+    }
+    j["discovered_clues"] = clues;
+    j["completed_puzzle_count"] = gameState_->completedPuzzleCount;
+
+    // Native puzzles keep their own state, by the name the definition uses
+    json extensions = json::object();
+    for (size_t index = 0; index < extensions_.size(); ++index) {
+        if (extensions_[index]) {
+            std::string state = extensions_[index]->serializeState();
+            if (!state.empty()) {
+                extensions[std::string(program_.text(program_.extensions[index]))] = state;
+            }
+        }
+    }
+    j["extensions"] = extensions;
+
+    return j.dump();
+}
+
+bool RoomEngine::deserializeState(const std::string& data) {
+    if (!loaded_) {
+        return false;
+    }
+    try {
+        json j = json::parse(data);
+        uint32_t phase = j["phase"].get<uint32_t>();
+        if (phase >= program_.phases.size()) {
+            return false;
+        }
+        phase_ = phase;
+        hintLevel_ = j["hint_level"];
+        timeInPhase_ = j.value("time_in_puzzle", 0.0f);
+        phaseSeconds_ = j.value("time_in_phase", 0.0f);
+        redrawPending_ = true;
+
+        if (j.contains("puzzles")) {
+            for (auto& [id, puzzleJson] : j["puzzles"].items()) {
+                auto it = gameState_->puzzles.find(std::string_view(id));
+                if (it == gameState_->puzzles.end()) continue;
+
+                PuzzleState& puzzle = it->second;
+                puzzle.solved = puzzleJson["solved"];
+                puzzle.locked = puzzleJson["locked"];
+                puzzle.wrongAttempts = puzzleJson["wrong_attempts"];
+                puzzle.hintsUsed = puzzleJson["hints_used"];
+                puzzle.timeSpentSeconds = puzzleJson["time_spent_seconds"];
+                puzzle.playerAnswer = puzzleJson["player_answer"].get_ref<const std::string&>();
+            }
+        }
+
+        if (j.contains("event_log")) {
+            gameState_->eventLog.clear();
+            for (const auto& event : j["event_log"]) {
+                gameState_->eventLog.emplace_back(event.get_ref<const std::string&>());
+            }
+        }
+
+        if (j.contains("inventory")) {
+            gameState_->inventory.clear();
+            for (auto& [item, value] : j["inventory"].items()) {
+                gameState_->inventory.emplace(item, value.get_ref<const std::string&>());
+            }
+        }
+        if (j.contains("discovered_clues")) {
+            gameState_->discoveredClues.clear();
+            for (const auto& clue : j["discovered_clues"]) {
+                gameState_->discoveredClues.emplace_back(clue.get_ref<const std::string&>());
+            }
+        }
+        gameState_->completedPuzzleCount =
+            j.value("completed_puzzle_count", gameState_->completedPuzzleCount);
+
+        if (j.contains("extensions")) {
+            for (size_t index = 0; index < extensions_.size(); ++index) {
+                std::string name(program_.text(program_.extensions[index]));
+                auto it = j["extensions"].find(name);
+                if (extensions_[index] && it != j["extensions"].end() &&
+                    !extensions_[index]->deserializeState(it->get<std::string>())) {
+                    std::cerr << definitionPath_ << ": extension '" << name
+                              << "' cannot restore its state" << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        // initialize() started the first phase's music and hint timers;
+        // match the restored phase
+        scheduleHintUnlocks();
+        playPhaseMusic();
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+std::string RoomEngine::getHint(int hintLevel) {
+    if (!loaded_ || program_.phases[phase_].hintCount == 0) {
+        return "No hints available.";
+    }
+    const RoomProgram::Phase& phase = program_.phases[phase_];
+    // The last hint repeats once the phase runs out
+    uint32_t level = static_cast<uint32_t>(std::max(0, hintLevel));
+    return std::string(program_.text(program_.hints[phase.firstHint +
+                                                    std::min(level, phase.hintCount - 1)]));
+}
+
+void RoomEngine::onSessionTimeout() {
+    if (loaded_) {
+        ProcessResult ignored(context_.memoryResource);
+        run(RoomProgram::VERB_TIMEOUT, CommandMatch(), ignored);
+    }
+}
+
+} // namespace devescape
@@ -0,0 +1,466 @@
+#include "framework/RoomProgram.h"
+#include "framework/Sequencer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace devescape {
+
+namespace {
+
+uint32_t hashText(std::string_view text) {
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (char c : text) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+struct Token {
+    std::string text;
+};
+
+// Words and "quoted strings" (with \n, \" and \\), up to a '#' starting a
+// token. False on an unterminated string.
+bool tokenize(const std::string& line, std::vector<Token>& tokens) {
+    tokens.clear();
+    size_t i = 0;
+    while (i < line.size()) {
+        if (std::isspace(static_cast<unsigned char>(line[i]))) {
+            i++;
+            continue;
+        }
+        if (line[i] == '#') {
+            break;
+        }
+        Token token;
+        if (line[i] == '"') {
+            for (i++; i < line.size() && line[i] != '"'; ++i) {
+                if (line[i] == '\\' && i + 1 < line.size()) {
+                    char escaped = line[++i];
+                    token.text += escaped == 'n' ? '\n' : escaped;
+                } else {
+                    token.text += line[i];
+                }
+            }
+            if (i >= line.size()) {
+                return false;
+            }
+            i++;
+        } else {
+            while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i]))) {
+                token.text += line[i++];
+            }
+        }
+        tokens.push_back(std::move(token));
+    }
+    return true;
+}
+
+bool parseInt(const std::string& text, int64_t& value) {
+    char* end = nullptr;
+    long long parsed = std::strtoll(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0') {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool parseColor(const std::string& name, ColorType& color) {
+    static const struct {
+        const char* name;
+        ColorType color;
+    } COLORS[] = {
+        {"default", ColorType::DEFAULT}, {"accent", ColorType::ACCENT},
+        {"alert", ColorType::ALERT},     {"success", ColorType::SUCCESS},
+        {"warning", ColorType::WARNING}, {"status", ColorType::STATUS},
+        {"error", ColorType::ERROR_COLOR}, {"pending", ColorType::PENDING},
+    };
+    for (const auto& entry : COLORS) {
+        if (name == entry.name) {
+            color = entry.color;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseTheme(const std::string& name, ThemeType& theme) {
+    for (int type = 0; type <= static_cast<int>(ThemeType::FAILURE); ++type) {
+        if (name == Sequencer::themeName(static_cast<ThemeType>(type))) {
+            theme = static_cast<ThemeType>(type);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Action keywords; `hint` and `prompt` with an argument declare phase text
+struct ActionSyntax {
+    const char* keyword;
+    size_t args;
+    RoomProgram::Op op;
+};
+
+const ActionSyntax ACTIONS[] = {
+    {"say", 1, RoomProgram::Op::SAY},       {"event", 1, RoomProgram::Op::EVENT},
+    {"effect", 1, RoomProgram::Op::EFFECT}, {"solve", 0, RoomProgram::Op::SOLVE},
+    {"wrong", 0, RoomProgram::Op::WRONG},   {"answer", 0, RoomProgram::Op::ANSWER},
+    {"goto", 1, RoomProgram::Op::GOTO},     {"end", 0, RoomProgram::Op::END},
+    {"hint", 0, RoomProgram::Op::HINT},     {"prompt", 0, RoomProgram::Op::PROMPT},
+    {"call", 1, RoomProgram::Op::CALL},     {"call", 2, RoomProgram::Op::CALL},
+};
+
+// A rule as parsed, before rules are grouped by (phase, verb)
+struct PendingRule {
+    uint32_t row;   // phase, or the phase count for rules of every phase
+    uint32_t verb;
+    RoomProgram::Rule rule;
+    std::vector<RoomProgram::Action> actions;
+};
+
+} // namespace
+
+StringPool::StringPool() {
+    table_.assign(64, 0);
+    intern("");
+}
+
+StringPool::Id StringPool::intern(std::string_view text) {
+    size_t mask = table_.size() - 1;
+    for (size_t slot = hashText(text) & mask;; slot = (slot + 1) & mask) {
+        if (table_[slot] == 0) {
+            Id id = static_cast<Id>(spans_.size());
+            spans_.push_back({static_cast<uint32_t>(text_.size()),
+                              static_cast<uint32_t>(text.size())});
+            text_.append(text.data(), text.size());
+            table_[slot] = id + 1;
+            if (spans_.size() * 2 > table_.size()) {
+                grow();
+            }
+            return id;
+        }
+        if (get(table_[slot] - 1) == text) {
+            return table_[slot] - 1;
+        }
+    }
+}
+
+void StringPool::grow() {
+    std::vector<Id> table(table_.size() * 2, 0);
+    size_t mask = table.size() - 1;
+    for (Id id = 0; id < spans_.size(); ++id) {
+        size_t slot = hashText(get(id)) & mask;
+        while (table[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        table[slot] = id + 1;
+    }
+    table_ = std::move(table);
+}
+
+bool RoomProgram::load(const std::string& path, RoomProgram& program) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Cannot open room definition " << path << std::endl;
+        return false;
+    }
+
+    RoomProgram loaded;
+    loaded.verbs = {loaded.strings.intern("start"), loaded.strings.intern("timeout"),
+                    loaded.strings.intern("other")};
+    std::vector<bool> verbBound(loaded.verbs.size(), true);
+    std::vector<PendingRule> rules;
+    std::vector<std::pair<uint32_t, Id>> puzzleRefs;  // phase, puzzle id
+    struct GotoRef {
+        size_t rule;
+        size_t action;
+        int line;
+    };
+    std::vector<GotoRef> gotoRefs;
+    bool inRule = false;
+
+    std::string line;
+    int lineNumber = 0;
+    std::vector<Token> tokens;
+
+    auto fail = [&](const std::string& message) {
+        std::cerr << path << ":" << lineNumber << ": " << message << std::endl;
+        return false;
+    };
+    auto verbIndex = [&](const std::string& name) {
+        Id id = loaded.strings.intern(name);
+        auto it = std::find(loaded.verbs.begin(), loaded.verbs.end(), id);
+        if (it != loaded.verbs.end()) {
+            return static_cast<uint32_t>(it - loaded.verbs.begin());
+        }
+        loaded.verbs.push_back(id);
+        verbBound.push_back(false);
+        return static_cast<uint32_t>(loaded.verbs.size() - 1);
+    };
+    auto extensionIndex = [&](const std::string& name) {
+        Id id = loaded.strings.intern(name);
+        auto it = std::find(loaded.extensions.begin(), loaded.extensions.end(), id);
+        if (it != loaded.extensions.end()) {
+            return static_cast<uint32_t>(it - loaded.extensions.begin());
+        }
+        loaded.extensions.push_back(id);
+        return static_cast<uint32_t>(loaded.extensions.size() - 1);
+    };
+
+    while (std::getline(file, line)) {
+        lineNumber++;
+        if (!tokenize(line, tokens)) {
+            return fail("unterminated string");
+        }
+        if (tokens.empty()) {
+            continue;
+        }
+        const std::string& keyword = tokens[0].text;
+        size_t args = tokens.size() - 1;
+        Phase* phase = loaded.phases.empty() ? nullptr : &loaded.phases.back();
+        uint32_t row = static_cast<uint32_t>(loaded.phases.size()) - 1;
+
+        // Actions, for the rule above
+        const ActionSyntax* syntax = nullptr;
+        for (const ActionSyntax& candidate : ACTIONS) {
+            if (keyword == candidate.keyword && args == candidate.args) {
+                syntax = &candidate;
+            }
+        }
+
+        if (syntax) {
+            Op op = syntax->op;
+            if (!inRule) {
+                return fail("'" + keyword + "' outside a rule");
+            }
+            Action action{op, NONE};
+            if (op == Op::CALL) {
+                action.operand = extensionIndex(tokens[1].text);
+                if (args == 2) {
+                    action.argument = loaded.strings.intern(tokens[2].text);
+                }
+            } else if (args == 1) {
+                action.operand = loaded.strings.intern(tokens[1].text);
+            }
+            if (op == Op::GOTO) {
+                gotoRefs.push_back({rules.size() - 1, rules.back().actions.size(), lineNumber});
+            }
+            rules.back().actions.push_back(action);
+            continue;
+        }
+        inRule = false;
+
+        if (keyword == "on") {
+            if (args < 1) {
+                return fail("on needs a verb");
+            }
+            PendingRule pending;
+            pending.row = phase ? row : NONE;  // NONE: every phase, fixed up below
+            pending.verb = verbIndex(tokens[1].text);
+            Rule& rule = pending.rule;
+            if (args == 1) {
+                rule.test = Test::ALWAYS;
+            } else if (tokens[2].text == "contains" && args >= 3) {
+                rule.test = Test::CONTAINS;
+                rule.firstWord = static_cast<uint32_t>(loaded.words.size());
+                for (size_t i = 3; i < tokens.size(); ++i) {
+                    loaded.words.push_back(loaded.strings.intern(tokens[i].text));
+                }
+                rule.wordCount = static_cast<uint32_t>(tokens.size() - 3);
+            } else if (tokens[2].text == "number" && args == 4) {
+                rule.test = Test::NUMBER;
+                if (!parseInt(tokens[3].text, rule.low) || !parseInt(tokens[4].text, rule.high)) {
+                    return fail("number needs a low and a high bound");
+                }
+            } else if (tokens[2].text == "nonumber" && args == 2) {
+                rule.test = Test::NO_NUMBER;
+            } else {
+                return fail("unknown test '" + tokens[2].text + "'");
+            }
+            rules.push_back(std::move(pending));
+            inRule = true;
+        } else if (keyword == "room" && args == 1) {
+            loaded.name = loaded.strings.intern(tokens[1].text);
+        } else if (keyword == "version" && args == 1) {
+            loaded.version = loaded.strings.intern(tokens[1].text);
+        } else if (keyword == "author" && args == 1) {
+            loaded.author = loaded.strings.intern(tokens[1].text);
+        } else if (keyword == "description" && args == 1) {
+            loaded.description = loaded.strings.intern(tokens[1].text);
+        } else if (keyword == "title" && args == 1) {
+            loaded.title = loaded.strings.intern(tokens[1].text);
+        } else if (keyword == "duration" && args == 1) {
+            int64_t seconds = 0;
+            if (!parseInt(tokens[1].text, seconds) || seconds <= 0) {
+                return fail("duration must be a positive number of seconds");
+            }
+            loaded.durationSeconds = static_cast<uint32_t>(seconds);
+        } else if (keyword == "banner" && (args == 2 || args == 3)) {
+            if (!parseColor(tokens[1].text, loaded.bannerColor)) {
+                return fail("unknown color '" + tokens[1].text + "'");
+            }
+            loaded.bannerBold = args == 3 && tokens[2].text == "bold";
+            loaded.banner = loaded.strings.intern(tokens[args].text);
+        } else if (keyword == "command" && args == 2) {
+            uint32_t verb = verbIndex(tokens[1].text);
+            if (verb <= VERB_OTHER) {
+                return fail("'" + tokens[1].text + "' is a built-in verb");
+            }
+            if (!loaded.grammar.add(tokens[2].text, static_cast<int>(verb))) {
+                return fail("bad command pattern '" + tokens[2].text + "'");
+            }
+            verbBound[verb] = true;
+        } else if (keyword == "complete" && args == 1) {
+            loaded.completions.push_back(loaded.strings.intern(tokens[1].text));
+        } else if (keyword == "puzzle" && args == 2) {
+            Puzzle puzzle;
+            puzzle.id = loaded.strings.intern(tokens[1].text);
+            puzzle.title = loaded.strings.intern(tokens[2].text);
+            for (const Puzzle& other : loaded.puzzles) {
+                if (other.id == puzzle.id) {
+                    return fail("puzzle '" + tokens[1].text + "' defined twice");
+                }
+            }
+            loaded.puzzles.push_back(puzzle);
+        } else if (keyword == "phase" && args == 2) {
+            Phase added;
+            added.name = loaded.strings.intern(tokens[1].text);
+            added.title = loaded.strings.intern(tokens[2].text);
+            for (const Phase& other : loaded.phases) {
+                if (other.name == added.name) {
+                    return fail("phase '" + tokens[1].text + "' defined twice");
+                }
+            }
+            added.firstLine = static_cast<uint32_t>(loaded.lines.size());
+            added.firstHint = static_cast<uint32_t>(loaded.hints.size());
+            loaded.phases.push_back(added);
+        } else if (!phase) {
+            return fail("unknown keyword '" + keyword + "' (or it belongs in a phase)");
+        } else if (keyword == "puzzle" && args == 1) {
+            puzzleRefs.emplace_back(row, loaded.strings.intern(tokens[1].text));
+        } else if (keyword == "music" && args == 1) {
+            if (!parseTheme(tokens[1].text, phase->music)) {
+                return fail("unknown theme '" + tokens[1].text + "'");
+            }
+            phase->hasMusic = true;
+        } else if (keyword == "prompt" && args == 1) {
+            phase->prompt = loaded.strings.intern(tokens[1].text);
+        } else if (keyword == "final" && args == 0) {
+            phase->final = true;
+        } else if (keyword == "hint" && (args == 1 || (args == 3 && tokens[2].text == "after"))) {
+            int64_t delay = 0;
+            if (args == 3 && (!parseInt(tokens[3].text, delay) || delay < 0)) {
+                return fail("hint ... after needs a number of seconds");
+            }
+            if (phase->hintCount > 0 && delay < loaded.hintDelays.back()) {
+                return fail("a phase's hints unlock in order; this one is due before the last");
+            }
+            loaded.hints.push_back(loaded.strings.intern(tokens[1].text));
+            loaded.hintDelays.push_back(static_cast<uint32_t>(delay));
+            phase->hintCount++;
+        } else if (keyword == "text" && (args == 4 || args == 5)) {
+            TextLine text;
+            int64_t x = 0;
+            int64_t y = 0;
+            if (!parseInt(tokens[1].text, x) || !parseInt(tokens[2].text, y) ||
+                x < 0 || x > 255 || y < 0 || y > 255) {
+                return fail("text needs a column and a row");
+            }
+            if (!parseColor(tokens[3].text, text.color)) {
+                return fail("unknown color '" + tokens[3].text + "'");
+            }
+            text.x = static_cast<int>(x);
+            text.y = static_cast<int>(y);
+            text.bold = args == 5 && tokens[4].text == "bold";
+            text.text = loaded.strings.intern(tokens[args].text);
+            loaded.lines.push_back(text);
+            phase->lineCount++;
+        } else if (keyword == "pane" && args == 5) {
+            int64_t box[4] = {};
+            for (int i = 0; i < 4; ++i) {
+                if (!parseInt(tokens[2 + i].text, box[i]) || box[i] < 0 || box[i] > 255) {
+                    return fail("pane needs a column, a row, a width and a height");
+                }
+            }
+            phase->pane = extensionIndex(tokens[1].text);
+            phase->paneX = static_cast<int>(box[0]);
+            phase->paneY = static_cast<int>(box[1]);
+            phase->paneWidth = static_cast<int>(box[2]);
+            phase->paneHeight = static_cast<int>(box[3]);
+        } else {
+            return fail("unknown keyword '" + keyword + "' or wrong arguments");
+        }
+    }
+
+    if (loaded.phases.empty()) {
+        return fail("a room needs at least one phase");
+    }
+    for (size_t verb = 0; verb < loaded.verbs.size(); ++verb) {
+        if (!verbBound[verb]) {
+            return fail("verb '" + std::string(loaded.text(loaded.verbs[verb])) +
+                        "' has rules but no command");
+        }
+    }
+    for (const auto& [phase, id] : puzzleRefs) {
+        for (size_t puzzle = 0; puzzle < loaded.puzzles.size(); ++puzzle) {
+            if (loaded.puzzles[puzzle].id == id) {
+                loaded.phases[phase].puzzle = static_cast<uint32_t>(puzzle);
+            }
+        }
+        if (loaded.phases[phase].puzzle == NONE) {
+            return fail("unknown puzzle '" + std::string(loaded.text(id)) + "'");
+        }
+    }
+    for (const GotoRef& ref : gotoRefs) {
+        Action& action = rules[ref.rule].actions[ref.action];
+        Id target = action.operand;
+        action.operand = NONE;
+        for (size_t phase = 0; phase < loaded.phases.size(); ++phase) {
+            if (loaded.phases[phase].name == target) {
+                action.operand = static_cast<uint32_t>(phase);
+            }
+        }
+        if (action.operand == NONE) {
+            lineNumber = ref.line;
+            return fail("unknown phase '" + std::string(loaded.text(target)) + "'");
+        }
+    }
+
+    // Group the rules into one contiguous range per (phase, verb), keeping
+    // their order in the file
+    uint32_t phaseCount = static_cast<uint32_t>(loaded.phases.size());
+    uint32_t verbCount = static_cast<uint32_t>(loaded.verbs.size());
+    for (PendingRule& pending : rules) {
+        if (pending.row == NONE) {
+            pending.row = phaseCount;
+        }
+    }
+    std::stable_sort(rules.begin(), rules.end(), [](const PendingRule& a, const PendingRule& b) {
+        return a.row != b.row ? a.row < b.row : a.verb < b.verb;
+    });
+    loaded.ruleTable.assign(static_cast<size_t>(phaseCount + 1) * verbCount, RuleRange());
+    for (PendingRule& pending : rules) {
+        RuleRange& range = loaded.ruleTable[pending.row * verbCount + pending.verb];
+        if (range.count == 0) {
+            range.first = static_cast<uint32_t>(loaded.rules.size());
+        }
+        range.count++;
+        pending.rule.firstAction = static_cast<uint32_t>(loaded.actions.size());
+        pending.rule.actionCount = static_cast<uint32_t>(pending.actions.size());
+        loaded.actions.insert(loaded.actions.end(), pending.actions.begin(), pending.actions.end());
+        loaded.rules.push_back(pending.rule);
+    }
+
+    for (const Phase& phase : loaded.phases) {
+        loaded.maxHintLevel = std::max(loaded.maxHintLevel, static_cast<int>(phase.hintCount));
+    }
+
+    program = std::move(loaded);
+    return true;
+}
+
+} // namespace devescape
@@ -0,0 +1,24 @@
+#include "framework/RoomV1Adapter.h"
+
+namespace devescape {
+
+size_t RoomV1Adapter::processInputs(Span<const std::string> commands,
+                                    std::pmr::vector<ProcessResult>& results) {
+    size_t handled = 0;
+    for (const std::string& command : commands) {
+        results.push_back(room_->processInput(command));
+        ++handled;
+        if (results.back().sessionEnded) {
+            break;
+        }
+    }
+    return handled;
+}
+
+UpdateHint RoomV1Adapter::updateFrame(float deltaTimeSeconds) {
+    // v1 rooms give no hint, so assume they change every frame
+    room_->update(deltaTimeSeconds);
+    return UpdateHint();
+}
+
+} // namespace devescape
@@ -0,0 +1,752 @@
+#include "framework/SandboxedRoom.h"
+#include "framework/RoomV1Adapter.h"
+#include "framework/TerminalRenderer.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace devescape {
+
+namespace {
+
+constexpr size_t RING_CAPACITY = 1 << 20;
+
+enum RequestType : uint32_t {
+    REQ_DESCRIBE = 1,
+    REQ_INITIALIZE,
+    REQ_CLEANUP,
+    REQ_GAME_STATE,
+    REQ_PROCESS_INPUT,
+    REQ_RENDER,
+    REQ_UPDATE,
+    REQ_SERIALIZE,
+    REQ_DESERIALIZE,
+    REQ_GET_HINT,
+    REQ_TIMEOUT,
+    REQ_PROCESS_INPUTS,
+    REQ_UPDATE_FRAME,
+    REQ_SHUTDOWN
+};
+
+constexpr uint32_t REPLY_OK = 0;
+
+// Flat little-endian encoding; both ends run on the same machine from the
+// same framework library, so no byte-order handling is needed.
+class PayloadWriter {
+public:
+    explicit PayloadWriter(std::vector<char>& buffer) : buffer_(buffer) { buffer_.clear(); }
+
+    PayloadWriter& u32(uint32_t value) { return raw(&value, sizeof(value)); }
+    PayloadWriter& f32(float value) { return raw(&value, sizeof(value)); }
+    PayloadWriter& str(const char* data, size_t length) {
+        u32(static_cast<uint32_t>(length));
+        return raw(data, length);
+    }
+    PayloadWriter& str(const std::string& value) { return str(value.data(), value.size()); }
+
+private:
+    PayloadWriter& raw(const void* data, size_t length) {
+        const char* bytes = static_cast<const char*>(data);
+        buffer_.insert(buffer_.end(), bytes, bytes + length);
+        return *this;
+    }
+
+    std::vector<char>& buffer_;
+};
+
+class PayloadReader {
+public:
+    explicit PayloadReader(const std::vector<char>& buffer) : buffer_(buffer), offset_(0) {}
+
+    uint32_t u32() {
+        uint32_t value = 0;
+        raw(&value, sizeof(value));
+        return value;
+    }
+    float f32() {
+        float value = 0.0f;
+        raw(&value, sizeof(value));
+        return value;
+    }
+    std::string str() {
+        uint32_t length = u32();
+        if (offset_ + length > buffer_.size()) length = 0;
+        std::string value(buffer_.data() + offset_, length);
+        offset_ += length;
+        return value;
+    }
+
+private:
+    void raw(void* data, size_t length) {
+        if (offset_ + length <= buffer_.size()) {
+            std::memcpy(data, buffer_.data() + offset_, length);
+            offset_ += length;
+        }
+    }
+
+    const std::vector<char>& buffer_;
+    size_t offset_;
+};
+
+std::string encodeGameState(const GameState& state) {
+    auto toStd = [](const std::pmr::string& s) { return std::string(s.data(), s.size()); };
+
+    json puzzles = json::object();
+    for (const auto& [id, puzzle] : state.puzzles) {
+        puzzles[toStd(id)] = {
+            {"title", toStd(puzzle.title)},
+            {"solved", puzzle.solved},
+            {"locked", puzzle.locked},
+            {"completion_percent", puzzle.completionPercent},
+            {"hints_used", puzzle.hintsUsed},
+            {"wrong_attempts", puzzle.wrongAttempts},
+            {"time_spent_seconds", puzzle.timeSpentSeconds},
+            {"player_answer", toStd(puzzle.playerAnswer)},
+            {"correct_answer", toStd(puzzle.correctAnswer)}
+        };
+    }
+
+    json inventory = json::object();
+    for (const auto& [item, value] : state.inventory) {
+        inventory[toStd(item)] = toStd(value);
+    }
+
+    json clues = json::array();
+    for (const auto& clue : state.discoveredClues) clues.push_back(toStd(clue));
+    json events = json::array();
+    for (const auto& event : state.eventLog) events.push_back(toStd(event));
+
+    json j;
+    j["puzzles"] = puzzles;
+    j["inventory"] = inventory;
+    j["clues"] = clues;
+    j["completed"] = state.completedPuzzleCount;
+    j["events"] = events;
+    return j.dump();
+}
+
+GameState decodeGameState(const std::string& data) {
+    GameState state;
+    try {
+        json j = json::parse(data);
+        for (auto& [id, p] : j["puzzles"].items()) {
+            PuzzleState puzzle;
+            puzzle.id = id;
+            puzzle.title = p["title"].get_ref<const std::string&>();
+            puzzle.solved = p["solved"];
+            puzzle.locked = p["locked"];
+            puzzle.completionPercent = p["completion_percent"];
+            puzzle.hintsUsed = p["hints_used"];
+            puzzle.wrongAttempts = p["wrong_attempts"];
+            puzzle.timeSpentSeconds = p["time_spent_seconds"];
+            puzzle.playerAnswer = p["player_answer"].get_ref<const std::string&>();
+            puzzle.correctAnswer = p["correct_answer"].get_ref<const std::string&>();
+            state.puzzles.emplace(id, std::move(puzzle));
+        }
+        for (auto& [item, value] : j["inventory"].items()) {
+            state.inventory.emplace(item, value.get_ref<const std::string&>());
+        }
+        for (const auto& clue : j["clues"]) state.discoveredClues.emplace_back(clue.get_ref<const std::string&>());
+        for (const auto& event : j["events"]) state.eventLog.emplace_back(event.get_ref<const std::string&>());
+        state.completedPuzzleCount = j["completed"];
+    } catch (const std::exception&) {
+        // Return whatever was decoded
+    }
+    return state;
+}
+
+// Shared-memory fd as the helper sees it
+constexpr int HELPER_SHARED_FD = 3;
+
+// A crash loses at most this much play since the last snapshot
+constexpr std::chrono::seconds SNAPSHOT_INTERVAL(2);
+
+size_t sharedBlockBytes() {
+    return 2 * ShmRingBuffer::requiredBytes(RING_CAPACITY);
+}
+
+std::string& helperPathSetting() {
+    static std::string path;
+    return path;
+}
+
+#ifndef _WIN32
+// devescape_sandbox is installed next to devescape; benchmarks and other
+// tools in the build tree fall back to the one this build made
+std::string findHelper() {
+#ifdef __linux__
+    char self[4096];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length > 0) {
+        std::string path(self, static_cast<size_t>(length));
+        path = path.substr(0, path.rfind('/') + 1) + "devescape_sandbox";
+        if (access(path.c_str(), X_OK) == 0) {
+            return path;
+        }
+    }
+#endif
+#ifdef DEVESCAPE_SANDBOX_HELPER
+    if (access(DEVESCAPE_SANDBOX_HELPER, X_OK) == 0) {
+        return DEVESCAPE_SANDBOX_HELPER;
+    }
+#endif
+    return "devescape_sandbox";  // searched for on PATH
+}
+#endif
+
+} // namespace
+
+SandboxedRoom::SandboxedRoom(const std::string& pluginPath, uint32_t abiVersion,
+                             std::chrono::milliseconds callTimeout)
+    : pluginPath_(pluginPath)
+    , abiVersion_(abiVersion)
+    , callTimeout_(callTimeout)
+    , sharedFd_(-1)
+    , sharedMemory_(nullptr)
+    , sharedBytes_(0)
+    , childPid_(-1)
+    , restartCount_(0)
+    , initialized_(false)
+    , stateChanged_(false) {
+#ifndef _WIN32
+    // A named block, unlinked at once, so that the helper can map it from
+    // the descriptor it inherits
+    std::string name = "/devescape-sandbox-" + std::to_string(getpid()) + "-" +
+                       std::to_string(reinterpret_cast<uintptr_t>(this));
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        std::cerr << "Sandbox: failed to create shared memory" << std::endl;
+        return;
+    }
+    shm_unlink(name.c_str());
+
+    // Kept clear of the helper's descriptor number for the dup2 at spawn
+    sharedFd_ = fcntl(fd, F_DUPFD_CLOEXEC, HELPER_SHARED_FD + 1);
+    close(fd);
+    sharedBytes_ = sharedBlockBytes();
+    if (sharedFd_ < 0 || ftruncate(sharedFd_, static_cast<off_t>(sharedBytes_)) != 0) {
+        std::cerr << "Sandbox: failed to size shared memory" << std::endl;
+        return;
+    }
+    sharedMemory_ = mmap(nullptr, sharedBytes_, PROT_READ | PROT_WRITE, MAP_SHARED, sharedFd_, 0);
+    if (sharedMemory_ == MAP_FAILED) {
+        std::cerr << "Sandbox: failed to map shared memory" << std::endl;
+        sharedMemory_ = nullptr;
+        return;
+    }
+
+    char* base = static_cast<char*>(sharedMemory_);
+    requests_ = ShmRingBuffer::create(base, RING_CAPACITY);
+    responses_ = ShmRingBuffer::create(base + ShmRingBuffer::requiredBytes(RING_CAPACITY), RING_CAPACITY);
+
+    if (startChild()) {
+        describe();
+    }
+#endif
+}
+
+SandboxedRoom::~SandboxedRoom() {
+#ifndef _WIN32
+    stopChild(true);
+    if (sharedMemory_) {
+        munmap(sharedMemory_, sharedBytes_);
+    }
+    if (sharedFd_ >= 0) {
+        close(sharedFd_);
+    }
+#endif
+}
+
+bool SandboxedRoom::isSupported() {
+#ifdef _WIN32
+    return false;
+#else
+    return true;
+#endif
+}
+
+void SandboxedRoom::setHelperPath(const std::string& path) {
+    helperPathSetting() = path;
+}
+
+bool SandboxedRoom::startChild() const {
+#ifndef _WIN32
+    if (!sharedMemory_) {
+        return false;
+    }
+
+    requests_.reset();
+    responses_.reset();
+
+    std::string helper = helperPathSetting().empty() ? findHelper() : helperPathSetting();
+    std::string fdArg = std::to_string(HELPER_SHARED_FD);
+    std::string abiArg = std::to_string(abiVersion_);
+    char* argv[] = {const_cast<char*>(helper.c_str()), const_cast<char*>(fdArg.c_str()),
+                    const_cast<char*>(abiArg.c_str()), const_cast<char*>(pluginPath_.c_str()),
+                    nullptr};
+
+    // Frames go back to the host through the ring; keep the room's own
+    // terminal writes (clearScreen etc.) off the player's screen
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, sharedFd_, HELPER_SHARED_FD);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    pid_t pid = -1;
+    int error = helper.find('/') == std::string::npos
+                    ? posix_spawnp(&pid, helper.c_str(), &actions, nullptr, argv, environ)
+                    : posix_spawn(&pid, helper.c_str(), &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (error != 0) {
+        std::cerr << "Sandbox: cannot start " << helper << ": " << std::strerror(error) << std::endl;
+        return false;
+    }
+    childPid_ = pid;
+
+    // A replacement child picks up where the last snapshot left off
+    if (initialized_) {
+        PayloadWriter(request_).str(context_.dataDirectory).str(context_.checkpointDirectory);
+        bool restored = exchange(REQ_INITIALIZE);
+        if (restored && !lastSnapshot_.empty()) {
+            PayloadWriter(request_).str(lastSnapshot_);
+            restored = exchange(REQ_DESERIALIZE);
+        }
+        if (!restored) {
+            std::cerr << "Sandbox: " << description_.name << " could not be restored" << std::endl;
+            stopChild(false);
+            return false;
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SandboxedRoom::stopChild(bool graceful) const {
+#ifndef _WIN32
+    if (childPid_ <= 0) {
+        return;
+    }
+
+    if (graceful) {
+        requests_.write(REQ_SHUTDOWN, nullptr, 0);
+        for (int i = 0; i < 100; ++i) {
+            if (waitpid(childPid_, nullptr, WNOHANG) == childPid_) {
+                childPid_ = -1;
+                return;
+            }
+            usleep(1000);
+        }
+    }
+
+    kill(childPid_, SIGKILL);
+    waitpid(childPid_, nullptr, 0);
+    childPid_ = -1;
+#else
+    (void)graceful;
+#endif
+}
+
+void SandboxedRoom::restartChild() const {
+    stopChild(false);
+    restartCount_++;
+    std::cerr << "Sandbox: restarting " << description_.name << " from last snapshot" << std::endl;
+    startChild();
+}
+
+int SandboxedRoom::serveChild(int sharedFd, CreateRoomFunc createRoom, DestroyRoomFunc destroyRoom,
+                              uint32_t abiVersion) {
+#ifndef _WIN32
+#ifdef __linux__
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+    size_t sharedBytes = sharedBlockBytes();
+    void* sharedMemory = mmap(nullptr, sharedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, sharedFd, 0);
+    close(sharedFd);
+    if (sharedMemory == MAP_FAILED) {
+        std::cerr << "Sandbox: failed to map shared memory" << std::endl;
+        return 1;
+    }
+    char* base = static_cast<char*>(sharedMemory);
+    ShmRingBuffer requests = ShmRingBuffer::attach(base);
+    ShmRingBuffer responses = ShmRingBuffer::attach(base + ShmRingBuffer::requiredBytes(RING_CAPACITY));
+
+    // The child only ever runs the room. Host-side services stay in the
+    // host; the directories arrive with REQ_INITIALIZE.
+    FrameworkContext childContext;
+
+    IEscapeRoom* room = createRoom();
+    RoomV1Adapter adapter(room);
+    IEscapeRoomV2* roomV2 = abiVersion >= PLUGIN_ABI_V2 ? static_cast<IEscapeRoomV2*>(room) : &adapter;
+
+    std::vector<char> request;
+    std::vector<char> reply;
+    uint32_t type = 0;
+    bool running = true;
+
+    while (running) {
+        if (!requests.read(type, request)) {
+            requests.waitReadable(std::chrono::seconds(1));
+            continue;
+        }
+
+        PayloadReader in(request);
+        PayloadWriter out(reply);
+        switch (type) {
+            case REQ_DESCRIBE:
+                out.str(room->getName()).str(room->getVersion()).str(room->getAuthor())
+                   .str(room->getDescription()).u32(room->getTotalDurationSeconds())
+                   .u32(static_cast<uint32_t>(room->getMaxHintLevel()))
+                   .u32(roomV2->getCapabilities());
+                break;
+            case REQ_INITIALIZE:
+                // The child was spawned before the host knew its context
+                childContext.dataDirectory = in.str();
+                childContext.checkpointDirectory = in.str();
+                room->initialize(childContext);
+                break;
+            case REQ_CLEANUP:
+                room->cleanup();
+                break;
+            case REQ_GAME_STATE:
+                out.str(encodeGameState(room->getCurrentState()));
+                break;
+            case REQ_PROCESS_INPUT: {
+                ProcessResult result = room->processInput(in.str());
+                out.u32(result.sessionEnded).u32(result.success).u32(result.invalidCommand)
+                   .str(result.outputText.data(), result.outputText.size());
+                break;
+            }
+            case REQ_RENDER: {
+                TerminalRenderer renderer;
+                int width = static_cast<int>(in.u32());
+                int height = static_cast<int>(in.u32());
+                renderer.resize(width, height);
+                room->render(renderer);
+                out.u32(static_cast<uint32_t>(renderer.getHeight()));
+                for (int y = 0; y < renderer.getHeight(); ++y) {
+                    std::string_view line = renderer.getLine(y);
+                    out.str(line.data(), line.size());
+                }
+                break;
+            }
+            case REQ_UPDATE:
+                room->update(in.f32());
+                break;
+            case REQ_SERIALIZE:
+                out.str(room->serializeState());
+                break;
+            case REQ_DESERIALIZE:
+                out.u32(room->deserializeState(in.str()));
+                break;
+            case REQ_GET_HINT: {
+                int level = static_cast<int>(in.u32());
+                out.str(room->getHint(level));
+                break;
+            }
+            case REQ_TIMEOUT:
+                room->onSessionTimeout();
+                break;
+            case REQ_PROCESS_INPUTS: {
+                std::vector<std::string> commands(in.u32());
+                for (auto& command : commands) {
+                    command = in.str();
+                }
+                std::pmr::vector<ProcessResult> results;
+                roomV2->processInputs(Span<const std::string>(commands), results);
+                out.u32(static_cast<uint32_t>(results.size()));
+                for (const auto& result : results) {
+                    out.u32(result.sessionEnded).u32(result.success).u32(result.invalidCommand)
+                       .str(result.outputText.data(), result.outputText.size());
+                }
+                break;
+            }
+            case REQ_UPDATE_FRAME: {
+                UpdateHint hint = roomV2->updateFrame(in.f32());
+                out.u32(hint.needsRedraw).f32(hint.nextWakeupSeconds);
+                break;
+            }
+            case REQ_SHUTDOWN:
+                running = false;
+                continue;
+        }
+
+        // Every reply carries the status flags so the host can answer the
+        // const queries (isCompleted, canUseHint, ...) without a round trip
+        out.u32(room->isCompleted()).u32(room->isFailed()).u32(room->canUseHint())
+           .u32(static_cast<uint32_t>(room->getCompletionPercentage()));
+        while (!responses.write(REPLY_OK, reply.data(), static_cast<uint32_t>(reply.size()))) {
+            usleep(100);
+        }
+    }
+
+    destroyRoom(room);
+    munmap(sharedMemory, sharedBytes);
+    return 0;
+#else
+    (void)sharedFd;
+    (void)createRoom;
+    (void)destroyRoom;
+    (void)abiVersion;
+    return 1;
+#endif
+}
+
+bool SandboxedRoom::call(uint32_t type) const {
+    if (childPid_ <= 0 && !startChild()) {
+        return false;
+    }
+    if (!exchange(type)) {
+        restartChild();
+        return false;
+    }
+    return true;
+}
+
+bool SandboxedRoom::exchange(uint32_t type) const {
+#ifndef _WIN32
+    if (!requests_.write(type, request_.data(), static_cast<uint32_t>(request_.size()))) {
+        return false;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + callTimeout_;
+    uint32_t replyType = 0;
+    while (!responses_.read(replyType, reply_)) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            std::cerr << "Sandbox: " << description_.name << " did not answer in "
+                      << callTimeout_.count() << "ms" << std::endl;
+            return false;
+        }
+
+        auto slice = std::min<std::chrono::microseconds>(
+            std::chrono::duration_cast<std::chrono::microseconds>(deadline - now),
+            std::chrono::milliseconds(10));
+        if (!responses_.waitReadable(slice) && waitpid(childPid_, nullptr, WNOHANG) == childPid_) {
+            childPid_ = -1;
+            std::cerr << "Sandbox: " << description_.name << " crashed" << std::endl;
+            return false;
+        }
+    }
+
+    // Status flags trail every reply
+    if (reply_.size() >= 4 * sizeof(uint32_t)) {
+        uint32_t flags[4];
+        std::memcpy(flags, reply_.data() + reply_.size() - sizeof(flags), sizeof(flags));
+        status_.completed = flags[0] != 0;
+        status_.failed = flags[1] != 0;
+        status_.canUseHint = flags[2] != 0;
+        status_.completionPercent = static_cast<int>(flags[3]);
+    }
+    return true;
+#else
+    (void)type;
+    return false;
+#endif
+}
+
+void SandboxedRoom::snapshotIfDue() {
+    auto now = std::chrono::steady_clock::now();
+    if (stateChanged_ && now >= nextSnapshot_) {
+        snapshot();
+    }
+}
+
+void SandboxedRoom::snapshot() {
+    request_.clear();
+    if (call(REQ_SERIALIZE)) {
+        lastSnapshot_ = PayloadReader(reply_).str();
+        stateChanged_ = false;
+        nextSnapshot_ = std::chrono::steady_clock::now() + SNAPSHOT_INTERVAL;
+    }
+}
+
+void SandboxedRoom::describe() {
+    request_.clear();
+    if (call(REQ_DESCRIBE)) {
+        PayloadReader reader(reply_);
+        description_.name = reader.str();
+        description_.version = reader.str();
+        description_.author = reader.str();
+        description_.description = reader.str();
+        description_.durationSeconds = reader.u32();
+        description_.maxHintLevel = static_cast<int>(reader.u32());
+        description_.capabilities = reader.u32();
+    }
+}
+
+void SandboxedRoom::initialize(const FrameworkContext& context) {
+    context_ = context;
+    PayloadWriter(request_).str(context.dataDirectory).str(context.checkpointDirectory);
+    if (call(REQ_INITIALIZE)) {
+        initialized_ = true;
+        // Rooms may only know their metadata once they have the data directory
+        describe();
+        snapshot();
+    }
+}
+
+void SandboxedRoom::cleanup() {
+    request_.clear();
+    call(REQ_CLEANUP);
+}
+
+GameState SandboxedRoom::getCurrentState() const {
+    request_.clear();
+    if (!call(REQ_GAME_STATE)) {
+        return GameState();
+    }
+    return decodeGameState(PayloadReader(reply_).str());
+}
+
+ProcessResult SandboxedRoom::processInput(const std::string& command) {
+    ProcessResult result(context_.memoryResource);
+
+    PayloadWriter(request_).str(command);
+    if (!call(REQ_PROCESS_INPUT)) {
+        result.outputText = "The room stopped responding and was restored from its last checkpoint.";
+        return result;
+    }
+
+    PayloadReader reader(reply_);
+    result.sessionEnded = reader.u32() != 0;
+    result.success = reader.u32() != 0;
+    result.invalidCommand = reader.u32() != 0;
+    result.outputText = reader.str();
+
+    stateChanged_ = true;
+    return result;
+}
+
+size_t SandboxedRoom::processInputs(Span<const std::string> commands,
+                                    std::pmr::vector<ProcessResult>& results) {
+    if (commands.empty()) {
+        return 0;
+    }
+
+    PayloadWriter writer(request_);
+    writer.u32(static_cast<uint32_t>(commands.size()));
+    for (const std::string& command : commands) {
+        writer.str(command);
+    }
+
+    if (!call(REQ_PROCESS_INPUTS)) {
+        // The batch is lost with the child; report it once
+        results.emplace_back().outputText =
+            "The room stopped responding and was restored from its last checkpoint.";
+        return commands.size();
+    }
+
+    PayloadReader reader(reply_);
+    size_t handled = reader.u32();
+    for (size_t i = 0; i < handled; ++i) {
+        ProcessResult& result = results.emplace_back();
+        result.sessionEnded = reader.u32() != 0;
+        result.success = reader.u32() != 0;
+        result.invalidCommand = reader.u32() != 0;
+        result.outputText = reader.str();
+    }
+
+    // Snapshotted later, from updateFrame(), off the command's round trip
+    stateChanged_ = true;
+    return handled;
+}
+
+void SandboxedRoom::render(TerminalRenderer& renderer) const {
+    PayloadWriter(request_).u32(static_cast<uint32_t>(renderer.getWidth()))
+                           .u32(static_cast<uint32_t>(renderer.getHeight()));
+    if (!call(REQ_RENDER)) {
+        return;
+    }
+
+    PayloadReader reader(reply_);
+    int rows = static_cast<int>(reader.u32());
+    for (int y = 0; y < rows; ++y) {
+        std::string line = reader.str();
+        if (y < renderer.getHeight()) {
+            renderer.setLine(y, line);
+        }
+    }
+}
+
+void SandboxedRoom::update(float deltaTimeSeconds) {
+    request_.clear();
+    PayloadWriter(request_).f32(deltaTimeSeconds);
+    call(REQ_UPDATE);
+    snapshotIfDue();
+}
+
+UpdateHint SandboxedRoom::updateFrame(float deltaTimeSeconds) {
+    request_.clear();
+    PayloadWriter(request_).f32(deltaTimeSeconds);
+
+    UpdateHint hint;
+    if (call(REQ_UPDATE_FRAME)) {
+        PayloadReader reader(reply_);
+        hint.needsRedraw = reader.u32() != 0;
+        hint.nextWakeupSeconds = reader.f32();
+    }
+
+    // A pending snapshot wakes the room when it falls due
+    snapshotIfDue();
+    if (stateChanged_) {
+        float dueSeconds = std::chrono::duration<float>(nextSnapshot_ -
+                                                        std::chrono::steady_clock::now()).count();
+        hint.nextWakeupSeconds = std::max(0.0f, std::min(hint.nextWakeupSeconds, dueSeconds));
+    }
+    return hint;
+}
+
+std::string SandboxedRoom::serializeState() const {
+    request_.clear();
+    if (!call(REQ_SERIALIZE)) {
+        return lastSnapshot_;
+    }
+    lastSnapshot_ = PayloadReader(reply_).str();
+    return lastSnapshot_;
+}
+
+bool SandboxedRoom::deserializeState(const std::string& data) {
+    PayloadWriter(request_).str(data);
+    if (!call(REQ_DESERIALIZE) || PayloadReader(reply_).u32() == 0) {
+        return false;
+    }
+    lastSnapshot_ = data;
+    stateChanged_ = false;
+    return true;
+}
+
+std::string SandboxedRoom::getHint(int hintLevel) {
+    PayloadWriter(request_).u32(static_cast<uint32_t>(hintLevel));
+    if (!call(REQ_GET_HINT)) {
+        return "No hints available.";
+    }
+    std::string hint = PayloadReader(reply_).str();
+    stateChanged_ = true;
+    return hint;
+}
+
+void SandboxedRoom::onSessionTimeout() {
+    request_.clear();
+    call(REQ_TIMEOUT);
+}
+
+} // namespace devescape
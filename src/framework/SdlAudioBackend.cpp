@@ -0,0 +1,94 @@
+#include "framework/AudioBackend.h"
+#include <SDL2/SDL.h>
+#include <iostream>
+
+namespace devescape {
+
+namespace {
+
+class SdlAudioBackend : public AudioBackend {
+public:
+    SdlAudioBackend()
+        : device_(0)
+        , initialized_(false)
+        , render_(nullptr)
+        , userdata_(nullptr) {
+        SDL_zero(spec_);
+    }
+
+    ~SdlAudioBackend() override {
+        close();
+    }
+
+    const char* getName() const override { return "sdl"; }
+
+    bool open(int sampleRate, int blockFrames, RenderCallback render, void* userdata) override {
+        // Only this backend needs SDL, so the subsystem comes up here
+        if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+            std::cerr << "SDL audio initialization failed: " << SDL_GetError() << std::endl;
+            return false;
+        }
+        initialized_ = true;
+        render_ = render;
+        userdata_ = userdata;
+
+        SDL_AudioSpec desiredSpec;
+        SDL_zero(desiredSpec);
+        desiredSpec.freq = sampleRate;
+        desiredSpec.format = AUDIO_F32SYS;
+        desiredSpec.channels = 1;
+        desiredSpec.samples = static_cast<Uint16>(blockFrames);
+        desiredSpec.callback = audioCallback;
+        desiredSpec.userdata = this;
+
+        device_ = SDL_OpenAudioDevice(nullptr, 0, &desiredSpec, &spec_, 0);
+        if (device_ == 0) {
+            std::cerr << "Failed to open audio device: " << SDL_GetError() << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void start() override {
+        if (device_ != 0) {
+            SDL_PauseAudioDevice(device_, 0);
+        }
+    }
+
+    void close() override {
+        if (device_ != 0) {
+            SDL_CloseAudioDevice(device_);
+            device_ = 0;
+        }
+        if (initialized_) {
+            SDL_QuitSubSystem(SDL_INIT_AUDIO);
+            initialized_ = false;
+        }
+    }
+
+    int getSampleRate() const override { return spec_.freq; }
+    int getBlockFrames() const override { return spec_.samples; }
+    bool hasDeviceLatency() const override { return true; }
+
+private:
+    SDL_AudioDeviceID device_;
+    SDL_AudioSpec spec_;
+    bool initialized_;
+    RenderCallback render_;
+    void* userdata_;
+
+    static void audioCallback(void* userdata, uint8_t* stream, int len) {
+        SdlAudioBackend* backend = static_cast<SdlAudioBackend*>(userdata);
+        backend->render_(backend->userdata_, reinterpret_cast<float*>(stream),
+                         len / static_cast<int>(sizeof(float)));
+    }
+};
+
+} // namespace
+
+std::unique_ptr<AudioBackend> createSdlAudioBackend() {
+    return std::make_unique<SdlAudioBackend>();
+}
+
+} // namespace devescape
@@ -0,0 +1,372 @@
+#include "framework/Sequencer.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace devescape {
+
+namespace {
+
+// Full-volume level per voice: squares, triangle, noise
+const float VOICE_GAIN[SynthEngine::VOICE_COUNT] = {0.25f, 0.25f, 0.3f, 0.2f};
+
+struct NoteTable {
+    float frequency[128];
+    NoteTable() {
+        for (int note = 0; note < 128; ++note) {
+            frequency[note] = 440.0f * std::pow(2.0f, (note - 69) / 12.0f);
+        }
+    }
+};
+
+bool parseCell(const std::string& token, PatternCell& cell) {
+    cell = PatternCell();
+    if (token == ".") {
+        return true;
+    }
+    if (token == "--") {
+        cell.note = PatternCell::NOTE_OFF;
+        return true;
+    }
+
+    size_t colon = token.find(':');
+    std::string note = token.substr(0, colon);
+    if (colon != std::string::npos) {
+        char* end = nullptr;
+        long volume = std::strtol(token.c_str() + colon + 1, &end, 10);
+        if (*end != '\0' || end == token.c_str() + colon + 1 || volume < 0 || volume > 15) {
+            return false;
+        }
+        cell.volume = static_cast<uint8_t>(volume);
+    }
+    if (note == ".") {
+        return colon != std::string::npos;  // volume change only
+    }
+
+    return Sequencer::parseNote(note, cell.note);
+}
+
+} // namespace
+
+Sequencer::Sequencer()
+    : song_(nullptr)
+    , tier_(0)
+    , orderIndex_(0)
+    , row_(0)
+    , samplesUntilRow_(0.0)
+    , position_(0)
+    , eventCallback_(nullptr)
+    , eventUserdata_(nullptr)
+    , eventBpm_(0.0f) {
+}
+
+const char* Sequencer::themeName(ThemeType theme) {
+    switch (theme) {
+        case ThemeType::AMBIENT: return "ambient";
+        case ThemeType::FOCUS: return "focus";
+        case ThemeType::COMPLEX: return "complex";
+        case ThemeType::CRISIS: return "crisis";
+        case ThemeType::VICTORY: return "victory";
+        case ThemeType::FAILURE: return "failure";
+    }
+    return "unknown";
+}
+
+std::string Sequencer::stripComment(const std::string& line) {
+    for (size_t i = 0; i < line.size(); ++i) {
+        if (line[i] == '#' && (i == 0 || std::isspace(static_cast<unsigned char>(line[i - 1])))) {
+            return line.substr(0, i);
+        }
+    }
+    return line;
+}
+
+bool Sequencer::parseNote(const std::string& text, uint8_t& note) {
+    static const int SEMITONES[] = {9, 11, 0, 2, 4, 5, 7};  // A-G
+    if (text.size() < 2 || text[0] < 'A' || text[0] > 'G') {
+        return false;
+    }
+    int semitone = SEMITONES[text[0] - 'A'];
+    size_t pos = 1;
+    if (text[pos] == '#') {
+        semitone++;
+        pos++;
+    } else if (text[pos] == 'b') {
+        semitone--;
+        pos++;
+    }
+    char* end = nullptr;
+    long octave = std::strtol(text.c_str() + pos, &end, 10);
+    if (*end != '\0' || end == text.c_str() + pos) {
+        return false;
+    }
+    long midi = (octave + 1) * 12 + semitone;
+    if (midi < 0 || midi > 127) {
+        return false;
+    }
+    note = static_cast<uint8_t>(midi);
+    return true;
+}
+
+float Sequencer::noteFrequency(uint8_t note) {
+    static const NoteTable table;
+    return table.frequency[note & 0x7F];
+}
+
+float Sequencer::voiceGain(int voice) {
+    return VOICE_GAIN[voice & 3];
+}
+
+bool Sequencer::loadSong(const std::string& path, Song& song) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    Song loaded;
+    bool tierSeen[Song::TIERS] = {};
+    int rowsLeft = 0;  // rows still due in the current pattern
+    std::string line;
+    int lineNumber = 0;
+
+    auto fail = [&](const std::string& message) {
+        std::cerr << path << ":" << lineNumber << ": " << message << std::endl;
+        return false;
+    };
+
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = stripComment(line);
+        std::istringstream in(line);
+        std::string keyword;
+        if (!(in >> keyword)) {
+            continue;
+        }
+
+        if (rowsLeft > 0) {
+            std::string token = keyword;
+            for (int voice = 0; voice < SynthEngine::VOICE_COUNT; ++voice) {
+                PatternCell cell;
+                if (voice > 0 && !(in >> token)) {
+                    return fail("expected " + std::to_string(SynthEngine::VOICE_COUNT) + " cells");
+                }
+                if (!parseCell(token, cell)) {
+                    return fail("bad cell '" + token + "'");
+                }
+                loaded.cells.push_back(cell);
+            }
+            if (in >> token) {
+                return fail("extra cell '" + token + "'");
+            }
+            rowsLeft--;
+            continue;
+        }
+
+        if (keyword == "theme") {
+            in >> loaded.name;
+        } else if (keyword == "rows") {
+            if (loaded.patternCount > 0 || !(in >> loaded.rowsPerPattern) ||
+                loaded.rowsPerPattern < 1 || loaded.rowsPerPattern > 256) {
+                return fail("rows must be 1-256 and come before the patterns");
+            }
+        } else if (keyword == "speed") {
+            if (!(in >> loaded.rowsPerBeat) || loaded.rowsPerBeat < 1 || loaded.rowsPerBeat > 32) {
+                return fail("speed must be 1-32 rows per beat");
+            }
+        } else if (keyword == "duty") {
+            if (!(in >> loaded.duty[0] >> loaded.duty[1])) {
+                return fail("duty needs two values");
+            }
+        } else if (keyword == "tier") {
+            int tier = -1;
+            Song::Tier settings;
+            if (!(in >> tier >> settings.bpm) || tier < 0 || tier >= Song::TIERS ||
+                settings.bpm <= 0.0f || settings.bpm > 1000.0f) {
+                return fail("tier needs a tier (0-3) and a bpm");
+            }
+            int pattern = 0;
+            while (in >> pattern) {
+                if (pattern < 0 || pattern > 255) {
+                    return fail("pattern numbers go up to 255");
+                }
+                settings.order.push_back(static_cast<uint8_t>(pattern));
+            }
+            if (settings.order.empty()) {
+                return fail("tier needs a pattern order");
+            }
+            loaded.tiers[tier] = std::move(settings);
+            tierSeen[tier] = true;
+        } else if (keyword == "pattern") {
+            loaded.patternCount++;
+            rowsLeft = loaded.rowsPerPattern;
+        } else {
+            return fail("unknown keyword '" + keyword + "'");
+        }
+    }
+
+    if (rowsLeft > 0) {
+        return fail("pattern ends early");
+    }
+    if (loaded.patternCount == 0 || !tierSeen[0]) {
+        return fail("need at least one pattern and tier 0");
+    }
+    for (int tier = 1; tier < Song::TIERS; ++tier) {
+        if (!tierSeen[tier]) {
+            loaded.tiers[tier] = loaded.tiers[tier - 1];
+        }
+    }
+    for (const Song::Tier& tier : loaded.tiers) {
+        for (uint8_t pattern : tier.order) {
+            if (pattern >= loaded.patternCount) {
+                return fail("order refers to missing pattern " + std::to_string(pattern));
+            }
+        }
+    }
+
+    song = std::move(loaded);
+    return true;
+}
+
+void Sequencer::play(const Song* song, SynthEngine& synth) {
+    song_ = song && song->isLoaded() ? song : nullptr;
+    orderIndex_ = 0;
+    row_ = 0;
+    samplesUntilRow_ = 0.0;  // first row lands on the next sample
+
+    emit(NoteEventType::STOP, 0, 0, 0, 0);
+    for (int voice = 0; voice < SynthEngine::VOICE_COUNT; ++voice) {
+        synth.voice(voice).enabled = false;
+        synth.voice(voice).volume = VOICE_GAIN[voice];
+        emit(NoteEventType::VOLUME, voice, 0, 15, 0);
+    }
+    if (song_) {
+        synth.voice(0).duty = song_->duty[0];
+        synth.voice(1).duty = song_->duty[1];
+        for (int voice = 0; voice < 2; ++voice) {
+            emit(NoteEventType::DUTY, voice, 0, 0,
+                 static_cast<uint32_t>(std::lround(song_->duty[voice] * 256.0f)));
+        }
+    }
+    eventBpm_ = 0.0f;  // the first row sends it
+}
+
+void Sequencer::stop(SynthEngine& synth) {
+    song_ = nullptr;
+    for (int voice = 0; voice < SynthEngine::VOICE_COUNT; ++voice) {
+        synth.voice(voice).enabled = false;
+    }
+    emit(NoteEventType::STOP, 0, 0, 0, 0);
+}
+
+void Sequencer::setEventCallback(EventCallback callback, void* userdata) {
+    eventCallback_ = callback;
+    eventUserdata_ = userdata;
+}
+
+void Sequencer::setTier(int tier) {
+    tier_ = std::max(0, std::min(Song::TIERS - 1, tier));
+}
+
+float Sequencer::getBpm() const {
+    return song_ ? song_->tiers[tier_].bpm : 0.0f;
+}
+
+void Sequencer::render(SynthEngine& synth, float* buffer, size_t frameCount) {
+    process(synth, buffer, frameCount);
+}
+
+void Sequencer::advance(SynthEngine& synth, size_t frameCount) {
+    process(synth, nullptr, frameCount);
+}
+
+void Sequencer::process(SynthEngine& synth, float* buffer, size_t frameCount) {
+    size_t done = 0;
+    while (done < frameCount) {
+        if (!song_) {
+            if (buffer) {
+                synth.render(buffer + done, frameCount - done);
+            }
+            position_ += frameCount - done;
+            return;
+        }
+
+        if (samplesUntilRow_ <= 0.0) {
+            applyRow(synth);
+            advanceRow();
+            // Tempo is read per row, so a tier change lands on the next one
+            float bpm = getBpm();
+            if (bpm != eventBpm_) {
+                eventBpm_ = bpm;
+                emit(NoteEventType::TEMPO, 0, 0, 0,
+                     static_cast<uint32_t>(std::lround(bpm * 10.0f)));
+            }
+            double samplesPerRow = synth.getSampleRate() * 60.0 /
+                                   (static_cast<double>(bpm) * song_->rowsPerBeat);
+            samplesUntilRow_ += samplesPerRow;
+        }
+
+        size_t chunk = std::min(frameCount - done,
+                                static_cast<size_t>(std::ceil(samplesUntilRow_)));
+        if (buffer) {
+            synth.render(buffer + done, chunk);
+        }
+        done += chunk;
+        position_ += chunk;
+        samplesUntilRow_ -= static_cast<double>(chunk);
+    }
+}
+
+void Sequencer::applyRow(SynthEngine& synth) {
+    const std::vector<uint8_t>& order = song_->tiers[tier_].order;
+    const PatternCell* cells = song_->row(order[orderIndex_ % order.size()], row_);
+
+    for (int voice = 0; voice < SynthEngine::VOICE_COUNT; ++voice) {
+        const PatternCell& cell = cells[voice];
+        SynthVoice& target = synth.voice(voice);
+
+        if (cell.note == PatternCell::NOTE_OFF) {
+            target.enabled = false;
+            emit(NoteEventType::NOTE_OFF, voice, 0, 0, 0);
+        } else if (cell.note != PatternCell::NOTE_NONE) {
+            float frequency = noteFrequency(cell.note);
+            target.frequency = voice == 3 ? frequency * NOISE_CLOCK_RATIO : frequency;
+            target.enabled = true;
+            emit(NoteEventType::NOTE_ON, voice, cell.note, cell.volume, 0);
+        }
+        if (cell.volume != PatternCell::VOLUME_KEEP) {
+            target.volume = VOICE_GAIN[voice] * cell.volume / 15.0f;
+            if (cell.note == PatternCell::NOTE_NONE || cell.note == PatternCell::NOTE_OFF) {
+                emit(NoteEventType::VOLUME, voice, 0, cell.volume, 0);
+            }
+        }
+    }
+}
+
+void Sequencer::advanceRow() {
+    if (++row_ < song_->rowsPerPattern) {
+        return;
+    }
+    // The next pattern comes from whichever tier is current now
+    row_ = 0;
+    orderIndex_ = (orderIndex_ + 1) % song_->tiers[tier_].order.size();
+}
+
+void Sequencer::emit(NoteEventType type, int voice, uint8_t note, uint8_t volume, uint32_t value) {
+    if (!eventCallback_) {
+        return;
+    }
+    NoteEvent event;
+    event.frame = position_;
+    event.type = type;
+    event.voice = static_cast<uint8_t>(voice);
+    event.note = note;
+    event.volume = volume;
+    event.value = value;
+    eventCallback_(eventUserdata_, event);
+}
+
+} // namespace devescape
@@ -0,0 +1,21 @@
+#include "framework/SessionArena.h"
+
+namespace devescape {
+
+SessionArena::SessionArena(std::size_t initialBytes)
+    : initialBuffer_(new std::byte[initialBytes])
+    , initialBytes_(initialBytes)
+    , monotonic_(initialBuffer_.get(), initialBytes_, std::pmr::new_delete_resource())
+    , pool_(&monotonic_) {
+}
+
+SessionArena::~SessionArena() = default;
+
+void SessionArena::release() {
+    // The pool hands its chunks back to the monotonic resource, which only
+    // frees its overflow blocks; the initial buffer is kept for the next session.
+    pool_.release();
+    monotonic_.release();
+}
+
+} // namespace devescape
@@ -0,0 +1,145 @@
+#include "framework/SessionRecorder.h"
+#include <iostream>
+
+namespace devescape {
+
+namespace {
+
+constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+
+} // namespace
+
+uint64_t recording::hashState(const std::string& state) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : state) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+SessionRecorder::SessionRecorder()
+    : lastDeltaTicks_(0)
+    , frames_(0) {
+}
+
+SessionRecorder::~SessionRecorder() {
+    if (out_.is_open()) {
+        flush();
+        out_.close();
+    }
+}
+
+bool SessionRecorder::open(const std::string& path, const RecordingHeader& header) {
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        std::cerr << "Cannot write recording " << path << std::endl;
+        return false;
+    }
+
+    buffer_.clear();
+    buffer_.reserve(FLUSH_THRESHOLD * 2);
+    lastDeltaTicks_ = 0;
+    frames_ = 0;
+
+    buffer_.append(recording::MAGIC, sizeof(recording::MAGIC));
+    writeString(header.pluginName);
+    writeVarint(header.pluginVersion);
+    writeString(header.roomVersion);
+    writeVarint(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        header.wallStart.time_since_epoch()).count()));
+    writeString(header.initialState);
+    flush();
+    return true;
+}
+
+void SessionRecorder::recordFrame(ClockSource::duration delta, Span<const std::string> commands) {
+    if (!out_.is_open()) {
+        return;
+    }
+    writeRecord(recording::RECORD_FRAME, commands.size());
+    writeDelta(delta);
+    for (const std::string& command : commands) {
+        writeString(command);
+    }
+    frames_++;
+    if (buffer_.size() >= FLUSH_THRESHOLD) {
+        flush();
+    }
+}
+
+void SessionRecorder::recordTimeoutFrame(ClockSource::duration delta) {
+    if (!out_.is_open()) {
+        return;
+    }
+    writeRecord(recording::RECORD_TIMEOUT_FRAME, 0);
+    writeDelta(delta);
+    frames_++;
+}
+
+void SessionRecorder::recordReload() {
+    if (out_.is_open()) {
+        writeRecord(recording::RECORD_RELOAD, 0);
+    }
+}
+
+void SessionRecorder::recordCheckpoint(const std::string& state) {
+    if (!out_.is_open()) {
+        return;
+    }
+    writeRecord(recording::RECORD_CHECKPOINT, 0);
+    writeState(state);
+    flush();
+}
+
+void SessionRecorder::close(const std::string& finalState) {
+    if (!out_.is_open()) {
+        return;
+    }
+    writeRecord(recording::RECORD_END, 0);
+    writeState(finalState);
+    flush();
+    out_.close();
+}
+
+void SessionRecorder::writeRecord(uint32_t kind, uint64_t count) {
+    writeVarint((count << recording::KIND_BITS) | kind);
+}
+
+void SessionRecorder::writeVarint(uint64_t value) {
+    while (value >= 0x80) {
+        buffer_.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer_.push_back(static_cast<char>(value));
+}
+
+void SessionRecorder::writeString(const std::string& value) {
+    writeVarint(value.size());
+    buffer_.append(value);
+}
+
+void SessionRecorder::writeDelta(ClockSource::duration delta) {
+    // Stored in clock ticks rather than float seconds so the replayed
+    // deltaTime is bit-identical
+    int64_t ticks = delta.count();
+    int64_t difference = ticks - lastDeltaTicks_;
+    lastDeltaTicks_ = ticks;
+    writeVarint((static_cast<uint64_t>(difference) << 1) ^ static_cast<uint64_t>(difference >> 63));
+}
+
+void SessionRecorder::writeState(const std::string& state) {
+    uint64_t hash = recording::hashState(state);
+    for (int i = 0; i < 8; ++i) {
+        buffer_.push_back(static_cast<char>(hash >> (i * 8)));
+    }
+    writeVarint(state.size());
+}
+
+void SessionRecorder::flush() {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    out_.flush();
+    buffer_.clear();
+}
+
+} // namespace devescape
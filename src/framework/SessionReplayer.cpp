@@ -0,0 +1,275 @@
+#include "framework/SessionReplayer.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace devescape {
+
+namespace {
+
+// Bounds-checked cursor over the loaded recording; reads past the end
+// clear ok instead of throwing
+struct RecordingReader {
+    const std::string& data;
+    size_t pos;
+    bool ok = true;
+
+    bool atEnd() const { return pos >= data.size(); }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= data.size()) {
+                ok = false;
+                return 0;
+            }
+            uint8_t byte = static_cast<uint8_t>(data[pos++]);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    void string(std::string& out) {
+        uint64_t length = varint();
+        if (!ok || length > data.size() - pos) {
+            ok = false;
+            return;
+        }
+        out.assign(data, pos, length);
+        pos += length;
+    }
+
+    void skipString() {
+        uint64_t length = varint();
+        if (!ok || length > data.size() - pos) {
+            ok = false;
+            return;
+        }
+        pos += length;
+    }
+
+    uint64_t fixed64() {
+        if (data.size() - pos < 8) {
+            ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(data[pos++])) << (i * 8);
+        }
+        return value;
+    }
+
+    // Frame deltas are zigzag-encoded differences from the previous frame
+    ClockSource::duration delta(int64_t& lastTicks) {
+        uint64_t zigzag = varint();
+        int64_t difference = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+        lastTicks += difference;
+        return ClockSource::duration(lastTicks);
+    }
+};
+
+} // namespace
+
+SessionReplayer::SessionReplayer()
+    : recordsOffset_(0)
+    , frameCount_(0) {
+}
+
+bool SessionReplayer::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Cannot open recording " << path << std::endl;
+        return false;
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    data_ = contents.str();
+
+    if (data_.size() < sizeof(recording::MAGIC) ||
+        std::memcmp(data_.data(), recording::MAGIC, sizeof(recording::MAGIC)) != 0) {
+        std::cerr << path << " is not a session recording" << std::endl;
+        return false;
+    }
+
+    RecordingReader reader{data_, sizeof(recording::MAGIC)};
+    reader.string(header_.pluginName);
+    header_.pluginVersion = static_cast<uint32_t>(reader.varint());
+    reader.string(header_.roomVersion);
+    header_.wallStart = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::nanoseconds(static_cast<int64_t>(reader.varint()))));
+    reader.string(header_.initialState);
+    recordsOffset_ = reader.pos;
+
+    // Validate the whole file up front so a replay never stops half way on
+    // a damaged record. A missing end record only means the session was cut
+    // short, which replays fine up to there.
+    frameCount_ = 0;
+    int64_t lastTicks = 0;
+    while (reader.ok && !reader.atEnd()) {
+        uint64_t head = reader.varint();
+        uint64_t count = head >> recording::KIND_BITS;
+        switch (head & ((1u << recording::KIND_BITS) - 1)) {
+            case recording::RECORD_FRAME:
+            case recording::RECORD_TIMEOUT_FRAME:
+                reader.delta(lastTicks);
+                for (uint64_t i = 0; i < count && reader.ok; ++i) {
+                    reader.skipString();
+                }
+                frameCount_++;
+                break;
+            case recording::RECORD_CHECKPOINT:
+            case recording::RECORD_END:
+                reader.fixed64();
+                reader.varint();
+                break;
+            case recording::RECORD_RELOAD:
+                break;
+            default:
+                reader.ok = false;
+                break;
+        }
+    }
+
+    if (!reader.ok) {
+        std::cerr << "Recording " << path << " is damaged at byte " << reader.pos << std::endl;
+        return false;
+    }
+    return true;
+}
+
+ReplayReport SessionReplayer::replay(IEscapeRoomV2& room, ReplaySpeed speed, bool keepGoing,
+                                     ClockSource& clock) const {
+    using namespace std::chrono;
+
+    ReplayReport report;
+    if (room.getVersion() != header_.roomVersion) {
+        std::cerr << "Replaying a recording of " << header_.pluginName << " " << header_.roomVersion
+                  << " against " << room.getVersion() << std::endl;
+    }
+
+    if (!header_.initialState.empty() && !room.deserializeState(header_.initialState)) {
+        report.error = "room rejected the recorded initial state";
+        return report;
+    }
+
+    ClockSource::Mode previousMode = clock.getMode();
+    double previousScale = clock.getScale();
+    clock.setVirtualAt(header_.wallStart);
+
+    RecordingReader reader{data_, recordsOffset_};
+    std::vector<std::string> commands;
+    std::pmr::vector<ProcessResult> results;
+    int64_t lastTicks = 0;
+    ClockSource::duration sessionTime(0);
+    float pendingUpdateSeconds = 0.0f;
+    float nextWakeupSeconds = 0.0f;
+    bool stopped = false;
+
+    auto started = steady_clock::now();
+
+    while (!stopped && !reader.atEnd()) {
+        uint64_t head = reader.varint();
+        size_t count = static_cast<size_t>(head >> recording::KIND_BITS);
+        uint32_t kind = static_cast<uint32_t>(head & ((1u << recording::KIND_BITS) - 1));
+
+        switch (kind) {
+            case recording::RECORD_FRAME:
+            case recording::RECORD_TIMEOUT_FRAME: {
+                ClockSource::duration delta = reader.delta(lastTicks);
+                sessionTime += delta;
+                clock.advance(delta);
+                if (commands.size() < count) {
+                    commands.resize(count);
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    reader.string(commands[i]);
+                }
+                if (speed == ReplaySpeed::RECORDED) {
+                    std::this_thread::sleep_until(started + sessionTime);
+                }
+                report.frames++;
+
+                // Same order as the game loop: timeout, inputs, update
+                if (kind == recording::RECORD_TIMEOUT_FRAME) {
+                    room.onSessionTimeout();
+                    report.timedOut = true;
+                    break;
+                }
+
+                if (count > 0) {
+                    results.clear();
+                    room.processInputs(Span<const std::string>(commands.data(), count), results);
+                    report.commands += count;
+                    bool sessionEnded = false;
+                    for (const auto& result : results) {
+                        sessionEnded = sessionEnded || result.sessionEnded;
+                    }
+                    if (sessionEnded) {
+                        report.sessionEnded = true;
+                        break;
+                    }
+                }
+
+                pendingUpdateSeconds += duration<float>(delta).count();
+                if (count > 0 || pendingUpdateSeconds >= nextWakeupSeconds) {
+                    UpdateHint hint = room.updateFrame(pendingUpdateSeconds);
+                    pendingUpdateSeconds = 0.0f;
+                    nextWakeupSeconds = hint.nextWakeupSeconds;
+                }
+                break;
+            }
+            case recording::RECORD_RELOAD:
+                nextWakeupSeconds = 0.0f;
+                break;
+            case recording::RECORD_CHECKPOINT:
+            case recording::RECORD_END: {
+                uint64_t hash = reader.fixed64();
+                uint64_t length = reader.varint();
+                std::string state = room.serializeState();
+                if (state.size() == length && recording::hashState(state) == hash) {
+                    report.checkpointsVerified++;
+                } else {
+                    report.checkpointsMismatched++;
+                    if (report.firstMismatchFrame < 0) {
+                        report.firstMismatchFrame = static_cast<int64_t>(report.frames);
+                        std::cerr << "State diverged from the recording after frame " << report.frames
+                                  << std::endl;
+                    }
+                    stopped = !keepGoing;
+                }
+                report.reachedEnd = kind == recording::RECORD_END;
+                break;
+            }
+            default:
+                reader.ok = false;
+                break;
+        }
+
+        if (!reader.ok) {
+            report.error = "damaged record";
+            break;
+        }
+    }
+
+    if (previousMode == ClockSource::Mode::REAL) {
+        clock.setReal();
+    } else if (previousMode == ClockSource::Mode::SCALED) {
+        clock.setScaled(previousScale);
+    }
+
+    report.realSeconds = duration<double>(steady_clock::now() - started).count();
+    report.sessionSeconds = duration<double>(sessionTime).count();
+    return report;
+}
+
+} // namespace devescape
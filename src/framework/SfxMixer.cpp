@@ -0,0 +1,297 @@
+#include "framework/SfxMixer.h"
+#include "framework/Sequencer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace devescape {
+
+namespace {
+
+// Pitch and volume slides update this often
+constexpr size_t CONTROL_FRAMES = 32;
+
+// Same limits as SynthEngine
+constexpr double MAX_TONE_INCREMENT = 0.49;
+
+// "a" or "a->b"
+bool splitSlide(const std::string& token, std::string& from, std::string& to) {
+    size_t arrow = token.find("->");
+    from = token.substr(0, arrow);
+    to = arrow == std::string::npos ? from : token.substr(arrow + 2);
+    return !from.empty() && !to.empty();
+}
+
+bool parseFrequency(const std::string& text, Waveform waveform, float& frequency) {
+    uint8_t note = 0;
+    if (Sequencer::parseNote(text, note)) {
+        frequency = Sequencer::noteFrequency(note);
+        if (waveform == Waveform::NOISE) {
+            frequency *= Sequencer::NOISE_CLOCK_RATIO;
+        }
+        return true;
+    }
+    char* end = nullptr;
+    frequency = std::strtof(text.c_str(), &end);
+    return *end == '\0' && end != text.c_str() && frequency > 0.0f;
+}
+
+bool parseVolume(const std::string& text, float& volume) {
+    char* end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || end == text.c_str() || value < 0 || value > 15) {
+        return false;
+    }
+    volume = value / 15.0f;
+    return true;
+}
+
+} // namespace
+
+SfxMixer::SfxMixer(int sampleRate, const synth::KernelTable& kernels)
+    : started_(0)
+    , sampleRate_(sampleRate)
+    , gain_(0.25f)
+    , policy_(StealPolicy::LOWEST_PRIORITY)
+    , kernels_(&kernels)
+    , stolen_(0)
+    , dropped_(0) {
+}
+
+bool SfxMixer::loadEffects(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::vector<SfxStep> steps;
+    std::vector<SfxEffect> effects;
+    std::string line;
+    int lineNumber = 0;
+
+    auto fail = [&](const std::string& message) {
+        std::cerr << path << ":" << lineNumber << ": " << message << std::endl;
+        return false;
+    };
+
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream in(Sequencer::stripComment(line));
+        std::string first;
+        if (!(in >> first)) {
+            continue;
+        }
+
+        if (first == "effect") {
+            SfxEffect effect;
+            if (!(in >> effect.name >> effect.priority)) {
+                return fail("effect needs a name and a priority");
+            }
+            for (const SfxEffect& other : effects) {
+                if (other.name == effect.name) {
+                    return fail("effect '" + effect.name + "' defined twice");
+                }
+            }
+            effect.firstStep = steps.size();
+            effects.push_back(effect);
+            continue;
+        }
+        if (effects.empty()) {
+            return fail("step before the first effect");
+        }
+
+        SfxStep step;
+        std::string wave = first.substr(0, first.find(':'));
+        if (wave == "square") {
+            step.waveform = Waveform::SQUARE;
+        } else if (wave == "triangle") {
+            step.waveform = Waveform::TRIANGLE;
+        } else if (wave == "noise") {
+            step.waveform = Waveform::NOISE;
+        } else {
+            return fail("unknown waveform '" + wave + "'");
+        }
+        if (wave.size() < first.size()) {
+            step.duty = std::strtof(first.c_str() + wave.size() + 1, nullptr);
+            if (step.duty <= 0.0f || step.duty >= 1.0f) {
+                return fail("duty must be between 0 and 1");
+            }
+        }
+
+        std::string pitch, volume, from, to;
+        int milliseconds = 0;
+        if (!(in >> pitch >> volume >> milliseconds) || milliseconds <= 0) {
+            return fail("step needs a waveform, pitch, volume and length in ms");
+        }
+        if (!splitSlide(pitch, from, to) ||
+            !parseFrequency(from, step.waveform, step.startFrequency) ||
+            !parseFrequency(to, step.waveform, step.endFrequency)) {
+            return fail("bad pitch '" + pitch + "'");
+        }
+        if (!splitSlide(volume, from, to) || !parseVolume(from, step.startVolume) ||
+            !parseVolume(to, step.endVolume)) {
+            return fail("bad volume '" + volume + "'");
+        }
+        step.seconds = milliseconds / 1000.0f;
+        steps.push_back(step);
+        effects.back().stepCount++;
+    }
+
+    for (const SfxEffect& effect : effects) {
+        if (effect.stepCount == 0) {
+            std::cerr << path << ": effect '" << effect.name << "' has no steps" << std::endl;
+            return false;
+        }
+    }
+
+    // Sorted for findEffect(); steps stay where they are
+    std::sort(effects.begin(), effects.end(),
+              [](const SfxEffect& a, const SfxEffect& b) { return a.name < b.name; });
+    steps_ = std::move(steps);
+    effects_ = std::move(effects);
+    return true;
+}
+
+int SfxMixer::findEffect(std::string_view name) const {
+    auto it = std::lower_bound(effects_.begin(), effects_.end(), name,
+                               [](const SfxEffect& effect, std::string_view key) {
+                                   return std::string_view(effect.name) < key;
+                               });
+    if (it == effects_.end() || it->name != name) {
+        return NO_EFFECT;
+    }
+    return static_cast<int>(it - effects_.begin());
+}
+
+bool SfxMixer::trigger(int effect) {
+    if (effect < 0 || effect >= static_cast<int>(effects_.size())) {
+        return false;
+    }
+    if (!triggers_.push(effect)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void SfxMixer::mix(float* buffer, size_t frameCount) {
+    int32_t effect = 0;
+    while (triggers_.pop(effect)) {
+        start(effect);
+    }
+
+    for (Voice& voice : voices_) {
+        if (voice.effect != NO_EFFECT) {
+            renderVoice(voice, buffer, frameCount);
+        }
+    }
+}
+
+bool SfxMixer::popTrigger(int& effect) {
+    int32_t queued = 0;
+    if (!triggers_.pop(queued)) {
+        return false;
+    }
+    effect = queued;
+    return true;
+}
+
+int SfxMixer::getActiveVoices() const {
+    int active = 0;
+    for (const Voice& voice : voices_) {
+        active += voice.effect != NO_EFFECT ? 1 : 0;
+    }
+    return active;
+}
+
+void SfxMixer::start(int effect) {
+    const SfxEffect& program = effects_[effect];
+
+    Voice* target = nullptr;
+    for (Voice& voice : voices_) {
+        if (voice.effect == NO_EFFECT) {
+            target = &voice;
+            break;
+        }
+    }
+
+    if (!target) {
+        for (Voice& voice : voices_) {
+            if (!target) {
+                target = &voice;
+            } else if (policy_ == StealPolicy::OLDEST || voice.priority == target->priority) {
+                target = voice.startedAt < target->startedAt ? &voice : target;
+            } else if (voice.priority < target->priority) {
+                target = &voice;
+            }
+        }
+        if (policy_ == StealPolicy::LOWEST_PRIORITY && target->priority > program.priority) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        stolen_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    target->effect = effect;
+    target->priority = program.priority;
+    target->startedAt = started_++;
+    target->phase = 0.0;
+    enterStep(*target, program.firstStep);
+}
+
+void SfxMixer::enterStep(Voice& voice, size_t step) {
+    voice.step = step;
+    voice.stepFrame = 0;
+    voice.stepFrames = static_cast<uint32_t>(
+        std::max(1L, std::lround(steps_[step].seconds * static_cast<float>(sampleRate_))));
+}
+
+void SfxMixer::renderVoice(Voice& voice, float* buffer, size_t frameCount) {
+    size_t done = 0;
+    while (done < frameCount) {
+        const SfxStep& step = steps_[voice.step];
+        size_t chunk = std::min({frameCount - done, CONTROL_FRAMES,
+                                 static_cast<size_t>(voice.stepFrames - voice.stepFrame)});
+
+        // Slides are sampled at the middle of each control chunk
+        float t = (voice.stepFrame + 0.5f * chunk) / static_cast<float>(voice.stepFrames);
+        double frequency = step.startFrequency *
+                           std::pow(static_cast<double>(step.endFrequency) / step.startFrequency, t);
+        double increment = frequency / sampleRate_;
+        float gain = gain_ * (step.startVolume + (step.endVolume - step.startVolume) * t);
+
+        float* out = buffer + done;
+        switch (step.waveform) {
+            case Waveform::SQUARE:
+                voice.phase = kernels_->addSquare(out, chunk, voice.phase,
+                                                  std::min(increment, MAX_TONE_INCREMENT),
+                                                  step.duty, gain);
+                break;
+            case Waveform::TRIANGLE:
+                voice.phase = kernels_->addTriangle(out, chunk, voice.phase,
+                                                    std::min(increment, MAX_TONE_INCREMENT), gain);
+                break;
+            case Waveform::NOISE:
+                voice.phase = synth::addNoise(out, chunk, voice.phase, std::min(increment, 1.0),
+                                              voice.lfsr, gain);
+                break;
+        }
+
+        done += chunk;
+        voice.stepFrame += static_cast<uint32_t>(chunk);
+        if (voice.stepFrame == voice.stepFrames) {
+            const SfxEffect& effect = effects_[voice.effect];
+            if (voice.step + 1 < effect.firstStep + effect.stepCount) {
+                enterStep(voice, voice.step + 1);
+            } else {
+                voice.effect = NO_EFFECT;
+                return;
+            }
+        }
+    }
+}
+
+} // namespace devescape
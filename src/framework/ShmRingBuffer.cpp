@@ -0,0 +1,175 @@
+#include "framework/ShmRingBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace devescape {
+
+namespace {
+
+struct FrameHeader {
+    uint32_t type;
+    uint32_t length;
+};
+
+// Roughly a few microseconds of polling before the reader parks itself;
+// request/response traffic normally lands inside this window. Spinning on a
+// single CPU only delays the peer, so go straight to the futex there.
+int spinIterations() {
+    static const int iterations = std::thread::hardware_concurrency() > 1 ? 4000 : 0;
+    return iterations;
+}
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+#ifdef __linux__
+// Shared (not FUTEX_PRIVATE) futex - the waiter and waker are different processes
+void futexWait(std::atomic<uint32_t>* word, uint32_t expected, std::chrono::microseconds timeout) {
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000);
+    ts.tv_nsec = static_cast<long>((timeout.count() % 1000000) * 1000);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+void futexWake(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+#endif
+
+} // namespace
+
+size_t ShmRingBuffer::requiredBytes(size_t capacity) {
+    return sizeof(Header) + capacity;
+}
+
+ShmRingBuffer ShmRingBuffer::create(void* memory, size_t capacity) {
+    ShmRingBuffer ring;
+    ring.header_ = new (memory) Header();
+    ring.header_->capacity = capacity;
+    ring.data_ = static_cast<char*>(memory) + sizeof(Header);
+    ring.capacity_ = capacity;
+    ring.reset();
+    return ring;
+}
+
+ShmRingBuffer ShmRingBuffer::attach(void* memory) {
+    ShmRingBuffer ring;
+    ring.header_ = static_cast<Header*>(memory);
+    ring.data_ = static_cast<char*>(memory) + sizeof(Header);
+    ring.capacity_ = static_cast<size_t>(ring.header_->capacity);
+    return ring;
+}
+
+void ShmRingBuffer::reset() {
+    header_->head.store(0, std::memory_order_relaxed);
+    header_->tail.store(0, std::memory_order_relaxed);
+    header_->wakeSequence.store(0, std::memory_order_relaxed);
+    header_->sleepers.store(0, std::memory_order_relaxed);
+}
+
+void ShmRingBuffer::copyIn(uint64_t position, const void* src, size_t length) {
+    size_t offset = position & (capacity_ - 1);
+    size_t first = std::min(length, capacity_ - offset);
+    std::memcpy(data_ + offset, src, first);
+    std::memcpy(data_, static_cast<const char*>(src) + first, length - first);
+}
+
+void ShmRingBuffer::copyOut(uint64_t position, void* dst, size_t length) const {
+    size_t offset = position & (capacity_ - 1);
+    size_t first = std::min(length, capacity_ - offset);
+    std::memcpy(dst, data_ + offset, first);
+    std::memcpy(static_cast<char*>(dst) + first, data_, length - first);
+}
+
+bool ShmRingBuffer::write(uint32_t type, const void* payload, uint32_t length) {
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    uint64_t tail = header_->tail.load(std::memory_order_acquire);
+    size_t frameSize = sizeof(FrameHeader) + length;
+
+    if (length > maxMessageSize() || capacity_ - (head - tail) < frameSize) {
+        return false;
+    }
+
+    FrameHeader frame{type, length};
+    copyIn(head, &frame, sizeof(frame));
+    copyIn(head + sizeof(frame), payload, length);
+    header_->head.store(head + frameSize, std::memory_order_release);
+
+    notify();
+    return true;
+}
+
+bool ShmRingBuffer::read(uint32_t& type, std::vector<char>& payload) {
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    uint64_t head = header_->head.load(std::memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+
+    FrameHeader frame;
+    copyOut(tail, &frame, sizeof(frame));
+    payload.resize(frame.length);
+    copyOut(tail + sizeof(frame), payload.data(), frame.length);
+    type = frame.type;
+
+    header_->tail.store(tail + sizeof(frame) + frame.length, std::memory_order_release);
+    return true;
+}
+
+void ShmRingBuffer::notify() {
+    header_->wakeSequence.fetch_add(1, std::memory_order_seq_cst);
+#ifdef __linux__
+    if (header_->sleepers.load(std::memory_order_seq_cst) > 0) {
+        futexWake(&header_->wakeSequence);
+    }
+#endif
+}
+
+bool ShmRingBuffer::waitReadable(std::chrono::microseconds timeout) {
+    auto isReadable = [this]() {
+        return header_->head.load(std::memory_order_acquire) !=
+               header_->tail.load(std::memory_order_relaxed);
+    };
+
+    for (int i = 0, spins = spinIterations(); i < spins; ++i) {
+        if (isReadable()) return true;
+        cpuRelax();
+    }
+
+#ifdef __linux__
+    // Register as a sleeper, then re-check: a producer that publishes after
+    // the check bumps wakeSequence, so the futex wait returns immediately.
+    header_->sleepers.fetch_add(1, std::memory_order_seq_cst);
+    uint32_t sequence = header_->wakeSequence.load(std::memory_order_seq_cst);
+    if (!isReadable()) {
+        futexWait(&header_->wakeSequence, sequence, timeout);
+    }
+    header_->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+#else
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!isReadable() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+#endif
+    return isReadable();
+}
+
+} // namespace devescape
@@ -12,6 +12,30 @@ namespace fs = std::filesystem;
 
 namespace devescape {
 
+namespace {
+
+// nlohmann::json only understands std::string; pmr strings are copied across.
+std::string toStdString(const std::pmr::string& s) {
+    return std::string(s.data(), s.size());
+}
+
+json toJson(const std::pmr::vector<std::pmr::string>& values) {
+    json array = json::array();
+    for (const auto& value : values) {
+        array.push_back(toStdString(value));
+    }
+    return array;
+}
+
+void fromJson(const json& array, std::pmr::vector<std::pmr::string>& values) {
+    values.clear();
+    for (const auto& value : array) {
+        values.emplace_back(value.get_ref<const std::string&>());
+    }
+}
+
+} // namespace
+
 StateManager::StateManager(const std::string& checkpointDir) 
     : checkpointDirectory_(checkpointDir) {
     fs::create_directories(checkpointDir);
@@ -74,22 +98,28 @@ std::string StateManager::serializeSession(const GameSession& session) const {
     // Room state
     json puzzlesJson;
     for (const auto& [id, puzzle] : session.currentRoomState.puzzles) {
-        puzzlesJson[id] = {
+        puzzlesJson[toStdString(id)] = {
             {"status", puzzle.solved ? "solved" : (puzzle.locked ? "locked" : "in_progress")},
             {"completion_percent", puzzle.completionPercent},
             {"hints_used", puzzle.hintsUsed},
             {"wrong_attempts", puzzle.wrongAttempts},
             {"time_spent_seconds", puzzle.timeSpentSeconds},
-            {"player_answer", puzzle.playerAnswer},
-            {"correct_answer", puzzle.correctAnswer}
+            {"player_answer", toStdString(puzzle.playerAnswer)},
+            {"correct_answer", toStdString(puzzle.correctAnswer)}
         };
     }
 
+    json inventoryJson = json::object();
+    for (const auto& [item, value] : session.currentRoomState.inventory) {
+        inventoryJson[toStdString(item)] = toStdString(value);
+    }
+
     j["room_state"] = {
         {"puzzles", puzzlesJson},
-        {"inventory", session.currentRoomState.inventory},
-        {"discovered_clues", session.currentRoomState.discoveredClues},
-        {"event_log", session.currentRoomState.eventLog}
+        {"inventory", inventoryJson},
+        {"discovered_clues", toJson(session.currentRoomState.discoveredClues)},
+        {"event_log", toJson(session.currentRoomState.eventLog)},
+        {"snapshot", session.roomSnapshot}
     };
 
     return j.dump(2);
@@ -111,21 +141,25 @@ bool StateManager::deserializeSession(const std::string& jsonData, GameSession&
         for (auto& [id, puzzleJson] : j["room_state"]["puzzles"].items()) {
             PuzzleState puzzle;
             puzzle.id = id;
-            std::string status = puzzleJson["status"];
+            const std::string& status = puzzleJson["status"].get_ref<const std::string&>();
             puzzle.solved = (status == "solved");
             puzzle.locked = (status == "locked");
             puzzle.completionPercent = puzzleJson["completion_percent"];
             puzzle.hintsUsed = puzzleJson["hints_used"];
             puzzle.wrongAttempts = puzzleJson["wrong_attempts"];
             puzzle.timeSpentSeconds = puzzleJson["time_spent_seconds"];
-            puzzle.playerAnswer = puzzleJson["player_answer"];
-            puzzle.correctAnswer = puzzleJson["correct_answer"];
-            session.currentRoomState.puzzles[id] = puzzle;
+            puzzle.playerAnswer = puzzleJson["player_answer"].get_ref<const std::string&>();
+            puzzle.correctAnswer = puzzleJson["correct_answer"].get_ref<const std::string&>();
+            session.currentRoomState.puzzles.insert_or_assign(std::pmr::string(id), puzzle);
         }
 
-        session.currentRoomState.inventory = j["room_state"]["inventory"].get<std::map<std::string, std::string>>();
-        session.currentRoomState.discoveredClues = j["room_state"]["discovered_clues"].get<std::vector<std::string>>();
-        session.currentRoomState.eventLog = j["room_state"]["event_log"].get<std::vector<std::string>>();
+        session.currentRoomState.inventory.clear();
+        for (auto& [item, value] : j["room_state"]["inventory"].items()) {
+            session.currentRoomState.inventory.emplace(item, value.get_ref<const std::string&>());
+        }
+        fromJson(j["room_state"]["discovered_clues"], session.currentRoomState.discoveredClues);
+        fromJson(j["room_state"]["event_log"], session.currentRoomState.eventLog);
+        session.roomSnapshot = j["room_state"].value("snapshot", "");
 
         return true;
     } catch (const std::exception&) {
@@ -0,0 +1,52 @@
+#include "framework/SynthEngine.h"
+#include <algorithm>
+
+namespace devescape {
+
+namespace {
+
+// Band-limiting residuals assume less than half a cycle per sample
+constexpr double MAX_TONE_INCREMENT = 0.49;
+
+} // namespace
+
+SynthEngine::SynthEngine(int sampleRate, const synth::KernelTable& kernels)
+    : sampleRate_(sampleRate)
+    , masterVolume_(0.3f)
+    , kernels_(&kernels) {
+    voices_[0].waveform = Waveform::SQUARE;
+    voices_[1].waveform = Waveform::SQUARE;
+    voices_[2].waveform = Waveform::TRIANGLE;
+    voices_[3].waveform = Waveform::NOISE;
+}
+
+void SynthEngine::render(float* buffer, size_t frameCount) {
+    std::fill(buffer, buffer + frameCount, 0.0f);
+
+    for (SynthVoice& voice : voices_) {
+        if (!voice.enabled || voice.volume <= 0.0f || voice.frequency <= 0.0f) {
+            continue;
+        }
+
+        double increment = static_cast<double>(voice.frequency) / sampleRate_;
+        float gain = voice.volume * masterVolume_;
+
+        switch (voice.waveform) {
+            case Waveform::SQUARE:
+                voice.phase = kernels_->addSquare(buffer, frameCount, voice.phase,
+                                                  std::min(increment, MAX_TONE_INCREMENT),
+                                                  voice.duty, gain);
+                break;
+            case Waveform::TRIANGLE:
+                voice.phase = kernels_->addTriangle(buffer, frameCount, voice.phase,
+                                                    std::min(increment, MAX_TONE_INCREMENT), gain);
+                break;
+            case Waveform::NOISE:
+                voice.phase = synth::addNoise(buffer, frameCount, voice.phase,
+                                              std::min(increment, 1.0), voice.lfsr, gain);
+                break;
+        }
+    }
+}
+
+} // namespace devescape
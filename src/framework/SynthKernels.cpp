@@ -0,0 +1,248 @@
+#include "framework/SynthKernels.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define DEVESCAPE_SYNTH_SSE 1
+  #include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <immintrin.h>
+  #include <intrin.h>
+#endif
+
+namespace devescape {
+namespace synth {
+
+namespace {
+
+double wrap(double phase) {
+    return phase - std::floor(phase);
+}
+
+// PolyBLEP residual of a unit step at t = 0 (t in cycles)
+float polyBlep(float t, float dt) {
+    if (t < dt) {
+        float x = t / dt;
+        return x + x - x * x - 1.0f;
+    }
+    if (t > 1.0f - dt) {
+        float x = (t - 1.0f) / dt;
+        return x * x + x + x + 1.0f;
+    }
+    return 0.0f;
+}
+
+// PolyBLAMP residual of a unit slope change at t = 0
+float polyBlamp(float t, float dt) {
+    if (t < dt) {
+        float x = t / dt - 1.0f;
+        return -x * x * x / 3.0f;
+    }
+    if (t > 1.0f - dt) {
+        float x = (t - 1.0f) / dt + 1.0f;
+        return x * x * x / 3.0f;
+    }
+    return 0.0f;
+}
+
+double scalarSquare(float* out, size_t count, double phase, double increment, float duty,
+                    float gain) {
+    float dt = static_cast<float>(increment);
+    for (size_t i = 0; i < count; ++i) {
+        float t = static_cast<float>(phase);
+        float falling = t - duty;
+        falling += falling < 0.0f ? 1.0f : 0.0f;
+
+        float value = t < duty ? 1.0f : -1.0f;
+        value += polyBlep(t, dt) - polyBlep(falling, dt);
+        out[i] += gain * value;
+
+        phase += increment;
+        phase -= phase >= 1.0 ? 1.0 : 0.0;
+    }
+    return phase;
+}
+
+// Peaks at t = 0 (slope +4 to -4 per cycle) and troughs at t = 0.5
+double scalarTriangle(float* out, size_t count, double phase, double increment, float gain) {
+    float dt = static_cast<float>(increment);
+    float corner = 8.0f * dt;
+    for (size_t i = 0; i < count; ++i) {
+        float t = static_cast<float>(phase);
+        float trough = t + 0.5f;
+        trough -= trough >= 1.0f ? 1.0f : 0.0f;
+
+        float value = 4.0f * std::fabs(t - 0.5f) - 1.0f;
+        value += corner * (polyBlamp(trough, dt) - polyBlamp(t, dt));
+        out[i] += gain * value;
+
+        phase += increment;
+        phase -= phase >= 1.0 ? 1.0 : 0.0;
+    }
+    return phase;
+}
+
+const KernelTable SCALAR_KERNELS = {"scalar", scalarSquare, scalarTriangle};
+
+#if defined(DEVESCAPE_SYNTH_SSE)
+
+// Phases of the first four samples
+__m128 startPhases(double phase, double increment) {
+    float lanes[4];
+    for (int k = 0; k < 4; ++k) {
+        lanes[k] = static_cast<float>(wrap(phase + k * increment));
+        lanes[k] = lanes[k] >= 1.0f ? 0.0f : lanes[k];
+    }
+    return _mm_loadu_ps(lanes);
+}
+
+__m128 wrapOnce(__m128 t, __m128 one) {
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpge_ps(t, one), one));
+}
+
+__m128 polyBlep4(__m128 t, __m128 dt, __m128 invDt, __m128 one) {
+    __m128 x1 = _mm_mul_ps(t, invDt);
+    __m128 r1 = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(x1, x1), _mm_mul_ps(x1, x1)), one);
+    __m128 x2 = _mm_mul_ps(_mm_sub_ps(t, one), invDt);
+    __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x2, x2), _mm_add_ps(x2, x2)), one);
+    __m128 head = _mm_cmplt_ps(t, dt);
+    __m128 tail = _mm_cmpgt_ps(t, _mm_sub_ps(one, dt));
+    return _mm_or_ps(_mm_and_ps(head, r1), _mm_and_ps(tail, r2));
+}
+
+__m128 polyBlamp4(__m128 t, __m128 dt, __m128 invDt, __m128 one) {
+    const __m128 third = _mm_set1_ps(1.0f / 3.0f);
+    __m128 x1 = _mm_sub_ps(_mm_mul_ps(t, invDt), one);
+    __m128 r1 = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(x1, x1), x1), third));
+    __m128 x2 = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(t, one), invDt), one);
+    __m128 r2 = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(x2, x2), x2), third);
+    __m128 head = _mm_cmplt_ps(t, dt);
+    __m128 tail = _mm_cmpgt_ps(t, _mm_sub_ps(one, dt));
+    return _mm_or_ps(_mm_and_ps(head, r1), _mm_and_ps(tail, r2));
+}
+
+double sseSquare(float* out, size_t count, double phase, double increment, float duty,
+                 float gain) {
+    size_t blocks = count & ~size_t(3);
+    if (blocks > 0) {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 minusOne = _mm_set1_ps(-1.0f);
+        const __m128 dt = _mm_set1_ps(static_cast<float>(increment));
+        const __m128 invDt = _mm_set1_ps(static_cast<float>(1.0 / increment));
+        const __m128 dutyV = _mm_set1_ps(duty);
+        const __m128 gainV = _mm_set1_ps(gain);
+        const __m128 step = _mm_set1_ps(static_cast<float>(wrap(4.0 * increment)));
+
+        __m128 t = startPhases(phase, increment);
+        for (size_t i = 0; i < blocks; i += 4) {
+            __m128 high = _mm_cmplt_ps(t, dutyV);
+            __m128 value = _mm_or_ps(_mm_and_ps(high, one), _mm_andnot_ps(high, minusOne));
+            __m128 falling = _mm_sub_ps(t, dutyV);
+            falling = _mm_add_ps(falling, _mm_and_ps(_mm_cmplt_ps(falling, _mm_setzero_ps()), one));
+
+            value = _mm_add_ps(value, polyBlep4(t, dt, invDt, one));
+            value = _mm_sub_ps(value, polyBlep4(falling, dt, invDt, one));
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(value, gainV)));
+
+            t = wrapOnce(_mm_add_ps(t, step), one);
+        }
+        phase = wrap(phase + static_cast<double>(blocks) * increment);
+    }
+    return scalarSquare(out + blocks, count - blocks, phase, increment, duty, gain);
+}
+
+double sseTriangle(float* out, size_t count, double phase, double increment, float gain) {
+    size_t blocks = count & ~size_t(3);
+    if (blocks > 0) {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 four = _mm_set1_ps(4.0f);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        const __m128 dt = _mm_set1_ps(static_cast<float>(increment));
+        const __m128 invDt = _mm_set1_ps(static_cast<float>(1.0 / increment));
+        const __m128 corner = _mm_set1_ps(static_cast<float>(8.0 * increment));
+        const __m128 gainV = _mm_set1_ps(gain);
+        const __m128 step = _mm_set1_ps(static_cast<float>(wrap(4.0 * increment)));
+
+        __m128 t = startPhases(phase, increment);
+        for (size_t i = 0; i < blocks; i += 4) {
+            __m128 distance = _mm_andnot_ps(signMask, _mm_sub_ps(t, half));
+            __m128 value = _mm_sub_ps(_mm_mul_ps(four, distance), one);
+            __m128 trough = wrapOnce(_mm_add_ps(t, half), one);
+
+            __m128 residual = _mm_sub_ps(polyBlamp4(trough, dt, invDt, one),
+                                         polyBlamp4(t, dt, invDt, one));
+            value = _mm_add_ps(value, _mm_mul_ps(corner, residual));
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(value, gainV)));
+
+            t = wrapOnce(_mm_add_ps(t, step), one);
+        }
+        phase = wrap(phase + static_cast<double>(blocks) * increment);
+    }
+    return scalarTriangle(out + blocks, count - blocks, phase, increment, gain);
+}
+
+const KernelTable SSE_KERNELS = {"sse2", sseSquare, sseTriangle};
+
+#endif // DEVESCAPE_SYNTH_SSE
+
+} // namespace
+
+const KernelTable& scalarKernels() {
+    return SCALAR_KERNELS;
+}
+
+const KernelTable* sseKernels() {
+#if defined(DEVESCAPE_SYNTH_SSE)
+    return &SSE_KERNELS;
+#else
+    return nullptr;
+#endif
+}
+
+bool cpuSupportsAvx() {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("avx");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    // AVX in the CPU, and the OS saving the YMM registers
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+    return false;
+#endif
+}
+
+const KernelTable& bestKernels() {
+    static const KernelTable* best = []() {
+        if (cpuSupportsAvx() && avxKernels()) {
+            return avxKernels();
+        }
+        if (sseKernels()) {
+            return sseKernels();
+        }
+        return &SCALAR_KERNELS;
+    }();
+    return *best;
+}
+
+double addNoise(float* out, size_t count, double phase, double increment, uint32_t& lfsr,
+                float gain) {
+    float level = (lfsr & 1u) ? gain : -gain;
+    for (size_t i = 0; i < count; ++i) {
+        phase += increment;
+        if (phase >= 1.0) {
+            phase -= 1.0;
+            lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+            level = (lfsr & 1u) ? gain : -gain;
+        }
+        out[i] += level;
+    }
+    return phase;
+}
+
+} // namespace synth
+} // namespace devescape
@@ -0,0 +1,139 @@
+// Built with AVX enabled (see CMakeLists.txt) and only reached through
+// bestKernels() once the CPU has been checked, so it includes nothing with
+// inline functions that other translation units might share.
+#include "framework/SynthKernels.h"
+
+#if defined(__AVX__)
+  #include <immintrin.h>
+#endif
+
+namespace devescape {
+namespace synth {
+
+#if defined(__AVX__)
+
+namespace {
+
+// Phases stay small and non-negative, so truncation is floor
+double wrap(double phase) {
+    return phase - static_cast<double>(static_cast<long long>(phase));
+}
+
+__m256 startPhases(double phase, double increment) {
+    float lanes[8];
+    for (int k = 0; k < 8; ++k) {
+        lanes[k] = static_cast<float>(wrap(phase + k * increment));
+        lanes[k] = lanes[k] >= 1.0f ? 0.0f : lanes[k];
+    }
+    return _mm256_loadu_ps(lanes);
+}
+
+__m256 wrapOnce(__m256 t, __m256 one) {
+    return _mm256_sub_ps(t, _mm256_and_ps(_mm256_cmp_ps(t, one, _CMP_GE_OQ), one));
+}
+
+__m256 polyBlep8(__m256 t, __m256 dt, __m256 invDt, __m256 one) {
+    __m256 x1 = _mm256_mul_ps(t, invDt);
+    __m256 r1 = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(x1, x1), _mm256_mul_ps(x1, x1)), one);
+    __m256 x2 = _mm256_mul_ps(_mm256_sub_ps(t, one), invDt);
+    __m256 r2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x2, x2), _mm256_add_ps(x2, x2)), one);
+    __m256 head = _mm256_cmp_ps(t, dt, _CMP_LT_OQ);
+    __m256 tail = _mm256_cmp_ps(t, _mm256_sub_ps(one, dt), _CMP_GT_OQ);
+    return _mm256_or_ps(_mm256_and_ps(head, r1), _mm256_and_ps(tail, r2));
+}
+
+__m256 polyBlamp8(__m256 t, __m256 dt, __m256 invDt, __m256 one) {
+    const __m256 third = _mm256_set1_ps(1.0f / 3.0f);
+    __m256 x1 = _mm256_sub_ps(_mm256_mul_ps(t, invDt), one);
+    __m256 r1 = _mm256_sub_ps(_mm256_setzero_ps(),
+                              _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(x1, x1), x1), third));
+    __m256 x2 = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(t, one), invDt), one);
+    __m256 r2 = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(x2, x2), x2), third);
+    __m256 head = _mm256_cmp_ps(t, dt, _CMP_LT_OQ);
+    __m256 tail = _mm256_cmp_ps(t, _mm256_sub_ps(one, dt), _CMP_GT_OQ);
+    return _mm256_or_ps(_mm256_and_ps(head, r1), _mm256_and_ps(tail, r2));
+}
+
+double avxSquare(float* out, size_t count, double phase, double increment, float duty,
+                 float gain) {
+    size_t blocks = count & ~size_t(7);
+    if (blocks > 0) {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 minusOne = _mm256_set1_ps(-1.0f);
+        const __m256 dt = _mm256_set1_ps(static_cast<float>(increment));
+        const __m256 invDt = _mm256_set1_ps(static_cast<float>(1.0 / increment));
+        const __m256 dutyV = _mm256_set1_ps(duty);
+        const __m256 gainV = _mm256_set1_ps(gain);
+        const __m256 step = _mm256_set1_ps(static_cast<float>(wrap(8.0 * increment)));
+
+        __m256 t = startPhases(phase, increment);
+        for (size_t i = 0; i < blocks; i += 8) {
+            __m256 value = _mm256_blendv_ps(minusOne, one, _mm256_cmp_ps(t, dutyV, _CMP_LT_OQ));
+            __m256 falling = _mm256_sub_ps(t, dutyV);
+            falling = _mm256_add_ps(
+                falling, _mm256_and_ps(_mm256_cmp_ps(falling, _mm256_setzero_ps(), _CMP_LT_OQ), one));
+
+            value = _mm256_add_ps(value, polyBlep8(t, dt, invDt, one));
+            value = _mm256_sub_ps(value, polyBlep8(falling, dt, invDt, one));
+            _mm256_storeu_ps(out + i,
+                             _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(value, gainV)));
+
+            t = wrapOnce(_mm256_add_ps(t, step), one);
+        }
+        _mm256_zeroupper();
+        phase = wrap(phase + static_cast<double>(blocks) * increment);
+    }
+    return scalarKernels().addSquare(out + blocks, count - blocks, phase, increment, duty, gain);
+}
+
+double avxTriangle(float* out, size_t count, double phase, double increment, float gain) {
+    size_t blocks = count & ~size_t(7);
+    if (blocks > 0) {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 four = _mm256_set1_ps(4.0f);
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        const __m256 dt = _mm256_set1_ps(static_cast<float>(increment));
+        const __m256 invDt = _mm256_set1_ps(static_cast<float>(1.0 / increment));
+        const __m256 corner = _mm256_set1_ps(static_cast<float>(8.0 * increment));
+        const __m256 gainV = _mm256_set1_ps(gain);
+        const __m256 step = _mm256_set1_ps(static_cast<float>(wrap(8.0 * increment)));
+
+        __m256 t = startPhases(phase, increment);
+        for (size_t i = 0; i < blocks; i += 8) {
+            __m256 distance = _mm256_andnot_ps(signMask, _mm256_sub_ps(t, half));
+            __m256 value = _mm256_sub_ps(_mm256_mul_ps(four, distance), one);
+            __m256 trough = wrapOnce(_mm256_add_ps(t, half), one);
+
+            __m256 residual = _mm256_sub_ps(polyBlamp8(trough, dt, invDt, one),
+                                            polyBlamp8(t, dt, invDt, one));
+            value = _mm256_add_ps(value, _mm256_mul_ps(corner, residual));
+            _mm256_storeu_ps(out + i,
+                             _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(value, gainV)));
+
+            t = wrapOnce(_mm256_add_ps(t, step), one);
+        }
+        _mm256_zeroupper();
+        phase = wrap(phase + static_cast<double>(blocks) * increment);
+    }
+    return scalarKernels().addTriangle(out + blocks, count - blocks, phase, increment, gain);
+}
+
+const KernelTable AVX_KERNELS = {"avx", avxSquare, avxTriangle};
+
+} // namespace
+
+const KernelTable* avxKernels() {
+    return &AVX_KERNELS;
+}
+
+#else
+
+const KernelTable* avxKernels() {
+    return nullptr;
+}
+
+#endif // __AVX__
+
+} // namespace synth
+} // namespace devescape
@@ -1,4 +1,5 @@
 #include "framework/TerminalRenderer.h"
+#include "framework/InputReader.h"
 #ifdef _WIN32
 #include <windows.h>
 #else
@@ -22,7 +23,7 @@ void initializeConsoleHandle() {
     }
 }
 #else
-struct termios TerminalControl::originalTermios_;
+::termios TerminalControl::originalTermios_;
 #endif
 
 void TerminalControl::disableEcho() {
@@ -116,36 +117,19 @@ void TerminalControl::restoreTerminalMode() {
 }
 
 std::string TerminalControl::readInputNonBlocking() {
-    std::string input;
-#ifdef _WIN32
-    initializeConsoleHandle();
-    DWORD numEvents = 0;
-    if (GetNumberOfConsoleInputEvents(hStdin, &numEvents) && numEvents > 0) {
-        INPUT_RECORD record;
-        DWORD numRead = 0;
-        while (PeekConsoleInput(hStdin, &record, 1, &numRead) && numRead > 0) {
-            ReadConsoleInput(hStdin, &record, 1, &numRead);
-            if (record.EventType == KEY_EVENT && record.Event.KeyEvent.bKeyDown) {
-                char c = record.Event.KeyEvent.uChar.AsciiChar;
-                if (c == '\r' || c == '\n') {
-                    return input;
-                }
-                if (c != 0) {
-                    input += c;
-                }
-            }
-        }
+    // Complete lines only; a line typed across frames stays buffered in the
+    // reader until its Enter arrives
+    InputReader& reader = InputReader::standardInput();
+    if (!reader.hasEvents()) {
+        reader.poll();
     }
-#else
-    char c;
-    while (read(STDIN_FILENO, &c, 1) > 0) {
-        if (c == '\n' || c == '\r') {
-            return input;
+    InputEvent event;
+    while (reader.nextEvent(event)) {
+        if (event.type == InputEvent::Type::LINE) {
+            return event.text;
         }
-        input += c;
     }
-#endif
-    return input;
+    return std::string();
 }
 
 } // namespace devescape
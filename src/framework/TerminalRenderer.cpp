@@ -1,5 +1,6 @@
 #include "framework/TerminalRenderer.h"
 #include <iostream>
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 #include <cmath>
@@ -16,7 +17,8 @@
 
 namespace devescape {
 
-TerminalRenderer::TerminalRenderer() : width_(80), height_(24) {
+TerminalRenderer::TerminalRenderer(std::pmr::memory_resource* resource)
+    : width_(80), height_(24), screenBuffer_(resource) {
     initialize();
 }
 
@@ -30,9 +32,10 @@ void TerminalRenderer::initialize() {
     height_ = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
 #else
     struct winsize w;
-    ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
-    width_ = w.ws_col;
-    height_ = w.ws_row;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == 0) {
+        width_ = w.ws_col;
+        height_ = w.ws_row;
+    }
 #endif
 
     if (width_ < 80) width_ = 80;
@@ -41,9 +44,18 @@ void TerminalRenderer::initialize() {
     initializeBuffer();
 }
 
+void TerminalRenderer::resize(int width, int height) {
+    width_ = std::max(width, 1);
+    height_ = std::max(height, 1);
+    initializeBuffer();
+}
+
 void TerminalRenderer::initializeBuffer() {
-    screenBuffer_.clear();
-    screenBuffer_.resize(height_, std::string(width_, ' '));
+    // Blank rows in place so a renderer reused across frames keeps its storage.
+    screenBuffer_.resize(height_);
+    for (auto& row : screenBuffer_) {
+        row.assign(width_, ' ');
+    }
 }
 
 std::string TerminalRenderer::getColorCode(ColorType color, bool bold) const {
@@ -138,6 +150,17 @@ void TerminalRenderer::drawText(int x, int y, const std::string& text, ColorType
     }
 }
 
+std::string_view TerminalRenderer::getLine(int y) const {
+    if (y < 0 || y >= height_) return {};
+    return screenBuffer_[y];
+}
+
+void TerminalRenderer::setLine(int y, std::string_view line) {
+    if (y < 0 || y >= height_) return;
+    size_t length = std::min(line.size(), static_cast<size_t>(width_));
+    screenBuffer_[y].replace(0, length, line.substr(0, length));
+}
+
 void TerminalRenderer::drawProgressBar(int x, int y, float percent, int width, ColorType color) {
     if (y < 0 || y >= height_ || x < 0) return;
 
@@ -185,6 +208,17 @@ void TerminalRenderer::render() {
     std::cout << std::flush;
 }
 
+void TerminalRenderer::setCursorPosition(int x, int y) {
+    x = std::max(0, std::min(x, width_ - 1));
+    y = std::max(0, std::min(y, height_ - 1));
+#ifdef _WIN32
+    COORD position = {static_cast<SHORT>(x), static_cast<SHORT>(y)};
+    SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), position);
+#else
+    std::cout << "\033[" << (y + 1) << ";" << (x + 1) << "H" << std::flush;
+#endif
+}
+
 void TerminalRenderer::setCursorVisible(bool visible) {
 #ifdef _WIN32
     HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -0,0 +1,303 @@
+#include "framework/TimerService.h"
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace devescape {
+
+namespace {
+
+constexpr uint32_t WHEEL_MASK = 0xFF;
+
+uint32_t lowestSetBit(uint64_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(bits));
+#endif
+}
+
+} // namespace
+
+TimerService::TimerService(std::chrono::microseconds tick, ClockSource& clock)
+    : clock_(clock)
+    , epoch_(clock.now())
+    , tick_(std::max<Clock::duration>(tick, Clock::duration(1)))
+    , currentTick_(0)
+    , pending_(0)
+    , advancing_(false) {
+    std::fill(std::begin(slots_), std::end(slots_), NIL);
+    std::fill(std::begin(occupied_), std::end(occupied_), 0);
+}
+
+TimerService::~TimerService() = default;
+
+TimerService& TimerService::shared() {
+    static TimerService service;
+    return service;
+}
+
+TimerService::TimerId TimerService::scheduleAfter(Clock::duration delay, Callback callback) {
+    return scheduleAt(clock_.now() + delay, std::move(callback));
+}
+
+TimerService::TimerId TimerService::scheduleAt(Clock::time_point when, Callback callback) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return schedule(ticksUntil(when), 0, std::move(callback));
+}
+
+TimerService::TimerId TimerService::schedulePeriodic(Clock::duration period, Callback callback) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    uint64_t periodTicks = std::max<uint64_t>(1, (period + tick_ - Clock::duration(1)) / tick_);
+    return schedule(ticksUntil(clock_.now() + period), periodTicks, std::move(callback));
+}
+
+TimerService::TimerId TimerService::schedule(uint64_t expires, uint64_t period, Callback callback) {
+    uint32_t index;
+    if (!freeNodes_.empty()) {
+        index = freeNodes_.back();
+        freeNodes_.pop_back();
+    } else {
+        index = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+
+    Node& node = nodes_[index];
+    node.expires = std::max(expires, currentTick_);
+    node.period = period;
+    node.callback = std::move(callback);
+    link(index);
+    pending_++;
+
+    return (static_cast<uint64_t>(node.generation) << 32) | (index + 1);
+}
+
+bool TimerService::cancel(TimerId id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    Node* node = lookup(id);
+    if (!node) {
+        return false;
+    }
+
+    uint32_t index = static_cast<uint32_t>((id & 0xFFFFFFFFu) - 1);
+    if (node->slot != EXPIRING) {
+        unlink(index);
+    }
+
+    // A periodic callback cancelling itself is running from a moved-out
+    // copy, so clearing the node here is safe
+    node->slot = NIL;
+    node->callback = nullptr;
+    node->generation++;
+    freeNodes_.push_back(index);
+    pending_--;
+    return true;
+}
+
+bool TimerService::isPending(TimerId id) const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return lookup(id) != nullptr;
+}
+
+size_t TimerService::pendingCount() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return pending_;
+}
+
+size_t TimerService::advance() {
+    return advanceTo(clock_.now());
+}
+
+size_t TimerService::advanceTo(Clock::time_point now) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (advancing_ || now < epoch_) {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>((now - epoch_) / tick_);
+    size_t fired = 0;
+
+    advancing_ = true;
+    while (currentTick_ <= target) {
+        // Jump over ticks with nothing to run or cascade
+        uint64_t next = pending_ == 0 ? target + 1 : nextBusyTick();
+        if (next > target) {
+            currentTick_ = target + 1;
+            break;
+        }
+        currentTick_ = next;
+        fired += runTick();
+    }
+    advancing_ = false;
+
+    return fired;
+}
+
+uint64_t TimerService::ticksUntil(Clock::time_point when) const {
+    if (when <= epoch_) {
+        return 0;
+    }
+    // Round up: a timer never fires before its time
+    return static_cast<uint64_t>((when - epoch_ + tick_ - Clock::duration(1)) / tick_);
+}
+
+TimerService::Node* TimerService::lookup(TimerId id) {
+    return const_cast<Node*>(static_cast<const TimerService*>(this)->lookup(id));
+}
+
+const TimerService::Node* TimerService::lookup(TimerId id) const {
+    uint64_t index = (id & 0xFFFFFFFFu);
+    if (index == 0 || index > nodes_.size()) {
+        return nullptr;
+    }
+
+    const Node& node = nodes_[index - 1];
+    if (node.generation != static_cast<uint32_t>(id >> 32) || node.slot == NIL) {
+        return nullptr;
+    }
+    return &node;
+}
+
+void TimerService::link(uint32_t index) {
+    Node& node = nodes_[index];
+    uint64_t expires = std::max(node.expires, currentTick_);
+    uint64_t delta = expires - currentTick_;
+
+    // Coarsest wheel needed to tell the expiry apart from now
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= (uint64_t(1) << (WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    if (delta >= (uint64_t(1) << (WHEEL_BITS * WHEEL_LEVELS))) {
+        // Beyond the outermost wheel: park in its furthest slot and re-place
+        // on cascade
+        expires = currentTick_ + (uint64_t(1) << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+    }
+
+    uint32_t slot = level * WHEEL_SLOTS + static_cast<uint32_t>((expires >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    if (level == 0) {
+        occupied_[slot / 64] |= uint64_t(1) << (slot % 64);
+    }
+
+    node.slot = slot;
+    node.prev = NIL;
+    node.next = slots_[slot];
+    if (node.next != NIL) {
+        nodes_[node.next].prev = index;
+    }
+    slots_[slot] = index;
+}
+
+void TimerService::unlink(uint32_t index) {
+    Node& node = nodes_[index];
+    if (node.prev != NIL) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        slots_[node.slot] = node.next;
+        if (node.next == NIL && node.slot < WHEEL_SLOTS) {
+            occupied_[node.slot / 64] &= ~(uint64_t(1) << (node.slot % 64));
+        }
+    }
+    if (node.next != NIL) {
+        nodes_[node.next].prev = node.prev;
+    }
+    node.prev = NIL;
+    node.next = NIL;
+}
+
+void TimerService::cascade(int level) {
+    uint32_t slot = level * WHEEL_SLOTS +
+                    static_cast<uint32_t>((currentTick_ >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    uint32_t index = slots_[slot];
+    slots_[slot] = NIL;
+
+    while (index != NIL) {
+        uint32_t next = nodes_[index].next;
+        link(index);
+        index = next;
+    }
+}
+
+uint64_t TimerService::nextBusyTick() const {
+    // The first occupied slot of the finest wheel in the current block, else
+    // the start of the next block, where the coarser wheels cascade
+    uint32_t index = static_cast<uint32_t>(currentTick_ & WHEEL_MASK);
+    if (index == 0) {
+        return currentTick_;
+    }
+
+    for (uint32_t word = index / 64; word < WHEEL_SLOTS / 64; ++word) {
+        uint64_t bits = occupied_[word];
+        if (word == index / 64) {
+            bits &= ~uint64_t(0) << (index % 64);
+        }
+        if (bits != 0) {
+            uint32_t slot = word * 64 + lowestSetBit(bits);
+            return currentTick_ + (slot - index);
+        }
+    }
+    return (currentTick_ | WHEEL_MASK) + 1;
+}
+
+size_t TimerService::runTick() {
+    uint64_t tick = currentTick_;
+
+    // Entering a new block of a wheel pulls the next slot of the wheel
+    // above down into the finer ones
+    for (int level = 1; level < WHEEL_LEVELS; ++level) {
+        if (((tick >> (WHEEL_BITS * (level - 1))) & WHEEL_MASK) != 0) {
+            break;
+        }
+        cascade(level);
+    }
+
+    uint32_t slot = static_cast<uint32_t>(tick & WHEEL_MASK);
+    due_.clear();
+    for (uint32_t index = slots_[slot]; index != NIL; index = nodes_[index].next) {
+        nodes_[index].slot = EXPIRING;
+        due_.emplace_back(index, nodes_[index].generation);
+    }
+    slots_[slot] = NIL;
+    occupied_[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    currentTick_ = tick + 1;
+
+    size_t fired = 0;
+    for (const auto& [index, generation] : due_) {
+        Node& node = nodes_[index];
+        if (node.generation != generation || node.slot != EXPIRING) {
+            continue;  // cancelled by an earlier callback this tick
+        }
+        node.prev = NIL;
+        node.next = NIL;
+
+        Callback callback = std::move(node.callback);
+        if (node.period > 0) {
+            // Stay on the grid the timer was started on
+            node.expires = tick + node.period;
+            link(index);
+        } else {
+            node.slot = NIL;
+            node.generation++;
+            freeNodes_.push_back(index);
+            pending_--;
+        }
+
+        if (callback) {
+            callback();
+            fired++;
+        }
+
+        // Hand a periodic callback back unless it was cancelled meanwhile
+        Node& after = nodes_[index];
+        if (after.period > 0 && after.generation == generation && after.slot != NIL) {
+            after.callback = std::move(callback);
+        }
+    }
+    return fired;
+}
+
+} // namespace devescape
@@ -3,32 +3,73 @@
 
 namespace devescape {
 
-TimerSystem::TimerSystem(int totalSeconds, AudioManager* audioMgr)
+TimerSystem::TimerSystem(int totalSeconds, AudioManager* audioMgr, TimerService& timers)
     : totalSeconds_(totalSeconds)
     , secondsRemaining_(totalSeconds)
-    , accumulatedTime_(0.0f)
     , pressureLevel_(PressureLevel::LOW)
-    , audioManager_(audioMgr) {
+    , audioManager_(audioMgr)
+    , timers_(timers)
+    , countdownTimer_(TimerService::INVALID_TIMER)
+    , ticksAhead_(0) {
+}
+
+TimerSystem::~TimerSystem() {
+    stop();
 }
 
 void TimerSystem::start() {
-    accumulatedTime_ = 0.0f;
+    stop();
     secondsRemaining_ = totalSeconds_;
+    ticksAhead_ = 0;
+    startedAt_ = timers_.getClock().now();
+    countdownTimer_ = timers_.schedulePeriodic(std::chrono::seconds(1), [this]() { countdownTick(); });
 }
 
-void TimerSystem::update(float deltaTime) {
-    accumulatedTime_ += deltaTime;
-
-    if (accumulatedTime_ >= 1.0f) {
-        secondsRemaining_ -= static_cast<int>(accumulatedTime_);
-        accumulatedTime_ = accumulatedTime_ - static_cast<int>(accumulatedTime_);
+void TimerSystem::stop() {
+    if (countdownTimer_ != TimerService::INVALID_TIMER) {
+        timers_.cancel(countdownTimer_);
+        countdownTimer_ = TimerService::INVALID_TIMER;
+    }
+}
 
-        if (secondsRemaining_ < 0) {
-            secondsRemaining_ = 0;
-        }
+void TimerSystem::countdownTick() {
+    if (ticksAhead_ > 0) {
+        ticksAhead_--;  // already counted by a callback due on the same tick
+        return;
+    }
+    tick();
+}
 
+void TimerSystem::tick() {
+    if (secondsRemaining_ > 0) {
+        secondsRemaining_--;
         updatePressureLevel();
     }
+    if (secondsRemaining_ == 0) {
+        stop();
+    }
+}
+
+TimerService::TimerId TimerSystem::scheduleAtRemaining(int secondsRemaining,
+                                                      TimerService::Callback callback) {
+    // Before start() there is no tick to anchor to
+    if (countdownTimer_ == TimerService::INVALID_TIMER) {
+        return TimerService::INVALID_TIMER;
+    }
+    if (secondsRemaining >= secondsRemaining_) {
+        return timers_.scheduleAfter(TimerService::Clock::duration::zero(), std::move(callback));
+    }
+    // The countdown ticks at startedAt_ + n seconds. The timer service
+    // runs timers due on the same tick in no set order, so the callback
+    // counts the second itself if the countdown has not yet
+    return timers_.scheduleAt(startedAt_ + std::chrono::seconds(totalSeconds_ - secondsRemaining),
+                              [this, secondsRemaining, callback = std::move(callback)]() {
+                                  while (secondsRemaining_ > secondsRemaining) {
+                                      tick();
+                                      ticksAhead_++;
+                                  }
+                                  callback();
+                              });
 }
 
 bool TimerSystem::isExpired() const {
@@ -57,6 +98,9 @@ void TimerSystem::updatePressureLevel() {
     // Notify audio manager of tension changes
     if (pressureLevel_ != oldLevel && audioManager_) {
         audioManager_->updateTensionLevel(percent);
+        if (pressureLevel_ > oldLevel) {
+            audioManager_->playSoundEffect("alarm");
+        }
     }
 }
 
@@ -1,4 +1,7 @@
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 #include <SDL2/SDL.h>
 
 // Forward declaration of GameLoop class
@@ -6,26 +9,63 @@ namespace devescape {
     class GameLoop;
 }
 
+// Command line options
+struct FrameworkOptions {
+    bool sandbox = false;  // --sandbox: run rooms in a child process
+    std::string clock;     // --clock=real|virtual|scaled:<factor>
+    std::string record;    // --record=<file>: record the session for --replay
+    std::string replay;    // --replay=<file>: replay a session recording and verify it
+    bool replayFast = false;  // --replay-fast: don't pace frames at their recorded speed
+    std::string audio;     // --audio=sdl|null|null:fast|wav:<file>|events
+    bool lowLatency = false;  // --low-latency: small audio blocks sized from measured headroom
+    bool audioStats = false;  // --audio-stats: print callback timing on exit
+};
+
 // Declare the GameLoop run function
-extern void runDevEscapeFramework();
+extern void runDevEscapeFramework(const FrameworkOptions& options);
 
 int main(int argc, char* argv[]) {
     std::cout << "DevEscape Framework v1.0\n";
     std::cout << "Developer-Centric Escape Room Platform\n";
     std::cout << "======================================\n\n";
 
-    runDevEscapeFramework();
+    FrameworkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--sandbox") == 0) {
+            options.sandbox = true;
+        } else if (std::strncmp(argv[i], "--clock=", 8) == 0) {
+            options.clock = argv[i] + 8;
+        } else if (std::strncmp(argv[i], "--record=", 9) == 0) {
+            options.record = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--replay=", 9) == 0) {
+            options.replay = argv[i] + 9;
+        } else if (std::strcmp(argv[i], "--replay-fast") == 0) {
+            options.replayFast = true;
+        } else if (std::strncmp(argv[i], "--audio=", 8) == 0) {
+            options.audio = argv[i] + 8;
+        } else if (std::strcmp(argv[i], "--low-latency") == 0) {
+            options.lowLatency = true;
+        } else if (std::strcmp(argv[i], "--audio-stats") == 0) {
+            options.audioStats = true;
+        }
+    }
+
+    runDevEscapeFramework(options);
 
     return 0;
 }
 
 // Implementation using GameLoop
+#include "framework/GameLoop.h"
 #include "framework/PluginManager.h"
 #include "framework/StateManager.h"
 #include "framework/AudioManager.h"
 #include "framework/TerminalRenderer.h"
 #include "framework/TimerSystem.h"
-#include "framework/IEscapeRoom.h"
+#include "framework/ClockSource.h"
+#include "framework/SessionReplayer.h"
+#include "framework/IEscapeRoomV2.h"
+#include "framework/SessionArena.h"
 #include <thread>
 #include <chrono>
 #include <memory>
@@ -34,8 +74,9 @@ namespace devescape {
 
 class DevEscapeFramework {
 public:
-    DevEscapeFramework()
-        : pluginManager_("./plugins")
+    explicit DevEscapeFramework(const FrameworkOptions& options)
+        : options_(options)
+        , pluginManager_("./plugins")
         , stateManager_("./data/checkpoints")
         , timerSystem_(nullptr)
         , currentRoom_(nullptr) {
@@ -46,31 +87,48 @@ public:
             return;
         }
 
-        displayMenu();
+        if (!options_.replay.empty()) {
+            replaySession(options_.replay);
+        } else {
+            displayMenu();
+        }
 
         cleanup();
     }
 
 private:
     bool initialize() {
-        if (SDL_Init(SDL_INIT_AUDIO) < 0) {
-            std::cerr << "SDL initialization failed\n";
+        if (!options_.clock.empty() && !ClockSource::shared().configure(options_.clock)) {
+            return false;
+        }
+
+        if (!options_.audio.empty() && !audioManager_.setOutput(options_.audio)) {
             return false;
         }
+        audioManager_.setLowLatency(options_.lowLatency);
 
         if (!audioManager_.initialize()) {
             std::cerr << "Audio initialization failed\n";
             return false;
         }
 
+        for (const StaticPluginEntry* entry : staticPluginEntries()) {
+            pluginManager_.addStaticPlugin(*entry);
+        }
         pluginManager_.scanForPlugins();
+        pluginManager_.enableHotReload();
+        if (options_.sandbox) {
+            pluginManager_.setSandboxEnabled(true);
+        }
         return true;
     }
 
     void cleanup() {
         TerminalControl::restoreTerminalMode();
+        if (options_.audioStats) {
+            audioManager_.getTimingStats().print(std::cout);
+        }
         audioManager_.cleanup();
-        SDL_Quit();
     }
 
     void displayMenu() {
@@ -87,54 +145,91 @@ private:
             std::cout << "  " << (i+1) << ". " << plugins[i].name << "\n";
         }
 
+        if (stateManager_.hasRecentCheckpoint()) {
+            std::cout << "  R. Resume previous session\n";
+        }
+
         std::cout << "\nSelect room: ";
-        size_t choice;
+        std::string choice;
         std::cin >> choice;
 
-        if (choice > 0 && choice <= plugins.size()) {
-            startRoom(plugins[choice - 1].name);
+        if ((choice == "R" || choice == "r") && stateManager_.hasRecentCheckpoint()) {
+            GameLoop loop(pluginManager_, stateManager_, audioManager_);
+            loop.recordTo(options_.record);
+            if (!loop.resume()) {
+                std::cerr << "Failed to resume session\n";
+            }
+            return;
         }
-    }
 
-    void startRoom(const std::string& roomName) {
-        std::cout << "Loading " << roomName << "...\n";
+        size_t index = std::strtoul(choice.c_str(), nullptr, 10);
+        if (index > 0 && index <= plugins.size()) {
+            startRoom(plugins[index - 1].name);
+        }
+    }
 
-        currentRoom_ = pluginManager_.loadRoom(roomName);
-        if (!currentRoom_) {
-            std::cerr << "Failed to load room\n";
+    void replaySession(const std::string& path) {
+        SessionReplayer replayer;
+        if (!replayer.load(path)) {
             return;
         }
 
+        const RecordingHeader& header = replayer.getHeader();
+        std::cout << "Replaying " << replayer.getFrameCount() << " frames of " << header.pluginName
+                  << " " << header.roomVersion << (options_.replayFast ? " (fast)" : "") << "\n";
+
         FrameworkContext context;
         context.audioManager = &audioManager_;
         context.stateManager = &stateManager_;
+        context.memoryResource = sessionArena_.resource();
+        context.dataDirectory = "./data";
+        context.checkpointDirectory = "./data/checkpoints";
 
-        currentRoom_->initialize(context);
+        currentRoom_ = pluginManager_.acquireRoom(header.pluginName, context);
+        if (!currentRoom_) {
+            std::cerr << "Failed to load room " << header.pluginName << "\n";
+            return;
+        }
 
-        std::cout << "Room loaded successfully!\n";
-        std::cout << "Duration: " << currentRoom_->getTotalDurationSeconds() << " seconds\n";
-        std::cout << "Description: " << currentRoom_->getDescription() << "\n\n";
-        std::cout << "Press ENTER to start...";
-        std::cin.ignore();
-        std::cin.get();
+        ReplayReport report = replayer.replay(
+            *currentRoom_, options_.replayFast ? ReplaySpeed::FAST : ReplaySpeed::RECORDED);
 
-        // Would run full game loop here
-        // For now, just demonstrate the room is loaded
+        std::cout << report.frames << " frames, " << report.commands << " commands, "
+                  << report.sessionSeconds << " s of play in " << report.realSeconds << " s\n";
+        std::cout << report.checkpointsVerified << " checkpoints matched, "
+                  << report.checkpointsMismatched << " diverged";
+        if (report.firstMismatchFrame >= 0) {
+            std::cout << " (first after frame " << report.firstMismatchFrame << ")";
+        }
+        std::cout << "\n" << (report.passed() ? "REPLAY OK" : "REPLAY FAILED") << "\n";
+
+        pluginManager_.releaseRoom(currentRoom_);
+        currentRoom_ = nullptr;
+        sessionArena_.release();
+    }
+
+    void startRoom(const std::string& roomName) {
+        std::cout << "Loading " << roomName << "...\n";
 
-        currentRoom_->cleanup();
-        pluginManager_.unloadRoom(currentRoom_, roomName);
+        GameLoop loop(pluginManager_, stateManager_, audioManager_);
+        loop.recordTo(options_.record);
+        if (!loop.run(roomName)) {
+            std::cerr << "Failed to load room\n";
+        }
     }
 
+    FrameworkOptions options_;
     PluginManager pluginManager_;
     StateManager stateManager_;
     AudioManager audioManager_;
+    SessionArena sessionArena_;
     std::unique_ptr<TimerSystem> timerSystem_;
-    IEscapeRoom* currentRoom_;
+    IEscapeRoomV2* currentRoom_;
 };
 
 } // namespace devescape
 
-void runDevEscapeFramework() {
-    devescape::DevEscapeFramework framework;
+void runDevEscapeFramework(const FrameworkOptions& options) {
+    devescape::DevEscapeFramework framework(options);
     framework.run();
 }
@@ -0,0 +1,51 @@
+// devescape_sandbox: the child process of a sandboxed room. SandboxedRoom
+// starts it as
+//
+//   devescape_sandbox <shared memory fd> <plugin ABI version> <plugin library>
+//
+// and it loads the plugin itself, then serves the room until the host
+// shuts it down or dies.
+
+#include "framework/SandboxedRoom.h"
+#include <cstdlib>
+#include <iostream>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+int main(int argc, char* argv[]) {
+    using devescape::SandboxedRoom;
+
+#ifndef _WIN32
+    if (argc != 4) {
+        std::cerr << "usage: " << argv[0]
+                  << " <shared memory fd> <plugin ABI version> <plugin library>\n";
+        return 2;
+    }
+
+    void* handle = dlopen(argv[3], RTLD_NOW);
+    if (!handle) {
+        std::cerr << "Sandbox: " << dlerror() << std::endl;
+        return 1;
+    }
+    auto createRoom = reinterpret_cast<SandboxedRoom::CreateRoomFunc>(dlsym(handle, "createRoom"));
+    auto destroyRoom = reinterpret_cast<SandboxedRoom::DestroyRoomFunc>(dlsym(handle, "destroyRoom"));
+    if (!createRoom || !destroyRoom) {
+        std::cerr << "Sandbox: " << argv[3] << " is missing createRoom/destroyRoom" << std::endl;
+        return 1;
+    }
+
+    int sharedFd = std::atoi(argv[1]);
+    uint32_t abiVersion = static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10));
+    if (abiVersion < devescape::PLUGIN_ABI_V1 || abiVersion > devescape::PLUGIN_ABI_CURRENT) {
+        std::cerr << "Sandbox: cannot serve plugin ABI v" << abiVersion << std::endl;
+        return 1;
+    }
+    return SandboxedRoom::serveChild(sharedFd, createRoom, destroyRoom, abiVersion);
+#else
+    (void)argc;
+    std::cerr << argv[0] << ": the room sandbox is POSIX only\n";
+    return 1;
+#endif
+}
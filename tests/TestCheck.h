@@ -0,0 +1,50 @@
+#pragma once
+
+// Checks for the programs in tests/. Each test is a plain executable that
+// ctest runs: a failed CHECK is reported with its line and the test goes
+// on, and main() returns testResult(), non-zero if anything failed.
+
+#include <iostream>
+
+namespace devescape {
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline bool check(bool passed, const char* expression, const char* file, int line) {
+    if (!passed) {
+        std::cerr << file << ":" << line << ": CHECK failed: " << expression << std::endl;
+        failures()++;
+    }
+    return passed;
+}
+
+template <typename Actual, typename Expected>
+bool checkEqual(const Actual& actual, const Expected& expected, const char* expression,
+                const char* file, int line) {
+    if (actual == expected) {
+        return true;
+    }
+    std::cerr << file << ":" << line << ": CHECK_EQ failed: " << expression << "\n    got "
+              << actual << ", expected " << expected << std::endl;
+    failures()++;
+    return false;
+}
+
+inline int testResult() {
+    if (failures() > 0) {
+        std::cerr << failures() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace test
+} // namespace devescape
+
+#define CHECK(condition) ::devescape::test::check((condition), #condition, __FILE__, __LINE__)
+#define CHECK_EQ(actual, expected) \
+    ::devescape::test::checkEqual((actual), (expected), #actual " == " #expected, __FILE__, __LINE__)
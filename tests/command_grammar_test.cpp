@@ -0,0 +1,91 @@
+// CommandGrammar: slot types, their precedence and the <rest> fallback.
+
+#include "TestCheck.h"
+#include "framework/CommandGrammar.h"
+#include <string>
+
+using namespace devescape;
+
+namespace {
+
+enum Command { FILTER_WORD, FILTER_ERROR, SUBMIT, NAVIGATE, COUNT, HELP, DEPLOY, DEPLOY_NOW };
+
+void testSlots(const CommandGrammar& grammar) {
+    CommandMatch match;
+
+    CHECK_EQ(grammar.match("submit solution 60", match), SUBMIT);
+    CHECK_EQ(match.argumentCount, 1u);
+    CHECK_EQ(match.number(0), 60);
+    CHECK(match.text(0) == "60");
+
+    CHECK_EQ(grammar.match("count 3 ERROR", match), COUNT);
+    CHECK_EQ(match.argumentCount, 2u);
+    CHECK_EQ(match.number(0), 3);
+    CHECK(match.text(1) == "ERROR");
+
+    // <int> takes decimal 64-bit integers only
+    CHECK_EQ(grammar.match("submit solution sixty", match), CommandGrammar::NO_MATCH);
+    CHECK_EQ(grammar.match("submit solution 99999999999999999999", match),
+             CommandGrammar::NO_MATCH);
+
+    CHECK_EQ(grammar.match("  help  ", match), HELP);
+    CHECK_EQ(grammar.match("help me", match), CommandGrammar::NO_MATCH);
+    CHECK_EQ(grammar.match("", match), CommandGrammar::NO_MATCH);
+}
+
+void testPrecedence(const CommandGrammar& grammar) {
+    CommandMatch match;
+
+    // A literal beats <word>
+    CHECK_EQ(grammar.match("filter logs ERROR", match), FILTER_ERROR);
+    CHECK_EQ(match.argumentCount, 0u);
+    CHECK_EQ(grammar.match("filter logs WARN", match), FILTER_WORD);
+    CHECK(match.text(0) == "WARN");
+}
+
+void testRest(const CommandGrammar& grammar) {
+    CommandMatch match;
+
+    CHECK_EQ(grammar.match("navigate metrics payment-api  latency ", match), NAVIGATE);
+    CHECK(match.rest == "metrics payment-api  latency");
+    CHECK_EQ(grammar.match("navigate", match), NAVIGATE);
+    CHECK(match.rest.empty());
+
+    // A dead end falls back to the deepest <rest> passed on the way
+    CHECK_EQ(grammar.match("deploy config now", match), DEPLOY_NOW);
+    CHECK_EQ(grammar.match("deploy config later", match), DEPLOY);
+    CHECK(match.rest == "config later");
+}
+
+void testAdd() {
+    CommandGrammar grammar;
+    CHECK(grammar.add("help", HELP));
+    CHECK(grammar.add("help", HELP));        // same binding again
+    CHECK(!grammar.add("help", SUBMIT));     // bound to another command
+    CHECK(!grammar.add("<rest> logs", FILTER_WORD));  // <rest> must come last
+    CHECK_EQ(grammar.size(), 1u);
+
+    grammar.clear();
+    CommandMatch match;
+    CHECK_EQ(grammar.match("help", match), CommandGrammar::NO_MATCH);
+}
+
+} // namespace
+
+int main() {
+    CommandGrammar grammar;
+    CHECK(grammar.add("filter logs <word>", FILTER_WORD));
+    CHECK(grammar.add("filter logs ERROR", FILTER_ERROR));
+    CHECK(grammar.add("submit solution <int>", SUBMIT));
+    CHECK(grammar.add("navigate <rest>", NAVIGATE));
+    CHECK(grammar.add("count <int> <word>", COUNT));
+    CHECK(grammar.add("help", HELP));
+    CHECK(grammar.add("deploy <rest>", DEPLOY));
+    CHECK(grammar.add("deploy config now", DEPLOY_NOW));
+
+    testSlots(grammar);
+    testPrecedence(grammar);
+    testRest(grammar);
+    testAdd();
+    return test::testResult();
+}
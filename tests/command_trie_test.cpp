@@ -0,0 +1,89 @@
+// CommandTrie: tab completion extensions and word-boundary candidates.
+
+#include "TestCheck.h"
+#include "framework/CommandTrie.h"
+#include <string>
+#include <vector>
+
+using namespace devescape;
+
+namespace {
+
+using Words = std::vector<std::string>;
+
+CommandTrie makeTrie() {
+    CommandTrie trie;
+    trie.insert("navigate metrics payment-api latency");
+    trie.insert("navigate metrics payment-api error_rate");
+    trie.insert("navigate metrics checkout-web latency");
+    trie.insert("help");
+    trie.insert("hint");
+    trie.insert("help");  // duplicates count once
+    return trie;
+}
+
+void testContents(const CommandTrie& trie) {
+    CHECK_EQ(trie.size(), 5u);
+    CHECK(trie.contains("help"));
+    CHECK(trie.contains("navigate metrics checkout-web latency"));
+    CHECK(!trie.contains("he"));
+    CHECK(!trie.contains("navigate metrics"));
+
+    CommandTrie empty;
+    CHECK(empty.empty());
+    CHECK_EQ(empty.complete("h").matches, 0u);
+}
+
+void testCompletion(const CommandTrie& trie) {
+    // One match: complete it
+    Completion single = trie.complete("he");
+    CHECK(single.extension == "lp");
+    CHECK_EQ(single.matches, 1u);
+    CHECK(single.candidates.empty());
+
+    // Diverging at once: no extension, the words to choose from
+    Completion choice = trie.complete("h");
+    CHECK(choice.extension.empty());
+    CHECK_EQ(choice.matches, 2u);
+    CHECK(choice.candidates == Words({"help", "hint"}));
+
+    // The shared part first, with candidates cut at the next word boundary
+    Completion shared = trie.complete("nav");
+    CHECK(shared.extension == "igate metrics ");
+    CHECK_EQ(shared.matches, 3u);
+    CHECK(shared.candidates ==
+          Words({"navigate metrics checkout-web ", "navigate metrics payment-api "}));
+
+    Completion segment = trie.complete("navigate metrics p");
+    CHECK(segment.extension == "ayment-api ");
+    CHECK(segment.candidates == Words({"navigate metrics payment-api error_rate",
+                                       "navigate metrics payment-api latency"}));
+
+    Completion everything = trie.complete("");
+    CHECK_EQ(everything.matches, 5u);
+    CHECK(everything.candidates == Words({"help", "hint", "navigate "}));
+
+    CHECK_EQ(trie.complete("help").matches, 1u);
+    CHECK(trie.complete("help").extension.empty());
+    CHECK_EQ(trie.complete("x").matches, 0u);
+}
+
+void testCandidateLimit(const CommandTrie& trie) {
+    Completion limited = trie.complete("h", 1);
+    CHECK_EQ(limited.matches, 2u);  // still counts every match
+    CHECK(limited.candidates == Words({"help"}));
+}
+
+} // namespace
+
+int main() {
+    CommandTrie trie = makeTrie();
+    testContents(trie);
+    testCompletion(trie);
+    testCandidateLimit(trie);
+
+    trie.clear();
+    CHECK(trie.empty());
+    CHECK(!trie.contains("help"));
+    return test::testResult();
+}
@@ -0,0 +1,138 @@
+// InputReader: line assembly, escape sequences and UTF-8 split across
+// reads, and the lone ESC.
+
+#include "TestCheck.h"
+#include "framework/InputReader.h"
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace devescape;
+
+namespace {
+
+std::vector<InputEvent> drain(InputReader& reader) {
+    std::vector<InputEvent> events;
+    InputEvent event;
+    while (reader.nextEvent(event)) {
+        events.push_back(event);
+    }
+    return events;
+}
+
+void feed(InputReader& reader, const std::string& bytes) {
+    reader.feed(bytes.data(), bytes.size());
+}
+
+bool isKey(const InputEvent& event, Key key) {
+    return event.type == InputEvent::Type::KEY && event.key == key;
+}
+
+void testLines() {
+    InputReader reader;
+    feed(reader, "filter logs ERROR\r\nhelp\n");
+    std::vector<InputEvent> events = drain(reader);
+    CHECK_EQ(events.size(), 2u);  // CR LF is one Enter
+    if (events.size() == 2) {
+        CHECK(events[0].type == InputEvent::Type::LINE);
+        CHECK_EQ(events[0].text, std::string("filter logs ERROR"));
+        CHECK_EQ(events[1].text, std::string("help"));
+    }
+
+    // A partial line survives between reads; backspace takes a whole
+    // UTF-8 character
+    feed(reader, "caf\xC3\xA9");
+    CHECK(!reader.hasEvents());
+    CHECK_EQ(reader.getPartialLine(), std::string("caf\xC3\xA9"));
+    feed(reader, "\x7F" "e\r");
+    events = drain(reader);
+    CHECK_EQ(events.size(), 1u);
+    if (!events.empty()) {
+        CHECK_EQ(events[0].text, std::string("cafe"));
+    }
+    CHECK(reader.getPartialLine().empty());
+
+    // Other keys still come through while a line is being typed
+    feed(reader, "nav\t");
+    events = drain(reader);
+    CHECK_EQ(events.size(), 1u);
+    CHECK(!events.empty() && isKey(events[0], Key::TAB));
+    CHECK_EQ(reader.getPartialLine(), std::string("nav"));
+}
+
+void testEscapeSequences() {
+    InputReader reader;
+    reader.setLineAssembly(false);
+
+    // CSI, tilde keys with modifiers, SS3, each split across feeds
+    feed(reader, "\x1B[");
+    CHECK(!reader.hasEvents());
+    feed(reader, "A");
+    feed(reader, "\x1B[3");
+    feed(reader, "~\x1B[5;2~");
+    feed(reader, "\x1BO");
+    feed(reader, "H\x1B[Z");
+    std::vector<InputEvent> events = drain(reader);
+    std::vector<Key> expected = {Key::UP, Key::DELETE_CHAR, Key::PAGE_UP, Key::HOME, Key::TAB};
+    CHECK_EQ(events.size(), expected.size());
+    for (size_t i = 0; i < events.size() && i < expected.size(); ++i) {
+        CHECK(isKey(events[i], expected[i]));
+    }
+
+    // Controls, and UTF-8 split in the middle of a character
+    feed(reader, "\x03" "a\xE2\x82");
+    feed(reader, "\xAC");
+    events = drain(reader);
+    CHECK_EQ(events.size(), 3u);
+    if (events.size() == 3) {
+        CHECK(isKey(events[0], Key::CONTROL));
+        CHECK_EQ(events[0].control, 'c');
+        CHECK(isKey(events[1], Key::CHARACTER));
+        CHECK_EQ(events[1].text, std::string("a"));
+        CHECK_EQ(events[2].text, std::string("\xE2\x82\xAC"));
+    }
+}
+
+void testLoneEscape() {
+#ifndef _WIN32
+    int fds[2];
+    if (!CHECK(pipe(fds) == 0)) {
+        return;
+    }
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    InputReader reader(fds[0]);
+    reader.setLineAssembly(false);
+
+    // Still maybe the start of a sequence after the poll that read it...
+    CHECK_EQ(write(fds[1], "\x1B", 1), 1);
+    CHECK_EQ(reader.poll(), 0u);
+    // ...and a key once a poll passes with nothing after it
+    CHECK_EQ(reader.poll(), 1u);
+    std::vector<InputEvent> events = drain(reader);
+    CHECK(events.size() == 1 && isKey(events[0], Key::ESCAPE));
+
+    // An ESC followed by more input in the next poll is a sequence
+    CHECK_EQ(write(fds[1], "\x1B", 1), 1);
+    reader.poll();
+    CHECK_EQ(write(fds[1], "[B", 2), 2);
+    reader.poll();
+    events = drain(reader);
+    CHECK(events.size() == 1 && isKey(events[0], Key::DOWN));
+
+    close(fds[0]);
+    close(fds[1]);
+#endif
+}
+
+} // namespace
+
+int main() {
+    testLines();
+    testEscapeSequences();
+    testLoneEscape();
+    return test::testResult();
+}
@@ -0,0 +1,169 @@
+// MetricStore: the path trie, samples round-tripping exactly through the
+// compressed chunks, and rollups and downsampling against a brute-force
+// computation over the same samples.
+
+#include "TestCheck.h"
+#include "framework/MetricStore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace devescape;
+
+namespace {
+
+// Irregular timestamps and values: steady runs, repeats, jumps in both
+// and values that need every mantissa bit
+std::vector<MetricSample> makeSamples(size_t count) {
+    std::vector<MetricSample> samples;
+    uint64_t state = 12345;
+    int64_t time = -5000;
+    double value = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint32_t r = static_cast<uint32_t>(state >> 33);
+        if (i % 50 < 20) {
+            time += 1000;                 // steady interval
+        } else {
+            time += 1 + r % 90000;        // jitter, sometimes long gaps
+        }
+        switch (r % 4) {
+            case 0: break;                                   // unchanged
+            case 1: value += 0.1; break;                     // inexact
+            case 2: value = static_cast<double>(r % 1000) / 7.0; break;
+            default: value = -value * 1e6; break;
+        }
+        samples.push_back({time, value});
+    }
+    return samples;
+}
+
+bool sameBits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof a) == 0;
+}
+
+MetricSummary bruteForce(const std::vector<MetricSample>& samples, int64_t from, int64_t to) {
+    MetricSummary summary;
+    for (const MetricSample& sample : samples) {
+        if (sample.time >= from && sample.time < to) {
+            summary.add(sample.time, sample.value);
+        }
+    }
+    return summary;
+}
+
+bool sameSummary(const MetricSummary& a, const MetricSummary& b) {
+    // Sums may be added in a different order, chunk by chunk
+    double tolerance = 1e-9 * std::max(1.0, std::fabs(b.sum));
+    return a.count == b.count && a.min == b.min && a.max == b.max &&
+           std::fabs(a.sum - b.sum) <= tolerance && a.last == b.last && a.lastTime == b.lastTime;
+}
+
+void testTrie() {
+    MetricStore store;
+    MetricStore::SeriesId latency = store.addSeries("services/payment-api/latency");
+    MetricStore::SeriesId errors = store.addSeries("services/payment-api/errors");
+    CHECK(latency != MetricStore::NONE && errors != MetricStore::NONE && latency != errors);
+    CHECK_EQ(store.addSeries("services/payment-api/latency"), latency);
+    CHECK_EQ(store.getSeriesCount(), 2u);
+
+    // A path through an existing series is not a series
+    CHECK_EQ(store.addSeries("services/payment-api/latency/p99"), MetricStore::NONE);
+
+    MetricStore::NodeId node = store.findNode("services/payment-api/latency");
+    CHECK(node != MetricStore::NONE);
+    CHECK_EQ(store.series(node), latency);
+    CHECK_EQ(store.path(node), std::string("services/payment-api/latency"));
+
+    MetricStore::NodeId service = store.findNode("services/payment-api");
+    CHECK_EQ(store.parent(node), service);
+    CHECK_EQ(store.series(service), MetricStore::NONE);
+    CHECK_EQ(store.children(service).size(), 2u);
+    CHECK_EQ(store.child(service, "errors"), store.findNode("services/payment-api/errors"));
+    CHECK(store.name(service) == "payment-api");
+    CHECK_EQ(store.findNode("services/checkout-web"), MetricStore::NONE);
+}
+
+void testRoundTrip() {
+    MetricStore store;
+    MetricStore::SeriesId id = store.addSeries("load/cpu");
+    std::vector<MetricSample> samples = makeSamples(3 * MetricStore::CHUNK_SAMPLES + 17);
+    for (const MetricSample& sample : samples) {
+        CHECK(store.append(id, sample.time, sample.value));
+    }
+    CHECK_EQ(store.getSampleCount(), static_cast<uint64_t>(samples.size()));
+
+    // Out of order or repeated times are dropped
+    CHECK(!store.append(id, samples.back().time, 1.0));
+    CHECK(!store.append(id, samples.back().time - 1, 1.0));
+    CHECK(!store.append(MetricStore::NONE, 0, 1.0));
+
+    std::vector<MetricSample> out;
+    store.range(id, INT64_MIN, INT64_MAX, out);
+    CHECK_EQ(out.size(), samples.size());
+    size_t mismatched = 0;
+    for (size_t i = 0; i < out.size() && i < samples.size(); ++i) {
+        if (out[i].time != samples[i].time || !sameBits(out[i].value, samples[i].value)) {
+            mismatched++;
+        }
+    }
+    CHECK_EQ(mismatched, 0u);
+
+    // A range cut inside chunks
+    int64_t from = samples[100].time;
+    int64_t to = samples[600].time;
+    out.clear();
+    store.range(id, from, to, out);
+    CHECK_EQ(out.size(), 500u);
+    CHECK(!out.empty() && out.front().time == from && out.back().time == samples[599].time);
+}
+
+void testRollups() {
+    MetricStore store;
+    MetricStore::SeriesId id = store.addSeries("load/cpu");
+    std::vector<MetricSample> samples = makeSamples(5 * MetricStore::CHUNK_SAMPLES);
+    for (const MetricSample& sample : samples) {
+        store.append(id, sample.time, sample.value);
+    }
+    int64_t first = samples.front().time;
+    int64_t end = samples.back().time + 1;
+
+    CHECK(sameSummary(store.summary(id), bruteForce(samples, INT64_MIN, INT64_MAX)));
+    CHECK(sameSummary(store.rollup(id, first, end), bruteForce(samples, first, end)));
+    int64_t from = samples[300].time - 1;
+    int64_t to = samples[1000].time + 1;
+    CHECK(sameSummary(store.rollup(id, from, to), bruteForce(samples, from, to)));
+    CHECK_EQ(store.rollup(id, end, end + 1000).count, 0u);
+
+    // Bucket widths that do and do not line up with chunk edges
+    for (size_t buckets : {1u, 7u, 64u, 1000u}) {
+        std::vector<MetricSummary> out(buckets);
+        store.downsample(id, from, to, buckets, out.data());
+        size_t wrong = 0;
+        uint64_t total = 0;
+        for (size_t i = 0; i < buckets; ++i) {
+            int64_t bucketFrom = from + static_cast<int64_t>(
+                (static_cast<uint64_t>(to - from) * i + buckets - 1) / buckets);
+            int64_t bucketTo = from + static_cast<int64_t>(
+                (static_cast<uint64_t>(to - from) * (i + 1) + buckets - 1) / buckets);
+            if (!sameSummary(out[i], bruteForce(samples, bucketFrom, bucketTo))) {
+                wrong++;
+            }
+            total += out[i].count;
+        }
+        CHECK_EQ(wrong, 0u);
+        CHECK_EQ(total, bruteForce(samples, from, to).count);
+    }
+}
+
+} // namespace
+
+int main() {
+    testTrie();
+    testRoundTrip();
+    testRollups();
+    return test::testResult();
+}
@@ -0,0 +1,218 @@
+// SessionRecorder and SessionReplayer: a scripted session on a RoomEngine
+// room is recorded frame by frame the way the game loop records it, then
+// replayed into a fresh room, which has to pass every checkpoint. A
+// recording whose checkpoint does not match the room is reported.
+
+#include "TestCheck.h"
+#include "framework/ClockSource.h"
+#include "framework/RoomEngine.h"
+#include "framework/SessionRecorder.h"
+#include "framework/SessionReplayer.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+using namespace devescape;
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* ROOM_DEFINITION = R"(room "Replay Test"
+version 1.2.0
+author "tests"
+duration 600
+
+puzzle triage "Triage"
+puzzle sizing "Sizing"
+
+command hint "hint"
+command look "look <rest>"
+command size "size <int>"
+command size "size <rest>"
+
+on start
+    event "Session started"
+
+on hint
+    hint
+
+phase triage "Triage"
+    puzzle triage
+    prompt "Try: look logs"
+    hint "Read the logs."
+    hint "The database is the culprit." after 2
+    on look contains database
+        solve
+        event "Found it"
+        goto sizing
+    on look
+        wrong
+        say "Nothing there."
+
+phase sizing "Sizing"
+    puzzle sizing
+    prompt "Try: size <n>"
+    hint "Little's Law." after 1
+    on size number 50 75
+        solve
+        answer
+        event "Sized to {0}"
+        goto done
+        end
+    on size
+        wrong
+        say "Too small."
+
+phase done "Done"
+    final
+    prompt "All done."
+)";
+
+constexpr auto FRAME = std::chrono::microseconds(16667);
+constexpr uint64_t CHECKPOINT_FRAMES = 60;
+
+// Input batches by frame; the session ends on the last one
+const std::map<uint64_t, std::vector<std::string>>& script() {
+    static const std::map<uint64_t, std::vector<std::string>> commands = {
+        {5, {"look around"}},
+        {30, {"hint", "hint"}},                // the second is still locked
+        {150, {"hint"}},                       // unlocked after 2 s
+        {151, {"look database", "size 10"}},   // one batch across a phase change
+        {200, {"hint"}},
+        {260, {"size 60"}},
+    };
+    return commands;
+}
+
+struct Session {
+    fs::path dataDirectory;
+    FrameworkContext context;
+    std::pmr::unsynchronized_pool_resource memory;
+
+    Session(const fs::path& directory) : dataDirectory(directory) {
+        context.dataDirectory = directory.string();
+        context.memoryResource = &memory;
+    }
+};
+
+// Mirrors GameLoop: inputs, then updateFrame() once its wakeup is due or
+// commands arrived, a checkpoint every CHECKPOINT_FRAMES frames.
+// tamperAt, if non-zero, records a wrong state at that checkpoint.
+bool record(Session& session, const std::string& path, uint64_t tamperAt,
+            std::string& finalState) {
+    ClockSource& clock = ClockSource::shared();
+    clock.setVirtualAt(std::chrono::system_clock::time_point(std::chrono::hours(480000)));
+
+    RoomEngine room("rooms/test.room");
+    room.initialize(session.context);
+    if (!CHECK(room.isLoaded())) {
+        return false;
+    }
+
+    RecordingHeader header;
+    header.pluginName = "Replay Test";
+    header.roomVersion = room.getVersion();
+    header.wallStart = clock.wallNow();
+    header.initialState = room.serializeState();
+
+    SessionRecorder recorder;
+    if (!CHECK(recorder.open(path, header))) {
+        return false;
+    }
+
+    std::pmr::vector<ProcessResult> results;
+    float pendingUpdateSeconds = 0.0f;
+    float nextWakeupSeconds = 0.0f;
+    bool ended = false;
+    uint64_t checkpoints = 0;
+    for (uint64_t frame = 1; !ended; ++frame) {
+        clock.advance(FRAME);
+        std::vector<std::string> commands;
+        auto batch = script().find(frame);
+        if (batch != script().end()) {
+            commands = batch->second;
+        }
+        recorder.recordFrame(FRAME, Span<const std::string>(commands));
+
+        if (!commands.empty()) {
+            results.clear();
+            room.processInputs(Span<const std::string>(commands), results);
+            for (const ProcessResult& result : results) {
+                ended = ended || result.sessionEnded;
+            }
+            if (ended) {
+                break;
+            }
+        }
+        pendingUpdateSeconds += std::chrono::duration<float>(FRAME).count();
+        if (!commands.empty() || pendingUpdateSeconds >= nextWakeupSeconds) {
+            nextWakeupSeconds = room.updateFrame(pendingUpdateSeconds).nextWakeupSeconds;
+            pendingUpdateSeconds = 0.0f;
+        }
+
+        if (frame % CHECKPOINT_FRAMES == 0) {
+            checkpoints++;
+            std::string state = room.serializeState();
+            recorder.recordCheckpoint(checkpoints == tamperAt ? state + " " : state);
+        }
+    }
+
+    finalState = room.serializeState();
+    CHECK(room.isCompleted());
+    recorder.close(finalState);
+    return true;
+}
+
+ReplayReport replay(Session& session, const std::string& path, std::string& finalState) {
+    SessionReplayer replayer;
+    ReplayReport report;
+    if (!CHECK(replayer.load(path))) {
+        report.error = "unreadable";
+        return report;
+    }
+    CHECK(replayer.getHeader().roomVersion == "1.2.0");
+
+    RoomEngine room("rooms/test.room");
+    room.initialize(session.context);
+    report = replayer.replay(room, ReplaySpeed::FAST);
+    finalState = room.serializeState();
+    return report;
+}
+
+} // namespace
+
+int main() {
+    fs::path directory = fs::temp_directory_path() / "devescape_session_replay_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory / "rooms");
+    std::ofstream(directory / "rooms" / "test.room") << ROOM_DEFINITION;
+    Session session(directory);
+    std::string recording = (directory / "session.rec").string();
+
+    std::string recordedState;
+    if (record(session, recording, 0, recordedState)) {
+        std::string replayedState;
+        ReplayReport report = replay(session, recording, replayedState);
+        CHECK(report.passed());
+        CHECK_EQ(report.error, std::string());
+        CHECK(report.sessionEnded);
+        CHECK_EQ(report.checkpointsVerified, 5);  // four along the way and the end
+        CHECK_EQ(report.commands, 8u);
+        CHECK(replayedState == recordedState);
+    }
+
+    if (record(session, recording, 2, recordedState)) {
+        std::string replayedState;
+        ReplayReport report = replay(session, recording, replayedState);
+        CHECK(!report.passed());
+        CHECK_EQ(report.checkpointsMismatched, 1);
+        CHECK_EQ(report.firstMismatchFrame, static_cast<int64_t>(2 * CHECKPOINT_FRAMES));
+    }
+
+    fs::remove_all(directory);
+    return test::testResult();
+}
@@ -0,0 +1,153 @@
+// TimerService: firing order, cancellation, periodic timers kept on the
+// tick grid and timers far enough out to sit in the coarse wheels, all on a
+// virtual clock.
+
+#include "TestCheck.h"
+#include "framework/ClockSource.h"
+#include "framework/TimerService.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace devescape;
+using namespace std::chrono;
+
+namespace {
+
+ClockSource& virtualClock() {
+    static ClockSource clock;
+    clock.setVirtual();
+    return clock;
+}
+
+void testOrder() {
+    ClockSource& clock = virtualClock();
+    TimerService timers(milliseconds(1), clock);
+    ClockSource::time_point start = clock.now();
+    std::string fired;
+
+    timers.scheduleAfter(milliseconds(30), [&] { fired += 'c'; });
+    timers.scheduleAfter(milliseconds(10), [&] { fired += 'a'; });
+    timers.scheduleAfter(milliseconds(20), [&] {
+        fired += 'b';
+        // Due within the same advance() that scheduled it
+        timers.scheduleAt(start + milliseconds(25), [&] { fired += 'B'; });
+    });
+    CHECK_EQ(timers.pendingCount(), 3u);
+
+    clock.advance(milliseconds(9));
+    CHECK_EQ(timers.advance(), 0u);
+    clock.advance(milliseconds(1));
+    CHECK_EQ(timers.advance(), 1u);
+    CHECK_EQ(fired, std::string("a"));
+
+    clock.advance(milliseconds(100));
+    CHECK_EQ(timers.advance(), 3u);
+    CHECK_EQ(fired, std::string("abBc"));
+    CHECK_EQ(timers.pendingCount(), 0u);
+}
+
+void testCancel() {
+    ClockSource& clock = virtualClock();
+    TimerService timers(milliseconds(1), clock);
+    int fired = 0;
+
+    TimerService::TimerId kept = timers.scheduleAfter(milliseconds(5), [&] { ++fired; });
+    TimerService::TimerId dropped = timers.scheduleAfter(milliseconds(5), [&] { fired += 100; });
+    CHECK(timers.isPending(dropped));
+    CHECK(timers.cancel(dropped));
+    CHECK(!timers.cancel(dropped));
+    CHECK(!timers.isPending(dropped));
+    CHECK(!timers.cancel(TimerService::INVALID_TIMER));
+    CHECK_EQ(timers.pendingCount(), 1u);
+
+    clock.advance(milliseconds(5));
+    timers.advance();
+    CHECK_EQ(fired, 1);
+    CHECK(!timers.cancel(kept));  // already fired
+
+    // A node reused for a new timer does not answer to the old id
+    TimerService::TimerId reused = timers.scheduleAfter(milliseconds(5), [&] { ++fired; });
+    CHECK(reused != kept && reused != dropped);
+    CHECK(!timers.isPending(kept));
+    CHECK(!timers.cancel(dropped));
+    CHECK(timers.isPending(reused));
+}
+
+void testPeriodic() {
+    ClockSource& clock = virtualClock();
+    TimerService timers(milliseconds(1), clock);
+    ClockSource::time_point start = clock.now();
+    std::vector<long long> firedAt;
+
+    TimerService::TimerId id = timers.schedulePeriodic(milliseconds(10), [&] {
+        firedAt.push_back(duration_cast<milliseconds>(clock.now() - start).count());
+    });
+
+    // Late by 35 ms: once per missed period, then back on the grid
+    clock.advance(milliseconds(35));
+    CHECK_EQ(timers.advance(), 3u);
+    clock.advance(milliseconds(5));
+    CHECK_EQ(timers.advance(), 1u);
+    clock.advance(milliseconds(9));
+    CHECK_EQ(timers.advance(), 0u);
+    clock.advance(milliseconds(1));
+    CHECK_EQ(timers.advance(), 1u);
+    CHECK_EQ(firedAt.size(), 5u);
+
+    CHECK(timers.isPending(id));
+    CHECK(timers.cancel(id));
+    clock.advance(milliseconds(100));
+    CHECK_EQ(timers.advance(), 0u);
+}
+
+void testFarFuture() {
+    ClockSource& clock = virtualClock();
+    TimerService timers(milliseconds(1), clock);
+    bool fired = false;
+
+    // Two hours is 7.2M ticks, in the fourth wheel; it has to cascade down
+    // through the others without coming due early
+    timers.scheduleAfter(hours(2), [&] { fired = true; });
+    timers.scheduleAfter(minutes(90), [] {});
+    for (int minute = 0; minute < 119; ++minute) {
+        clock.advance(minutes(1));
+        timers.advance();
+    }
+    clock.advance(seconds(59) + milliseconds(999));
+    timers.advance();
+    CHECK(!fired);
+    CHECK_EQ(timers.pendingCount(), 1u);
+
+    clock.advance(milliseconds(1));
+    CHECK_EQ(timers.advance(), 1u);
+    CHECK(fired);
+    CHECK_EQ(timers.pendingCount(), 0u);
+}
+
+void testAdvanceTo() {
+    ClockSource& clock = virtualClock();
+    TimerService timers(milliseconds(1), clock);
+    ClockSource::time_point start = clock.now();
+    int fired = 0;
+
+    for (int i = 1; i <= 1000; ++i) {
+        timers.scheduleAt(start + milliseconds(i * 3), [&] { ++fired; });
+    }
+    CHECK_EQ(timers.pendingCount(), 1000u);
+    CHECK_EQ(timers.advanceTo(start + milliseconds(1500)), 500u);
+    CHECK_EQ(timers.advanceTo(start + seconds(10)), 500u);
+    CHECK_EQ(fired, 1000);
+    CHECK_EQ(timers.pendingCount(), 0u);
+}
+
+} // namespace
+
+int main() {
+    testOrder();
+    testCancel();
+    testPeriodic();
+    testFarFuture();
+    testAdvanceTo();
+    return test::testResult();
+}
@@ -0,0 +1,142 @@
+// TimerSystem: a session countdown run to its timeout on a virtual clock,
+// frame by frame the way GameLoop::runGameLoop drives it (freeze the
+// clock, advance the timer service, check for the timeout, move one frame
+// on), with a stall part way through. Pressure changes and the events
+// scheduled at remaining times must come in order on the right ticks, and
+// two runs must agree exactly.
+
+#include "TestCheck.h"
+#include "framework/ClockSource.h"
+#include "framework/TimerService.h"
+#include "framework/TimerSystem.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace devescape;
+using namespace std::chrono;
+
+namespace {
+
+constexpr int TOTAL_SECONDS = 100;
+constexpr float FRAME_TIME = 1.0f / 60.0f;
+
+const char* pressureName(PressureLevel level) {
+    switch (level) {
+        case PressureLevel::LOW: return "LOW";
+        case PressureLevel::MEDIUM: return "MEDIUM";
+        case PressureLevel::HIGH: return "HIGH";
+        case PressureLevel::CRITICAL: return "CRITICAL";
+    }
+    return "?";
+}
+
+struct Run {
+    std::vector<std::string> log;    // in the order things happened
+    std::vector<long long> eventMs;  // session time of each event's frame
+    long long timeoutMs = -1;
+    uint64_t frames = 0;
+};
+
+Run runSession() {
+    const auto FRAME_DURATION = duration_cast<ClockSource::duration>(duration<float>(FRAME_TIME));
+
+    ClockSource clock;
+    clock.setVirtual();
+    TimerService timers(milliseconds(1), clock);
+    TimerSystem timer(TOTAL_SECONDS, nullptr, timers);
+    Run run;
+
+    clock.freeze();
+    auto sessionStart = clock.now();
+    timer.start();
+    auto frameMs = [&] { return duration_cast<milliseconds>(clock.now() - sessionStart).count(); };
+
+    for (int remaining : {TOTAL_SECONDS, 50, 25, 10, 1}) {
+        timer.scheduleAtRemaining(remaining, [&, remaining] {
+            // The countdown has already ticked to the event's second
+            run.log.push_back("event " + std::to_string(remaining) + " at " +
+                              std::to_string(timer.getSecondsRemaining()) + " " +
+                              pressureName(timer.getPressureLevel()));
+            run.eventMs.push_back(frameMs());
+        });
+    }
+    CHECK_EQ(timer.scheduleAtRemaining(TOTAL_SECONDS + 5, [] {}) != TimerService::INVALID_TIMER,
+             true);
+    clock.unfreeze();
+
+    PressureLevel pressure = timer.getPressureLevel();
+    bool stalled = false;
+    while (run.frames < 100000) {
+        clock.freeze();
+        run.frames++;
+        timers.advance();
+
+        if (timer.getPressureLevel() != pressure) {
+            pressure = timer.getPressureLevel();
+            run.log.push_back(std::string("pressure ") + pressureName(pressure) + " at " +
+                              std::to_string(timer.getSecondsRemaining()));
+        }
+        if (timer.isExpired()) {
+            run.log.push_back("timeout");
+            run.timeoutMs = frameMs();
+            break;
+        }
+
+        clock.unfreeze();
+        clock.advance(FRAME_DURATION);
+        // One long frame: 8 s pass between two advances, across the 25 s
+        // mark
+        if (!stalled && timer.getSecondsRemaining() == 30) {
+            clock.advance(seconds(8));
+            stalled = true;
+        }
+    }
+    clock.unfreeze();
+    return run;
+}
+
+} // namespace
+
+int main() {
+    Run run = runSession();
+
+    // Pressure changes are seen at the end of the frame whose timers made
+    // them; the stall brings the countdown from 30 to 22 in one advance, so
+    // HIGH is reported at 22 and the event at 25 runs inside that advance
+    std::vector<std::string> expected = {
+        "event 100 at 100 LOW",
+        "event 50 at 50 MEDIUM",
+        "pressure MEDIUM at 50",
+        "event 25 at 25 HIGH",
+        "pressure HIGH at 22",
+        "event 10 at 10 CRITICAL",
+        "pressure CRITICAL at 10",
+        "event 1 at 1 CRITICAL",
+        "timeout",
+    };
+    CHECK_EQ(run.log.size(), expected.size());
+    for (size_t i = 0; i < run.log.size() && i < expected.size(); ++i) {
+        CHECK_EQ(run.log[i], expected[i]);
+    }
+
+    // Each event runs in the first frame at or after its second, except the
+    // one inside the stall, which comes in the frame that ends it
+    const long long frameMs = static_cast<long long>(FRAME_TIME * 1000.0f) + 1;
+    std::vector<long long> due = {0, 50000, 75000, 90000, 99000};
+    CHECK_EQ(run.eventMs.size(), due.size());
+    for (size_t i = 0; i < run.eventMs.size() && i < due.size(); ++i) {
+        CHECK(run.eventMs[i] >= due[i]);
+        if (due[i] != 75000) {
+            CHECK(run.eventMs[i] < due[i] + frameMs);
+        }
+    }
+    // The countdown is anchored at start(), so the stall costs no time
+    CHECK(run.timeoutMs >= TOTAL_SECONDS * 1000LL && run.timeoutMs < TOTAL_SECONDS * 1000LL + frameMs);
+
+    Run again = runSession();
+    CHECK(again.log == run.log);
+    CHECK(again.eventMs == run.eventMs);
+    CHECK_EQ(again.frames, run.frames);
+    return test::testResult();
+}